@@ -1633,6 +1633,10 @@ uint32 secondCode(uint64 fullCode) {
 	return (fullCode > 0xFFFFFFFFLLU) ? (fullCode & 0xFFFFFFFFU) : 0;
 }
 
+QByteArray hexCode(uint64 code) {
+	return QString("%1").arg(code, 0, 16).toUpper().toUtf8();
+}
+
 void writeEmojiCategory(QTextStream &tcpp, uint64 *emojiCategory, uint32 size, const char *name) {
 	tcpp << "\tcase dbiet" << name << ": {\n";
 	tcpp << "\t\tstatic QVector<EmojiPtr> v" << name << ";\n";
@@ -2010,106 +2014,68 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org\n\
 			}
 			tcpp << "};\n\n";
 
-			// getter of one symbol emojis
-			tcpp << "EmojiPtr emojiGet(uint32 code) {\n";
-			tcpp << "\tif (!emojis) return 0;\n\n";
-			tcpp << "\tuint32 highCode = code >> 16;\n";
-
-			EmojisData::const_iterator i = emojisData.cbegin(), e = emojisData.cend();
-
-			tcpp << "\tif (!highCode) {\n"; // small codes
-			tcpp << "\t\tswitch (code) {\n";
-			for (index = 0; i != e; ++i) { // two small
-				if (i->code2) break;
-				if (i->code != 169 && i->code != 174) break;
-
-                tcpp << "\t\t\tcase 0x" << QString("%1").arg(i->code, 0, 16).toUpper().toUtf8().constData() << "U: return &emojis[" << (index++) << "];\n";
-			}
-			tcpp << "\t\t}\n\n";
-            tcpp << "\t\tif (code < 0x" << QString("%1").arg(min1, 0, 16).toUpper().toUtf8().constData() << "U || code > 0x" << QString("%1").arg(max1, 0, 16).toUpper().toUtf8().constData() << "U) return 0;\n\n";
-			tcpp << "\t\tswitch (code) {\n";
-			for (; i != e; ++i) {
-				if (i->code2 || (i->code >> 16)) break;
-                tcpp << "\t\t\tcase 0x" << QString("%1").arg(i->code, 0, 16).toUpper().toUtf8().constData() << "U: return &emojis[" << (index++) << "];\n";
+			// sorted tables of one symbol and two symbol emoji codes, both are searched by binary search
+			QMap<uint32, int> emojiCodes; // code -> index in emojis, -1 for the first part of a two symbol emoji
+			QMap<uint64, int> emojiPairs; // (code << 32) | code2 -> index in emojis
+			index = 0;
+			for (EmojisData::const_iterator i = emojisData.cbegin(), e = emojisData.cend(); i != e; ++i, ++index) {
+				if (i->code2) {
+					emojiCodes.insert(i->code, -1);
+					emojiPairs.insert((uint64(i->code) << 32) | uint64(i->code2), index);
+				} else if ((i->code >> 16) == 0xFFFFU) { // sequence
+					continue;
+				} else if (i->color && ((i->color & 0xFFFF0000U) != 0xFFFF0000U)) { // colored variant
+					continue;
+				} else {
+					emojiCodes.insert(i->code, index);
+				}
 			}
-			tcpp << "\t\t}\n\n";
-			tcpp << "\t\treturn 0;\n";
-			tcpp << "\t}\n\n";
 
-			tcpp << "\tif (highCode == 0x23 || highCode == 0x2A || (highCode >= 0x30 && highCode < 0x3A)) {\n"; // digits
-            tcpp << "\t\tif ((code & 0xFFFFU) != 0x20E3U) return 0;\n\n";
-			tcpp << "\t\tswitch (code) {\n";
-			for (; i != e; ++i) {
-				if (i->code2) break;
-				uint32 high = i->code >> 16;
-				if (high != 0x23 && high != 0x2A && (high < 0x30 || high >= 0x3A)) break;
-
-                tcpp << "\t\t\tcase 0x" << QString("%1").arg(i->code, 0, 16).toUpper().toUtf8().constData() << "U: return &emojis[" << (index++) << "];\n";
+			tcpp << "namespace {\n\n";
+			tcpp << "struct EmojiCodeEntry {\n";
+			tcpp << "\tuint32 code;\n";
+			tcpp << "\tint16 index; // -1 for the first part of a two symbol emoji\n";
+			tcpp << "};\n\n";
+			tcpp << "constexpr EmojiCodeEntry emojiCodes[] = {\n";
+			for (QMap<uint32, int>::const_iterator i = emojiCodes.cbegin(), e = emojiCodes.cend(); i != e; ++i) {
+				tcpp << "\t{ 0x" << hexCode(i.key()) << "U, " << i.value() << " },\n";
 			}
-			tcpp << "\t\t}\n\n";
-			tcpp << "\t\treturn 0;\n";
-			tcpp << "\t}\n\n";
+			tcpp << "};\n\n";
+			tcpp << "struct EmojiPairEntry {\n";
+			tcpp << "\tuint64 key; // (code << 32) | code2\n";
+			tcpp << "\tint16 index;\n";
+			tcpp << "};\n\n";
+			tcpp << "constexpr EmojiPairEntry emojiPairs[] = {\n";
+			for (QMap<uint64, int>::const_iterator i = emojiPairs.cbegin(), e = emojiPairs.cend(); i != e; ++i) {
+				tcpp << "\t{ 0x" << hexCode(i.key()) << "LLU, " << i.value() << " },\n";
+			}
+			tcpp << "};\n\n";
+			tcpp << "} // namespace\n\n";
 
-			tcpp << "\tif (highCode == 0xFFFFU) {\n"; // sequences
+			// getter of one symbol emojis
+			tcpp << "EmojiPtr emojiGet(uint32 code) {\n";
+			tcpp << "\tif (!emojis) return 0;\n\n";
+			tcpp << "\tif ((code >> 16) == 0xFFFFU) {\n"; // sequences
 			tcpp << "\t\tstatic const int sequenceOffset = " << sequenceOffset << ";\n\n";
 			tcpp << "\t\tuint32 index = (code & 0xFFFFU);\n";
 			tcpp << "\t\treturn (index < " << (sizeof(emojiSequences) / sizeof(emojiSequences[0])) << ") ? &emojis[sequenceOffset + index] : 0;\n";
 			tcpp << "\t}\n\n";
-
-            tcpp << "\tif (code < 0x" << QString("%1").arg(min2, 0, 16).toUpper().toUtf8().constData() << "U || code > 0x" << QString("%1").arg(max2, 0, 16).toUpper().toUtf8().constData() << "U) return 0;\n\n";
-			tcpp << "\tswitch (code) {\n";
-			uint32 minTwoSymbol = 0, maxTwoSymbol = 0;
-			for (; i != e; ++i) {
-				if (i->code2) {
-					if (!minTwoSymbol) minTwoSymbol = i->code;
-					if (i->code > maxTwoSymbol) {
-						tcpp << "\t\tcase 0x" << QString("%1").arg(i->code, 0, 16).toUpper().toUtf8().constData() << "U: return TwoSymbolEmoji;\n";
-						maxTwoSymbol = i->code;
-					}
-					index++;
-					continue;
-				}
-				if ((i->code & 16) == 0xFFFF) { // sequence
-					index++;
-					continue;
-				}
-				if (i->color && ((i->color & 0xFFFF0000U) != 0xFFFF0000U)) {
-					index++;
-					continue;
-				}
-                tcpp << "\t\tcase 0x" << QString("%1").arg(i->code, 0, 16).toUpper().toUtf8().constData() << "U: return &emojis[" << (index++) << "];\n";
-			}
-			tcpp << "\t}\n\n";
-
-			tcpp << "\treturn 0;\n";
+			tcpp << "\tauto i = std::lower_bound(std::begin(emojiCodes), std::end(emojiCodes), code, [](const EmojiCodeEntry &entry, uint32 code) {\n";
+			tcpp << "\t\treturn entry.code < code;\n";
+			tcpp << "\t});\n";
+			tcpp << "\tif (i == std::end(emojiCodes) || i->code != code) return 0;\n\n";
+			tcpp << "\treturn (i->index < 0) ? TwoSymbolEmoji : &emojis[i->index];\n";
 			tcpp << "}\n\n";
 
 			// getter of two symbol emojis
 			tcpp << "EmojiPtr emojiGet(uint32 code, uint32 code2) {\n";
-			tcpp << "\tif (code < 0x" << QString("%1").arg(minTwoSymbol, 0, 16).toUpper().toUtf8().constData() << "U || code > 0x" << QString("%1").arg(maxTwoSymbol, 0, 16).toUpper().toUtf8().constData() << "U) return 0;\n\n";
-			tcpp << "\tswitch (code) {\n";
-			maxTwoSymbol = 0;
-			index = 0;
-			for (i = emojisData.cbegin(); i != e; ++i) {
-				if (i->code2) {
-					if (i->code > maxTwoSymbol) {
-						if (maxTwoSymbol) {
-							tcpp << "\t\t\tdefault: return 0;\n";
-							tcpp << "\t\t} break;\n";
-						}
-						tcpp << "\t\tcase 0x" << QString("%1").arg(i->code, 0, 16).toUpper().toUtf8().constData() << "U: switch (code2) {\n";
-						maxTwoSymbol = i->code;
-					}
-					tcpp << "\t\t\tcase 0x" << QString("%1").arg(i->code2, 0, 16).toUpper().toUtf8().constData() << "U: return &emojis[" << index << "];\n";
-				}
-				index++;
-			}
-			if (maxTwoSymbol) {
-				tcpp << "\t\t\tdefault: return 0;\n";
-				tcpp << "\t\t} break;\n";
-			}
-			tcpp << "\t}\n\n";
-			tcpp << "\treturn 0;\n";
+			tcpp << "\tif (!emojis) return 0;\n\n";
+			tcpp << "\tauto key = (uint64(code) << 32) | uint64(code2);\n";
+			tcpp << "\tauto i = std::lower_bound(std::begin(emojiPairs), std::end(emojiPairs), key, [](const EmojiPairEntry &entry, uint64 key) {\n";
+			tcpp << "\t\treturn entry.key < key;\n";
+			tcpp << "\t});\n";
+			tcpp << "\tif (i == std::end(emojiPairs) || i->key != key) return 0;\n\n";
+			tcpp << "\treturn &emojis[i->index];\n";
 			tcpp << "}\n\n";
 
 			// getter of colored emojis
@@ -2230,53 +2196,76 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org\n\
 			tcpp << "\treturn (index >= 0 && index < sequences.size()) ? sequences.at(index) : QString();\n";
 			tcpp << "}\n\n";
 
-			// emoji autoreplace
-			tcpp << "void emojiFind(const QChar *ch, const QChar *e, const QChar *&newEmojiEnd, uint32 &emojiCode) {\n";
-			tcpp << "\tswitch (ch->unicode()) {\n";
-
-			QString tab("\t");
+			// emoji autoreplace, a trie over the replacement strings stored breadth-first,
+			// so that children of each node are contiguous and sorted by character
 			for (uint32 i = 0; i < replacesCount; ++i) {
 				QString key = QString::fromUtf8(replaces[i].replace);
 				replaceMap[key] = replaces[i].code;
 			}
-			QString chars;
-			for (ReplaceMap::const_iterator i = replaceMap.cend(), e = replaceMap.cbegin(); i != e;) {
-				--i;
-				QString key = i.key();
-				if (key == chars) {
-					tcpp << tab.repeated(1 + chars.size()) << "}\n";
-				}
-				bool needSwitch = chars.size();
-				while (chars.size() && key.midRef(0, chars.size()) != chars) {
-					needSwitch = false;
-					chars.resize(chars.size() - 1);
-					tcpp << tab.repeated(1 + chars.size()) << "break;\n";
-					if (chars.size() && (key.midRef(0, chars.size()) != chars || key == chars)) {
-						tcpp << tab.repeated(1 + chars.size()) << "}\n";
-					}
-				}
-				for (int j = chars.size(); j < key.size(); ++j) {
-					if (needSwitch) {
-						tcpp << tab.repeated(1 + chars.size()) << "if (ch + " << chars.size() << " != e) switch ((ch + " << chars.size() << ")->unicode()) {\n";
-					}
-					tcpp << tab.repeated(1 + chars.size()) << "case '" << ((key.at(j) == '\\' || key.at(j) == '\'') ? "\\" : "") << key.at(j) << "':\n";
-					chars.push_back(key.at(j));
-					needSwitch = true;
+			struct ReplaceNode {
+				QString chars;
+				int childrenStart, childrenCount;
+				uint32 code;
+			};
+			QVector<ReplaceNode> replaceTrie(1, ReplaceNode { QString(), 0, 0, 0 });
+			int replaceMaxLength = 0;
+			for (int i = 0; i < replaceTrie.size(); ++i) {
+				QString chars = replaceTrie[i].chars;
+				replaceTrie[i].childrenStart = replaceTrie.size();
+				for (ReplaceMap::const_iterator j = replaceMap.cbegin(), e = replaceMap.cend(); j != e; ++j) {
+					QString key = j.key();
+					if (key.size() <= chars.size() || key.midRef(0, chars.size()) != chars) continue;
+
+					QString child = key.mid(0, chars.size() + 1);
+					if (replaceTrie.back().chars == child) continue;
+
+					ReplaceMap::const_iterator exact = replaceMap.constFind(child);
+					replaceTrie.push_back(ReplaceNode { child, 0, 0, (exact == e) ? 0U : exact.value() });
+					if (child.size() > replaceMaxLength) replaceMaxLength = child.size();
 				}
-				tcpp << tab.repeated(1 + chars.size()) << "newEmojiEnd = ch + " << chars.size() << ";\n";
-				tcpp << tab.repeated(1 + chars.size()) << "if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {\n";
-                tcpp << tab.repeated(1 + chars.size()) << "\temojiCode = 0x" << QString("%1").arg(i.value(), 0, 16).toUpper().toUtf8().constData() << "U;\n";
-				tcpp << tab.repeated(1 + chars.size()) << "\treturn;\n";
-				tcpp << tab.repeated(1 + chars.size()) << "}\n";
+				replaceTrie[i].childrenCount = replaceTrie.size() - replaceTrie[i].childrenStart;
 			}
-			while (chars.size()) {
-				chars.resize(chars.size() - 1);
-				tcpp << tab.repeated(1 + chars.size()) << "break;\n";
-				if (chars.size()) {
-					tcpp << tab.repeated(1 + chars.size()) << "}\n";
-				}
+
+			tcpp << "namespace {\n\n";
+			tcpp << "struct EmojiReplaceNode {\n";
+			tcpp << "\tushort ch;\n";
+			tcpp << "\tuint16 childrenStart, childrenCount;\n";
+			tcpp << "\tuint32 code; // 0 if no replacement ends in this node\n";
+			tcpp << "};\n\n";
+			tcpp << "constexpr int kEmojiReplaceMaxLength = " << replaceMaxLength << ";\n";
+			tcpp << "constexpr EmojiReplaceNode emojiReplaceTrie[] = {\n";
+			for (int i = 0; i < replaceTrie.size(); ++i) {
+				const ReplaceNode &node = replaceTrie.at(i);
+				ushort ch = node.chars.isEmpty() ? 0 : node.chars.at(node.chars.size() - 1).unicode();
+				tcpp << "\t{ 0x" << hexCode(ch) << ", " << node.childrenStart << ", " << node.childrenCount << ", 0x" << hexCode(node.code) << "U },";
+				if (!node.chars.isEmpty()) tcpp << " // " << node.chars;
+				tcpp << "\n";
 			}
-					
+			tcpp << "};\n\n";
+			tcpp << "} // namespace\n\n";
+
+			tcpp << "void emojiFind(const QChar *ch, const QChar *e, const QChar *&newEmojiEnd, uint32 &emojiCode) {\n";
+			tcpp << "\tconst EmojiReplaceNode *found[kEmojiReplaceMaxLength] = { nullptr };\n";
+			tcpp << "\tauto node = &emojiReplaceTrie[0];\n";
+			tcpp << "\tauto length = 0;\n";
+			tcpp << "\tfor (; length < kEmojiReplaceMaxLength && ch + length != e; ++length) {\n";
+			tcpp << "\t\tauto childrenBegin = emojiReplaceTrie + node->childrenStart, childrenEnd = childrenBegin + node->childrenCount;\n";
+			tcpp << "\t\tauto unicode = (ch + length)->unicode();\n";
+			tcpp << "\t\tauto child = std::lower_bound(childrenBegin, childrenEnd, unicode, [](const EmojiReplaceNode &node, ushort unicode) {\n";
+			tcpp << "\t\t\treturn node.ch < unicode;\n";
+			tcpp << "\t\t});\n";
+			tcpp << "\t\tif (child == childrenEnd || child->ch != unicode) break;\n\n";
+			tcpp << "\t\tnode = found[length] = child;\n";
+			tcpp << "\t}\n\n";
+			tcpp << "\t// prefer the longest replacement that ends on an edge\n";
+			tcpp << "\twhile (length > 0) {\n";
+			tcpp << "\t\tauto match = found[--length];\n";
+			tcpp << "\t\tif (!match->code) continue;\n\n";
+			tcpp << "\t\tnewEmojiEnd = ch + length + 1;\n";
+			tcpp << "\t\tif (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {\n";
+			tcpp << "\t\t\temojiCode = match->code;\n";
+			tcpp << "\t\t\treturn;\n";
+			tcpp << "\t\t}\n";
 			tcpp << "\t}\n";
 			tcpp << "}\n\n";
 
@@ -317,24 +317,20 @@ void writeCppKey(QTextStream &tcpp, const QByteArray &key, const QString &val) {
 	tcpp << "\t\t\tset(" << key << ", " << escapeCpp(key, val) << ");\n";
 }
 
-bool genLang(const QString &lang_in, const QString &lang_out) {
-	QString lang_cpp = lang_out + ".cpp", lang_h = lang_out + ".h";
+bool readLangData(const QString &lang_in, QByteArray &data, int &skip) {
 	QFile f(lang_in);
 	if (!f.open(QIODevice::ReadOnly)) {
 		cout << "Could not open lang input file '" << lang_in.toUtf8().constData() << "'!\n";
-		QCoreApplication::exit(1);
 		return false;
 	}
 	QByteArray checkCodec = f.read(3);
 	if (checkCodec.size() < 3) {
 		cout << "Bad lang input file '" << lang_in.toUtf8().constData() << "'!\n";
-		QCoreApplication::exit(1);
 		return false;
 	}
 	f.seek(0);
 
-	QByteArray data;
-	int skip = 0;
+	skip = 0;
 	if ((checkCodec.at(0) == '\xFF' && checkCodec.at(1) == '\xFE') || (checkCodec.at(0) == '\xFE' && checkCodec.at(1) == '\xFF') || (checkCodec.at(1) == 0)) {
 		QTextStream stream(&f);
 		stream.setCodec("UTF-16");
@@ -342,7 +338,6 @@ bool genLang(const QString &lang_in, const QString &lang_out) {
 		QString string = stream.readAll();
 		if (stream.status() != QTextStream::Ok) {
 			cout << "Could not read valid UTF-16 file '" << lang_in.toUtf8().constData() << "'!\n";
-			QCoreApplication::exit(1);
 			return false;
 		}
 		f.close();
@@ -357,7 +352,6 @@ bool genLang(const QString &lang_in, const QString &lang_out) {
 		QString string = stream.readAll();
 		if (stream.status() != QTextStream::Ok) {
 			cout << "Could not read valid UTF-16 file '" << lang_in.toUtf8().constData() << "'!\n";
-			QCoreApplication::exit(1);
 			return false;
 		}
 
@@ -368,6 +362,189 @@ bool genLang(const QString &lang_in, const QString &lang_out) {
 			skip = 3; // skip UTF-8 BOM
 		}
 	}
+	return true;
+}
+
+// Names of the LangKey values in the order of the generated enum.
+QVector<QByteArray> keyEnumNames() {
+	QVector<QByteArray> result;
+	for (int i = 0, l = keysOrder.size(); i < l; ++i) {
+		if (keysTags[keysOrder[i]].isEmpty()) {
+			result.push_back(keysOrder[i]);
+		} else {
+			result.push_back(keysOrder[i] + "__tagged");
+			const QMap<QByteArray, QVector<QString> > &countedTags(keysCounted[keysOrder[i]]);
+			for (QMap<QByteArray, QVector<QString> >::const_iterator j = countedTags.cbegin(), e = countedTags.cend(); j != e; ++j) {
+				for (int k = 0, s = j->size(); k < s; ++k) {
+					result.push_back(keysOrder[i] + "__" + j.key() + QString::number(k).toUtf8());
+				}
+			}
+		}
+	}
+	return result;
+}
+
+uint32 countCrc32(const void *data, int len) { // same as hashCrc32() in core/utils.cpp
+	static uint32 table[256] = { 0 };
+	if (!table[1]) {
+		for (uint32 i = 0; i < 256; ++i) {
+			uint32 value = i;
+			for (int j = 0; j < 8; ++j) {
+				value = (value & 1) ? ((value >> 1) ^ 0xEDB88320U) : (value >> 1);
+			}
+			table[i] = value;
+		}
+	}
+	const uchar *buf = (const uchar*)data;
+	uint32 crc = 0xFFFFFFFFU;
+	for (int i = 0; i < len; ++i) {
+		crc = (crc >> 8) ^ table[(crc & 0xFF) ^ buf[i]];
+	}
+	return crc ^ 0xFFFFFFFFU;
+}
+
+uint32 countKeysChecksum(const QVector<QByteArray> &names) {
+	QByteArray joined;
+	for (int i = 0, l = names.size(); i < l; ++i) {
+		joined.append(names[i]).append('\0');
+	}
+	return countCrc32(joined.constData(), joined.size());
+}
+
+// Binary language pack, read by LangLoaderPack, the writer is duplicated in langloaderpack.cpp
+// Header: magic, format version, keys checksum, keys count, source checksum, data checksum.
+// Data: (offset, length) of each key value in the UTF-16 blob, offset is 0xFFFFFFFF if there is no value.
+static const uint32 LangPackMagic = 0x4B50474CU, LangPackVersion = 1, LangPackNoValue = 0xFFFFFFFFU;
+
+QByteArray writeLangPack(const QVector<QString> &values, const QVector<bool> &present, uint32 keysChecksum, uint32 sourceChecksum) {
+	int count = values.size();
+	QVector<uint32> offsets(count * 2, 0);
+	QVector<ushort> blob;
+	for (int i = 0; i < count; ++i) {
+		if (present[i]) {
+			offsets[i * 2] = blob.size();
+			offsets[i * 2 + 1] = values[i].size();
+			for (const QChar *ch = values[i].constData(), *e = ch + values[i].size(); ch != e; ++ch) {
+				blob.push_back(ch->unicode());
+			}
+		} else {
+			offsets[i * 2] = LangPackNoValue;
+		}
+	}
+	if (blob.size() % 2) blob.push_back(0);
+
+	QByteArray data;
+	data.append((const char*)offsets.constData(), offsets.size() * sizeof(uint32));
+	data.append((const char*)blob.constData(), blob.size() * sizeof(ushort));
+
+	uint32 header[6] = { LangPackMagic, LangPackVersion, keysChecksum, uint32(count), sourceChecksum, countCrc32(data.constData(), data.size()) };
+	return QByteArray((const char*)header, sizeof(header)) + data;
+}
+
+struct LangState {
+	LangKeys keys;
+	LangTags tags;
+	LangKeysTags keysTags;
+	KeysOrder keysOrder, tagsOrder;
+	LangKeysCounted keysCounted;
+
+	void swapWithCurrent() {
+		std::swap(keys, ::keys);
+		std::swap(tags, ::tags);
+		std::swap(keysTags, ::keysTags);
+		std::swap(keysOrder, ::keysOrder);
+		std::swap(tagsOrder, ::tagsOrder);
+		std::swap(keysCounted, ::keysCounted);
+	}
+};
+
+// Parses a translation and puts its values to the LangKey slots of the source language,
+// skipping the values that LangLoaderPlain would not use with a warning.
+QByteArray genPack(const QString &pack_in, const QVector<QByteArray> &enumNames, uint32 keysChecksum) {
+	QByteArray data;
+	int skip = 0;
+	if (!readLangData(pack_in, data, skip)) {
+		throw Exception(QString("Could not read lang pack input file '%1'").arg(pack_in));
+	}
+	QByteArray name = QFileInfo(pack_in).fileName().toUtf8();
+
+	LangState translation;
+	translation.tags = tags; // Known tags keep their indices.
+	translation.tagsOrder = tagsOrder;
+	translation.swapWithCurrent();
+	try {
+		const char *text = data.constData() + skip, *end = text + data.size() - skip;
+		while (text < end) {
+			readKeyValue(text, end);
+		}
+	} catch (...) {
+		translation.swapWithCurrent();
+		throw;
+	}
+	translation.swapWithCurrent();
+
+	QMap<QByteArray, int> enumIndices;
+	for (int i = 0, l = enumNames.size(); i < l; ++i) {
+		enumIndices.insert(enumNames[i], i);
+	}
+	QVector<QString> values(enumNames.size());
+	QVector<bool> present(enumNames.size(), false);
+	for (int i = 0, l = translation.keysOrder.size(); i < l; ++i) {
+		const QByteArray &key(translation.keysOrder[i]);
+		if (!keys.contains(key)) {
+			cout << "Warning: unknown key '" << key.constData() << "' in '" << name.constData() << "'\n";
+			continue;
+		}
+		const QVector<QByteArray> &keyTags(keysTags[key]);
+		const QVector<QByteArray> &translatedTags(translation.keysTags[key]);
+		const QMap<QByteArray, QVector<QString> > &translatedCounted(translation.keysCounted[key]);
+
+		bool good = true;
+		for (int j = 0, s = translatedTags.size(); j < s; ++j) {
+			const QByteArray &tag(translatedTags[j]);
+			if (!keyTags.contains(tag)) {
+				cout << "Warning: unexpected tag '" << tag.constData() << "' in key '" << key.constData() << "' in '" << name.constData() << "', not using value\n";
+				good = false;
+			} else if (!translatedCounted.value(tag).isEmpty() && keysCounted[key].value(tag).isEmpty()) {
+				cout << "Warning: unexpected counted tag '" << tag.constData() << "' in key '" << key.constData() << "' in '" << name.constData() << "', not using value\n";
+				good = false;
+			}
+		}
+		if (!good) continue;
+
+		int index = enumIndices.value(keyTags.isEmpty() ? key : (key + "__tagged"));
+		values[index] = translation.keys[key];
+		present[index] = true;
+		for (QMap<QByteArray, QVector<QString> >::const_iterator j = translatedCounted.cbegin(), e = translatedCounted.cend(); j != e; ++j) {
+			int available = keysCounted[key].value(j.key()).size();
+			for (int k = 0, s = j->size(); k < s; ++k) {
+				if (k >= available) {
+					cout << "Warning: too many values of counted tag '" << j.key().constData() << "' in key '" << key.constData() << "' in '" << name.constData() << "'\n";
+					break;
+				}
+				int subindex = enumIndices.value(key + "__" + j.key() + QString::number(k).toUtf8());
+				values[subindex] = j->at(k);
+				present[subindex] = true;
+			}
+		}
+	}
+
+	QFile source(pack_in);
+	if (!source.open(QIODevice::ReadOnly)) {
+		throw Exception(QString("Could not read lang pack input file '%1'").arg(pack_in));
+	}
+	QByteArray sourceData = source.readAll();
+	return writeLangPack(values, present, keysChecksum, countCrc32(sourceData.constData(), sourceData.size()));
+}
+
+bool genLang(const QString &lang_in, const QString &lang_out, const QStringList &packs_in) {
+	QString lang_cpp = lang_out + ".cpp", lang_h = lang_out + ".h";
+	QByteArray data;
+	int skip = 0;
+	if (!readLangData(lang_in, data, skip)) {
+		QCoreApplication::exit(1);
+		return false;
+	}
 
 	const char *text = data.constData() + skip, *end = text + data.size() - skip;
 	try {
@@ -375,6 +552,16 @@ bool genLang(const QString &lang_in, const QString &lang_out) {
 			readKeyValue(text, end);
 		}
 
+		QVector<QByteArray> enumNames = keyEnumNames();
+		uint32 keysChecksum = countKeysChecksum(enumNames);
+
+		QMap<QByteArray, QByteArray> packs;
+		for (int i = 0, l = packs_in.size(); i < l; ++i) {
+			QRegularExpressionMatch m = QRegularExpression("^lang_([a-zA-Z_]+)\\.strings$").match(QFileInfo(packs_in[i]).fileName());
+			if (!m.hasMatch()) throw Exception(QString("Bad lang pack input file name '%1'").arg(packs_in[i]));
+			packs.insert(m.captured(1).toUtf8(), genPack(packs_in[i], enumNames, keysChecksum));
+		}
+
 		QByteArray cppText, hText;
 		{
 			QTextStream tcpp(&cppText), th(&hText);
@@ -432,11 +619,15 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org\n\
 				}
 			}
 			th << "\n\tlngkeys_cnt\n";
-			th << "};\n\n";
+			th << "};\n";
+			th << "static const uint32 lngkeys_checksum = 0x" << QString("%1").arg(keysChecksum, 8, 16, QChar('0')) << "U;\n\n";
 
 			th << "LangString lang(LangKey key);\n\n";
 			th << "LangString langOriginal(LangKey key);\n\n";
 
+			th << "// Binary pack made from 'lang_{code}.strings', see LangLoaderPack.\n";
+			th << "QByteArray langBuiltInPack(const QString &code);\n\n";
+
 			for (int i = 0, l = keysOrder.size(); i < l; ++i) {
 				QVector<QByteArray> &tagsList(keysTags[keysOrder[i]]);
 				if (tagsList.isEmpty()) continue;
@@ -537,6 +728,16 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org\n\
 
 			tcpp << "\tLangInit _langInit;\n\n";
 
+			for (QMap<QByteArray, QByteArray>::const_iterator i = packs.cbegin(), e = packs.cend(); i != e; ++i) {
+				const QByteArray &pack(i.value());
+				const uint32 *words = (const uint32*)pack.constData();
+				tcpp << "\tconst uint32 _langPack_" << i.key() << "[] = {";
+				for (int j = 0, s = pack.size() / sizeof(uint32); j < s; ++j) {
+					tcpp << ((j % 8) ? " " : "\n\t\t") << "0x" << QString("%1").arg(words[j], 8, 16, QChar('0')) << ",";
+				}
+				tcpp << "\n\t};\n\n";
+			}
+
 			tcpp << "\tinline bool _lngEquals(const QByteArray &key, int from, int len, const char *value, int size) {\n";
 			tcpp << "\t\tif (size != len || from + len > key.size()) return false;\n";
 			tcpp << "\t\tfor (const char *v = key.constData() + from, *e = v + len; v != e; ++v, ++value) {\n";
@@ -559,6 +760,13 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org\n\
 			tcpp << "\treturn (key < 0 || key > lngkeys_cnt || _langValuesOriginal[key] == qsl(\"{}\")) ? QString() : (_langValuesOriginal[key].isEmpty() ? _langValues[key] : _langValuesOriginal[key]);\n";
 			tcpp << "}\n\n";
 
+			tcpp << "QByteArray langBuiltInPack(const QString &code) {\n";
+			for (QMap<QByteArray, QByteArray>::const_iterator i = packs.cbegin(), e = packs.cend(); i != e; ++i) {
+				tcpp << "\tif (code == qstr(\"" << i.key() << "\")) return QByteArray::fromRawData((const char*)_langPack_" << i.key() << ", sizeof(_langPack_" << i.key() << "));\n";
+			}
+			tcpp << "\treturn QByteArray();\n";
+			tcpp << "}\n\n";
+
 			tcpp << "const char *langKeyName(LangKey key) {\n";
 			tcpp << "\treturn (key < 0 || key > lngkeys_cnt) ? \"\" : _langKeyNames[key];\n";
 			tcpp << "}\n\n";
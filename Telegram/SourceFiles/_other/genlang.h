@@ -30,6 +30,7 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include <QtCore/QTextStream>
 #include <QtCore/QString>
 #include <QtCore/QCoreApplication>
+#include <QtCore/QStringList>
 
 using std::string;
 using std::cout;
@@ -52,19 +53,19 @@ private:
 	QByteArray _msg;
 };
 
-bool genLang(const QString &lang_in, const QString &lang_out);
+bool genLang(const QString &lang_in, const QString &lang_out, const QStringList &packs_in);
 
 class GenLang : public QObject {
 	Q_OBJECT
 
 public:
-	GenLang(const QString &lang_in, const QString &lang_out) : QObject(0),
-		_lang_in(lang_in), _lang_out(lang_out) {
+	GenLang(const QString &lang_in, const QString &lang_out, const QStringList &packs_in) : QObject(0),
+		_lang_in(lang_in), _lang_out(lang_out), _packs_in(packs_in) {
 	}
 
 	public slots :
 		void run()  {
-			if (genLang(_lang_in, _lang_out)) {
+			if (genLang(_lang_in, _lang_out, _packs_in)) {
 				emit finished();
 			}
 		}
@@ -75,4 +76,5 @@ signals:
 private:
 
 	QString _lang_in, _lang_out;
+	QStringList _packs_in;
 };
@@ -22,11 +22,14 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 
 int main(int argc, char *argv[]) {
 	QString lang_in("lang.strings"), lang_out("lang");
+	QStringList packs_in;
 	for (int i = 0; i < argc; ++i) {
 		if (string("-lang_in") == argv[i]) {
 			if (++i < argc) lang_in = argv[i];
 		} else if (string("-lang_out") == argv[i]) {
 			if (++i < argc) lang_out = argv[i];
+		} else if (string("-pack") == argv[i]) {
+			if (++i < argc) packs_in.push_back(argv[i]);
 		}
 	}
 #ifdef Q_OS_MAC
@@ -39,11 +42,14 @@ int main(int argc, char *argv[]) {
                 QString basePath = result.absolutePath() + '/';
                 lang_in = basePath + lang_in;
                 lang_out = basePath + lang_out;
+                for (auto &pack_in : packs_in) {
+                    pack_in = basePath + pack_in;
+                }
             }
         }
     }
 #endif
-	QObject *taskImpl = new GenLang(lang_in, lang_out);
+	QObject *taskImpl = new GenLang(lang_in, lang_out, packs_in);
 
 	QCoreApplication a(argc, argv);
 
@@ -139,12 +139,87 @@ int32 *hashSha1(const void *data, uint32 len, void *dest) {
 
 QString BetaSignature;
 
+// Delta packages start with this instead of the version, see autoupdater.cpp
+const quint32 DeltaPackageMagic = 0x7FFFFFFE;
+const quint8 DeltaFileFull = 0x00, DeltaFilePatch = 0x01;
+const quint8 DeltaPatchEnd = 0x00, DeltaPatchCopy = 0x01, DeltaPatchInsert = 0x02;
+const int32 DeltaBlockSize = 32;
+
+uint32 deltaBlockHash(const uchar *data) {
+	uint32 result = 0;
+	for (int32 i = 0; i < DeltaBlockSize; ++i) {
+		result = result * 257 + data[i];
+	}
+	return result;
+}
+
+// Writes the commands building "now" from the ranges of "was" and the inserted bytes.
+// Blocks of "was" are indexed by a rolling hash, which is moved over "now" byte by byte.
+void writeDeltaPatch(QDataStream &stream, const QByteArray &was, const QByteArray &now) {
+	const uchar *wasData = (const uchar*)was.constData(), *nowData = (const uchar*)now.constData();
+	uint32 wasSize = was.size(), nowSize = now.size();
+
+	QHash<uint32, uint32> blocks;
+	for (uint32 offset = 0; offset + DeltaBlockSize <= wasSize; offset += DeltaBlockSize) {
+		uint32 hash = deltaBlockHash(wasData + offset);
+		if (!blocks.contains(hash)) {
+			blocks.insert(hash, offset);
+		}
+	}
+
+	uint32 power = 1; // 257 ^ (DeltaBlockSize - 1)
+	for (int32 i = 1; i < DeltaBlockSize; ++i) {
+		power *= 257;
+	}
+
+	uint32 position = 0, inserted = 0, hash = 0;
+	if (nowSize >= uint32(DeltaBlockSize)) {
+		hash = deltaBlockHash(nowData);
+	}
+	while (position + DeltaBlockSize <= nowSize) {
+		QHash<uint32, uint32>::const_iterator i = blocks.constFind(hash);
+		if (i != blocks.cend() && !memcmp(wasData + i.value(), nowData + position, DeltaBlockSize)) {
+			uint32 from = i.value(), length = DeltaBlockSize;
+			while (position + length < nowSize && from + length < wasSize && nowData[position + length] == wasData[from + length]) {
+				++length;
+			}
+			while (position > inserted && from > 0 && nowData[position - 1] == wasData[from - 1]) {
+				--position;
+				--from;
+				++length;
+			}
+			if (position > inserted) {
+				stream << DeltaPatchInsert << quint32(position - inserted);
+				stream.writeRawData(now.constData() + inserted, position - inserted);
+			}
+			stream << DeltaPatchCopy << quint32(from) << quint32(length);
+
+			position += length;
+			inserted = position;
+			if (position + DeltaBlockSize <= nowSize) {
+				hash = deltaBlockHash(nowData + position);
+			}
+		} else {
+			if (position + DeltaBlockSize < nowSize) {
+				hash = (hash - nowData[position] * power) * 257 + nowData[position + DeltaBlockSize];
+			}
+			++position;
+		}
+	}
+	if (nowSize > inserted) {
+		stream << DeltaPatchInsert << quint32(nowSize - inserted);
+		stream.writeRawData(now.constData() + inserted, nowSize - inserted);
+	}
+	stream << DeltaPatchEnd;
+}
+
 int main(int argc, char *argv[])
 {
 	QString workDir;
 
-	QString remove;
+	QString remove, deltaPath;
 	int version = 0;
+	quint64 deltaBase = 0;
 	bool target32 = false;
 	QFileInfoList files;
 	for (int i = 0; i < argc; ++i) {
@@ -157,6 +232,10 @@ int main(int argc, char *argv[])
 			target32 = (string("mac32") == argv[i + 1]);
 		} else if (string("-version") == argv[i] && i + 1 < argc) {
 			version = QString(argv[i + 1]).toInt();
+		} else if (string("-delta") == argv[i] && i + 1 < argc) {
+			deltaPath = QDir(QString(argv[i + 1])).canonicalPath() + "/";
+		} else if (string("-base") == argv[i] && i + 1 < argc) {
+			deltaBase = QString(argv[i + 1]).toULongLong();
 		} else if (string("-alpha") == argv[i]) {
 			AlphaChannel = true;
 		} else if (string("-beta") == argv[i] && i + 1 < argc) {
@@ -184,6 +263,10 @@ int main(int argc, char *argv[])
 #endif
 		return -1;
 	}
+	if (deltaPath.isEmpty() != !deltaBase) {
+		cout << "Both -delta {previous version dir} and -base {previous version} should be passed to make a delta package\n";
+		return -1;
+	}
 
 	bool hasDirs = true;
 	while (hasDirs) {
@@ -224,6 +307,9 @@ int main(int argc, char *argv[])
 		QDataStream stream(&buffer);
 		stream.setVersion(QDataStream::Qt_5_1);
 
+		if (deltaBase) {
+			stream << DeltaPackageMagic << deltaBase;
+		}
 		if (BetaVersion) {
 			stream << quint32(0x7FFFFFFF);
 			stream << quint64(BetaVersion);
@@ -245,7 +331,27 @@ int main(int argc, char *argv[])
 				return -1;
 			}
 			QByteArray inner = f.readAll();
-			stream << name << quint32(inner.size()) << inner;
+			stream << name;
+			if (deltaBase) {
+				// All the files are written, because the bundle is replaced as a whole on OS X.
+				QFile base(deltaPath + name);
+				if (base.open(QIODevice::ReadOnly)) {
+					QByteArray was = base.readAll();
+					uchar wasSha[20], nowSha[20];
+					hashSha1(was.constData(), was.size(), wasSha);
+					hashSha1(inner.constData(), inner.size(), nowSha);
+
+					stream << DeltaFilePatch << quint32(inner.size());
+					stream.writeRawData((const char*)wasSha, 20);
+					stream.writeRawData((const char*)nowSha, 20);
+					writeDeltaPatch(stream, was, inner);
+					cout << "Patch against '" << base.fileName().toUtf8().constData() << "' (" << was.size() << ")\n";
+				} else {
+					stream << DeltaFileFull << quint32(inner.size()) << inner;
+				}
+			} else {
+				stream << quint32(inner.size()) << inner;
+			}
 #if defined Q_OS_MAC || defined Q_OS_LINUX
 			stream << (QFileInfo(fullName).isExecutable() ? true : false);
 #endif
@@ -466,6 +572,9 @@ int main(int argc, char *argv[])
 #else
 #error Unknown platform!
 #endif
+	if (deltaBase) {
+		outName += QString("d%1").arg(deltaBase);
+	}
 	if (BetaVersion) {
 		outName += "_" + BetaSignature;
 	}
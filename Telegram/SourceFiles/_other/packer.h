@@ -27,6 +27,7 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include <QtCore/QStringList>
 #include <QtCore/QBuffer>
 #include <QtCore/QDataStream>
+#include <QtCore/QHash>
 
 #include <zlib.h>
 
@@ -32,6 +32,7 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include "styles/style_boxes.h"
 #include "lang.h"
 #include "data/data_abstract_structure.h"
+#include "data/data_userpic_cache.h"
 #include "history/history_service_layout.h"
 #include "history/history_location_manager.h"
 #include "history/history_media_types.h"
@@ -47,6 +48,7 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include "window/window_theme.h"
 #include "window/notifications_manager.h"
 #include "platform/platform_notifications_manager.h"
+#include "core/single_timer.h"
 
 namespace {
 	App::LaunchState _launchState = App::Launched;
@@ -105,7 +107,75 @@ namespace {
 		*contextItem = nullptr,
 		*mousedItem = nullptr;
 
-	QPixmap *emoji = nullptr, *emojiLarge = nullptr;
+	constexpr int kEmojiSpriteSourceReleaseTimeout = 5000;
+
+	// Emoji sprite is split to row tiles, each one is cut from the decoded
+	// atlas on the first paint that needs it. The decoded atlas itself is
+	// released after a while, so only the tiles that were drawn stay resident.
+	class EmojiSprite {
+	public:
+		void init(const QString &path, int size) {
+			clear();
+			_path = path;
+			_size = size;
+		}
+
+		const QPixmap &tile(EmojiPtr emoji) {
+			auto i = _tiles.constFind(emoji->y);
+			if (i == _tiles.cend()) {
+				i = _tiles.insert(emoji->y, prepareTile(emoji->y));
+			}
+			return i.value();
+		}
+
+		void releaseSource() {
+			_source = QImage();
+		}
+
+		void clear() {
+			releaseSource();
+			_tiles.clear();
+		}
+
+	private:
+		QPixmap prepareTile(int row) {
+			if (_source.isNull()) {
+				auto ms = getms();
+				_source = QImage(_path);
+				if (_source.format() != QImage::Format_ARGB32_Premultiplied) {
+					_source = _source.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+				}
+				DEBUG_LOG(("Emoji Info: decoded sprite '%1' in %2ms").arg(_path).arg(getms() - ms));
+			}
+			scheduleSourceRelease();
+
+			auto result = App::pixmapFromImageInPlace(_source.copy(0, row * _size, _source.width(), _size));
+			if (cRetina()) result.setDevicePixelRatio(cRetinaFactor());
+			return result;
+		}
+
+		void scheduleSourceRelease();
+
+		QString _path;
+		int _size = 0;
+		QImage _source;
+		QMap<int, QPixmap> _tiles;
+
+	};
+	EmojiSprite emojiSprite, emojiLargeSprite;
+	SingleTimer *emojiSpriteSourceReleaseTimer = nullptr;
+
+	void EmojiSprite::scheduleSourceRelease() {
+		if (!emojiSpriteSourceReleaseTimer) {
+			emojiSpriteSourceReleaseTimer = new SingleTimer();
+			emojiSpriteSourceReleaseTimer->setTimeoutHandler([] {
+				emojiSprite.releaseSource();
+				emojiLargeSprite.releaseSource();
+			});
+		}
+		emojiSpriteSourceReleaseTimer->start(kEmojiSpriteSourceReleaseTimeout);
+	}
+
 	style::font monofont;
 
 	struct CornersPixmaps {
@@ -115,6 +185,7 @@ namespace {
 		QPixmap *p[4];
 	};
 	CornersPixmaps corners[RoundCornersCount];
+	uint64 cornersColors[RoundCornersCount] = { 0 }; // The corners are rebuilt only if these change.
 	using CornersMap = QMap<uint32, CornersPixmaps>;
 	CornersMap cornersMap;
 	QImage *cornersMaskLarge[4] = { nullptr }, *cornersMaskSmall[4] = { nullptr };
@@ -2162,6 +2233,16 @@ namespace {
 	}
 
 	void prepareCorners(RoundCorners index, int32 radius, const QBrush &brush, const style::color *shadow = nullptr, QImage *cors = nullptr) {
+		if (index != SmallMaskCorners && index != LargeMaskCorners) {
+			auto colors = (uint64(brush.color().rgba()) << 32) | (shadow ? uint64((*shadow)->c.rgba()) : 0ULL);
+			if (::corners[index].p[0] && ::cornersColors[index] == colors) {
+				return;
+			}
+			for (auto &pixmap : ::corners[index].p) {
+				delete base::take(pixmap);
+			}
+			::cornersColors[index] = colors;
+		}
 		int32 r = radius * cIntRetinaFactor(), s = st::msgShadow * cIntRetinaFactor();
 		QImage rect(r * 3, r * 3 + (shadow ? s : 0), QImage::Format_ARGB32_Premultiplied), localCors[4];
 		{
@@ -2209,17 +2290,20 @@ namespace {
 		return MsgRadius;
 	}
 
+	// Only the corners with the changed colors are prepared again.
 	void createCorners() {
-		QImage mask[4];
-		prepareCorners(LargeMaskCorners, msgRadius(), QColor(255, 255, 255), nullptr, mask);
-		for (int i = 0; i < 4; ++i) {
-			::cornersMaskLarge[i] = new QImage(mask[i].convertToFormat(QImage::Format_ARGB32_Premultiplied));
-			::cornersMaskLarge[i]->setDevicePixelRatio(cRetinaFactor());
-		}
-		prepareCorners(SmallMaskCorners, st::buttonRadius, QColor(255, 255, 255), nullptr, mask);
-		for (int i = 0; i < 4; ++i) {
-			::cornersMaskSmall[i] = new QImage(mask[i].convertToFormat(QImage::Format_ARGB32_Premultiplied));
-			::cornersMaskSmall[i]->setDevicePixelRatio(cRetinaFactor());
+		if (!::cornersMaskLarge[0]) {
+			QImage mask[4];
+			prepareCorners(LargeMaskCorners, msgRadius(), QColor(255, 255, 255), nullptr, mask);
+			for (int i = 0; i < 4; ++i) {
+				::cornersMaskLarge[i] = new QImage(mask[i].convertToFormat(QImage::Format_ARGB32_Premultiplied));
+				::cornersMaskLarge[i]->setDevicePixelRatio(cRetinaFactor());
+			}
+			prepareCorners(SmallMaskCorners, st::buttonRadius, QColor(255, 255, 255), nullptr, mask);
+			for (int i = 0; i < 4; ++i) {
+				::cornersMaskSmall[i] = new QImage(mask[i].convertToFormat(QImage::Format_ARGB32_Premultiplied));
+				::cornersMaskSmall[i]->setDevicePixelRatio(cRetinaFactor());
+			}
 		}
 		prepareCorners(MenuCorners, st::buttonRadius, st::menuBg);
 		prepareCorners(BoxCorners, st::boxRadius, st::boxBg);
@@ -2279,32 +2363,25 @@ namespace {
 			::monofont = style::font(st::normalFont->f.pixelSize(), 0, family);
 		}
 		emojiInit();
-		if (!::emoji) {
-			::emoji = new QPixmap(QLatin1String(EName));
-            if (cRetina()) ::emoji->setDevicePixelRatio(cRetinaFactor());
-		}
-		if (!::emojiLarge) {
-			::emojiLarge = new QPixmap(QLatin1String(EmojiNames[EIndex + 1]));
-			if (cRetina()) ::emojiLarge->setDevicePixelRatio(cRetinaFactor());
-		}
+		emojiSprite.init(QLatin1String(EName), ESize);
+		emojiLargeSprite.init(QLatin1String(EmojiNames[EIndex + 1]), EmojiSizes[EIndex + 1]);
 
 		createCorners();
 
 		using Update = Window::Theme::BackgroundUpdate;
 		static auto subscription = Window::Theme::Background()->add_subscription([](const Update &update) {
 			if (update.paletteChanged()) {
-				clearCorners();
 				createCorners();
+				if (Window::Theme::Background()->paletteColorChanged(st::historyPeerUserpicFg)) {
+					// The letter avatars are found by their background color value.
+					Data::clearUserpics();
+				}
 
 				if (App::main()) {
 					App::main()->updateScrollColors();
 				}
 				HistoryLayout::serviceColorsUpdated();
 			} else if (update.type == Update::Type::New) {
-				for (int i = 0; i < 4; ++i) {
-					delete ::corners[StickerCorners].p[i]; ::corners[StickerCorners].p[i] = nullptr;
-					delete ::corners[StickerSelectedCorners].p[i]; ::corners[StickerSelectedCorners].p[i] = nullptr;
-				}
 				prepareCorners(StickerCorners, st::dateRadius, st::msgServiceBg);
 				prepareCorners(StickerSelectedCorners, st::dateRadius, st::msgServiceBgSelected);
 
@@ -2329,10 +2406,9 @@ namespace {
 	}
 
 	void deinitMedia() {
-		delete ::emoji;
-		::emoji = nullptr;
-		delete ::emojiLarge;
-		::emojiLarge = nullptr;
+		emojiSprite.clear();
+		emojiLargeSprite.clear();
+		delete base::take(emojiSpriteSourceReleaseTimer);
 
 		clearCorners();
 
@@ -2340,6 +2416,7 @@ namespace {
 		otherEmojiMap.clear();
 
 		Data::clearGlobalStructures();
+		Data::clearUserpics();
 
 		clearAllImages();
 	}
@@ -2405,12 +2482,12 @@ namespace {
 		return ::monofont;
 	}
 
-	const QPixmap &emoji() {
-		return *::emoji;
+	const QPixmap &emoji(EmojiPtr emoji) {
+		return emojiSprite.tile(emoji);
 	}
 
-	const QPixmap &emojiLarge() {
-		return *::emojiLarge;
+	const QPixmap &emojiLarge(EmojiPtr emoji) {
+		return emojiLargeSprite.tile(emoji);
 	}
 
 	const QPixmap &emojiSingle(EmojiPtr emoji, int32 fontHeight) {
@@ -212,8 +212,9 @@ namespace App {
 	void clearMousedItems();
 
 	const style::font &monofont();
-	const QPixmap &emoji();
-	const QPixmap &emojiLarge();
+	// Row tiles of the emoji sprites, the emoji is at QRect(emoji->x * size, 0, size, size).
+	const QPixmap &emoji(EmojiPtr emoji);
+	const QPixmap &emojiLarge(EmojiPtr emoji);
 	const QPixmap &emojiSingle(EmojiPtr emoji, int32 fontHeight);
 
 	void clearHistories();
@@ -30,6 +30,7 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include "ui/filedialog.h"
 #include "ui/widgets/tooltip.h"
 #include "langloaderplain.h"
+#include "langloaderpack.h"
 #include "localstorage.h"
 #include "autoupdater.h"
 #include "core/observer.h"
@@ -39,6 +40,7 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include "window/notifications_manager.h"
 #include "history/history_location_manager.h"
 #include "core/task_queue.h"
+#include "mtproto/connection_pool.h"
 
 namespace {
 
@@ -378,19 +380,24 @@ void Application::updateGotCurrent() {
 	if (!_updateReply || _updateThread) return;
 
 	cSetLastUpdateCheck(unixtime());
-	QRegularExpressionMatch m = QRegularExpression(qsl("^\\s*(\\d+)\\s*:\\s*([\\x21-\\x7f]+)\\s*$")).match(QString::fromLatin1(_updateReply->readAll()));
+	// The delta package url follows the full package url if the server has
+	// a binary diff from the version we've sent in the request.
+	QRegularExpressionMatch m = QRegularExpression(qsl("^\\s*(\\d+)\\s*:\\s*([\\x21-\\x7f]+)(\\s+([\\x21-\\x7f]+))?\\s*$")).match(QString::fromLatin1(_updateReply->readAll()));
 	if (m.hasMatch()) {
 		uint64 currentVersion = m.captured(1).toULongLong();
-		QString url = m.captured(2);
+		QString url = m.captured(2), deltaUrl = m.captured(4);
 		bool betaVersion = false;
 		if (url.startsWith(qstr("beta_"))) {
 			betaVersion = true;
 			url = url.mid(5) + '_' + countBetaVersionSignature(currentVersion);
+			if (deltaUrl.startsWith(qstr("beta_"))) {
+				deltaUrl = deltaUrl.mid(5) + '_' + countBetaVersionSignature(currentVersion);
+			}
 		}
 		if ((!betaVersion || cBetaVersion()) && currentVersion > (betaVersion ? cBetaVersion() : uint64(AppVersion))) {
 			_updateThread = new QThread();
 			connect(_updateThread, SIGNAL(finished()), _updateThread, SLOT(deleteLater()));
-			_updateChecker = new UpdateChecker(_updateThread, url);
+			_updateChecker = new UpdateChecker(_updateThread, url, deltaUrl);
 			_updateThread->start();
 		}
 	}
@@ -401,7 +408,7 @@ void Application::updateGotCurrent() {
 		if (updates.exists()) {
 			QFileInfoList list = updates.entryInfoList(QDir::Files);
 			for (QFileInfoList::iterator i = list.begin(), e = list.end(); i != e; ++i) {
-                if (QRegularExpression("^(tupdate|tmacupd|tmac32upd|tlinuxupd|tlinux32upd)\\d+(_[a-z\\d]+)?$", QRegularExpression::CaseInsensitiveOption).match(i->fileName()).hasMatch()) {
+                if (QRegularExpression("^(tupdate|tmacupd|tmac32upd|tlinuxupd|tlinux32upd)\\d+(d\\d+)?(_[a-z\\d]+)?$", QRegularExpression::CaseInsensitiveOption).match(i->fileName()).hasMatch()) {
 					QFile(i->absoluteFilePath()).remove();
 				}
 			}
@@ -488,7 +495,7 @@ void Application::startUpdateCheck(bool forceWait) {
 		if (updates.exists()) {
 			QFileInfoList list = updates.entryInfoList(QDir::Files);
 			for (QFileInfoList::iterator i = list.begin(), e = list.end(); i != e; ++i) {
-				if (QRegularExpression("^(tupdate|tmacupd|tmac32upd|tlinuxupd|tlinux32upd)\\d+(_[a-z\\d]+)?$", QRegularExpression::CaseInsensitiveOption).match(i->fileName()).hasMatch()) {
+				if (QRegularExpression("^(tupdate|tmacupd|tmac32upd|tlinuxupd|tlinux32upd)\\d+(d\\d+)?(_[a-z\\d]+)?$", QRegularExpression::CaseInsensitiveOption).match(i->fileName()).hasMatch()) {
 					sendRequest = true;
 				}
 			}
@@ -499,11 +506,11 @@ void Application::startUpdateCheck(bool forceWait) {
 	if (sendRequest) {
 		QUrl url(cUpdateURL());
 		if (cBetaVersion()) {
-			url.setQuery(qsl("version=%1&beta=%2").arg(AppVersion).arg(cBetaVersion()));
+			url.setQuery(qsl("version=%1&beta=%2&delta=1").arg(AppVersion).arg(cBetaVersion()));
 		} else if (cAlphaVersion()) {
-			url.setQuery(qsl("version=%1&alpha=1").arg(AppVersion));
+			url.setQuery(qsl("version=%1&alpha=1&delta=1").arg(AppVersion));
 		} else {
-			url.setQuery(qsl("version=%1").arg(AppVersion));
+			url.setQuery(qsl("version=%1&delta=1").arg(AppVersion));
 		}
 		QString u = url.toString();
 		QNetworkRequest checkVersion(url);
@@ -790,28 +797,46 @@ AppClass::AppClass() : QObject() {
 }
 
 void AppClass::loadLanguage() {
+	auto started = getms();
 	if (cLang() < languageTest) {
 		cSetLang(Sandbox::LangSystem());
 	}
 	if (cLang() == languageTest) {
 		if (QFileInfo(cLangFile()).exists()) {
-			LangLoaderPlain loader(cLangFile());
-			cSetLangErrors(loader.errors());
+			auto warnings = QString();
+			cSetLangErrors(LangLoaderPack::loadCustom(cLangFile(), &warnings));
 			if (!cLangErrors().isEmpty()) {
 				LOG(("Lang load errors: %1").arg(cLangErrors()));
-			} else if (!loader.warnings().isEmpty()) {
-				LOG(("Lang load warnings: %1").arg(loader.warnings()));
+			} else if (!warnings.isEmpty()) {
+				LOG(("Lang load warnings: %1").arg(warnings));
 			}
 		} else {
 			cSetLang(languageDefault);
 		}
 	} else if (cLang() > languageDefault && cLang() < languageCount) {
-		LangLoaderPlain loader(qsl(":/langs/lang_") + LanguageCodes[cLang()].c_str() + qsl(".strings"));
-		if (!loader.errors().isEmpty()) {
-			LOG(("Lang load errors: %1").arg(loader.errors()));
-		} else if (!loader.warnings().isEmpty()) {
-			LOG(("Lang load warnings: %1").arg(loader.warnings()));
+		LangLoaderPack pack(langBuiltInPack(LanguageCodes[cLang()].c_str()));
+		if (pack.errors().isEmpty()) {
+			if (!pack.warnings().isEmpty()) {
+				LOG(("Lang load warnings: %1").arg(pack.warnings()));
+			}
+		} else {
+			DEBUG_LOG(("Lang Info: built-in pack skipped, %1").arg(pack.errors()));
+
+			LangLoaderPlain loader(qsl(":/langs/lang_") + LanguageCodes[cLang()].c_str() + qsl(".strings"));
+			if (!loader.errors().isEmpty()) {
+				LOG(("Lang load errors: %1").arg(loader.errors()));
+			} else if (!loader.warnings().isEmpty()) {
+				LOG(("Lang load warnings: %1").arg(loader.warnings()));
+			}
+		}
+	}
+	if (cDebug()) {
+		// Values from the packs and the built-in ones don't own their characters.
+		auto heapSize = int64(0);
+		for (auto i = 0; i != lngkeys_cnt; ++i) {
+			heapSize += lang(LangKey(i)).capacity() * sizeof(QChar);
 		}
+		DEBUG_LOG(("Lang Info: language %1 loaded in %2ms, %3 bytes of strings allocated").arg(cLang()).arg(getms() - started).arg(heapSize));
 	}
 	application()->installTranslator(_translator = new Translator());
 }
@@ -949,9 +974,10 @@ void AppClass::killDownloadSessions() {
 	auto ms = getms(), left = static_cast<TimeMs>(MTPAckSendWaiting) + MTPKillFileSessionTimeout;
 	for (auto i = killDownloadSessionTimes.begin(); i != killDownloadSessionTimes.end(); ) {
 		if (i.value() <= ms) {
-			for (int j = 0; j < MTPDownloadSessionsCount; ++j) {
+			for (int j = 0; j < MTPDownloadSessionsMax; ++j) {
 				MTP::stopSession(MTP::dldDcId(i.key(), j));
 			}
+			MTP::poolSessionsKilled(MTP::PoolPurpose::Download, i.key());
 			i = killDownloadSessionTimes.erase(i);
 		} else {
 			if (i.value() - ms < left) {
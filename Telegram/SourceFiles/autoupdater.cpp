@@ -27,9 +27,11 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include <openssl/pem.h>
 #include <openssl/bio.h>
 #include <openssl/err.h>
+#include <openssl/sha.h>
 
 #ifdef Q_OS_WIN // use Lzma SDK for win
 #include <LzmaLib.h>
+#include <LzmaDec.h>
 #else // Q_OS_WIN
 #include <lzma.h>
 #endif // else of Q_OS_WIN
@@ -47,8 +49,495 @@ typedef int VerInt;
 typedef wchar_t VerChar;
 #endif // Q_OS_WIN
 
-UpdateChecker::UpdateChecker(QThread *thread, const QString &url) : reply(0), already(0), full(0) {
-	updateUrl = url;
+namespace {
+
+#ifdef Q_OS_WIN // use Lzma SDK for win
+constexpr auto kSigLen = 128, kShaLen = 20, kPropsLen = LZMA_PROPS_SIZE, kOriginalSizeLen = int(sizeof(int32));
+#else // Q_OS_WIN
+constexpr auto kSigLen = 128, kShaLen = 20, kPropsLen = 0, kOriginalSizeLen = int(sizeof(int32));
+#endif // Q_OS_WIN
+constexpr auto kHeaderSize = kSigLen + kShaLen + kPropsLen + kOriginalSizeLen;
+
+constexpr auto kUnpackChunk = 256 * 1024;
+
+// Delta packages start with this instead of the version and contain
+// binary diffs against the files of the installed version.
+constexpr auto kDeltaPackageMagic = quint32(0x7FFFFFFE);
+
+enum DeltaFileMode : quint8 {
+	DeltaFileFull = 0x00,
+	DeltaFilePatch = 0x01,
+};
+
+enum DeltaPatchCommand : quint8 {
+	DeltaPatchEnd = 0x00,
+	DeltaPatchCopy = 0x01, // Copy a range of the installed file.
+	DeltaPatchInsert = 0x02, // Insert the bytes from the package.
+};
+
+#ifdef Q_OS_WIN
+void *LzmaAlloc(void *p, size_t size) {
+	return malloc(size);
+}
+
+void LzmaFree(void *p, void *address) {
+	free(address);
+}
+
+ISzAlloc LzmaAllocator = { LzmaAlloc, LzmaFree };
+#endif // Q_OS_WIN
+
+// Decodes the packed part of the update file on demand, so that the
+// unpacked files are written to disk without holding them in memory.
+// The bytes read from disk are hashed once again, because the file could
+// be changed after the downloaded data was checked by the verifier.
+class UpdatePackageReader : public QIODevice {
+public:
+	UpdatePackageReader(QFile &file, const QByteArray &header, int32 size);
+
+	bool isSequential() const override {
+		return true;
+	}
+	int64 decoded() const {
+		return _decoded;
+	}
+
+	// Hashes the rest of the file and checks it against the header.
+	bool verifyReadData();
+
+	~UpdatePackageReader();
+
+protected:
+	qint64 readData(char *data, qint64 maxlen) override;
+	qint64 writeData(const char *data, qint64 len) override {
+		return -1;
+	}
+
+private:
+	bool readInput();
+	bool decode(char *data, qint64 maxlen, qint64 *written);
+
+	QFile &_file;
+	QByteArray _sha1;
+	SHA_CTX _sha;
+	int64 _size = 0;
+	int64 _decoded = 0;
+	QByteArray _input;
+	int _inputOffset = 0;
+	bool _inputFinished = false;
+	bool _streamEnded = false;
+	bool _failed = false;
+
+#ifdef Q_OS_WIN
+	CLzmaDec _decoder;
+	bool _decoderAllocated = false;
+#else // Q_OS_WIN
+	lzma_stream _stream = LZMA_STREAM_INIT;
+	bool _streamInited = false;
+#endif // Q_OS_WIN
+
+};
+
+UpdatePackageReader::UpdatePackageReader(QFile &file, const QByteArray &header, int32 size) : _file(file)
+, _sha1(header.mid(kSigLen, kShaLen))
+, _size(size) {
+	// The signature and the hash itself are not hashed.
+	SHA1_Init(&_sha);
+	SHA1_Update(&_sha, header.constData() + kSigLen + kShaLen, header.size() - kSigLen - kShaLen);
+
+	auto props = header.mid(kSigLen + kShaLen, kPropsLen);
+#ifdef Q_OS_WIN
+	LzmaDec_Construct(&_decoder);
+	auto res = LzmaDec_Allocate(&_decoder, (const Byte*)props.constData(), props.size(), &LzmaAllocator);
+	if (res != SZ_OK) {
+		LOG(("Update Error: could not initialize lzma decoder, code: %1").arg(res));
+		_failed = true;
+		return;
+	}
+	_decoderAllocated = true;
+	LzmaDec_Init(&_decoder);
+#else // Q_OS_WIN
+	auto ret = lzma_stream_decoder(&_stream, UINT64_MAX, LZMA_CONCATENATED);
+	if (ret != LZMA_OK) {
+		const char *msg;
+		switch (ret) {
+		case LZMA_MEM_ERROR: msg = "Memory allocation failed"; break;
+		case LZMA_OPTIONS_ERROR: msg = "Specified preset is not supported"; break;
+		case LZMA_UNSUPPORTED_CHECK: msg = "Specified integrity check is not supported"; break;
+		default: msg = "Unknown error, possibly a bug"; break;
+		}
+		LOG(("Error initializing the decoder: %1 (error code %2)").arg(msg).arg(ret));
+		_failed = true;
+		return;
+	}
+	_streamInited = true;
+#endif // Q_OS_WIN
+	open(QIODevice::ReadOnly);
+}
+
+qint64 UpdatePackageReader::readData(char *data, qint64 maxlen) {
+	if (_failed) return -1;
+
+	// QDataStream treats a short read as the end of the stream,
+	// so we decode until the whole requested block is ready.
+	auto result = qint64(0);
+	maxlen = qMin(maxlen, _size - _decoded);
+	while (result < maxlen) {
+		if (_inputOffset == _input.size() && !_inputFinished && !readInput()) {
+			_failed = true;
+			return -1;
+		}
+		auto written = qint64(0);
+		if (!decode(data + result, maxlen - result, &written)) {
+			_failed = true;
+			return -1;
+		}
+		if (!written && (_streamEnded || (_inputFinished && _inputOffset == _input.size()))) {
+			LOG(("Update Error: packed data is truncated, decoded %1 of %2").arg(_decoded + result).arg(_size));
+			_failed = true;
+			return -1;
+		}
+		result += written;
+	}
+	_decoded += result;
+	return result;
+}
+
+bool UpdatePackageReader::readInput() {
+	_input = _file.read(kUnpackChunk);
+	_inputOffset = 0;
+	if (_file.error() != QFileDevice::NoError) {
+		LOG(("Update Error: cant read updates file, error %1").arg(_file.error()));
+		return false;
+	}
+	SHA1_Update(&_sha, _input.constData(), _input.size());
+	_inputFinished = _file.atEnd();
+	return true;
+}
+
+bool UpdatePackageReader::verifyReadData() {
+	while (!_file.atEnd()) {
+		auto part = _file.read(kUnpackChunk);
+		if (part.isEmpty()) {
+			LOG(("Update Error: cant read updates file, error %1").arg(_file.error()));
+			return false;
+		}
+		SHA1_Update(&_sha, part.constData(), part.size());
+	}
+	auto result = QByteArray(kShaLen, Qt::Uninitialized);
+	SHA1_Final((uchar*)result.data(), &_sha);
+	if (result != _sha1) {
+		LOG(("Update Error: updates file was changed after it was verified!"));
+		return false;
+	}
+	return true;
+}
+
+bool UpdatePackageReader::decode(char *data, qint64 maxlen, qint64 *written) {
+#ifdef Q_OS_WIN
+	auto destLen = SizeT(maxlen);
+	auto srcLen = SizeT(_input.size() - _inputOffset);
+	auto status = LZMA_STATUS_NOT_SPECIFIED;
+	auto res = LzmaDec_DecodeToBuf(&_decoder, (Byte*)data, &destLen, (const Byte*)(_input.constData() + _inputOffset), &srcLen, LZMA_FINISH_ANY, &status);
+	if (res != SZ_OK) {
+		LOG(("Update Error: could not uncompress lzma, code: %1").arg(res));
+		return false;
+	}
+	_inputOffset += int(srcLen);
+	_streamEnded = (status == LZMA_STATUS_FINISHED_WITH_MARK);
+	*written = qint64(destLen);
+#else // Q_OS_WIN
+	_stream.next_in = (const uint8_t*)(_input.constData() + _inputOffset);
+	_stream.avail_in = _input.size() - _inputOffset;
+	_stream.next_out = (uint8_t*)data;
+	_stream.avail_out = size_t(maxlen);
+
+	auto res = lzma_code(&_stream, _inputFinished ? LZMA_FINISH : LZMA_RUN);
+	_inputOffset = _input.size() - int(_stream.avail_in);
+	*written = maxlen - qint64(_stream.avail_out);
+	if (res == LZMA_STREAM_END) {
+		_streamEnded = true;
+	} else if (res != LZMA_OK && res != LZMA_BUF_ERROR) { // LZMA_BUF_ERROR means no progress was possible.
+		const char *msg;
+		switch (res) {
+		case LZMA_MEM_ERROR: msg = "Memory allocation failed"; break;
+		case LZMA_FORMAT_ERROR: msg = "The input data is not in the .xz format"; break;
+		case LZMA_OPTIONS_ERROR: msg = "Unsupported compression options"; break;
+		case LZMA_DATA_ERROR: msg = "Compressed file is corrupt"; break;
+		default: msg = "Unknown error, possibly a bug"; break;
+		}
+		LOG(("Error in decompression: %1 (error code %2)").arg(msg).arg(res));
+		return false;
+	}
+#endif // Q_OS_WIN
+	return true;
+}
+
+UpdatePackageReader::~UpdatePackageReader() {
+#ifdef Q_OS_WIN
+	if (_decoderAllocated) {
+		LzmaDec_Free(&_decoder, &LzmaAllocator);
+	}
+#else // Q_OS_WIN
+	if (_streamInited) {
+		lzma_end(&_stream);
+	}
+#endif // Q_OS_WIN
+}
+
+QString InstalledFilePath(const QString &relativeName) {
+#ifdef Q_OS_MAC
+	// The bundle could be renamed after it was installed.
+	auto bundle = qsl("Telegram.app/");
+	if (relativeName.startsWith(bundle)) {
+		return cExeDir() + cExeName() + '/' + relativeName.mid(bundle.size());
+	}
+#endif // Q_OS_MAC
+	return cExeDir() + relativeName;
+}
+
+QByteArray CountFileSha1(QFile &file) {
+	SHA_CTX sha;
+	SHA1_Init(&sha);
+	while (!file.atEnd()) {
+		auto part = file.read(kUnpackChunk);
+		if (part.isEmpty()) {
+			return QByteArray();
+		}
+		SHA1_Update(&sha, part.constData(), part.size());
+	}
+	auto result = QByteArray(kShaLen, Qt::Uninitialized);
+	SHA1_Final((uchar*)result.data(), &sha);
+	return result;
+}
+
+bool WriteFromStream(QDataStream &stream, QFile &to, quint32 size, SHA_CTX *sha) {
+	auto buffer = QByteArray(qMin(int(size), kUnpackChunk), Qt::Uninitialized);
+	while (size > 0) {
+		auto part = int(qMin(size, quint32(buffer.size())));
+		if (stream.readRawData(buffer.data(), part) != part) {
+			LOG(("Update Error: cant read file data from downloaded stream, status: %1").arg(stream.status()));
+			return false;
+		}
+		if (sha) SHA1_Update(sha, buffer.constData(), part);
+		if (to.write(buffer.constData(), part) != part) {
+			LOG(("Update Error: cant write file '%1'").arg(to.fileName()));
+			return false;
+		}
+		size -= part;
+	}
+	return true;
+}
+
+bool WriteFromFile(QFile &from, quint32 offset, QFile &to, quint32 size, SHA_CTX *sha) {
+	if (quint64(offset) + size > quint64(from.size()) || !from.seek(offset)) {
+		LOG(("Update Error: bad range %1 - %2 of installed file '%3'").arg(offset).arg(offset + size).arg(from.fileName()));
+		return false;
+	}
+	while (size > 0) {
+		auto part = from.read(qMin(size, quint32(kUnpackChunk)));
+		if (part.isEmpty()) {
+			LOG(("Update Error: cant read installed file '%1'").arg(from.fileName()));
+			return false;
+		}
+		SHA1_Update(sha, part.constData(), part.size());
+		if (to.write(part) != part.size()) {
+			LOG(("Update Error: cant write file '%1'").arg(to.fileName()));
+			return false;
+		}
+		size -= part.size();
+	}
+	return true;
+}
+
+bool WriteFullFile(QDataStream &stream, QFile &to) {
+	quint32 fileSize = 0, dataSize = 0;
+	stream >> fileSize >> dataSize; // QByteArray is serialized as its size and contents.
+	if (stream.status() != QDataStream::Ok) {
+		LOG(("Update Error: cant read file from downloaded stream, status: %1").arg(stream.status()));
+		return false;
+	}
+	if (dataSize == 0xFFFFFFFFU) { // null QByteArray
+		dataSize = 0;
+	}
+	if (fileSize != dataSize) {
+		LOG(("Update Error: bad file size %1 not matching data size %2").arg(fileSize).arg(dataSize));
+		return false;
+	}
+	return WriteFromStream(stream, to, dataSize, nullptr);
+}
+
+// Applies the diff against the installed file, baseMismatch is set if the
+// installed file is not the one the delta package was made for.
+bool WritePatchedFile(QDataStream &stream, const QString &relativeName, QFile &to, bool *baseMismatch) {
+	quint32 resultSize = 0;
+	auto baseSha = QByteArray(kShaLen, Qt::Uninitialized), resultSha = QByteArray(kShaLen, Qt::Uninitialized);
+	stream >> resultSize;
+	if (stream.readRawData(baseSha.data(), kShaLen) != kShaLen || stream.readRawData(resultSha.data(), kShaLen) != kShaLen) {
+		LOG(("Update Error: cant read patch header from downloaded stream, status: %1").arg(stream.status()));
+		return false;
+	}
+
+	QFile base(InstalledFilePath(relativeName));
+	if (!base.open(QIODevice::ReadOnly)) {
+		LOG(("Update Error: cant open installed file '%1' to apply the delta").arg(base.fileName()));
+		*baseMismatch = true;
+		return false;
+	}
+	if (CountFileSha1(base) != baseSha) {
+		LOG(("Update Error: installed file '%1' does not match the delta").arg(base.fileName()));
+		*baseMismatch = true;
+		return false;
+	}
+
+	SHA_CTX sha;
+	SHA1_Init(&sha);
+	auto written = quint64(0);
+	while (true) {
+		quint8 command = DeltaPatchEnd;
+		quint32 offset = 0, length = 0;
+		stream >> command;
+		if (command == DeltaPatchEnd) {
+			break;
+		} else if (command == DeltaPatchCopy) {
+			stream >> offset >> length;
+		} else if (command == DeltaPatchInsert) {
+			stream >> length;
+		}
+		if (stream.status() != QDataStream::Ok) {
+			LOG(("Update Error: cant read patch command from downloaded stream, status: %1").arg(stream.status()));
+			return false;
+		}
+		written += length;
+		if (written > resultSize) {
+			LOG(("Update Error: patch for '%1' exceeds the file size %2").arg(relativeName).arg(resultSize));
+			return false;
+		}
+		if (command == DeltaPatchCopy) {
+			if (!WriteFromFile(base, offset, to, length, &sha)) {
+				return false;
+			}
+		} else if (command == DeltaPatchInsert) {
+			if (!WriteFromStream(stream, to, length, &sha)) {
+				return false;
+			}
+		} else {
+			LOG(("Update Error: bad patch command %1 for '%2'").arg(command).arg(relativeName));
+			return false;
+		}
+	}
+	if (stream.status() != QDataStream::Ok) {
+		LOG(("Update Error: cant read patch end from downloaded stream, status: %1").arg(stream.status()));
+		return false;
+	}
+
+	auto result = QByteArray(kShaLen, Qt::Uninitialized);
+	SHA1_Final((uchar*)result.data(), &sha);
+	if (written != resultSize || result != resultSha) {
+		LOG(("Update Error: patched file '%1' has bad size %2 (expected %3) or hash").arg(relativeName).arg(written).arg(resultSize));
+		return false;
+	}
+	return true;
+}
+
+} // namespace
+
+// Counts the SHA1 of the package while it is being downloaded, so that
+// the signature is checked without reading the whole file once again.
+class UpdatePackageVerifier {
+public:
+	UpdatePackageVerifier() {
+		SHA1_Init(&_sha);
+	}
+
+	void feed(const char *data, int64 size);
+	bool feed(QFile &file);
+	bool verify();
+
+	const QByteArray &header() const {
+		return _header;
+	}
+	int32 originalSize() const {
+		int32 result = 0;
+		memcpy(&result, _header.constData() + kSigLen + kShaLen + kPropsLen, kOriginalSizeLen);
+		return result;
+	}
+
+private:
+	bool verifySignature(const char *key);
+
+	SHA_CTX _sha;
+	int64 _position = 0;
+	QByteArray _header;
+
+};
+
+void UpdatePackageVerifier::feed(const char *data, int64 size) {
+	if (_header.size() < kHeaderSize) {
+		_header.append(data, int(qMin(size, int64(kHeaderSize - _header.size()))));
+	}
+
+	// The signature and the hash itself are not hashed.
+	auto skip = qMax(int64(kSigLen + kShaLen) - _position, int64(0));
+	if (skip < size) {
+		SHA1_Update(&_sha, data + skip, size_t(size - skip));
+	}
+	_position += size;
+}
+
+bool UpdatePackageVerifier::feed(QFile &file) {
+	if (!file.open(QIODevice::ReadOnly)) {
+		return false;
+	}
+	while (!file.atEnd()) {
+		auto part = file.read(kUnpackChunk);
+		if (part.isEmpty()) {
+			file.close();
+			return false;
+		}
+		feed(part.constData(), part.size());
+	}
+	file.close();
+	return true;
+}
+
+bool UpdatePackageVerifier::verify() {
+	if (_header.size() < kHeaderSize || _position <= kHeaderSize) {
+		LOG(("Update Error: bad compressed size: %1").arg(_position));
+		return false;
+	}
+
+	uchar sha1Buffer[kShaLen];
+	SHA1_Final(sha1Buffer, &_sha);
+	if (memcmp(_header.constData() + kSigLen, sha1Buffer, kShaLen)) {
+		LOG(("Update Error: bad SHA1 hash of update file!"));
+		return false;
+	}
+
+	if (!verifySignature(AppAlphaVersion ? UpdatesPublicAlphaKey : UpdatesPublicKey)) {
+		// try other public key, if we are in alpha or beta version
+		if (!(cAlphaVersion() || cBetaVersion()) || !verifySignature(AppAlphaVersion ? UpdatesPublicKey : UpdatesPublicAlphaKey)) {
+			LOG(("Update Error: bad RSA signature of update file!"));
+			return false;
+		}
+	}
+	return true;
+}
+
+bool UpdatePackageVerifier::verifySignature(const char *key) {
+	RSA *pbKey = PEM_read_bio_RSAPublicKey(BIO_new_mem_buf(const_cast<char*>(key), -1), 0, 0, 0);
+	if (!pbKey) {
+		LOG(("Update Error: cant read public rsa key!"));
+		return false;
+	}
+	auto result = (RSA_verify(NID_sha1, (const uchar*)(_header.constData() + kSigLen), kShaLen, (const uchar*)(_header.constData()), kSigLen, pbKey) == 1); // verify signature
+	RSA_free(pbKey);
+	return result;
+}
+
+UpdateChecker::UpdateChecker(QThread *thread, const QString &url, const QString &deltaUrl) : reply(0), already(0), full(0) {
+	updateUrl = deltaUrl.isEmpty() ? url : deltaUrl;
+	fullUrl = url;
 	moveToThread(thread);
 	manager.moveToThread(thread);
 	App::setProxySettings(manager);
@@ -82,30 +571,28 @@ void UpdateChecker::initOutput() {
 		dir.mkdir(dir.absolutePath());
 	}
 	outputFile.setFileName(fileName);
+	verifier = std_::make_unique<UpdatePackageVerifier>();
 	if (file.exists()) {
 		uint64 fullSize = file.size();
 		if (fullSize < INT_MAX) {
 			int32 goodSize = (int32)fullSize;
 			if (goodSize % UpdateChunk) {
 				goodSize = goodSize - (goodSize % UpdateChunk);
-				if (goodSize) {
-					if (outputFile.open(QIODevice::ReadOnly)) {
-						QByteArray goodData = outputFile.readAll().mid(0, goodSize);
-						outputFile.close();
-						if (outputFile.open(QIODevice::WriteOnly)) {
-							outputFile.write(goodData);
-							outputFile.close();
-
-							QMutexLocker lock(&mutex);
-							already = goodSize;
-						}
-					}
+				if (goodSize && outputFile.resize(goodSize)) {
+					QMutexLocker lock(&mutex);
+					already = goodSize;
 				}
 			} else {
 				QMutexLocker lock(&mutex);
 				already = goodSize;
 			}
 		}
+		if (already && !verifier->feed(outputFile)) {
+			verifier = std_::make_unique<UpdatePackageVerifier>();
+
+			QMutexLocker lock(&mutex);
+			already = 0;
+		}
 		if (!already) {
 			QFile::remove(fileName);
 		}
@@ -182,7 +669,11 @@ void UpdateChecker::partFinished(qint64 got, qint64 total) {
 	}
 	QByteArray r = reply->readAll();
 	if (!r.isEmpty()) {
-		outputFile.write(r);
+		if (outputFile.write(r) != r.size()) {
+			LOG(("Update Error: Could not write %1 bytes to output file '%2'").arg(r.size()).arg(outputFile.fileName()));
+			return fatalFail();
+		}
+		verifier->feed(r.constData(), r.size());
 
 		QMutexLocker lock(&mutex);
 		already += r.size();
@@ -215,6 +706,23 @@ void UpdateChecker::partFailed(QNetworkReply::NetworkError e) {
 	Sandbox::updateFailed();
 }
 
+void UpdateChecker::deltaFail() {
+	if (updateUrl == fullUrl) {
+		return fatalFail();
+	}
+	LOG(("Update Info: could not apply the delta package, downloading the full one."));
+
+	psDeleteDir(cWorkingDir() + qsl("tupdates/temp"));
+	outputFile.remove();
+	updateUrl = fullUrl;
+	{
+		QMutexLocker lock(&mutex);
+		already = full = 0;
+	}
+	initOutput();
+	sendRequest();
+}
+
 void UpdateChecker::fatalFail() {
 	clearAll();
 	Sandbox::updateFailed();
@@ -240,25 +748,9 @@ void UpdateChecker::clearAll() {
 //}
 
 void UpdateChecker::unpackUpdate() {
-	QByteArray packed;
-	if (!outputFile.open(QIODevice::ReadOnly)) {
-		LOG(("Update Error: cant read updates file!"));
-		return fatalFail();
-	}
-
-#ifdef Q_OS_WIN // use Lzma SDK for win
-	const int32 hSigLen = 128, hShaLen = 20, hPropsLen = LZMA_PROPS_SIZE, hOriginalSizeLen = sizeof(int32), hSize = hSigLen + hShaLen + hPropsLen + hOriginalSizeLen; // header
-#else // Q_OS_WIN
-	const int32 hSigLen = 128, hShaLen = 20, hPropsLen = 0, hOriginalSizeLen = sizeof(int32), hSize = hSigLen + hShaLen + hOriginalSizeLen; // header
-#endif // Q_OS_WIN
-
-	QByteArray compressed = outputFile.readAll();
-	int32 compressedLen = compressed.size() - hSize;
-	if (compressedLen <= 0) {
-		LOG(("Update Error: bad compressed size: %1").arg(compressed.size()));
+	if (!verifier->verify()) {
 		return fatalFail();
 	}
-	outputFile.close();
 
 	QString tempDirPath = cWorkingDir() + qsl("tupdates/temp"), readyFilePath = cWorkingDir() + qsl("tupdates/temp/ready");
 	psDeleteDir(tempDirPath);
@@ -269,110 +761,81 @@ void UpdateChecker::unpackUpdate() {
 		return fatalFail();
 	}
 
-	uchar sha1Buffer[20];
-	bool goodSha1 = !memcmp(compressed.constData() + hSigLen, hashSha1(compressed.constData() + hSigLen + hShaLen, compressedLen + hPropsLen + hOriginalSizeLen, sha1Buffer), hShaLen);
-	if (!goodSha1) {
-		LOG(("Update Error: bad SHA1 hash of update file!"));
-		return fatalFail();
+	auto deltaFailed = false;
+	if (!unpackFiles(&deltaFailed)) {
+		return deltaFailed ? deltaFail() : fatalFail();
 	}
 
-	RSA *pbKey = PEM_read_bio_RSAPublicKey(BIO_new_mem_buf(const_cast<char*>(AppAlphaVersion ? UpdatesPublicAlphaKey : UpdatesPublicKey), -1), 0, 0, 0);
-	if (!pbKey) {
-		LOG(("Update Error: cant read public rsa key!"));
-		return fatalFail();
-	}
-	if (RSA_verify(NID_sha1, (const uchar*)(compressed.constData() + hSigLen), hShaLen, (const uchar*)(compressed.constData()), hSigLen, pbKey) != 1) { // verify signature
-		RSA_free(pbKey);
-		if (cAlphaVersion() || cBetaVersion()) { // try other public key, if we are in alpha or beta version
-			pbKey = PEM_read_bio_RSAPublicKey(BIO_new_mem_buf(const_cast<char*>(AppAlphaVersion ? UpdatesPublicKey : UpdatesPublicAlphaKey), -1), 0, 0, 0);
-			if (!pbKey) {
-				LOG(("Update Error: cant read public rsa key!"));
-				return fatalFail();
-			}
-			if (RSA_verify(NID_sha1, (const uchar*)(compressed.constData() + hSigLen), hShaLen, (const uchar*)(compressed.constData()), hSigLen, pbKey) != 1) { // verify signature
-				RSA_free(pbKey);
-				LOG(("Update Error: bad RSA signature of update file!"));
-				return fatalFail();
-			}
+	QFile readyFile(readyFilePath);
+	if (readyFile.open(QIODevice::WriteOnly)) {
+		if (readyFile.write("1", 1)) {
+			readyFile.close();
 		} else {
-			LOG(("Update Error: bad RSA signature of update file!"));
+			LOG(("Update Error: cant write ready file '%1'").arg(readyFilePath));
 			return fatalFail();
 		}
-	}
-	RSA_free(pbKey);
-
-	QByteArray uncompressed;
-
-	int32 uncompressedLen;
-	memcpy(&uncompressedLen, compressed.constData() + hSigLen + hShaLen + hPropsLen, hOriginalSizeLen);
-	uncompressed.resize(uncompressedLen);
-
-	size_t resultLen = uncompressed.size();
-#ifdef Q_OS_WIN // use Lzma SDK for win
-	SizeT srcLen = compressedLen;
-	int uncompressRes = LzmaUncompress((uchar*)uncompressed.data(), &resultLen, (const uchar*)(compressed.constData() + hSize), &srcLen, (const uchar*)(compressed.constData() + hSigLen + hShaLen), LZMA_PROPS_SIZE);
-	if (uncompressRes != SZ_OK) {
-		LOG(("Update Error: could not uncompress lzma, code: %1").arg(uncompressRes));
+	} else {
+		LOG(("Update Error: cant create ready file '%1'").arg(readyFilePath));
 		return fatalFail();
 	}
-#else // Q_OS_WIN
-	lzma_stream stream = LZMA_STREAM_INIT;
+	outputFile.remove();
 
-	lzma_ret ret = lzma_stream_decoder(&stream, UINT64_MAX, LZMA_CONCATENATED);
-	if (ret != LZMA_OK) {
-		const char *msg;
-		switch (ret) {
-		case LZMA_MEM_ERROR: msg = "Memory allocation failed"; break;
-		case LZMA_OPTIONS_ERROR: msg = "Specified preset is not supported"; break;
-		case LZMA_UNSUPPORTED_CHECK: msg = "Specified integrity check is not supported"; break;
-		default: msg = "Unknown error, possibly a bug"; break;
-		}
-		LOG(("Error initializing the decoder: %1 (error code %2)").arg(msg).arg(ret));
-		return fatalFail();
-	}
+	Sandbox::updateReady();
+}
 
-	stream.avail_in = compressedLen;
-	stream.next_in = (uint8_t*)(compressed.constData() + hSize);
-	stream.avail_out = resultLen;
-	stream.next_out = (uint8_t*)uncompressed.data();
+bool UpdateChecker::unpackFiles(bool *deltaFailed) {
+	QString tempDirPath = cWorkingDir() + qsl("tupdates/temp");
+	QDir tempDir(tempDirPath);
 
-	lzma_ret res = lzma_code(&stream, LZMA_FINISH);
-	if (stream.avail_in) {
-		LOG(("Error in decompression, %1 bytes left in _in of %2 whole.").arg(stream.avail_in).arg(compressedLen));
-		return fatalFail();
-	} else if (stream.avail_out) {
-		LOG(("Error in decompression, %1 bytes free left in _out of %2 whole.").arg(stream.avail_out).arg(resultLen));
-		return fatalFail();
+	auto uncompressedLen = verifier->originalSize();
+	if (uncompressedLen <= 0) {
+		LOG(("Update Error: bad uncompressed size: %1").arg(uncompressedLen));
+		return false;
 	}
-	lzma_end(&stream);
-	if (res != LZMA_OK && res != LZMA_STREAM_END) {
-		const char *msg;
-		switch (res) {
-		case LZMA_MEM_ERROR: msg = "Memory allocation failed"; break;
-		case LZMA_FORMAT_ERROR: msg = "The input data is not in the .xz format"; break;
-		case LZMA_OPTIONS_ERROR: msg = "Unsupported compression options"; break;
-		case LZMA_DATA_ERROR: msg = "Compressed file is corrupt"; break;
-		case LZMA_BUF_ERROR: msg = "Compressed data is truncated or otherwise corrupt"; break;
-		default: msg = "Unknown error, possibly a bug"; break;
-		}
-		LOG(("Error in decompression: %1 (error code %2)").arg(msg).arg(res));
-		return fatalFail();
+	if (!outputFile.open(QIODevice::ReadOnly)) {
+		LOG(("Update Error: cant read updates file!"));
+		return false;
 	}
-#endif // Q_OS_WIN
+	auto header = outputFile.read(kHeaderSize);
+	if (header != verifier->header()) {
+		LOG(("Update Error: updates file header was changed after it was verified!"));
+		outputFile.close();
+		return false;
+	}
+	UpdatePackageReader reader(outputFile, header, uncompressedLen);
+	auto result = [this, &reader](bool success) {
+		reader.close();
+		outputFile.close();
+		return success;
+	};
 
 	tempDir.mkdir(tempDir.absolutePath());
 
 	quint32 version;
 	{
-		QBuffer buffer(&uncompressed);
-		buffer.open(QIODevice::ReadOnly);
-		QDataStream stream(&buffer);
+		QDataStream stream(&reader);
 		stream.setVersion(QDataStream::Qt_5_1);
 
 		stream >> version;
 		if (stream.status() != QDataStream::Ok) {
 			LOG(("Update Error: cant read version from downloaded stream, status: %1").arg(stream.status()));
-			return fatalFail();
+			return result(false);
+		}
+
+		auto delta = (version == kDeltaPackageMagic);
+		if (delta) {
+			quint64 baseVersion = 0;
+			stream >> baseVersion >> version;
+			if (stream.status() != QDataStream::Ok) {
+				LOG(("Update Error: cant read delta base version from downloaded stream, status: %1").arg(stream.status()));
+				return result(false);
+			}
+			auto installedVersion = cBetaVersion() ? cBetaVersion() : quint64(AppVersion);
+			if (baseVersion != installedVersion) {
+				LOG(("Update Error: delta package is made for version %1, installed version is %2").arg(baseVersion).arg(installedVersion));
+				*deltaFailed = true;
+				return result(false);
+			}
 		}
 
 		quint64 betaVersion = 0;
@@ -380,67 +843,86 @@ void UpdateChecker::unpackUpdate() {
 			stream >> betaVersion;
 			if (stream.status() != QDataStream::Ok) {
 				LOG(("Update Error: cant read beta version from downloaded stream, status: %1").arg(stream.status()));
-				return fatalFail();
+				return result(false);
 			}
 			if (!cBetaVersion() || betaVersion <= cBetaVersion()) {
 				LOG(("Update Error: downloaded beta version %1 is not greater, than mine %2").arg(betaVersion).arg(cBetaVersion()));
-				return fatalFail();
+				return result(false);
 			}
 		} else if (int32(version) <= AppVersion) {
 			LOG(("Update Error: downloaded version %1 is not greater, than mine %2").arg(version).arg(AppVersion));
-			return fatalFail();
+			return result(false);
 		}
 
 		quint32 filesCount;
 		stream >> filesCount;
 		if (stream.status() != QDataStream::Ok) {
 			LOG(("Update Error: cant read files count from downloaded stream, status: %1").arg(stream.status()));
-			return fatalFail();
+			return result(false);
 		}
 		if (!filesCount) {
 			LOG(("Update Error: update is empty!"));
-			return fatalFail();
+			return result(false);
 		}
+		auto patchedCount = 0;
 		for (uint32 i = 0; i < filesCount; ++i) {
 			QString relativeName;
-			quint32 fileSize;
-			QByteArray fileInnerData;
+			quint8 mode = DeltaFileFull;
 			bool executable = false;
 
-			stream >> relativeName >> fileSize >> fileInnerData;
-#if defined Q_OS_MAC || defined Q_OS_LINUX
-			stream >> executable;
-#endif // Q_OS_MAC || Q_OS_LINUX
+			stream >> relativeName;
+			if (delta) {
+				stream >> mode;
+			}
 			if (stream.status() != QDataStream::Ok) {
 				LOG(("Update Error: cant read file from downloaded stream, status: %1").arg(stream.status()));
-				return fatalFail();
-			}
-			if (fileSize != quint32(fileInnerData.size())) {
-				LOG(("Update Error: bad file size %1 not matching data size %2").arg(fileSize).arg(fileInnerData.size()));
-				return fatalFail();
+				return result(false);
 			}
 
 			QFile f(tempDirPath + '/' + relativeName);
 			if (!QDir().mkpath(QFileInfo(f).absolutePath())) {
 				LOG(("Update Error: cant mkpath for file '%1'").arg(tempDirPath + '/' + relativeName));
-				return fatalFail();
+				return result(false);
 			}
 			if (!f.open(QIODevice::WriteOnly)) {
 				LOG(("Update Error: cant open file '%1' for writing").arg(tempDirPath + '/' + relativeName));
-				return fatalFail();
+				return result(false);
 			}
-			if (f.write(fileInnerData) != fileSize) {
-				f.close();
-				LOG(("Update Error: cant write file '%1'").arg(tempDirPath + '/' + relativeName));
-				return fatalFail();
+			auto written = false;
+			if (mode == DeltaFilePatch) {
+				written = WritePatchedFile(stream, relativeName, f, deltaFailed);
+				++patchedCount;
+			} else if (mode == DeltaFileFull) {
+				written = WriteFullFile(stream, f);
+			} else {
+				LOG(("Update Error: bad file mode %1 for '%2'").arg(mode).arg(relativeName));
 			}
 			f.close();
+			if (!written) {
+				return result(false);
+			}
+
+#if defined Q_OS_MAC || defined Q_OS_LINUX
+			stream >> executable;
+#endif // Q_OS_MAC || Q_OS_LINUX
+			if (stream.status() != QDataStream::Ok) {
+				LOG(("Update Error: cant read file from downloaded stream, status: %1").arg(stream.status()));
+				return result(false);
+			}
 			if (executable) {
 				QFileDevice::Permissions p = f.permissions();
 				p |= QFileDevice::ExeOwner | QFileDevice::ExeUser | QFileDevice::ExeGroup | QFileDevice::ExeOther;
 				f.setPermissions(p);
 			}
 		}
+		if (reader.decoded() != uncompressedLen) {
+			LOG(("Update Error: bad uncompressed size %1, expected %2").arg(reader.decoded()).arg(uncompressedLen));
+			return result(false);
+		}
+		if (!reader.verifyReadData()) {
+			return result(false);
+		}
+		DEBUG_LOG(("Update Info: unpacked %1 files (%2 patched) from %3 bytes package, %4 bytes unpacked").arg(filesCount).arg(patchedCount).arg(outputFile.size()).arg(uncompressedLen));
 
 		// create tdata/version file
 		tempDir.mkdir(QDir(tempDirPath + qsl("/tdata")).absolutePath());
@@ -453,7 +935,7 @@ void UpdateChecker::unpackUpdate() {
 		QFile fVersion(tempDirPath + qsl("/tdata/version"));
 		if (!fVersion.open(QIODevice::WriteOnly)) {
 			LOG(("Update Error: cant write version file '%1'").arg(tempDirPath + qsl("/version")));
-			return fatalFail();
+			return result(false);
 		}
 		fVersion.write((const char*)&versionNum, sizeof(VerInt));
 		if (versionNum == 0x7FFFFFFF) { // beta version
@@ -464,22 +946,7 @@ void UpdateChecker::unpackUpdate() {
 		}
 		fVersion.close();
 	}
-
-	QFile readyFile(readyFilePath);
-	if (readyFile.open(QIODevice::WriteOnly)) {
-		if (readyFile.write("1", 1)) {
-			readyFile.close();
-		} else {
-			LOG(("Update Error: cant write ready file '%1'").arg(readyFilePath));
-			return fatalFail();
-		}
-	} else {
-		LOG(("Update Error: cant create ready file '%1'").arg(readyFilePath));
-		return fatalFail();
-	}
-	outputFile.remove();
-
-	Sandbox::updateReady();
+	return result(true);
 }
 
 UpdateChecker::~UpdateChecker() {
@@ -26,11 +26,15 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include <QtNetwork/QLocalServer>
 #include <QtNetwork/QNetworkReply>
 
+class UpdatePackageVerifier;
+
 class UpdateChecker : public QObject {
 	Q_OBJECT
 
 public:
-	UpdateChecker(QThread *thread, const QString &url);
+	// If the delta url is not empty the binary diff against the installed
+	// files is downloaded first, the full package is used if it can't be applied.
+	UpdateChecker(QThread *thread, const QString &url, const QString &deltaUrl = QString());
 
 	void unpackUpdate();
 
@@ -51,14 +55,17 @@ public slots:
 
 private:
 	void initOutput();
+	bool unpackFiles(bool *deltaFailed);
 
+	void deltaFail();
 	void fatalFail();
 
-	QString updateUrl;
+	QString updateUrl, fullUrl;
 	QNetworkAccessManager manager;
 	QNetworkReply *reply;
 	int32 already, full;
 	QFile outputFile;
+	std_::unique_ptr<UpdatePackageVerifier> verifier;
 
 	QMutex mutex;
 
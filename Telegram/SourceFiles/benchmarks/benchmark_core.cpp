@@ -0,0 +1,87 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#include "stdafx.h"
+#include "benchmarks/benchmarks.h"
+
+namespace {
+
+constexpr auto kSetSize = 10000;
+
+const QVector<int32> &SetValues() {
+	static auto result = [] {
+		auto values = QVector<int32>();
+		values.reserve(kSetSize);
+		auto random = Benchmarks::Random();
+		for (auto i = 0; i != kSetSize; ++i) {
+			values.push_back(int32(random.next() >> 1));
+		}
+		return values;
+	}();
+	return result;
+}
+
+const OrderedSet<int32> &FilledSet() {
+	static auto result = [] {
+		auto set = OrderedSet<int32>();
+		for_const (auto value, SetValues()) {
+			set.insert(value);
+		}
+		return set;
+	}();
+	return result;
+}
+
+} // namespace
+
+BENCHMARK(core, OrderedSetInsert) {
+	auto &values = SetValues();
+	for (auto i = 0; i != iterations; ++i) {
+		auto set = OrderedSet<int32>();
+		for_const (auto value, values) {
+			set.insert(value);
+		}
+		Benchmarks::consume(set.size());
+	}
+}
+
+BENCHMARK(core, OrderedSetContains) {
+	auto &set = FilledSet();
+	auto &values = SetValues();
+	auto found = 0;
+	for (auto i = 0; i != iterations; ++i) {
+		auto value = values[i % kSetSize];
+		if (set.contains((i & 1) ? value : ~value)) {
+			++found;
+		}
+	}
+	Benchmarks::consume(found);
+}
+
+BENCHMARK(core, OrderedSetIterate) {
+	auto &set = FilledSet();
+	for (auto i = 0; i != iterations; ++i) {
+		auto sum = int64(0);
+		for_const (auto value, set) {
+			sum += value;
+		}
+		Benchmarks::consume(sum);
+	}
+}
@@ -0,0 +1,113 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#include "stdafx.h"
+#include "benchmarks/benchmarks.h"
+
+#include "ui/emoji_config.h"
+
+namespace {
+
+constexpr auto kTextWords = 1000;
+
+// Words with the text replacements and real emoji between them.
+const QString &MixedText() {
+	static auto result = [] {
+		const QString words[] = {
+			qsl("hello"),
+			qsl(":)"),
+			qsl("world,"),
+			qsl(":like:"),
+			qsl("see"),
+			qsl("https://telegram.org/faq"),
+			qsl(":D"),
+			qsl("and"),
+			QString::fromUtf8("\xf0\x9f\x98\x80"),
+			qsl("B-)"),
+			qsl("the"),
+			qsl(":dislike:"),
+			QString::fromUtf8("\xf0\x9f\x91\x8d\xf0\x9f\x8f\xbb"),
+			qsl("end."),
+		};
+		auto text = QString();
+		auto random = Benchmarks::Random();
+		for (auto i = 0; i != kTextWords; ++i) {
+			text.append(words[(random.next() >> 16) % base::array_size(words)]).append(' ');
+		}
+		return text;
+	}();
+	return result;
+}
+
+void EnsureEmojiInit() {
+	static auto initialized = [] {
+		emojiInit();
+		return true;
+	}();
+	Benchmarks::consume(initialized);
+}
+
+} // namespace
+
+// The replacements lookup is tried at each position of a typed message.
+BENCHMARK(emoji, Find) {
+	auto &text = MixedText();
+	auto found = 0;
+	for (auto i = 0; i != iterations; ++i) {
+		for (auto ch = text.constData(), e = ch + text.size(); ch != e; ++ch) {
+			auto newEmojiEnd = static_cast<const QChar*>(nullptr);
+			auto emojiCode = uint32(0);
+			emojiFind(ch, e, newEmojiEnd, emojiCode);
+			if (emojiCode) {
+				++found;
+			}
+		}
+	}
+	Benchmarks::consume(found);
+}
+
+// Each symbol of a message is checked for the emoji when it is laid out.
+BENCHMARK(emoji, FromText) {
+	EnsureEmojiInit();
+	auto &text = MixedText();
+	auto found = 0;
+	for (auto i = 0; i != iterations; ++i) {
+		for (auto ch = text.constData(), e = ch + text.size(); ch != e;) {
+			auto length = 0;
+			if (emojiFromText(ch, e, &length)) {
+				++found;
+				ch += length;
+			} else {
+				++ch;
+			}
+		}
+	}
+	Benchmarks::consume(found);
+}
+
+BENCHMARK(emoji, Replace) {
+	EnsureEmojiInit();
+	auto &text = MixedText();
+	for (auto i = 0; i != iterations; ++i) {
+		auto entities = EntitiesInText();
+		auto result = replaceEmojis(text, &entities);
+		Benchmarks::consume(result.size());
+	}
+}
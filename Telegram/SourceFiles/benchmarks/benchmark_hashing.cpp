@@ -0,0 +1,96 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#include "stdafx.h"
+#include "benchmarks/benchmarks.h"
+
+#include "mtproto/auth_key.h"
+
+namespace {
+
+// The largest document part hashed by FileUploader, see DocumentUploadPartSize4.
+constexpr auto kPartSize = 512 * 1024;
+
+// About the size of a usual MTProto packet.
+constexpr auto kPacketSize = 4 * 1024;
+
+const QByteArray &Part() {
+	static auto result = [] {
+		auto bytes = QByteArray(kPartSize, Qt::Uninitialized);
+		auto random = Benchmarks::Random();
+		for (auto i = 0; i != kPartSize; ++i) {
+			bytes[i] = char(random.next() >> 16);
+		}
+		return bytes;
+	}();
+	return result;
+}
+
+template <typename Hash>
+void HashPart(int iterations, int size) {
+	auto &part = Part();
+	uchar result[Hash::kSize];
+	for (auto i = 0; i != iterations; ++i) {
+		Hash hash;
+		hash.feed(part.constData(), size);
+		hash.finish(result);
+		Benchmarks::consume(result[i % Hash::kSize]);
+	}
+}
+
+} // namespace
+
+BENCHMARK(hashing, Md5UploadPart) {
+	HashPart<base::hash::Md5>(iterations, kPartSize);
+}
+
+BENCHMARK(hashing, Sha1Packet) {
+	HashPart<base::hash::Sha1>(iterations, kPacketSize);
+}
+
+BENCHMARK(hashing, Sha256UploadPart) {
+	HashPart<base::hash::Sha256>(iterations, kPartSize);
+}
+
+BENCHMARK(hashing, Crc32UploadPart) {
+	auto &part = Part();
+	for (auto i = 0; i != iterations; ++i) {
+		base::hash::Crc32 crc;
+		crc.feed(part);
+		Benchmarks::consume(crc.result());
+	}
+}
+
+// Four sha1 hashes of the key parts for each sent and received packet.
+BENCHMARK(hashing, PrepareAES) {
+	static auto key = [] {
+		auto result = MTP::AuthKey();
+		result.setKey(Part().constData());
+		return result;
+	}();
+	auto msgKey = MTPint128();
+	auto aesKey = MTPint256();
+	auto aesIV = MTPint256();
+	for (auto i = 0; i != iterations; ++i) {
+		msgKey.l = i;
+		key.prepareAES(msgKey, aesKey, aesIV, (i & 1) != 0);
+		Benchmarks::consume(aesKey.l.l);
+	}
+}
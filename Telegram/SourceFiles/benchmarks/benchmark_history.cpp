@@ -0,0 +1,180 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#include "stdafx.h"
+#include "benchmarks/benchmarks.h"
+
+namespace {
+
+constexpr auto kHistoryMessages = 100000;
+constexpr auto kMessagesPerBlock = 50; // MessagesPerPage
+constexpr auto kScrollSteps = 1000;
+constexpr auto kViewportHeight = 800;
+
+// HistoryItem and HistoryBlock can't be created without the app, so the
+// benchmark lays out a 100k messages history the same way: items on the
+// heap with their y inside the block, and the blocks with the item tops
+// kept as a plain array, like HistoryBlock::itemTops().
+struct Item {
+	int y = 0;
+	int height = 0;
+	char rest[400]; // the remaining fields of a HistoryMessage
+};
+
+struct Block {
+	int y = 0;
+	int height = 0;
+	QVector<Item*> items;
+	QVector<int> itemTops;
+};
+
+struct History {
+	QVector<Block*> blocks;
+	int height = 0;
+};
+
+const History &LongHistory() {
+	static auto result = [] {
+		auto history = History();
+		auto random = Benchmarks::Random();
+		for (auto i = 0; i != kHistoryMessages; ++i) {
+			if (history.blocks.isEmpty() || history.blocks.back()->items.size() >= kMessagesPerBlock) {
+				auto block = new Block();
+				block->y = history.height;
+				block->items.reserve(kMessagesPerBlock);
+				block->itemTops.reserve(kMessagesPerBlock);
+				history.blocks.push_back(block);
+			}
+			auto block = history.blocks.back();
+			auto item = new Item();
+			item->y = block->height;
+			item->height = 40 + int((random.next() >> 16) % 200);
+			block->items.push_back(item);
+			block->itemTops.push_back(item->y);
+			block->height += item->height;
+			history.height += item->height;
+		}
+		return history;
+	}();
+	return result;
+}
+
+// Scroll positions all over the history, the same in each run.
+const QVector<int> &ScrollTops() {
+	static auto result = [] {
+		auto tops = QVector<int>();
+		tops.reserve(kScrollSteps);
+		auto height = LongHistory().height - kViewportHeight;
+		auto random = Benchmarks::Random();
+		for (auto i = 0; i != kScrollSteps; ++i) {
+			tops.push_back(int(random.next() % uint32(height)));
+		}
+		return tops;
+	}();
+	return result;
+}
+
+int BlockIndexAt(const History &history, int top) {
+	auto start = 0, end = history.blocks.size();
+	while (end - start > 1) {
+		auto middle = (start + end) / 2;
+		if (history.blocks[middle]->y <= top) {
+			start = middle;
+		} else {
+			end = middle;
+		}
+	}
+	return start;
+}
+
+} // namespace
+
+// The search of the first visible item, as in HistoryInner::enumerateItems.
+BENCHMARK(history, FindVisibleItemTops) {
+	auto &history = LongHistory();
+	auto &tops = ScrollTops();
+	auto found = 0;
+	for (auto i = 0; i != iterations; ++i) {
+		auto top = tops[i % kScrollSteps];
+		auto block = history.blocks[BlockIndexAt(history, top)];
+		auto &itemTops = block->itemTops;
+		auto start = 0, end = itemTops.size();
+		while (end - start > 1) {
+			auto middle = (start + end) / 2;
+			if (itemTops[middle] <= top - block->y) {
+				start = middle;
+			} else {
+				end = middle;
+			}
+		}
+		found += start;
+	}
+	Benchmarks::consume(found);
+}
+
+// The same search reading the y of the items, to compare with the array.
+BENCHMARK(history, FindVisibleItemPointers) {
+	auto &history = LongHistory();
+	auto &tops = ScrollTops();
+	auto found = 0;
+	for (auto i = 0; i != iterations; ++i) {
+		auto top = tops[i % kScrollSteps];
+		auto block = history.blocks[BlockIndexAt(history, top)];
+		auto &items = block->items;
+		auto start = 0, end = items.size();
+		while (end - start > 1) {
+			auto middle = (start + end) / 2;
+			if (items[middle]->y <= top - block->y) {
+				start = middle;
+			} else {
+				end = middle;
+			}
+		}
+		found += start;
+	}
+	Benchmarks::consume(found);
+}
+
+// Scrolling through the whole history by a viewport at a time, walking the
+// item tops forward like History::countScrollTopItem does.
+BENCHMARK(history, ScrollThroughTops) {
+	auto &history = LongHistory();
+	auto visited = 0;
+	for (auto i = 0; i != iterations; ++i) {
+		auto blockIndex = 0, itemIndex = 0;
+		for (auto top = 0; top < history.height; top += kViewportHeight) {
+			for (auto blocksCount = history.blocks.size(); blockIndex < blocksCount; ++blockIndex) {
+				auto block = history.blocks[blockIndex];
+				auto &itemTops = block->itemTops;
+				for (auto itemsCount = itemTops.size(); itemIndex < itemsCount; ++itemIndex) {
+					if (block->y + itemTops[itemIndex] > top) {
+						break;
+					}
+					++visited;
+				}
+				if (itemIndex < itemTops.size()) {
+					break;
+				}
+				itemIndex = 0;
+			}
+		}
+	}
+	Benchmarks::consume(visited);
+}
@@ -0,0 +1,151 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#include "stdafx.h"
+#include "benchmarks/benchmarks.h"
+
+#include "mtproto/auth_key.h"
+#include "mtproto/inflater.h"
+
+#include "zlib.h"
+
+namespace {
+
+constexpr auto kMessagesCount = 100;
+constexpr auto kLocalEncryptSize = 64 * 1024;
+
+// A slice of history, as it comes in messages.getHistory results.
+const MTPVector<MTPMessage> &Messages() {
+	static auto result = [] {
+		auto messages = QVector<MTPMessage>();
+		messages.reserve(kMessagesCount);
+		for (auto i = 0; i != kMessagesCount; ++i) {
+			auto text = qsl("Message number %1 with a link to https://telegram.org and some bold text in it.").arg(i);
+			auto entities = QVector<MTPMessageEntity>();
+			entities.push_back(MTP_messageEntityUrl(MTP_int(text.indexOf(qstr("https"))), MTP_int(20)));
+			entities.push_back(MTP_messageEntityBold(MTP_int(text.indexOf(qstr("bold"))), MTP_int(4)));
+
+			MTPDmessage::Flags flags = 0;
+			flags |= MTPDmessage::Flag::f_from_id;
+			flags |= MTPDmessage::Flag::f_media;
+			flags |= MTPDmessage::Flag::f_entities;
+			messages.push_back(MTP_message(MTP_flags(flags), MTP_int(i + 1), MTP_int(1000 + (i % 3)), MTP_peerUser(MTP_int(1000)), MTPMessageFwdHeader(), MTPint(), MTPint(), MTP_int(1480000000 + i * 60), MTP_string(text), MTP_messageMediaEmpty(), MTPReplyMarkup(), MTP_vector<MTPMessageEntity>(entities), MTPint(), MTPint()));
+		}
+		return MTP_vector<MTPMessage>(messages);
+	}();
+	return result;
+}
+
+const mtpBuffer &SerializedMessages() {
+	static auto result = [] {
+		auto buffer = mtpBuffer();
+		Messages().write(buffer);
+		return buffer;
+	}();
+	return result;
+}
+
+// The gzip_packed object body, it follows the constructor id.
+const mtpBuffer &PackedMessages() {
+	static auto result = [] {
+		auto &serialized = SerializedMessages();
+		auto input = QByteArray::fromRawData(reinterpret_cast<const char*>(serialized.constData()), serialized.size() * sizeof(mtpPrime));
+
+		z_stream stream;
+		stream.zalloc = nullptr;
+		stream.zfree = nullptr;
+		stream.opaque = nullptr;
+		deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+		auto packed = QByteArray(deflateBound(&stream, input.size()), Qt::Uninitialized);
+		stream.avail_in = input.size();
+		stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.constData()));
+		stream.avail_out = packed.size();
+		stream.next_out = reinterpret_cast<Bytef*>(packed.data());
+		deflate(&stream, Z_FINISH);
+		packed.resize(packed.size() - stream.avail_out);
+		deflateEnd(&stream);
+
+		auto buffer = mtpBuffer();
+		MTP_bytes(packed).write(buffer);
+		return buffer;
+	}();
+	return result;
+}
+
+void Unpack(MTP::internal::Inflater &inflater, mtpBuffer &result) {
+	auto &packed = PackedMessages();
+	auto from = packed.constData();
+	if (!inflater.unpack(from, from + packed.size(), result)) {
+		throw Exception(inflater.error());
+	}
+}
+
+} // namespace
+
+BENCHMARK(mtproto, SerializeMessages) {
+	auto &messages = Messages();
+	for (auto i = 0; i != iterations; ++i) {
+		auto buffer = mtpBuffer();
+		messages.write(buffer);
+		Benchmarks::consume(buffer.size());
+	}
+}
+
+BENCHMARK(mtproto, ParseMessages) {
+	auto &serialized = SerializedMessages();
+	for (auto i = 0; i != iterations; ++i) {
+		auto from = serialized.constData();
+		auto messages = MTPVector<MTPMessage>();
+		messages.read(from, from + serialized.size());
+		Benchmarks::consume(messages.c_vector().v.size());
+	}
+}
+
+// The zlib stream is reused for all gzip_packed objects of a connection.
+BENCHMARK(mtproto, UnpackGzipReused) {
+	static MTP::internal::Inflater inflater;
+	auto result = mtpBuffer();
+	for (auto i = 0; i != iterations; ++i) {
+		Unpack(inflater, result);
+		Benchmarks::consume(result.size());
+	}
+}
+
+// A new zlib stream for each object, to compare with the reused one.
+BENCHMARK(mtproto, UnpackGzipFresh) {
+	auto result = mtpBuffer();
+	for (auto i = 0; i != iterations; ++i) {
+		MTP::internal::Inflater inflater;
+		Unpack(inflater, result);
+		Benchmarks::consume(result.size());
+	}
+}
+
+// Local storage files are encrypted with AES-IGE as well.
+BENCHMARK(mtproto, AesIgeEncrypt64Kb) {
+	static auto key = QByteArray(32, 'k');
+	static auto iv = QByteArray(32, 'i');
+	static auto source = QByteArray(kLocalEncryptSize, 's');
+	auto encrypted = QByteArray(kLocalEncryptSize, Qt::Uninitialized);
+	for (auto i = 0; i != iterations; ++i) {
+		MTP::aesIgeEncrypt(source.constData(), encrypted.data(), kLocalEncryptSize, key.constData(), iv.constData());
+		Benchmarks::consume(encrypted.at(i % kLocalEncryptSize));
+	}
+}
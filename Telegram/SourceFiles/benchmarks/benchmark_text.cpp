@@ -0,0 +1,202 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#include "stdafx.h"
+#include "benchmarks/benchmarks.h"
+
+#include "ui/text/text_entity.h"
+#include "ui/emoji_config.h"
+
+namespace {
+
+constexpr auto kLongTextParagraphs = 200;
+constexpr auto kSplitLimit = 4096;
+constexpr auto kChannelMessages = 1000;
+constexpr auto kLinksPerMessage = 4;
+
+// A chat message with every kind of entity the parser looks for.
+const QString &MessageText() {
+	static auto result = QString::fromUtf8("Hello @durov, look at https://telegram.org/blog/channels and "
+		"t.me/telegram :) Write to support@telegram.org or press /start@BotFather. "
+		"#news #telegram \xf0\x9f\x98\x80 It works in any language: "
+		"\xd0\xbf\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82, \xd0\xbc\xd0\xb8\xd1\x80!\n"
+		"And a second line with example.com/path?query=1 in it.");
+	return result;
+}
+
+const QString &LongText() {
+	static auto result = [] {
+		auto text = QString();
+		text.reserve((MessageText().size() + 2) * kLongTextParagraphs);
+		for (auto i = 0; i != kLongTextParagraphs; ++i) {
+			text.append(MessageText()).append(qsl("\n\n"));
+		}
+		return text;
+	}();
+	return result;
+}
+
+// The entities of the message, as they come from the server.
+const QVector<MTPMessageEntity> &MessageEntities() {
+	static auto result = [] {
+		auto &text = MessageText();
+		auto entities = QVector<MTPMessageEntity>();
+		entities.push_back(MTP_messageEntityMentionName(MTP_int(text.indexOf(qstr("@durov"))), MTP_int(6), MTP_int(1000)));
+		entities.push_back(MTP_messageEntityUrl(MTP_int(text.indexOf(qstr("https"))), MTP_int(34)));
+		entities.push_back(MTP_messageEntityEmail(MTP_int(text.indexOf(qstr("support"))), MTP_int(20)));
+		entities.push_back(MTP_messageEntityBotCommand(MTP_int(text.indexOf(qstr("/start"))), MTP_int(16)));
+		entities.push_back(MTP_messageEntityHashtag(MTP_int(text.indexOf(qstr("#news"))), MTP_int(5)));
+		entities.push_back(MTP_messageEntityBold(MTP_int(text.indexOf(qstr("Hello"))), MTP_int(5)));
+		return entities;
+	}();
+	return result;
+}
+
+// The link data of channel messages: a few popular links, mentions and
+// hashtags repeated all over, each one parsed into a separate string.
+const QVector<QStringList> &ChannelLinks() {
+	static auto result = [] {
+		auto links = QVector<QStringList>();
+		links.reserve(kChannelMessages);
+		auto random = Benchmarks::Random();
+		for (auto i = 0; i != kChannelMessages; ++i) {
+			auto list = QStringList();
+			for (auto j = 0; j != kLinksPerMessage; ++j) {
+				auto value = int((random.next() >> 16) % 30);
+				switch (j) {
+				case 0: list.push_back(qsl("https://telegram.org/blog/post-%1").arg(value)); break;
+				case 1: list.push_back(qsl("@channel_author_%1").arg(value)); break;
+				case 2: list.push_back(qsl("#topic%1").arg(value)); break;
+				default: list.push_back(qsl("https://t.me/channel/%1").arg(i)); break;
+				}
+			}
+			links.push_back(list);
+		}
+		return links;
+	}();
+	return result;
+}
+
+// The heap bytes of the strings, each shared buffer is counted once.
+int64 StringsBytes(const QVector<QStringList> &strings) {
+	auto buffers = QSet<const QChar*>();
+	auto result = int64(0);
+	for_const (auto &list, strings) {
+		for_const (auto &string, list) {
+			result += sizeof(QString);
+			if (!buffers.contains(string.constData())) {
+				buffers.insert(string.constData());
+				result += sizeof(QArrayData) + (string.size() + 1) * sizeof(QChar);
+			}
+		}
+	}
+	return result;
+}
+
+void EnsureEmojiInit() {
+	static auto initialized = [] {
+		emojiInit();
+		return true;
+	}();
+	Benchmarks::consume(initialized);
+}
+
+} // namespace
+
+BENCHMARK(text, ParseEntities) {
+	auto &source = MessageText();
+	auto flags = TextParseLinks | TextParseMentions | TextParseHashtags | TextParseBotCommands;
+	for (auto i = 0; i != iterations; ++i) {
+		auto text = source;
+		auto entities = EntitiesInText();
+		textParseEntities(text, flags, &entities);
+		Benchmarks::consume(entities.size());
+	}
+}
+
+// The path of a message typed in the field: clean, replace emoji, parse.
+BENCHMARK(text, PrepareWithEntities) {
+	EnsureEmojiInit();
+	auto &source = MessageText();
+	auto flags = TextParseLinks | TextParseMentions | TextParseHashtags | TextParseBotCommands;
+	for (auto i = 0; i != iterations; ++i) {
+		auto entities = EntitiesInText();
+		auto text = prepareTextWithEntities(source, flags, &entities);
+		Benchmarks::consume(text.size() + entities.size());
+	}
+}
+
+BENCHMARK(text, EntitiesFromMTP) {
+	auto &entities = MessageEntities();
+	for (auto i = 0; i != iterations; ++i) {
+		auto result = entitiesFromMTP(entities);
+		Benchmarks::consume(result.size());
+	}
+}
+
+BENCHMARK(text, SearchKey) {
+	auto &source = MessageText();
+	for (auto i = 0; i != iterations; ++i) {
+		auto key = textSearchKey(source);
+		Benchmarks::consume(key.size());
+	}
+}
+
+// A long message is split into parts before sending.
+BENCHMARK(text, SplitLong) {
+	auto &source = LongText();
+	for (auto i = 0; i != iterations; ++i) {
+		auto left = source;
+		auto leftEntities = EntitiesInText();
+		auto parts = 0;
+		auto sending = QString();
+		auto sendingEntities = EntitiesInText();
+		while (textSplit(sending, sendingEntities, left, leftEntities, kSplitLimit)) {
+			++parts;
+		}
+		Benchmarks::consume(parts);
+	}
+}
+
+// Each iteration interns the link strings of a message, the bytes per
+// message are counted for the whole channel with and without interning.
+BENCHMARK(text, InternLinks) {
+	auto &links = ChannelLinks();
+	static auto plainBytes = StringsBytes(links);
+	static auto interned = [&links] {
+		auto result = links;
+		for (auto &list : result) {
+			for (auto &string : list) {
+				string = textIntern(string);
+			}
+		}
+		return result;
+	}();
+	static auto internedBytes = StringsBytes(interned);
+	Benchmarks::counter("plain_bytes_per_message", plainBytes / kChannelMessages);
+	Benchmarks::counter("interned_bytes_per_message", internedBytes / kChannelMessages);
+	Benchmarks::counter("interned_strings", textInternedCount());
+
+	for (auto i = 0; i != iterations; ++i) {
+		for_const (auto &string, links[i % kChannelMessages]) {
+			Benchmarks::consume(textIntern(string).size());
+		}
+	}
+}
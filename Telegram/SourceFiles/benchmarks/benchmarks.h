@@ -0,0 +1,63 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#pragma once
+
+namespace Benchmarks {
+
+// The method runs the measured code iterations times in a row,
+// the setup is done once in function-level statics.
+using Method = void(*)(int iterations);
+
+class Registration {
+public:
+	Registration(const char *group, const char *name, Method method);
+
+};
+
+// Keeps the computed value alive, so that the measured code is not optimized out.
+void consume(int64 value);
+
+// Pseudo random values for the setup data, the same sequence in each run,
+// so that the runs are comparable.
+class Random {
+public:
+	explicit Random(uint32 seed = 1U) : _state(seed) {
+	}
+	uint32 next() {
+		_state = _state * 1103515245U + 12345U;
+		return _state;
+	}
+
+private:
+	uint32 _state;
+
+};
+
+// Reports a value the benchmark measures besides the time, like the memory
+// used, it is written to the results with the timings.
+void counter(const char *name, int64 value);
+
+} // namespace Benchmarks
+
+#define BENCHMARK(group, name) \
+static void benchmark_##group##_##name(int iterations); \
+static ::Benchmarks::Registration benchmark_registration_##group##_##name(#group, #name, &benchmark_##group##_##name); \
+static void benchmark_##group##_##name(int iterations)
@@ -0,0 +1,69 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#include "stdafx.h"
+
+// Headless replacements for the app data that the benchmarked code reads.
+// The settings keep the defaults of settings.cpp and no users are loaded.
+
+bool gReplaceEmojis = true;
+DBIScale gRealScale = dbisAuto, gScreenScale = dbisOne;
+EmojiColorVariants gEmojiVariants;
+bool gRetina = false;
+
+#ifdef Q_OS_WIN
+DBIPlatform gPlatform = dbipWindows;
+#elif defined Q_OS_MAC
+DBIPlatform gPlatform = dbipMac;
+#elif defined Q_OS_LINUX64
+DBIPlatform gPlatform = dbipLinux64;
+#elif defined Q_OS_LINUX32
+DBIPlatform gPlatform = dbipLinux32;
+#else
+#error Unknown platform
+#endif
+bool gIsElCapitan = false;
+
+RecentEmojiPack &cGetRecentEmojis() {
+	static RecentEmojiPack result;
+	return result;
+}
+
+int32 hashCrc32(const void *data, uint32 len) {
+	base::hash::Crc32 crc;
+	crc.feed(data, len);
+	return int32(crc.result());
+}
+
+namespace App {
+
+UserData *userLoaded(const PeerId &id) {
+	return nullptr;
+}
+
+} // namespace App
+
+namespace MTP {
+
+int32 authedId() {
+	return 0;
+}
+
+} // namespace MTP
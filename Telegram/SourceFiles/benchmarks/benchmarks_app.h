@@ -0,0 +1,49 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#pragma once
+
+// The part of app.h, structs.h and mtproto/facade.h that the linked app
+// sources use. It is defined by the headless stubs in benchmarks_app.cpp.
+
+typedef int32 UserId;
+typedef uint64 PeerId;
+
+inline PeerId peerFromUser(const MTPint &user_id) {
+	return uint64(uint32(user_id.v));
+}
+
+class UserData {
+public:
+	uint64 access = 0;
+
+};
+
+namespace App {
+
+UserData *userLoaded(const PeerId &id);
+
+} // namespace App
+
+namespace MTP {
+
+int32 authedId();
+
+} // namespace MTP
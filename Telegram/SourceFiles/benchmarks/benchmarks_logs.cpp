@@ -0,0 +1,62 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#include "stdafx.h"
+
+// Headless replacements for the logs of the main app,
+// everything that the benchmarked code writes goes to stderr.
+
+namespace Logs {
+namespace {
+
+void write(const QString &v) {
+	fprintf(stderr, "%s\n", v.toUtf8().constData());
+}
+
+} // namespace
+
+bool started() {
+	return true;
+}
+
+void writeMain(const QString &v) {
+	write(v);
+}
+
+void writeDebug(const char *file, int32 line, const QString &v) {
+	write(QString("%1 (%2 : %3)").arg(v).arg(file).arg(line));
+}
+
+void writeTcp(const QString &v) {
+	write(v);
+}
+
+void writeMtp(int32 dc, const QString &v) {
+	write(QString("%1 (dc:%2)").arg(v).arg(dc));
+}
+
+} // namespace Logs
+
+namespace SignalHandlers {
+
+void setCrashAnnotation(const std::string &key, const QString &value) {
+}
+
+} // namespace SignalHandlers
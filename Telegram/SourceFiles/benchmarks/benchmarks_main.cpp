@@ -0,0 +1,226 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#include "stdafx.h"
+#include "benchmarks/benchmarks.h"
+
+#include "core/version.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace Benchmarks {
+namespace {
+
+constexpr auto kSampleDuration = 10 * 1000 * 1000LL; // Each sample runs for 10 ms at least.
+constexpr auto kMaxIterations = (1 << 30);
+constexpr auto kDefaultSamples = 15;
+constexpr auto kDefaultWarmup = 200; // ms
+
+struct Registered {
+	QString group;
+	QString name;
+	Method method = nullptr;
+};
+
+struct Result {
+	QString group;
+	QString name;
+	int iterations = 0;
+	QVector<double> samples; // nanoseconds per iteration
+	double min = 0.;
+	double median = 0.;
+	double mean = 0.;
+	double stddev = 0.;
+	QMap<QString, int64> counters;
+};
+
+QVector<Registered> &RegisteredList() {
+	static QVector<Registered> result;
+	return result;
+}
+
+volatile int64 Consumed = 0;
+QMap<QString, int64> Counters;
+
+int64 Measure(Method method, int iterations) {
+	QElapsedTimer timer;
+	timer.start();
+	method(iterations);
+	return timer.nsecsElapsed();
+}
+
+// Runs the method with twice more iterations each time until the warmup
+// time passes and a single run lasts for kSampleDuration at least.
+int Warmup(Method method, int warmup) {
+	auto iterations = 1;
+	QElapsedTimer timer;
+	timer.start();
+	while (true) {
+		auto elapsed = Measure(method, iterations);
+		if (elapsed < kSampleDuration && iterations < kMaxIterations / 2) {
+			iterations *= 2;
+		} else if (timer.elapsed() >= warmup) {
+			return iterations;
+		}
+	}
+}
+
+void CountStatistics(Result &result) {
+	auto sorted = result.samples;
+	std::sort(sorted.begin(), sorted.end());
+
+	auto count = sorted.size();
+	result.min = sorted.front();
+	result.median = (count % 2) ? sorted[count / 2] : (sorted[count / 2 - 1] + sorted[count / 2]) / 2.;
+	result.mean = std::accumulate(sorted.cbegin(), sorted.cend(), 0.) / count;
+	auto deviations = 0.;
+	for_const (auto sample, sorted) {
+		deviations += (sample - result.mean) * (sample - result.mean);
+	}
+	result.stddev = (count > 1) ? std::sqrt(deviations / (count - 1)) : 0.;
+}
+
+Result Run(const Registered &benchmark, int samples, int warmup) {
+	auto result = Result();
+	result.group = benchmark.group;
+	result.name = benchmark.name;
+	result.iterations = Warmup(benchmark.method, warmup);
+	Counters.clear();
+	result.samples.reserve(samples);
+	for (auto i = 0; i != samples; ++i) {
+		auto elapsed = Measure(benchmark.method, result.iterations);
+		result.samples.push_back(double(elapsed) / result.iterations);
+	}
+	CountStatistics(result);
+	result.counters = Counters;
+	return result;
+}
+
+QJsonObject Serialize(const Result &result) {
+	auto samples = QJsonArray();
+	for_const (auto sample, result.samples) {
+		samples.append(sample);
+	}
+	auto object = QJsonObject();
+	object.insert(qsl("group"), result.group);
+	object.insert(qsl("name"), result.name);
+	object.insert(qsl("iterations"), result.iterations);
+	object.insert(qsl("min_ns"), result.min);
+	object.insert(qsl("median_ns"), result.median);
+	object.insert(qsl("mean_ns"), result.mean);
+	object.insert(qsl("stddev_ns"), result.stddev);
+	object.insert(qsl("samples_ns"), samples);
+	if (!result.counters.isEmpty()) {
+		auto counters = QJsonObject();
+		for (auto i = result.counters.cbegin(), e = result.counters.cend(); i != e; ++i) {
+			counters.insert(i.key(), double(i.value()));
+		}
+		object.insert(qsl("counters"), counters);
+	}
+	return object;
+}
+
+} // namespace
+
+Registration::Registration(const char *group, const char *name, Method method) {
+	auto benchmark = Registered();
+	benchmark.group = QString::fromLatin1(group);
+	benchmark.name = QString::fromLatin1(name);
+	benchmark.method = method;
+	RegisteredList().push_back(benchmark);
+}
+
+void consume(int64 value) {
+	Consumed = Consumed + value;
+}
+
+void counter(const char *name, int64 value) {
+	Counters.insert(QString::fromLatin1(name), value);
+}
+
+} // namespace Benchmarks
+
+// Usage: Benchmarks [-filter {group or name part}] [-samples {count}] [-warmup {ms}] [-json {path}]
+// The results are written to stdout in JSON, or to the file passed in -json.
+int main(int argc, char *argv[]) {
+	using namespace Benchmarks;
+
+	auto filter = QString();
+	auto samples = kDefaultSamples;
+	auto warmup = kDefaultWarmup;
+	auto jsonPath = QString();
+	for (auto i = 1; i + 1 < argc; ++i) {
+		if (qstr("-filter") == argv[i]) {
+			filter = QString::fromLocal8Bit(argv[++i]);
+		} else if (qstr("-samples") == argv[i]) {
+			samples = qMax(QString::fromLocal8Bit(argv[++i]).toInt(), 1);
+		} else if (qstr("-warmup") == argv[i]) {
+			warmup = qMax(QString::fromLocal8Bit(argv[++i]).toInt(), 0);
+		} else if (qstr("-json") == argv[i]) {
+			jsonPath = QString::fromLocal8Bit(argv[++i]);
+		}
+	}
+
+	auto list = RegisteredList();
+	std::sort(list.begin(), list.end(), [](const Registered &a, const Registered &b) {
+		return (a.group < b.group) || (a.group == b.group && a.name < b.name);
+	});
+
+	auto results = QJsonArray();
+	for_const (auto &benchmark, list) {
+		auto fullName = benchmark.group + '/' + benchmark.name;
+		if (!filter.isEmpty() && !fullName.contains(filter)) {
+			continue;
+		}
+		try {
+			auto result = Run(benchmark, samples, warmup);
+			fprintf(stderr, "%-40s %12.1f ns median, %12.1f ns min, %5.1f%% stddev\n", fullName.toUtf8().constData(), result.median, result.min, result.mean ? (result.stddev * 100. / result.mean) : 0.);
+			for (auto i = result.counters.cbegin(), e = result.counters.cend(); i != e; ++i) {
+				fprintf(stderr, "%-40s %12lld\n", (qsl("  ") + i.key()).toUtf8().constData(), static_cast<long long>(i.value()));
+			}
+			results.append(Serialize(result));
+		} catch (Exception &e) {
+			fprintf(stderr, "%s failed: %s\n", fullName.toUtf8().constData(), e.what());
+			return 1;
+		}
+	}
+	if (results.isEmpty()) {
+		fprintf(stderr, "No benchmarks matched '%s'.\n", filter.toUtf8().constData());
+		return 1;
+	}
+
+	auto document = QJsonObject();
+	document.insert(qsl("version"), str_const_toString(AppVersionStr));
+	document.insert(qsl("qt"), QString::fromLatin1(qVersion()));
+	document.insert(qsl("samples"), samples);
+	document.insert(qsl("benchmarks"), results);
+	auto json = QJsonDocument(document).toJson();
+	if (jsonPath.isEmpty()) {
+		fwrite(json.constData(), 1, json.size(), stdout);
+		return 0;
+	}
+	QFile file(jsonPath);
+	if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size()) {
+		fprintf(stderr, "Could not write '%s'.\n", jsonPath.toUtf8().constData());
+		return 1;
+	}
+	return 0;
+}
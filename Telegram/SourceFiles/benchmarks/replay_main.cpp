@@ -0,0 +1,63 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#include "stdafx.h"
+
+#include "benchmarks/replay_recording.h"
+#include "benchmarks/replay_server.h"
+
+namespace {
+
+constexpr auto kDefaultPort = 8444;
+
+} // namespace
+
+// Usage: ReplayServer {capture path} [-port {port}] [-fast]
+// The capture is made by the debug client started with -mtprecord {capture path},
+// then the debug client with the copy of its tdata made before the recording
+// is started with -mtpreplay 127.0.0.1:{port} to replay the same session.
+int main(int argc, char *argv[]) {
+	QCoreApplication application(argc, argv);
+
+	if (argc < 2) {
+		fprintf(stderr, "Usage: ReplayServer {capture path} [-port {port}] [-fast]\n");
+		return 1;
+	}
+	auto path = QString::fromLocal8Bit(argv[1]);
+	auto port = kDefaultPort;
+	auto fast = false;
+	for (auto i = 2; i < argc; ++i) {
+		if (qstr("-port") == argv[i] && i + 1 < argc) {
+			port = QString::fromLocal8Bit(argv[++i]).toInt();
+		} else if (qstr("-fast") == argv[i]) {
+			fast = true;
+		}
+	}
+
+	Replay::Recording recording;
+	if (!recording.load(path)) {
+		return 1;
+	}
+	Replay::Server server(recording, fast);
+	if (!server.listen(port)) {
+		return 1;
+	}
+	return application.exec();
+}
@@ -0,0 +1,267 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#include "stdafx.h"
+#include "benchmarks/replay_recording.h"
+
+#include "mtproto/traffic_recorder.h"
+
+namespace Replay {
+namespace {
+
+constexpr auto kMessageHeaderSize = 4; // 2: msg_id, 1: seq_no, 1: message_length
+constexpr auto kKeySize = 256;
+
+void AddSent(KeyRecording &recording, QMap<uint64, int> &sentCalls, ShiftedDcId dc, TimeMs time, uint64 msgId, const mtpPrime *from, const mtpPrime *end) {
+	if (IsServiceMessage(mtpTypeId(*from))) {
+		return;
+	}
+	auto query = SkipInvokeWrappers(from, end);
+	auto call = Call();
+	call.dc = dc;
+	call.query = mtpBuffer(end - query);
+	memcpy(call.query.data(), query, (end - query) * sizeof(mtpPrime));
+	call.sentAt = time;
+	sentCalls.insert(msgId, recording.calls.size());
+	recording.calls.push_back(std_::move(call));
+
+	if (!recording.firstSentAt.contains(dc)) {
+		recording.firstSentAt.insert(dc, time);
+	}
+}
+
+void AddReceived(KeyRecording &recording, const QMap<uint64, int> &sentCalls, ShiftedDcId dc, TimeMs time, const mtpPrime *from, const mtpPrime *end) {
+	auto type = mtpTypeId(*from);
+	if (type == mtpc_rpc_result) {
+		if (from + 3 > end) throw mtpErrorInsufficient();
+		auto requestId = *reinterpret_cast<const uint64*>(from + 1);
+		auto index = sentCalls.value(requestId, -1);
+		if (index < 0) {
+			LOG(("Replay Info: skipping the result for an unknown request %1.").arg(requestId));
+			return;
+		}
+		auto &call = recording.calls[index];
+		call.result = mtpBuffer(end - from - 3);
+		memcpy(call.result.data(), from + 3, call.result.size() * sizeof(mtpPrime));
+		call.receivedAt = time;
+	} else if (!IsServiceMessage(type)) {
+		auto push = Push();
+		push.dc = dc;
+		push.body = mtpBuffer(end - from);
+		memcpy(push.body.data(), from, push.body.size() * sizeof(mtpPrime));
+		push.receivedAt = time;
+		recording.pushes.push_back(std_::move(push));
+	}
+}
+
+void SkipString(const mtpPrime *&from, const mtpPrime *end) {
+	MTPstring().read(from, end);
+}
+
+} // namespace
+
+bool Recording::load(const QString &path) {
+	using namespace MTP::internal;
+
+	QFile file(path);
+	if (!file.open(QIODevice::ReadOnly)) {
+		LOG(("Replay Error: could not open '%1'.").arg(path));
+		return false;
+	}
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_1);
+
+	quint32 signature = 0;
+	qint32 version = 0;
+	stream >> signature >> version;
+	if (signature != Capture::kSignature || version != Capture::kVersion) {
+		LOG(("Replay Error: '%1' is not a traffic capture of version %2.").arg(path).arg(Capture::kVersion));
+		return false;
+	}
+
+	auto keyIdByDc = QMap<ShiftedDcId, uint64>();
+	auto sentCallsByKeyId = QMap<uint64, QMap<uint64, int>>();
+	while (!stream.atEnd()) {
+		qint32 type = 0, dc = 0;
+		qint64 time = 0;
+		QByteArray bytes;
+		stream >> type >> dc >> time >> bytes;
+		if (stream.status() != QDataStream::Ok) {
+			LOG(("Replay Error: '%1' is cut, using the records before the cut.").arg(path));
+			break;
+		}
+
+		if (Capture::Record(type) == Capture::Record::Key) {
+			if (bytes.size() != kKeySize) {
+				LOG(("Replay Error: bad key size %1 in '%2'.").arg(bytes.size()).arg(path));
+				return false;
+			}
+			auto key = MakeShared<MTP::AuthKey>();
+			key->setKey(bytes.constData());
+			key->setDC(dc);
+			keyIdByDc.insert(dc, key->keyId());
+			_keys[key->keyId()].key = key;
+			continue;
+		}
+
+		auto keyId = keyIdByDc.value(dc);
+		auto i = _keys.find(keyId);
+		if (i == _keys.end()) {
+			LOG(("Replay Error: a message of dc %1 comes before its key in '%2'.").arg(dc).arg(path));
+			return false;
+		}
+		auto &recording = i.value();
+		auto &sentCalls = sentCallsByKeyId[keyId];
+		auto from = reinterpret_cast<const mtpPrime*>(bytes.constData());
+		auto end = from + (bytes.size() / sizeof(mtpPrime));
+		auto sent = (Capture::Record(type) == Capture::Record::Sent);
+		try {
+			EnumerateMessages(from, end, [&recording, &sentCalls, sent, dc, time](uint64 msgId, const mtpPrime *from, const mtpPrime *end) {
+				if (sent) {
+					AddSent(recording, sentCalls, dc, time, msgId, from, end);
+				} else {
+					AddReceived(recording, sentCalls, dc, time, from, end);
+				}
+			});
+		} catch (Exception &e) {
+			LOG(("Replay Error: bad message of dc %1 in '%2', %3").arg(dc).arg(path).arg(e.what()));
+			return false;
+		}
+	}
+
+	auto calls = 0, results = 0, pushes = 0;
+	for_const (auto &recording, _keys) {
+		calls += recording.calls.size();
+		pushes += recording.pushes.size();
+		for_const (auto &call, recording.calls) {
+			if (call.receivedAt) ++results;
+		}
+	}
+	LOG(("Replay Info: loaded %1 keys, %2 calls with %3 results and %4 pushes.").arg(_keys.size()).arg(calls).arg(results).arg(pushes));
+	return true;
+}
+
+KeyRecording *Recording::find(uint64 keyId) {
+	auto i = _keys.find(keyId);
+	return (i != _keys.end()) ? &i.value() : nullptr;
+}
+
+Call *Recording::take(KeyRecording &recording, const mtpPrime *from, const mtpPrime *end) {
+	auto size = end - from;
+	auto available = [](const Call &call) {
+		return !call.used && call.receivedAt;
+	};
+	auto sameType = static_cast<Call*>(nullptr);
+	for (auto &call : recording.calls) {
+		if (!available(call) || call.query.isEmpty() || call.query[0] != *from) {
+			continue;
+		}
+		if (call.query.size() == size && !memcmp(call.query.constData(), from, size * sizeof(mtpPrime))) {
+			call.used = true;
+			return &call;
+		} else if (!sameType) {
+			sameType = &call;
+		}
+	}
+	if (sameType) {
+		sameType->used = true;
+	}
+	return sameType;
+}
+
+void EnumerateMessages(const mtpPrime *from, const mtpPrime *end, base::lambda<void(uint64 msgId, const mtpPrime *from, const mtpPrime *end)> method) {
+	if (from + kMessageHeaderSize + 1 > end) throw mtpErrorInsufficient();
+
+	auto msgId = *reinterpret_cast<const uint64*>(from);
+	auto length = uint32(from[3]);
+	auto body = from + kMessageHeaderSize;
+	auto bodyEnd = body + (length >> 2);
+	if ((length & 0x03) || bodyEnd > end || bodyEnd == body) throw mtpErrorInsufficient();
+
+	if (mtpTypeId(*body) != mtpc_msg_container) {
+		method(msgId, body, bodyEnd);
+		return;
+	}
+	if (body + 2 > bodyEnd) throw mtpErrorInsufficient();
+	auto count = body[1];
+	auto inner = body + 2;
+	for (auto i = 0; i != count; ++i) {
+		if (inner + kMessageHeaderSize + 1 > bodyEnd) throw mtpErrorInsufficient();
+		auto innerId = *reinterpret_cast<const uint64*>(inner);
+		auto innerLength = uint32(inner[3]);
+		auto innerBody = inner + kMessageHeaderSize;
+		auto innerEnd = innerBody + (innerLength >> 2);
+		if ((innerLength & 0x03) || innerEnd > bodyEnd || innerEnd == innerBody) throw mtpErrorInsufficient();
+
+		method(innerId, innerBody, innerEnd);
+		inner = innerEnd;
+	}
+}
+
+const mtpPrime *SkipInvokeWrappers(const mtpPrime *from, const mtpPrime *end) {
+	while (from < end) {
+		switch (mtpTypeId(*from)) {
+		case mtpc_invokeWithLayer: from += 2; break; // layer:int
+		case mtpc_invokeWithoutUpdates: from += 1; break;
+		case mtpc_invokeAfterMsg: from += 3; break; // msg_id:long
+		case mtpc_invokeAfterMsgs: {
+			++from;
+			MTPVector<MTPlong> ids;
+			ids.read(from, end);
+		} break;
+		case mtpc_initConnection: {
+			from += 2; // api_id:int
+			SkipString(from, end); // device_model
+			SkipString(from, end); // system_version
+			SkipString(from, end); // app_version
+			SkipString(from, end); // lang_code
+		} break;
+		default: return from;
+		}
+	}
+	throw mtpErrorInsufficient();
+}
+
+bool IsServiceMessage(mtpTypeId type) {
+	switch (type) {
+	case mtpc_msgs_ack:
+	case mtpc_bad_msg_notification:
+	case mtpc_bad_server_salt:
+	case mtpc_msgs_state_req:
+	case mtpc_msgs_state_info:
+	case mtpc_msgs_all_info:
+	case mtpc_msg_detailed_info:
+	case mtpc_msg_new_detailed_info:
+	case mtpc_msg_resend_req:
+	case mtpc_future_salts:
+	case mtpc_pong:
+	case mtpc_new_session_created:
+	case mtpc_http_wait:
+	case mtpc_rpc_drop_answer:
+	case mtpc_get_future_salts:
+	case mtpc_ping:
+	case mtpc_ping_delay_disconnect:
+	case mtpc_destroy_session:
+		return true;
+	}
+	return false;
+}
+
+} // namespace Replay
@@ -0,0 +1,82 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#pragma once
+
+#include "mtproto/auth_key.h"
+
+namespace Replay {
+
+// A recorded rpc call with its result.
+struct Call {
+	ShiftedDcId dc = 0;
+	mtpBuffer query; // Without the invokeWithLayer, initConnection and invokeAfterMsg wrappers.
+	TimeMs sentAt = 0;
+	mtpBuffer result; // The rpc_result body after req_msg_id, it may be gzip_packed.
+	TimeMs receivedAt = 0;
+	bool used = false;
+};
+
+// The message which was not a response to anything, an update usually.
+struct Push {
+	ShiftedDcId dc = 0;
+	mtpBuffer body;
+	TimeMs receivedAt = 0;
+	bool sent = false;
+};
+
+struct KeyRecording {
+	MTP::AuthKeyPtr key;
+	QVector<Call> calls;
+	QVector<Push> pushes;
+
+	// Push times are counted from the first call sent to that dc.
+	QMap<ShiftedDcId, TimeMs> firstSentAt;
+	QMap<ShiftedDcId, TimeMs> replayStartedAt;
+};
+
+class Recording {
+public:
+	bool load(const QString &path);
+
+	KeyRecording *find(uint64 keyId);
+
+	// The call with the same query bytes is taken first, so that the file
+	// parts or the history slices are answered with the same data. Then the
+	// first unused call of the same query type is taken. Returns nullptr
+	// if the client makes more calls of that type than were recorded.
+	Call *take(KeyRecording &recording, const mtpPrime *from, const mtpPrime *end);
+
+private:
+	QMap<uint64, KeyRecording> _keys;
+
+};
+
+// Calls the method for each message from msg_id to the body end, the
+// messages of msg_container are passed one by one.
+void EnumerateMessages(const mtpPrime *from, const mtpPrime *end, base::lambda<void(uint64 msgId, const mtpPrime *from, const mtpPrime *end)> method);
+
+// Returns the query start after all the invoke wrappers.
+const mtpPrime *SkipInvokeWrappers(const mtpPrime *from, const mtpPrime *end);
+
+// The service messages are not calls and not pushes, they are never replayed.
+bool IsServiceMessage(mtpTypeId type);
+
+} // namespace Replay
@@ -0,0 +1,404 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#include "stdafx.h"
+#include "benchmarks/replay_server.h"
+
+#include "benchmarks/replay_recording.h"
+
+#include <QtNetwork/QTcpSocket>
+#include <openssl/sha.h>
+
+namespace Replay {
+namespace {
+
+constexpr auto kNonceSize = 64;
+constexpr auto kProtocolTag = 0xefefefefU;
+constexpr auto kShortLengthMax = 0x7f;
+constexpr auto kEncryptedHeaderSize = 6; // 2: auth_key_id, 4: msg_key
+constexpr auto kPlainHeaderSize = 8; // 2: salt, 2: session_id, 2: msg_id, 1: seq_no, 1: message_length
+constexpr auto kNotRecordedErrorCode = 400;
+constexpr auto kStateReceived = char(4);
+
+TimeMs Now() {
+	static QElapsedTimer timer;
+	if (!timer.isValid()) {
+		timer.start();
+	}
+	return timer.elapsed();
+}
+
+void AppendId(mtpBuffer &to, uint64 id) {
+	to.push_back(mtpPrime(id & 0xFFFFFFFFULL));
+	to.push_back(mtpPrime(id >> 32));
+}
+
+class Connection : public QObject {
+public:
+	Connection(QObject *parent, QTcpSocket *socket, Recording &recording, bool fast);
+
+private:
+	void read();
+	bool startTransport();
+	void handlePacket(const mtpPrime *from, const mtpPrime *end);
+	void handleFakeRequestPq(const mtpPrime *from, const mtpPrime *end);
+	void handleEncrypted(const mtpPrime *from, const mtpPrime *end);
+	void handleMessage(uint64 msgId, const mtpPrime *from, const mtpPrime *end);
+	void handleStateRequest(uint64 msgId, const mtpPrime *from, const mtpPrime *end);
+	void handleCall(uint64 msgId, const mtpPrime *from, const mtpPrime *end);
+	void startPushes();
+	void sendPush(int index);
+	void sendMessage(const mtpBuffer &body, bool response, TimeMs delay);
+	void sendPacket(const mtpBuffer &packet);
+	uint64 nextMsgId(bool response);
+	void close(const QString &reason);
+
+	QTcpSocket *_socket = nullptr;
+	Recording &_recording;
+	bool _fast = false;
+
+	bool _started = false;
+	QByteArray _received; // The nonce before the start, then the decrypted unfinished packets.
+	char _receiveKey[MTP::CTRState::KeySize];
+	MTP::CTRState _receiveState;
+	char _sendKey[MTP::CTRState::KeySize];
+	MTP::CTRState _sendState;
+
+	KeyRecording *_keyRecording = nullptr;
+	uint64 _salt = 0;
+	uint64 _session = 0;
+	ShiftedDcId _dc = 0; // Recorded dc of the calls made through this connection.
+	uint64 _lastMsgId = 0;
+	int _seqNo = 0;
+
+};
+
+Connection::Connection(QObject *parent, QTcpSocket *socket, Recording &recording, bool fast) : QObject(parent)
+, _socket(socket)
+, _recording(recording)
+, _fast(fast) {
+	_socket->setParent(this);
+	connect(_socket, &QTcpSocket::readyRead, this, [this] { read(); });
+	connect(_socket, &QTcpSocket::disconnected, this, [this] { deleteLater(); });
+}
+
+void Connection::read() {
+	auto bytes = _socket->readAll();
+	if (_started) {
+		MTP::aesCtrEncrypt(bytes.data(), bytes.size(), _receiveKey, &_receiveState);
+		_received.append(bytes);
+	} else {
+		_received.append(bytes);
+		if (_received.size() < kNonceSize) {
+			return;
+		} else if (!startTransport()) {
+			return close(qsl("not an obfuscated abridged transport"));
+		}
+	}
+
+	while (!_received.isEmpty() && _socket->state() == QAbstractSocket::ConnectedState) {
+		auto data = reinterpret_cast<const uchar*>(_received.constData());
+		auto length = uint32(data[0]);
+		auto header = 1;
+		if (length == kShortLengthMax) {
+			if (_received.size() < 4) break;
+			length = (uint32(data[3]) << 16) | (uint32(data[2]) << 8) | uint32(data[1]);
+			header = 4;
+		}
+		auto size = header + length * sizeof(mtpPrime);
+		if (uint32(_received.size()) < size) break;
+
+		auto packet = mtpBuffer(length);
+		memcpy(packet.data(), data + header, length * sizeof(mtpPrime));
+		_received.remove(0, size);
+		try {
+			handlePacket(packet.constData(), packet.constData() + packet.size());
+		} catch (Exception &e) {
+			return close(qsl("bad packet, %1").arg(e.what()));
+		}
+	}
+}
+
+// The client sends 64 random bytes first, its send key and iv are in the
+// middle of them and its receive key and iv are the same bytes reversed.
+bool Connection::startTransport() {
+	auto nonce = _received.mid(0, kNonceSize);
+	_received.remove(0, kNonceSize);
+
+	memcpy(_receiveKey, nonce.constData() + 8, MTP::CTRState::KeySize);
+	memcpy(_receiveState.ivec, nonce.constData() + 8 + MTP::CTRState::KeySize, MTP::CTRState::IvecSize);
+
+	char reversed[48];
+	memcpy(reversed, nonce.constData() + 8, sizeof(reversed));
+	std::reverse(reversed, reversed + base::array_size(reversed));
+	memcpy(_sendKey, reversed, MTP::CTRState::KeySize);
+	memcpy(_sendState.ivec, reversed + MTP::CTRState::KeySize, MTP::CTRState::IvecSize);
+
+	MTP::aesCtrEncrypt(nonce.data(), kNonceSize, _receiveKey, &_receiveState);
+	if (*reinterpret_cast<const uint32*>(nonce.constData() + 56) != kProtocolTag) {
+		return false;
+	}
+	MTP::aesCtrEncrypt(_received.data(), _received.size(), _receiveKey, &_receiveState);
+	_started = true;
+	return true;
+}
+
+void Connection::handlePacket(const mtpPrime *from, const mtpPrime *end) {
+	if (from + 2 > end) throw mtpErrorInsufficient();
+
+	auto keyId = *reinterpret_cast<const uint64*>(from);
+	if (keyId) {
+		handleEncrypted(from, end);
+	} else {
+		handleFakeRequestPq(from + 2, end);
+	}
+}
+
+// The transport is chosen by the first answered req_pq, the client
+// only checks the nonce in res_pq, the auth key is taken from tdata.
+void Connection::handleFakeRequestPq(const mtpPrime *from, const mtpPrime *end) {
+	if (from + 4 > end) throw mtpErrorInsufficient();
+	from += 3; // 2: msg_id, 1: message_length
+
+	MTPReq_pq request;
+	request.read(from, end);
+
+	auto body = mtpBuffer();
+	MTPResPQ(MTP_resPQ(request.vnonce, MTP_int128(Now(), 0), MTP_string(std::string()), MTP_vector<MTPlong>(0))).write(body);
+
+	auto packet = mtpBuffer();
+	packet.reserve(5 + body.size());
+	AppendId(packet, 0);
+	AppendId(packet, nextMsgId(true));
+	packet.push_back(body.size() * sizeof(mtpPrime));
+	packet += body;
+	sendPacket(packet);
+}
+
+void Connection::handleEncrypted(const mtpPrime *from, const mtpPrime *end) {
+	auto keyId = *reinterpret_cast<const uint64*>(from);
+	auto encryptedSize = (end - from - kEncryptedHeaderSize) * sizeof(mtpPrime);
+	if (end - from < kEncryptedHeaderSize + kPlainHeaderSize || (encryptedSize & 0x0F)) {
+		throw mtpErrorInsufficient();
+	}
+	if (!_keyRecording) {
+		_keyRecording = _recording.find(keyId);
+		if (!_keyRecording) {
+			return close(qsl("auth_key_id %1 was not recorded").arg(keyId));
+		}
+	} else if (_keyRecording->key->keyId() != keyId) {
+		return close(qsl("auth_key_id changed to %1").arg(keyId));
+	}
+
+	auto &msgKey = *reinterpret_cast<const MTPint128*>(from + 2);
+	MTPint256 aesKey, aesIV;
+	_keyRecording->key->prepareAES(msgKey, aesKey, aesIV, true);
+
+	auto decrypted = mtpBuffer(end - from - kEncryptedHeaderSize);
+	MTP::aesIgeDecrypt(from + kEncryptedHeaderSize, decrypted.data(), encryptedSize, &aesKey, &aesIV);
+
+	auto data = decrypted.constData();
+	auto length = uint32(data[7]);
+	if ((length & 0x03) || length > encryptedSize - kPlainHeaderSize * sizeof(mtpPrime)) {
+		throw mtpErrorInsufficient();
+	}
+	_salt = *reinterpret_cast<const uint64*>(data);
+	_session = *reinterpret_cast<const uint64*>(data + 2);
+
+	EnumerateMessages(data + 4, data + kPlainHeaderSize + (length >> 2), [this](uint64 msgId, const mtpPrime *from, const mtpPrime *end) {
+		handleMessage(msgId, from, end);
+	});
+}
+
+void Connection::handleMessage(uint64 msgId, const mtpPrime *from, const mtpPrime *end) {
+	switch (mtpTypeId(*from)) {
+	case mtpc_ping:
+	case mtpc_ping_delay_disconnect: {
+		if (from + 3 > end) throw mtpErrorInsufficient();
+		auto pingId = *reinterpret_cast<const uint64*>(from + 1);
+		auto body = mtpBuffer();
+		MTPPong(MTP_pong(MTP_long(msgId), MTP_long(pingId))).write(body);
+		sendMessage(body, true, 0);
+	} break;
+
+	case mtpc_msgs_state_req: handleStateRequest(msgId, from, end); break;
+
+	default: {
+		if (!IsServiceMessage(mtpTypeId(*from))) {
+			handleCall(msgId, from, end);
+		}
+	} break;
+	}
+}
+
+// All the calls are answered, so the state of each is "received".
+void Connection::handleStateRequest(uint64 msgId, const mtpPrime *from, const mtpPrime *end) {
+	MTPMsgsStateReq request;
+	request.read(from, end);
+
+	auto count = request.c_msgs_state_req().vmsg_ids.c_vector().v.size();
+	auto body = mtpBuffer();
+	MTPMsgsStateInfo(MTP_msgs_state_info(MTP_long(msgId), MTP_string(std::string(count, kStateReceived)))).write(body);
+	sendMessage(body, true, 0);
+}
+
+void Connection::handleCall(uint64 msgId, const mtpPrime *from, const mtpPrime *end) {
+	auto query = SkipInvokeWrappers(from, end);
+
+	auto body = mtpBuffer();
+	body.push_back(mtpc_rpc_result);
+	AppendId(body, msgId);
+
+	auto call = _recording.take(*_keyRecording, query, end);
+	if (!call) {
+		LOG(("Replay Info: no recorded result left for the call #%1, answering with an error.").arg(uint32(*query), 0, 16));
+		MTPRpcError(MTP_rpc_error(MTP_int(kNotRecordedErrorCode), MTP_string("REPLAY_NOT_RECORDED"))).write(body);
+		sendMessage(body, true, 0);
+		return;
+	}
+	body += call->result;
+	auto latency = call->receivedAt - call->sentAt;
+	if (!_dc) {
+		_dc = call->dc;
+		startPushes();
+	}
+	sendMessage(body, true, _fast ? 0 : latency);
+}
+
+void Connection::startPushes() {
+	auto &recording = *_keyRecording;
+	auto now = Now();
+	if (!recording.replayStartedAt.contains(_dc)) {
+		recording.replayStartedAt.insert(_dc, now);
+	}
+	auto elapsed = now - recording.replayStartedAt.value(_dc);
+	auto firstSentAt = recording.firstSentAt.value(_dc);
+	for (auto i = 0, count = recording.pushes.size(); i != count; ++i) {
+		auto &push = recording.pushes[i];
+		if (push.dc != _dc || push.sent) {
+			continue;
+		} else if (_fast) {
+			sendPush(i);
+		} else {
+			auto delay = qMax(push.receivedAt - firstSentAt - elapsed, 0LL);
+			QTimer::singleShot(delay, this, [this, i] { sendPush(i); });
+		}
+	}
+}
+
+// The pushes may be scheduled by several connections of the same dc.
+void Connection::sendPush(int index) {
+	auto &push = _keyRecording->pushes[index];
+	if (!push.sent) {
+		push.sent = true;
+		sendMessage(push.body, false, 0);
+	}
+}
+
+void Connection::sendMessage(const mtpBuffer &body, bool response, TimeMs delay) {
+	if (delay > 0) {
+		QTimer::singleShot(delay, this, [this, body, response] {
+			sendMessage(body, response, 0);
+		});
+		return;
+	}
+
+	auto plain = mtpBuffer();
+	plain.reserve(kPlainHeaderSize + body.size() + 3);
+	AppendId(plain, _salt);
+	AppendId(plain, _session);
+	AppendId(plain, nextMsgId(response));
+	plain.push_back(2 * (_seqNo++) + 1);
+	plain.push_back(body.size() * sizeof(mtpPrime));
+	plain += body;
+
+	uchar sha1[20];
+	SHA1(reinterpret_cast<const uchar*>(plain.constData()), plain.size() * sizeof(mtpPrime), sha1);
+	auto &msgKey = *reinterpret_cast<const MTPint128*>(sha1 + 4);
+
+	while (plain.size() & 0x03) {
+		plain.push_back(0); // AES-IGE works with the 16 byte blocks.
+	}
+	MTPint256 aesKey, aesIV;
+	_keyRecording->key->prepareAES(msgKey, aesKey, aesIV, false);
+
+	auto packet = mtpBuffer(kEncryptedHeaderSize + plain.size());
+	*reinterpret_cast<uint64*>(packet.data()) = _keyRecording->key->keyId();
+	*reinterpret_cast<MTPint128*>(packet.data() + 2) = msgKey;
+	MTP::aesIgeEncrypt(plain.constData(), packet.data() + kEncryptedHeaderSize, plain.size() * sizeof(mtpPrime), &aesKey, &aesIV);
+	sendPacket(packet);
+}
+
+void Connection::sendPacket(const mtpBuffer &packet) {
+	auto size = uint32(packet.size());
+	auto data = QByteArray();
+	data.reserve(4 + size * sizeof(mtpPrime));
+	if (size < kShortLengthMax) {
+		data.append(char(size));
+	} else {
+		data.append(char(kShortLengthMax));
+		data.append(char(size & 0xFF));
+		data.append(char((size >> 8) & 0xFF));
+		data.append(char((size >> 16) & 0xFF));
+	}
+	data.append(reinterpret_cast<const char*>(packet.constData()), size * sizeof(mtpPrime));
+	MTP::aesCtrEncrypt(data.data(), data.size(), _sendKey, &_sendState);
+	_socket->write(data);
+}
+
+// Server msg_id is unixtime in the high part and grows with each message,
+// it ends with 01 for the responses and with 11 for the other messages.
+uint64 Connection::nextMsgId(bool response) {
+	auto now = QDateTime::currentMSecsSinceEpoch();
+	auto result = (uint64(now / 1000) << 32) | (uint64(now % 1000) << 22);
+	result = qMax(result & ~0x03ULL, _lastMsgId + 4);
+	_lastMsgId = result;
+	return result | (response ? 0x01 : 0x03);
+}
+
+void Connection::close(const QString &reason) {
+	LOG(("Replay Error: closing the connection, %1.").arg(reason));
+	_socket->disconnectFromHost();
+}
+
+} // namespace
+
+Server::Server(Recording &recording, bool fast)
+: _recording(recording)
+, _fast(fast) {
+	QObject::connect(&_server, &QTcpServer::newConnection, [this] { newConnection(); });
+}
+
+bool Server::listen(quint16 port) {
+	if (!_server.listen(QHostAddress::LocalHost, port)) {
+		LOG(("Replay Error: could not listen on port %1, %2").arg(port).arg(_server.errorString()));
+		return false;
+	}
+	LOG(("Replay Info: listening on 127.0.0.1:%1%2.").arg(port).arg(_fast ? " without delays" : ""));
+	return true;
+}
+
+void Server::newConnection() {
+	while (auto socket = _server.nextPendingConnection()) {
+		new Connection(&_server, socket, _recording, _fast);
+	}
+}
+
+} // namespace Replay
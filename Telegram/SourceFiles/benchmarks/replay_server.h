@@ -0,0 +1,52 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#pragma once
+
+#include <QtNetwork/QTcpServer>
+
+namespace Replay {
+
+class Recording;
+
+// Stands in for all the dcs of the recorded client. It accepts the
+// obfuscated abridged transport of MTP::internal::TCPConnection, answers
+// the fake req_pq and the calls of the client with the recorded results,
+// encrypting them with the recorded auth keys. The client must be started
+// with -mtpreplay and a copy of the tdata it had when the capture was made.
+class Server {
+public:
+	// With fast the results and pushes are sent right away, otherwise each
+	// result comes with the recorded latency and each push at its recorded
+	// time from the first call made to that dc.
+	Server(Recording &recording, bool fast);
+
+	bool listen(quint16 port);
+
+private:
+	void newConnection();
+
+	QTcpServer _server;
+	Recording &_recording;
+	bool _fast = false;
+
+};
+
+} // namespace Replay
@@ -0,0 +1,46 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#pragma once
+
+// The benchmarked sources include "stdafx.h" as usual, the Benchmarks
+// target finds this header first, so they get Qt core and the non-GUI
+// basics only, the same part of the main precompiled header they use.
+
+#define NOMINMAX // no min() and max() macro declarations
+#define __HUGE
+
+#ifdef __cplusplus
+
+#include <cmath>
+
+#include <QtCore/QtCore>
+
+#include "core/basic_types.h"
+#include "logs.h"
+#include "core/utils.h"
+#include "core/lambda.h"
+#include "settings.h"
+
+#include "mtproto/core_types.h"
+
+#include "benchmarks/benchmarks_app.h"
+
+#endif // __cplusplus
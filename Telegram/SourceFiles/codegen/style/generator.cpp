@@ -172,6 +172,18 @@ QString moduleBaseName(const structure::Module &module) {
 	return moduleIsPalette ? "palette" : "style_" + moduleInfo.baseName();
 }
 
+// Such values don't depend on the scale or on the other modules, so they are
+// constant-initialized in the definitions and skipped in the init_ function.
+bool isConstantValue(const structure::Value &value) {
+	if (!value.copyOf().isEmpty()) {
+		return false;
+	}
+	auto tag = value.type().tag;
+	return (tag == Tag::Int)
+		|| (tag == Tag::Double)
+		|| (tag == Tag::Align);
+}
+
 QString colorFallbackName(structure::Value value) {
 	auto copy = value.copyOf();
 	if (!copy.isEmpty()) {
@@ -684,7 +696,11 @@ bool Generator::writeVariableDefinitions() {
 		if (type.isEmpty()) {
 			return false;
 		}
-		source_->stream() << type << " _" << name << " = " << typeToDefaultValue(variable.value.type()) << ";\n";
+		auto value = isConstantValue(variable.value) ? valueAssignmentCode(variable.value) : typeToDefaultValue(variable.value.type());
+		if (value.isEmpty()) {
+			return false;
+		}
+		source_->stream() << type << " _" << name << " = " << value << ";\n";
 		return true;
 	});
 	return result;
@@ -973,6 +989,9 @@ void init_" << baseName_ << "() {\n\
 	if (isPalette_) {
 		source_->stream() << "\t_palette.finalize();\n";
 	} else if (!module_.enumVariables([this](const Variable &variable) -> bool {
+		if (isConstantValue(variable.value)) {
+			return true;
+		}
 		auto name = variable.name.back();
 		auto value = valueAssignmentCode(variable.value);
 		if (value.isEmpty()) {
@@ -27,7 +27,7 @@ int main(int argc, char *argv[]) {
 	QCoreApplication app(argc, argv);
 
 	auto options = codegen::style::parseOptions();
-	if (options.inputPath.isEmpty()) {
+	if (options.files.empty()) {
 		return -1;
 	}
 
@@ -24,6 +24,7 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include <QtCore/QList>
 #include <QtCore/QMap>
 #include <vector>
+#include <memory>
 #include "codegen/style/structure_types.h"
 
 namespace codegen {
@@ -39,7 +40,8 @@ public:
 		return fullpath_;
 	}
 
-	void addIncluded(std::unique_ptr<Module> &&value);
+	// Included modules can be shared between several including modules.
+	void addIncluded(std::shared_ptr<const Module> &&value);
 
 	bool hasIncludes() const {
 		return !included_.empty();
@@ -99,7 +101,7 @@ public:
 
 private:
 	QString fullpath_;
-	std::vector<std::unique_ptr<Module>> included_;
+	std::vector<std::shared_ptr<const Module>> included_;
 	QList<Struct> structs_;
 	QList<Variable> variables_;
 	QMap<QString, int> structsByName_;
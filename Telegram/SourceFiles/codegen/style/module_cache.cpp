@@ -0,0 +1,80 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#include "codegen/style/module_cache.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QCryptographicHash>
+#include "codegen/style/module.h"
+
+namespace codegen {
+namespace style {
+
+ModuleCache::ModulePtr ModuleCache::find(const Options &options, const QString &filepath, Parser parser) {
+	auto key = computeKey(options, filepath);
+	if (key.isEmpty()) {
+		// The parser will report the error for the unreadable file.
+		return parser();
+	}
+
+	std::promise<ModulePtr> promise;
+	std::shared_future<ModulePtr> future;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto i = modules_.find(key);
+		if (i != modules_.end()) {
+			future = i->second;
+		} else {
+			modules_.emplace(key, promise.get_future().share());
+		}
+	}
+	if (future.valid()) {
+		++reused_;
+		return future.get();
+	}
+
+	++parsed_;
+	auto result = parser();
+	promise.set_value(result);
+	return result;
+}
+
+QByteArray ModuleCache::computeKey(const Options &options, const QString &filepath) const {
+	QFile file(filepath);
+	if (!file.open(QIODevice::ReadOnly)) {
+		return QByteArray();
+	}
+
+	// All the include paths are in the key, the icons are searched in each
+	// of them, including the first one: the directory of the including file.
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	hash.addData(QFileInfo(filepath).absoluteFilePath().toUtf8());
+	hash.addData(options.isPalette ? "\1" : "\0", 1);
+	for (const auto &path : options.includePaths) {
+		hash.addData(path.toUtf8());
+		hash.addData("\0", 1);
+	}
+	hash.addData(file.readAll());
+	return hash.result();
+}
+
+} // namespace style
+} // namespace codegen
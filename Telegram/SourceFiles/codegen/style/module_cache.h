@@ -0,0 +1,75 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <future>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <QtCore/QString>
+#include <QtCore/QByteArray>
+#include "codegen/style/options.h"
+
+namespace codegen {
+namespace style {
+namespace structure {
+class Module;
+} // namespace structure
+
+// Keeps the modules parsed during a single launch, so that the modules
+// imported by several style files are tokenized and parsed only once.
+// Modules are keyed by a hash of the file content and the options
+// that affect the parsing result, it is safe to use from many threads.
+class ModuleCache {
+public:
+	using ModulePtr = std::shared_ptr<const structure::Module>;
+	using Parser = std::function<ModulePtr()>;
+
+	ModuleCache() = default;
+	ModuleCache(const ModuleCache &other) = delete;
+	ModuleCache &operator=(const ModuleCache &other) = delete;
+
+	// Returns the module parsed from the same content or calls the parser.
+	// Concurrent requests for the same module wait for the first one.
+	// Failed results are cached as well, they are returned as nullptr.
+	ModulePtr find(const Options &options, const QString &filepath, Parser parser);
+
+	int parsed() const {
+		return parsed_.load();
+	}
+	int reused() const {
+		return reused_.load();
+	}
+
+private:
+	QByteArray computeKey(const Options &options, const QString &filepath) const;
+
+	std::mutex mutex_;
+	std::map<QByteArray, std::shared_future<ModulePtr>> modules_;
+	std::atomic<int> parsed_ = { 0 };
+	std::atomic<int> reused_ = { 0 };
+
+};
+
+} // namespace style
+} // namespace codegen
@@ -32,15 +32,17 @@ namespace {
 constexpr int kErrorIncludePathExpected     = 901;
 constexpr int kErrorOutputPathExpected      = 902;
 constexpr int kErrorInputPathExpected       = 903;
-constexpr int kErrorSingleInputPathExpected = 904;
 constexpr int kErrorWorkingPathExpected     = 905;
+constexpr int kErrorThreadsCountExpected    = 906;
 
 } // namespace
 
 using common::logError;
 
-Options parseOptions() {
-	Options result;
+LaunchOptions parseOptions() {
+	Options defaults;
+	LaunchOptions result;
+	QStringList inputPaths;
 	auto args = QCoreApplication::instance()->arguments();
 	for (int i = 1, count = args.size(); i < count; ++i) { // skip first
 		auto &arg = args.at(i);
@@ -49,50 +51,67 @@ Options parseOptions() {
 		if (arg == "-I") {
 			if (++i == count) {
 				logError(kErrorIncludePathExpected, "Command Line") << "include path expected after -I";
-				return Options();
+				return LaunchOptions();
 			} else {
-				result.includePaths.push_back(args.at(i));
+				defaults.includePaths.push_back(args.at(i));
 			}
 		} else if (arg.startsWith("-I")) {
-			result.includePaths.push_back(arg.mid(2));
+			defaults.includePaths.push_back(arg.mid(2));
 
 		// Output path
 		} else if (arg == "-o") {
 			if (++i == count) {
 				logError(kErrorOutputPathExpected, "Command Line") << "output path expected after -o";
-				return Options();
+				return LaunchOptions();
 			} else {
-				result.outputPath = args.at(i);
+				defaults.outputPath = args.at(i);
 			}
 		} else if (arg.startsWith("-o")) {
-			result.outputPath = arg.mid(2);
+			defaults.outputPath = arg.mid(2);
 
 		// Working path
 		} else if (arg == "-w") {
 			if (++i == count) {
 				logError(kErrorWorkingPathExpected, "Command Line") << "working path expected after -w";
-				return Options();
+				return LaunchOptions();
 			} else {
 				common::logSetWorkingPath(args.at(i));
 			}
 		} else if (arg.startsWith("-w")) {
 			common::logSetWorkingPath(arg.mid(2));
 
-		// Input path
-		} else {
-			if (result.inputPath.isEmpty()) {
-				result.inputPath = arg;
-			} else {
-				logError(kErrorSingleInputPathExpected, "Command Line") << "only one input path expected";
-				return Options();
+		// Threads count
+		} else if (arg.startsWith("-j")) {
+			auto value = arg.mid(2);
+			if (value.isEmpty() && ++i < count) {
+				value = args.at(i);
 			}
+			auto ok = false;
+			result.threadsCount = value.toInt(&ok);
+			if (!ok || result.threadsCount < 0) {
+				logError(kErrorThreadsCountExpected, "Command Line") << "threads count expected after -j";
+				return LaunchOptions();
+			}
+
+		// Timings report
+		} else if (arg == "-t") {
+			result.reportTimings = true;
+
+		// Input paths
+		} else {
+			inputPaths.push_back(arg);
 		}
 	}
-	if (result.inputPath.isEmpty()) {
+	if (inputPaths.isEmpty()) {
 		logError(kErrorInputPathExpected, "Command Line") << "input path expected";
-		return Options();
+		return LaunchOptions();
+	}
+	for (auto &inputPath : inputPaths) {
+		auto file = defaults;
+		file.inputPath = inputPath;
+		file.isPalette = (QFileInfo(inputPath).suffix() == "palette");
+		result.files.push_back(file);
 	}
-	result.isPalette = (QFileInfo(result.inputPath).suffix() == "palette");
 	return result;
 }
 
@@ -20,6 +20,7 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 */
 #pragma once
 
+#include <vector>
 #include <QtCore/QString>
 #include <QtCore/QStringList>
 
@@ -33,8 +34,15 @@ struct Options {
 	bool isPalette = false;
 };
 
-// Parsing failed if inputPath is empty in the result.
-Options parseOptions();
+// All the input files of a single launch share the include and output paths.
+struct LaunchOptions {
+	std::vector<Options> files;
+	int threadsCount = 0; // Zero means one thread for each hardware core.
+	bool reportTimings = false;
+};
+
+// Parsing failed if files are empty in the result.
+LaunchOptions parseOptions();
 
 } // namespace style
 } // namespace codegen
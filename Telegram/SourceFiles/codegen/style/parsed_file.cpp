@@ -26,6 +26,7 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include <QtCore/QRegularExpression>
 #include "codegen/common/basic_tokenized_file.h"
 #include "codegen/common/logging.h"
+#include "codegen/style/module_cache.h"
 
 using BasicToken = codegen::common::BasicTokenizedFile::Token;
 using BasicType = BasicToken::Type;
@@ -143,28 +144,31 @@ bool validateAlignString(const QString &value) {
 } // namespace
 
 Modifier GetModifier(const QString &name) {
-	static QMap<QString, Modifier> modifiers;
-	if (modifiers.empty()) {
-		modifiers.insert("invert", [](QImage &png100x, QImage &png200x) {
+	// Initialized once, the style files can be parsed from several threads.
+	static const auto modifiers = [] {
+		auto result = QMap<QString, Modifier>();
+		result.insert("invert", [](QImage &png100x, QImage &png200x) {
 			png100x.invertPixels();
 			png200x.invertPixels();
 		});
-		modifiers.insert("flip_horizontal", [](QImage &png100x, QImage &png200x) {
+		result.insert("flip_horizontal", [](QImage &png100x, QImage &png200x) {
 			png100x = png100x.mirrored(true, false);
 			png200x = png200x.mirrored(true, false);
 		});
-		modifiers.insert("flip_vertical", [](QImage &png100x, QImage &png200x) {
+		result.insert("flip_vertical", [](QImage &png100x, QImage &png200x) {
 			png100x = png100x.mirrored(false, true);
 			png200x = png200x.mirrored(false, true);
 		});
-	}
+		return result;
+	}();
 	return modifiers.value(name);
 }
 
-ParsedFile::ParsedFile(const Options &options)
+ParsedFile::ParsedFile(const Options &options, ModuleCache *cache)
 : filePath_(findInputFile(options))
 , file_(filePath_)
-, options_(options) {
+, options_(options)
+, cache_(cache) {
 }
 
 bool ParsedFile::read() {
@@ -215,15 +219,22 @@ common::LogStream ParsedFile::logErrorTypeMismatch() {
 	return logError(kErrorTypeMismatch) << "type mismatch: ";
 }
 
-ParsedFile::ModulePtr ParsedFile::readIncluded() {
+std::shared_ptr<const structure::Module> ParsedFile::readIncluded() {
 	if (auto usingFile = assertNextToken(BasicType::String)) {
 		if (assertNextToken(BasicType::Semicolon)) {
-			ParsedFile included(includedOptions(tokenValue(usingFile)));
-			if (included.read()) {
-				return included.getResult();
-			} else {
-				logError(kErrorInIncluded) << "error while parsing '" << tokenValue(usingFile).toStdString() << "'";
+			auto options = includedOptions(tokenValue(usingFile));
+			auto parse = [this, &options]() -> ModuleCache::ModulePtr {
+				ParsedFile included(options, cache_);
+				if (included.read()) {
+					return included.getResult();
+				}
+				return nullptr;
+			};
+			auto result = cache_ ? cache_->find(options, findInputFile(options), parse) : parse();
+			if (result) {
+				return result;
 			}
+			logError(kErrorInIncluded) << "error while parsing '" << tokenValue(usingFile).toStdString() << "'";
 		}
 	}
 	return nullptr;
@@ -34,13 +34,20 @@ namespace style {
 using Modifier = std::function<void(QImage &png100x, QImage &png200x)>;
 Modifier GetModifier(const QString &name);
 
+class ModuleCache;
+
 // Parses an input file to the internal struct.
+// Included files are taken from the cache if it is provided.
 class ParsedFile {
 public:
-	explicit ParsedFile(const Options &options);
+	explicit ParsedFile(const Options &options, ModuleCache *cache = nullptr);
 	ParsedFile(const ParsedFile &other) = delete;
 	ParsedFile &operator=(const ParsedFile &other) = delete;
 
+	QString filepath() const {
+		return filePath_;
+	}
+
 	bool read();
 
 	using ModulePtr = std::unique_ptr<structure::Module>;
@@ -71,7 +78,7 @@ private:
 	}
 
 	// Helper methods for context-dependent reading.
-	ModulePtr readIncluded();
+	std::shared_ptr<const structure::Module> readIncluded();
 	structure::Struct readStruct(const QString &name);
 	structure::Variable readVariable(const QString &name);
 
@@ -118,6 +125,7 @@ private:
 	QString filePath_;
 	common::BasicTokenizedFile file_;
 	Options options_;
+	ModuleCache *cache_ = nullptr;
 	bool failed_ = false;
 	ModulePtr module_;
 
@@ -20,10 +20,16 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 */
 #include "codegen/style/processor.h"
 
+#include <atomic>
+#include <thread>
+#include <iostream>
+#include <algorithm>
 #include <QtCore/QDir>
 #include <QtCore/QFileInfo>
+#include <QtCore/QElapsedTimer>
 #include "codegen/common/cpp_file.h"
 #include "codegen/style/parsed_file.h"
+#include "codegen/style/module_cache.h"
 #include "codegen/style/generator.h"
 
 namespace codegen {
@@ -38,34 +44,84 @@ QString destFileBaseName(const structure::Module &module) {
 
 } // namespace
 
-Processor::Processor(const Options &options)
-: parser_(std::make_unique<ParsedFile>(options))
-, options_(options) {
+Processor::Processor(const LaunchOptions &options)
+: options_(options)
+, cache_(std::make_unique<ModuleCache>()) {
 }
 
 int Processor::launch() {
-	if (!parser_->read()) {
-		return -1;
-	}
+	QElapsedTimer timer;
+	timer.start();
 
-	auto module = parser_->getResult();
-	if (!write(*module)) {
-		return -1;
+	auto filesCount = int(options_.files.size());
+	auto threadsCount = options_.threadsCount;
+	if (!threadsCount) {
+		threadsCount = std::max(int(std::thread::hardware_concurrency()), 1);
+	}
+	threadsCount = std::min(threadsCount, filesCount);
+
+	// Each file is processed by a single thread, so the timings are not shared.
+	auto timings = std::vector<Timing>(filesCount);
+	std::atomic<int> next(0);
+	auto work = [this, &timings, &next, filesCount] {
+		for (auto index = next++; index < filesCount; index = next++) {
+			process(options_.files[index], timings[index]);
+		}
+	};
+	if (threadsCount > 1) {
+		auto threads = std::vector<std::thread>();
+		for (auto i = 0; i != threadsCount; ++i) {
+			threads.emplace_back(work);
+		}
+		for (auto &thread : threads) {
+			thread.join();
+		}
+	} else {
+		work();
 	}
 
+	if (options_.reportTimings) {
+		reportTimings(timings, threadsCount, timer.elapsed());
+	}
+	for (const auto &timing : timings) {
+		if (timing.failed) {
+			return -1;
+		}
+	}
 	return 0;
 }
 
-bool Processor::write(const structure::Module &module) const {
+void Processor::process(const Options &options, Timing &timing) {
+	QElapsedTimer timer;
+	timer.start();
+
+	ParsedFile parser(options, cache_.get());
+	auto module = cache_->find(options, parser.filepath(), [&parser]() -> ModuleCache::ModulePtr {
+		if (parser.read()) {
+			return parser.getResult();
+		}
+		return nullptr;
+	});
+	timing.parse = timer.restart();
+	if (!module) {
+		timing.failed = true;
+		return;
+	}
+
+	timing.failed = !write(options, *module);
+	timing.write = timer.elapsed();
+}
+
+bool Processor::write(const Options &options, const structure::Module &module) const {
 	bool forceReGenerate = false;
-	QDir dir(options_.outputPath);
+	QDir dir(options.outputPath);
 	if (!dir.mkpath(".")) {
 		common::logError(kErrorCantWritePath, "Command Line") << "can not open path for writing: " << dir.absolutePath().toStdString();
 		return false;
 	}
 
 	QFileInfo srcFile(module.filepath());
-	QString dstFilePath = dir.absolutePath() + '/' + (options_.isPalette ? "palette" : destFileBaseName(module));
+	QString dstFilePath = dir.absolutePath() + '/' + (options.isPalette ? "palette" : destFileBaseName(module));
 
 	common::ProjectInfo project = {
 		"codegen_style",
@@ -74,7 +130,7 @@ bool Processor::write(const structure::Module &module) const {
 		forceReGenerate
 	};
 
-	Generator generator(module, dstFilePath, project, options_.isPalette);
+	Generator generator(module, dstFilePath, project, options.isPalette);
 	if (!generator.writeHeader()) {
 		return false;
 	}
@@ -82,12 +138,23 @@ bool Processor::write(const structure::Module &module) const {
 		return false;
 	}
 	auto themePath = srcFile.absoluteDir().absolutePath() + "/default.tdesktop-theme";
-	if (options_.isPalette && !generator.writeSampleTheme(themePath)) {
+	if (options.isPalette && !generator.writeSampleTheme(themePath)) {
 		return false;
 	}
 	return true;
 }
 
+void Processor::reportTimings(const std::vector<Timing> &timings, int threadsCount, qint64 total) const {
+	for (auto i = 0, count = int(timings.size()); i != count; ++i) {
+		auto &timing = timings[i];
+		std::cout << "codegen_style: " << QFileInfo(options_.files[i].inputPath).fileName().toStdString();
+		std::cout << " parsed in " << timing.parse << " ms, written in " << timing.write << " ms";
+		std::cout << (timing.failed ? ", failed\n" : "\n");
+	}
+	std::cout << "codegen_style: " << timings.size() << " files in " << total << " ms on " << threadsCount << " threads, ";
+	std::cout << cache_->parsed() << " modules parsed, " << cache_->reused() << " reused\n";
+}
+
 Processor::~Processor() = default;
 
 } // namespace style
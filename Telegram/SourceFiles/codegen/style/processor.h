@@ -21,6 +21,7 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #pragma once
 
 #include <memory>
+#include <vector>
 #include <QtCore/QString>
 #include "codegen/style/options.h"
 
@@ -29,13 +30,14 @@ namespace style {
 namespace structure {
 class Module;
 } // namespace structure
-class ParsedFile;
+class ModuleCache;
 
-// Walks through a file, parses it and parses dependency files if necessary.
+// Walks through the files, parses them and parses dependency files if necessary.
+// Several files are processed in parallel sharing the parsed dependencies.
 // Uses Generator class to produce the final output.
 class Processor {
 public:
-	explicit Processor(const Options &options);
+	explicit Processor(const LaunchOptions &options);
 	Processor(const Processor &other) = delete;
 	Processor &operator=(const Processor &other) = delete;
 
@@ -45,10 +47,18 @@ public:
 	~Processor();
 
 private:
-	bool write(const structure::Module &module) const;
+	struct Timing {
+		qint64 parse = 0;
+		qint64 write = 0;
+		bool failed = false;
+	};
 
-	std::unique_ptr<ParsedFile> parser_;
-	const Options &options_;
+	void process(const Options &options, Timing &timing);
+	bool write(const Options &options, const structure::Module &module) const;
+	void reportTimings(const std::vector<Timing> &timings, int threadsCount, qint64 total) const;
+
+	const LaunchOptions &options_;
+	std::unique_ptr<ModuleCache> cache_;
 
 	// List of files we need to generate with other instance of Generator.
 	// It is not empty only if rebuild_ flag is true.
@@ -0,0 +1,212 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#include "stdafx.h"
+#include "core/hashing.h"
+
+#include "zlib.h"
+
+#ifdef Q_PROCESSOR_X86
+#ifdef Q_CC_MSVC
+#include <intrin.h>
+#define HASHING_TARGET_PCLMUL
+#else // Q_CC_MSVC
+#include <cpuid.h>
+#define HASHING_TARGET_PCLMUL __attribute__((target("pclmul,sse4.1")))
+#endif // Q_CC_MSVC
+#include <emmintrin.h>
+#include <smmintrin.h>
+#include <wmmintrin.h>
+#endif // Q_PROCESSOR_X86
+
+namespace base {
+namespace hash {
+namespace {
+
+// zlib takes the length in uInt, OpenSSL in size_t that can be 32 bit as well.
+constexpr auto kMaxChunk = int64(1) << 30;
+
+template <typename Method>
+void FeedChunks(const void *data, int64 length, Method method) {
+	auto bytes = static_cast<const uchar*>(data);
+	while (length > 0) {
+		auto chunk = qMin(length, kMaxChunk);
+		method(bytes, chunk);
+		bytes += chunk;
+		length -= chunk;
+	}
+}
+
+#ifdef Q_PROCESSOR_X86
+
+// Shorter parts are left to zlib, the folding setup costs more for them.
+constexpr auto kPclmulMinLength = 64;
+
+bool CountPclmulSupported() {
+#ifdef Q_CC_MSVC
+	int info[4] = { 0 };
+	__cpuid(info, 1);
+	auto ecx = uint32(info[2]);
+#else // Q_CC_MSVC
+	unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+		return false;
+	}
+#endif // Q_CC_MSVC
+	constexpr auto kPclmulBit = (1U << 1);
+	constexpr auto kSse41Bit = (1U << 19);
+	return (ecx & kPclmulBit) && (ecx & kSse41Bit);
+}
+
+bool PclmulSupported() {
+	static const auto result = CountPclmulSupported();
+	return result;
+}
+
+HASHING_TARGET_PCLMUL inline __m128i Crc32Load(const uchar *from) {
+	return _mm_loadu_si128(reinterpret_cast<const __m128i*>(from));
+}
+
+// Multiplies the two halves of the value by the constants and adds the next block.
+HASHING_TARGET_PCLMUL inline __m128i Crc32Fold(__m128i value, __m128i k, __m128i next) {
+	auto low = _mm_clmulepi64_si128(value, k, 0x00);
+	auto high = _mm_clmulepi64_si128(value, k, 0x11);
+	return _mm_xor_si128(_mm_xor_si128(high, low), next);
+}
+
+// Folds 16 byte blocks with the carry-less multiplication, the constants are
+// for the bit-reflected zlib polynomial 0xEDB88320, see Intel's "Fast CRC
+// Computation for Generic Polynomials Using PCLMULQDQ Instruction".
+// The length is a multiple of 16 and at least kPclmulMinLength, the crc is
+// passed and returned inverted.
+HASHING_TARGET_PCLMUL uint32 Crc32Pclmul(const uchar *bytes, size_t length, uint32 crc) {
+	alignas(16) static const uint64 k1k2[] = { 0x0154442bd4ULL, 0x01c6e41596ULL };
+	alignas(16) static const uint64 k3k4[] = { 0x01751997d0ULL, 0x00ccaa009eULL };
+	alignas(16) static const uint64 k5k0[] = { 0x0163cd6124ULL, 0x0000000000ULL };
+	alignas(16) static const uint64 poly[] = { 0x01db710641ULL, 0x01f7011641ULL };
+
+	auto x1 = _mm_xor_si128(Crc32Load(bytes), _mm_cvtsi32_si128(int(crc)));
+	auto x2 = Crc32Load(bytes + 0x10);
+	auto x3 = Crc32Load(bytes + 0x20);
+	auto x4 = Crc32Load(bytes + 0x30);
+	bytes += 64;
+	length -= 64;
+
+	// Four blocks are folded in parallel while there are 64 bytes more.
+	auto k = _mm_load_si128(reinterpret_cast<const __m128i*>(k1k2));
+	while (length >= 64) {
+		x1 = Crc32Fold(x1, k, Crc32Load(bytes));
+		x2 = Crc32Fold(x2, k, Crc32Load(bytes + 0x10));
+		x3 = Crc32Fold(x3, k, Crc32Load(bytes + 0x20));
+		x4 = Crc32Fold(x4, k, Crc32Load(bytes + 0x30));
+		bytes += 64;
+		length -= 64;
+	}
+
+	// Then into a single block and by 16 bytes.
+	k = _mm_load_si128(reinterpret_cast<const __m128i*>(k3k4));
+	x1 = Crc32Fold(x1, k, x2);
+	x1 = Crc32Fold(x1, k, x3);
+	x1 = Crc32Fold(x1, k, x4);
+	while (length >= 16) {
+		x1 = Crc32Fold(x1, k, Crc32Load(bytes));
+		bytes += 16;
+		length -= 16;
+	}
+
+	// From 128 bits to 64 bits.
+	auto mask = _mm_setr_epi32(~0, 0, ~0, 0);
+	x2 = _mm_clmulepi64_si128(x1, k, 0x10);
+	x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+	k = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(k5k0));
+	x2 = _mm_srli_si128(x1, 4);
+	x1 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask), k, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	// And the Barrett reduction to 32 bits.
+	k = _mm_load_si128(reinterpret_cast<const __m128i*>(poly));
+	x2 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask), k, 0x10);
+	x2 = _mm_clmulepi64_si128(_mm_and_si128(x2, mask), k, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+	return uint32(_mm_extract_epi32(x1, 1));
+}
+
+#endif // Q_PROCESSOR_X86
+
+} // namespace
+
+Md5::Md5() {
+	MD5_Init(&_context);
+}
+
+void Md5::feed(const void *data, int64 length) {
+	FeedChunks(data, length, [this](const uchar *bytes, int64 chunk) {
+		MD5_Update(&_context, bytes, size_t(chunk));
+	});
+}
+
+void Md5::finish(void *dest) {
+	MD5_Final(static_cast<uchar*>(dest), &_context);
+}
+
+Sha1::Sha1() {
+	SHA1_Init(&_context);
+}
+
+void Sha1::feed(const void *data, int64 length) {
+	FeedChunks(data, length, [this](const uchar *bytes, int64 chunk) {
+		SHA1_Update(&_context, bytes, size_t(chunk));
+	});
+}
+
+void Sha1::finish(void *dest) {
+	SHA1_Final(static_cast<uchar*>(dest), &_context);
+}
+
+Sha256::Sha256() {
+	SHA256_Init(&_context);
+}
+
+void Sha256::feed(const void *data, int64 length) {
+	FeedChunks(data, length, [this](const uchar *bytes, int64 chunk) {
+		SHA256_Update(&_context, bytes, size_t(chunk));
+	});
+}
+
+void Sha256::finish(void *dest) {
+	SHA256_Final(static_cast<uchar*>(dest), &_context);
+}
+
+void Crc32::feed(const void *data, int64 length) {
+	FeedChunks(data, length, [this](const uchar *bytes, int64 chunk) {
+#ifdef Q_PROCESSOR_X86
+		if (chunk >= kPclmulMinLength && PclmulSupported()) {
+			auto folded = chunk & ~int64(15);
+			_value = ~Crc32Pclmul(bytes, size_t(folded), ~_value);
+			bytes += folded;
+			chunk -= folded;
+		}
+#endif // Q_PROCESSOR_X86
+		_value = uint32(crc32(_value, bytes, uInt(chunk)));
+	});
+}
+
+} // namespace hash
+} // namespace base
@@ -0,0 +1,103 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#pragma once
+
+#include <openssl/md5.h>
+#include <openssl/sha.h>
+
+namespace base {
+namespace hash {
+
+// Streaming hashes for the uploaded parts, the local files and the packets.
+// OpenSSL selects its assembly code for the running CPU itself (SSSE3, AVX
+// and the SHA extensions). The crc32 is folded with PCLMULQDQ when the CPU
+// has it, zlib computes the short parts and the rest on the other CPUs.
+// After finish() the object can't be fed any more.
+
+class Md5 {
+public:
+	static constexpr auto kSize = 16;
+
+	Md5();
+	void feed(const void *data, int64 length);
+	void feed(const QByteArray &data) {
+		feed(data.constData(), data.size());
+	}
+	void finish(void *dest); // Writes kSize bytes.
+
+private:
+	MD5_CTX _context;
+
+};
+
+class Sha1 {
+public:
+	static constexpr auto kSize = 20;
+
+	Sha1();
+	void feed(const void *data, int64 length);
+	void feed(const QByteArray &data) {
+		feed(data.constData(), data.size());
+	}
+	void finish(void *dest); // Writes kSize bytes.
+
+private:
+	SHA_CTX _context;
+
+};
+
+class Sha256 {
+public:
+	static constexpr auto kSize = 32;
+
+	Sha256();
+	void feed(const void *data, int64 length);
+	void feed(const QByteArray &data) {
+		feed(data.constData(), data.size());
+	}
+	void finish(void *dest); // Writes kSize bytes.
+
+private:
+	SHA256_CTX _context;
+
+};
+
+// The same checksum as zlib and the PNG format use, it is stored in
+// the language packs and the theme caches, so it can't be replaced by
+// the CRC32-C that the SSE 4.2 crc32 instruction computes. The carry-less
+// multiplication folding works for any polynomial, so it is used instead.
+class Crc32 {
+public:
+	void feed(const void *data, int64 length);
+	void feed(const QByteArray &data) {
+		feed(data.constData(), data.size());
+	}
+	uint32 result() const {
+		return _value;
+	}
+
+private:
+	uint32 _value = 0;
+
+};
+
+} // namespace hash
+} // namespace base
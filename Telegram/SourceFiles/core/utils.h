@@ -21,6 +21,7 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #pragma once
 
 #include "core/basic_types.h"
+#include "core/hashing.h"
 
 namespace base {
 
@@ -224,7 +225,6 @@ using TimeMs = int64;
 bool checkms(); // returns true if time has changed
 TimeMs getms(bool checked = false);
 
-const static uint32 _md5_block_size = 64;
 class HashMd5 {
 public:
 
@@ -234,15 +234,9 @@ public:
 
 private:
 
-	void init();
-	void finalize();
-	void transform(const uchar *block);
-
-	bool _finalized;
-	uchar _buffer[_md5_block_size];
-	uint32 _count[2];
-	uint32 _state[4];
-	uchar _digest[16];
+	base::hash::Md5 _md5;
+	bool _finalized = false;
+	int32 _digest[4];
 
 };
 
@@ -0,0 +1,211 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#include "stdafx.h"
+#include "data/data_mention_index.h"
+
+#include "observer_peer.h"
+
+namespace Data {
+namespace {
+
+using UpdateFlag = Notify::PeerUpdate::Flag;
+
+struct Candidate {
+	int group = 0;
+	int64 value = 0;
+	UserData *user = nullptr;
+};
+
+bool GoesBefore(const Candidate &a, const Candidate &b) {
+	return (a.group < b.group) || (a.group == b.group && a.value < b.value);
+}
+
+bool UserMatches(UserData *user, const QString &query) {
+	if (query.isEmpty() || user->username.startsWith(query, Qt::CaseInsensitive)) {
+		return true;
+	}
+	for_const (auto &namePart, user->names) {
+		if (namePart.startsWith(query)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+} // namespace
+
+MentionIndex::MentionIndex(PeerData *peer) : _peer(peer) {
+	auto observeEvents = UpdateFlag::MembersChanged
+		| UpdateFlag::NameChanged
+		| UpdateFlag::UsernameChanged;
+	subscribe(Notify::PeerUpdated(), Notify::PeerUpdatedHandler(observeEvents, [this](const Notify::PeerUpdate &update) {
+		if (update.peer == _peer) {
+			if (update.flags & UpdateFlag::MembersChanged) {
+				_dirty = true;
+			}
+		} else if (auto user = update.peer->asUser()) {
+			auto i = _users.find(user);
+			if (i != _users.end() && i->nameVersion != user->nameVersion) {
+				unindexUser(user, i.value());
+				indexUser(user, i.value());
+			}
+		}
+	}));
+}
+
+bool MentionIndex::syncNeeded(int count) const {
+	return _dirty || (_users.size() != count);
+}
+
+void MentionIndex::sync(const ChatData::Participants &participants) {
+	if (!syncNeeded(participants.size())) return;
+
+	++_syncId;
+	for (auto i = participants.cbegin(), e = participants.cend(); i != e; ++i) {
+		syncUser(i.key(), -1);
+	}
+	finishSync();
+}
+
+void MentionIndex::sync(const MegagroupInfo::LastParticipants &participants) {
+	if (!syncNeeded(participants.size())) return;
+
+	++_syncId;
+	auto order = 0;
+	for_const (auto user, participants) {
+		syncUser(user, order++);
+	}
+	finishSync();
+}
+
+void MentionIndex::syncUser(UserData *user, int order) {
+	auto i = _users.find(user);
+	if (i == _users.end()) {
+		i = _users.insert(user, Entry());
+		indexUser(user, i.value());
+	} else if (i->nameVersion != user->nameVersion) {
+		unindexUser(user, i.value());
+		indexUser(user, i.value());
+	}
+	i->order = order;
+	i->syncId = _syncId;
+}
+
+void MentionIndex::finishSync() {
+	for (auto i = _users.begin(); i != _users.end();) {
+		if (i->syncId != _syncId) {
+			unindexUser(i.key(), i.value());
+			i = _users.erase(i);
+		} else {
+			++i;
+		}
+	}
+	_dirty = false;
+}
+
+void MentionIndex::indexUser(UserData *user, Entry &entry) {
+	entry.nameVersion = user->nameVersion;
+	entry.tokens.clear();
+	for_const (auto &namePart, user->names) {
+		entry.tokens.push_back(namePart);
+	}
+	auto username = user->username.toLower();
+	if (!username.isEmpty() && !user->names.contains(username)) {
+		entry.tokens.push_back(username);
+	}
+	for_const (auto &token, entry.tokens) {
+		_tokens.insert(token, user);
+	}
+}
+
+void MentionIndex::unindexUser(UserData *user, const Entry &entry) {
+	for_const (auto &token, entry.tokens) {
+		_tokens.remove(token, user);
+	}
+}
+
+QList<UserData*> MentionIndex::find(const QString &query, const QList<UserData*> &recent, int limit, Skip &&skip) const {
+	auto now = unixtime();
+	auto lower = query.toLower();
+
+	// The worst of the best candidates found so far is kept on the top of the heap.
+	auto heap = std::vector<Candidate>();
+	heap.reserve(limit);
+	auto checked = QSet<UserData*>();
+	auto consider = [&](UserData *user, const Candidate &candidate) {
+		if (checked.contains(user)) return;
+		checked.insert(user);
+		if (user->isInaccessible() || skip(user)) return;
+
+		if (heap.size() < size_t(limit)) {
+			heap.push_back(candidate);
+			std::push_heap(heap.begin(), heap.end(), GoesBefore);
+		} else if (GoesBefore(candidate, heap.front())) {
+			std::pop_heap(heap.begin(), heap.end(), GoesBefore);
+			heap.back() = candidate;
+			std::push_heap(heap.begin(), heap.end(), GoesBefore);
+		}
+	};
+	auto considerIndexed = [&](UserData *user, const Entry &entry) {
+		auto candidate = Candidate();
+		candidate.user = user;
+		if (entry.order >= 0) {
+			candidate.group = 1;
+			candidate.value = entry.order;
+		} else {
+			candidate.group = 2;
+			candidate.value = -int64(App::onlineForSort(user, now));
+		}
+		consider(user, candidate);
+	};
+
+	for (auto i = 0, count = recent.size(); i != count; ++i) {
+		auto user = recent[i];
+		if (!UserMatches(user, lower)) continue;
+
+		auto candidate = Candidate();
+		candidate.group = 0;
+		candidate.value = i;
+		candidate.user = user;
+		consider(user, candidate);
+	}
+	if (lower.isEmpty()) {
+		for (auto i = _users.cbegin(), e = _users.cend(); i != e; ++i) {
+			considerIndexed(i.key(), i.value());
+		}
+	} else {
+		for (auto i = _tokens.lowerBound(lower), e = _tokens.cend(); i != e && i.key().startsWith(lower); ++i) {
+			auto user = i.value();
+			if (checked.contains(user)) continue;
+			considerIndexed(user, _users.value(user));
+		}
+	}
+
+	std::sort_heap(heap.begin(), heap.end(), GoesBefore);
+	auto result = QList<UserData*>();
+	result.reserve(heap.size());
+	for_const (auto &candidate, heap) {
+		result.push_back(candidate.user);
+	}
+	return result;
+}
+
+} // namespace Data
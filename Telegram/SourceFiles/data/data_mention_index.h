@@ -0,0 +1,69 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#pragma once
+
+namespace Data {
+
+// Prefix index over the usernames and the name parts of the group members,
+// so that the mentions autocomplete in large groups does not compare the
+// query with every member on each keystroke. Only the members that were
+// added or renamed since the last sync() are tokenized again.
+class MentionIndex : private base::Subscriber {
+public:
+	MentionIndex(PeerData *peer);
+
+	PeerData *peer() const {
+		return _peer;
+	}
+
+	// The megagroup recent members keep their order for the ranking.
+	void sync(const ChatData::Participants &participants);
+	void sync(const MegagroupInfo::LastParticipants &participants);
+
+	// Returns at most limit users having the username or a name part starting
+	// with the query: the ones from the recent list first in its order, then
+	// the synced megagroup members in their order, then the rest by online time.
+	using Skip = base::lambda<bool(UserData *user)>;
+	QList<UserData*> find(const QString &query, const QList<UserData*> &recent, int limit, Skip &&skip) const;
+
+private:
+	struct Entry {
+		int nameVersion = 0;
+		int order = -1;
+		int syncId = 0;
+		QStringList tokens;
+	};
+
+	bool syncNeeded(int count) const;
+	void syncUser(UserData *user, int order);
+	void indexUser(UserData *user, Entry &entry);
+	void unindexUser(UserData *user, const Entry &entry);
+	void finishSync();
+
+	PeerData *_peer;
+	QHash<UserData*, Entry> _users;
+	QMultiMap<QString, UserData*> _tokens;
+	int _syncId = 0;
+	bool _dirty = true;
+
+};
+
+} // namespace Data
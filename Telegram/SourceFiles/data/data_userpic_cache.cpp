@@ -0,0 +1,181 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#include "stdafx.h"
+#include "data/data_userpic_cache.h"
+
+#include "core/task_queue.h"
+
+namespace Data {
+namespace {
+
+constexpr auto kMemoryLimit = 32 * 1024 * 1024LL;
+constexpr auto kLogStatisticsEach = 5000;
+
+using Key = QPair<StorageKey, uint64>;
+
+struct Entry {
+	QPixmap pixmap;
+	uint64 used = 0;
+};
+
+struct Cache {
+	QHash<Key, Entry> entries;
+	QSet<Key> preparing;
+	int64 memory = 0;
+	uint64 useCounter = 0;
+	int generation = 0; // Results of the async preparations made before clear() are skipped.
+
+	int64 hits = 0;
+	int64 misses = 0;
+	int64 prepared = 0;
+	int64 evicted = 0;
+};
+
+Cache &cache() {
+	static Cache result;
+	return result;
+}
+
+Key makeKey(const StorageKey &userpic, int size, UserpicShape shape) {
+	return Key(userpic, uint64(size) | (uint64(shape) << 24) | (uint64(cIntRetinaFactor()) << 32));
+}
+
+int64 pixmapMemory(const QPixmap &pixmap) {
+	return int64(pixmap.width()) * pixmap.height() * 4;
+}
+
+void countLookup(bool hit) {
+	auto &data = cache();
+	++(hit ? data.hits : data.misses);
+	auto total = data.hits + data.misses;
+	if (!(total % kLogStatisticsEach)) {
+		DEBUG_LOG(("Userpics Info: hit rate %1% (%2 of %3), %4 userpics of %5 kb, prepared async %6, evicted %7").arg(data.hits * 100 / total).arg(data.hits).arg(total).arg(data.entries.size()).arg(data.memory / 1024).arg(data.prepared).arg(data.evicted));
+	}
+}
+
+void evict(const Key &except) {
+	auto &data = cache();
+	while (data.memory > kMemoryLimit && data.entries.size() > 1) {
+		auto oldest = data.entries.end();
+		for (auto i = data.entries.begin(), e = data.entries.end(); i != e; ++i) {
+			if (i.key() != except && (oldest == data.entries.end() || i->used < oldest->used)) {
+				oldest = i;
+			}
+		}
+		if (oldest == data.entries.end()) {
+			break;
+		}
+		data.memory -= pixmapMemory(oldest->pixmap);
+		data.entries.erase(oldest);
+		++data.evicted;
+	}
+}
+
+QPixmap insert(const Key &key, QPixmap &&pixmap) {
+	auto &data = cache();
+	auto &entry = data.entries[key];
+	data.memory += pixmapMemory(pixmap) - pixmapMemory(entry.pixmap);
+	entry.pixmap = std_::move(pixmap);
+	entry.used = ++data.useCounter;
+	auto result = entry.pixmap;
+	evict(key);
+	return result;
+}
+
+void prepared(const Key &key, int generation, UserpicShape shape, QImage &&image) {
+	auto &data = cache();
+	if (data.generation != generation) {
+		return;
+	}
+	data.preparing.remove(key);
+	if (image.isNull() || data.entries.contains(key)) {
+		return;
+	}
+	if (shape == UserpicShape::Circle) {
+		Images::prepareCircle(image);
+	} else {
+		Images::prepareRound(image, ImageRoundRadius::Small);
+	}
+	insert(key, App::pixmapFromImageInPlace(std_::move(image)));
+	++data.prepared;
+}
+
+} // namespace
+
+QPixmap findUserpic(const StorageKey &userpic, int size, UserpicShape shape) {
+	auto &data = cache();
+	auto i = data.entries.find(makeKey(userpic, size, shape));
+	if (i == data.entries.end()) {
+		countLookup(false);
+		return QPixmap();
+	}
+	countLookup(true);
+	i->used = ++data.useCounter;
+	return i->pixmap;
+}
+
+QPixmap insertUserpic(const StorageKey &userpic, int size, UserpicShape shape, QPixmap &&pixmap) {
+	return insert(makeKey(userpic, size, shape), std_::move(pixmap));
+}
+
+void prepareUserpicAsync(const StorageKey &userpic, int size, UserpicShape shape, const QByteArray &bytes, const QByteArray &format) {
+	auto &data = cache();
+	auto key = makeKey(userpic, size, shape);
+	if (bytes.isEmpty() || data.entries.contains(key) || data.preparing.contains(key)) {
+		return;
+	}
+	data.preparing.insert(key);
+
+	// Only decoding and scaling is done on the worker thread, the circle
+	// and the corner masks are pixmaps that can be used on the main thread.
+	auto generation = data.generation;
+	auto pixelSize = size * cIntRetinaFactor();
+	base::TaskQueue::Normal().Put([key, generation, shape, pixelSize, bytes, format] {
+		auto copy = bytes;
+		QBuffer buffer(&copy);
+		QImageReader reader(&buffer, format);
+#ifndef OS_MAC_OLD
+		reader.setAutoTransform(true);
+#endif // OS_MAC_OLD
+		struct mutable_data {
+			mutable_data(QImage &&value) : value(std_::move(value)) {
+			}
+			mutable QImage value;
+		};
+		auto result = mutable_data(reader.read());
+		if (!result.value.isNull()) {
+			result.value = Images::prepare(std_::move(result.value), pixelSize, pixelSize, Images::Option::Smooth, -1, -1);
+		}
+		base::TaskQueue::Main().Put([key, generation, shape, result = std_::move(result)] {
+			prepared(key, generation, shape, std_::move(result.value));
+		});
+	});
+}
+
+void clearUserpics() {
+	auto &data = cache();
+	data.entries.clear();
+	data.preparing.clear();
+	data.memory = 0;
+	++data.generation;
+}
+
+} // namespace Data
@@ -0,0 +1,43 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#pragma once
+
+namespace Data {
+
+enum class UserpicShape {
+	Circle,
+	Rounded,
+};
+
+// Prepared userpics shared by all the peer lists. They are found by the
+// PeerData::userpicUniqueKey(), size, shape and retina factor, so a letter
+// avatar is drawn once for all the peers with the same letters and color.
+// The least recently used ones are dropped when the memory limit is reached.
+QPixmap findUserpic(const StorageKey &userpic, int size, UserpicShape shape);
+QPixmap insertUserpic(const StorageKey &userpic, int size, UserpicShape shape, QPixmap &&pixmap);
+
+// Decodes and scales the photo on a worker thread, so that a list that was
+// just opened finds its userpics prepared when it is painted the first time.
+void prepareUserpicAsync(const StorageKey &userpic, int size, UserpicShape shape, const QByteArray &bytes, const QByteArray &format);
+
+void clearUserpics();
+
+} // namespace Data
@@ -1897,6 +1897,7 @@ void DialogsInner::loadPeerPhotos() {
 					break;
 				}
 				(*i)->history()->peer->loadUserpic();
+				(*i)->history()->peer->prepareUserpic(st::dialogsPhotoSize);
 			}
 			yFrom = 0;
 		} else {
@@ -1912,6 +1913,7 @@ void DialogsInner::loadPeerPhotos() {
 
 			for (; from < to; ++from) {
 				_filterResults[from]->history()->peer->loadUserpic();
+				_filterResults[from]->history()->peer->prepareUserpic(st::dialogsPhotoSize);
 			}
 		}
 
@@ -1923,6 +1925,7 @@ void DialogsInner::loadPeerPhotos() {
 
 			for (; from < to; ++from) {
 				_peerSearchResults[from]->peer->loadUserpic();
+				_peerSearchResults[from]->peer->prepareUserpic(st::dialogsPhotoSize);
 			}
 		}
 		from = (yFrom > filteredOffset() + ((_peerSearchResults.isEmpty() ? 0 : st::searchedBarHeight) + st::searchedBarHeight) ? ((yFrom - filteredOffset() - (_peerSearchResults.isEmpty() ? 0 : st::searchedBarHeight) - st::searchedBarHeight) / int32(st::dialogsRowHeight)) : 0) - _filterResults.size() - _peerSearchResults.size();
@@ -21,6 +21,8 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include "stdafx.h"
 #include "fileuploader.h"
 
+#include "mtproto/connection_pool.h"
+
 FileUploader::FileUploader() : sentSize(0) {
 	memset(sentSizes, 0, sizeof(sentSizes));
 	nextTimer.setSingleShot(true);
@@ -94,7 +96,7 @@ void FileUploader::currentFailed() {
 	dcMap.clear();
 	uploading = FullMsgId();
 	sentSize = 0;
-	for (int i = 0; i < MTPUploadSessionsCount; ++i) {
+	for (int i = 0; i < MTPUploadSessionsMax; ++i) {
 		sentSizes[i] = 0;
 	}
 
@@ -102,13 +104,15 @@ void FileUploader::currentFailed() {
 }
 
 void FileUploader::killSessions() {
-	for (int i = 0; i < MTPUploadSessionsCount; ++i) {
+	for (int i = 0; i < MTPUploadSessionsMax; ++i) {
 		MTP::stopSession(MTP::uplDcId(i));
 	}
+	MTP::poolSessionsKilled(MTP::PoolPurpose::Upload, 0);
 }
 
 void FileUploader::sendNext() {
-	if (sentSize >= MaxUploadFileParallelSize || _paused.msg) return;
+	auto sessionsCount = MTP::poolSessionsCount(MTP::PoolPurpose::Upload, 0);
+	if (sentSize >= uint32(sessionsCount * MaxUploadFileParallelSizePerSession) || _paused.msg) return;
 
 	bool killing = killSessionsTimer.isActive();
 	if (queue.isEmpty()) {
@@ -129,7 +133,7 @@ void FileUploader::sendNext() {
 		uploading = i.key();
 	}
 	int todc = 0;
-	for (int dc = 1; dc < MTPUploadSessionsCount; ++dc) {
+	for (int dc = 1; dc < sessionsCount; ++dc) {
 		if (sentSizes[dc] < sentSizes[todc]) {
 			todc = dc;
 		}
@@ -144,8 +148,10 @@ void FileUploader::sendNext() {
 				if (i->type() == SendMediaType::Photo) {
 					emit photoReady(uploading, silent, MTP_inputFile(MTP_long(i->id()), MTP_int(i->partsCount), MTP_string(i->filename()), MTP_bytes(i->file ? i->file->filemd5 : i->media.jpeg_md5)));
 				} else if (i->type() == SendMediaType::File || i->type() == SendMediaType::Audio) {
+					int32 md5[base::hash::Md5::kSize / sizeof(int32)];
+					i->md5Hash.finish(md5);
 					QByteArray docMd5(32, Qt::Uninitialized);
-					hashMd5Hex(i->md5Hash.result(), docMd5.data());
+					hashMd5Hex(md5, docMd5.data());
 
 					MTPInputFile doc = (i->docSize > UseBigFilesFrom) ? MTP_inputFileBig(MTP_long(i->id()), MTP_int(i->docPartsCount), MTP_string(i->filename())) : MTP_inputFile(MTP_long(i->id()), MTP_int(i->docPartsCount), MTP_string(i->filename()), MTP_bytes(docMd5));
 					if (i->partsCount) {
@@ -245,10 +251,11 @@ void FileUploader::clear() {
 	docRequestsSent.clear();
 	dcMap.clear();
 	sentSize = 0;
-	for (int32 i = 0; i < MTPUploadSessionsCount; ++i) {
+	for (int32 i = 0; i < MTPUploadSessionsMax; ++i) {
 		MTP::stopSession(MTP::uplDcId(i));
 		sentSizes[i] = 0;
 	}
+	MTP::poolSessionsKilled(MTP::PoolPurpose::Upload, 0);
 	killSessionsTimer.stop();
 }
 
@@ -282,6 +289,7 @@ void FileUploader::partLoaded(const MTPBool &result, mtpRequestId requestId) {
 			}
 			sentSize -= sentPartSize;
 			sentSizes[dc] -= sentPartSize;
+			MTP::poolTransferred(MTP::PoolPurpose::Upload, 0, sentPartSize);
 			if (k->type() == SendMediaType::Photo) {
 				k->fileSentSize += sentPartSize;
 				PhotoData *photo = App::photo(k->id());
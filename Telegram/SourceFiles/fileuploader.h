@@ -111,7 +111,7 @@ private:
 			return file ? file->filename : media.filename;
 		}
 
-		HashMd5 md5Hash;
+		base::hash::Md5 md5Hash;
 
 		QSharedPointer<QFile> docFile;
 		int32 docSentParts;
@@ -130,7 +130,7 @@ private:
 	QMap<mtpRequestId, int32> docRequestsSent;
 	QMap<mtpRequestId, int32> dcMap;
 	uint32 sentSize;
-	uint32 sentSizes[MTPUploadSessionsCount];
+	uint32 sentSizes[MTPUploadSessionsMax];
 
 	FullMsgId uploading, _paused;
 	Queue queue;
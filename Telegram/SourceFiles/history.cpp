@@ -1260,7 +1260,7 @@ HistoryBlock *History::prepareBlockForAddingItem() {
 
 		auto result = _buildingFrontBlock->block = new HistoryBlock(this);
 		if (_buildingFrontBlock->expectedItemsCount > 0) {
-			result->items.reserve(_buildingFrontBlock->expectedItemsCount + 1);
+			result->reserveItems(_buildingFrontBlock->expectedItemsCount + 1);
 		}
 		result->setIndexInHistory(0);
 		blocks.push_front(result);
@@ -1279,7 +1279,7 @@ HistoryBlock *History::prepareBlockForAddingItem() {
 	result->setIndexInHistory(blocks.size());
 	blocks.push_back(result);
 
-	result->items.reserve(MessagesPerPage);
+	result->reserveItems(MessagesPerPage);
 	return result;
 };
 
@@ -1290,7 +1290,7 @@ void History::addItemToBlock(HistoryItem *item) {
 	auto block = prepareBlockForAddingItem();
 
 	item->attachToBlock(block, block->items.size());
-	block->items.push_back(item);
+	block->insertItem(block->items.size(), item);
 	item->previousItemChanged();
 
 	if (isBuildingFrontBlock() && _buildingFrontBlock->expectedItemsCount > 0) {
@@ -1487,11 +1487,15 @@ int History::countUnread(MsgId upTo) {
 	int result = 0;
 	for (auto i = blocks.cend(), e = blocks.cbegin(); i != e;) {
 		--i;
-		for (auto j = (*i)->items.cend(), en = (*i)->items.cbegin(); j != en;) {
+		auto block = *i;
+		auto &ids = block->itemIds();
+		auto &flags = block->itemFlags();
+		for (auto j = ids.size(); j > 0;) {
 			--j;
-			if ((*j)->id > 0 && (*j)->id <= upTo) {
+			auto id = ids[j];
+			if (id > 0 && id <= upTo) {
 				break;
-			} else if (!(*j)->out() && (*j)->unread() && (*j)->id > upTo) {
+			} else if (!(flags[j] & HistoryBlock::ItemOut) && id > upTo && block->items[j]->unread()) {
 				++result;
 			}
 		}
@@ -1625,23 +1629,23 @@ void History::setUnreadCount(int newUnreadCount) {
 }
 
 void History::getNextShowFrom(HistoryBlock *block, int i) {
-	if (i >= 0) {
-		int l = block->items.size();
-		for (++i; i < l; ++i) {
-			if (block->items.at(i)->type() == HistoryItemMsg) {
-				showFrom = block->items.at(i);
-				return;
+	auto findMessage = [this](HistoryBlock *block, int from) {
+		auto &flags = block->itemFlags();
+		for (auto index = from, count = flags.size(); index < count; ++index) {
+			if (flags[index] & HistoryBlock::ItemMessage) {
+				showFrom = block->items.at(index);
+				return true;
 			}
 		}
+		return false;
+	};
+	if (i >= 0 && findMessage(block, i + 1)) {
+		return;
 	}
 
 	for (int j = block->indexInHistory() + 1, s = blocks.size(); j < s; ++j) {
-		block = blocks.at(j);
-		for_const (HistoryItem *item, block->items) {
-			if (item->type() == HistoryItemMsg) {
-				showFrom = item;
-				return;
-			}
+		if (findMessage(blocks.at(j), 0)) {
+			return;
 		}
 	}
 	showFrom = nullptr;
@@ -1670,11 +1674,11 @@ void History::countScrollTopItem(int top) {
 		// go backward through history while we don't find an item that starts above
 		do {
 			HistoryBlock *block = blocks.at(blockIndex);
+			auto &tops = block->itemTops();
 			for (--itemIndex; itemIndex >= 0; --itemIndex) {
-				HistoryItem *item = block->items.at(itemIndex);
-				itemTop = block->y + item->y;
+				itemTop = block->y + tops[itemIndex];
 				if (itemTop <= top) {
-					scrollTopItem = item;
+					scrollTopItem = block->items.at(itemIndex);
 					return;
 				}
 			}
@@ -1690,9 +1694,9 @@ void History::countScrollTopItem(int top) {
 		// go forward through history while we don't find the last item that starts above
 		for (int blocksCount = blocks.size(); blockIndex < blocksCount; ++blockIndex) {
 			HistoryBlock *block = blocks.at(blockIndex);
-			for (int itemsCount = block->items.size(); itemIndex < itemsCount; ++itemIndex) {
-				HistoryItem *item = block->items.at(itemIndex);
-				itemTop = block->y + item->y;
+			auto &tops = block->itemTops();
+			for (int itemsCount = tops.size(); itemIndex < itemsCount; ++itemIndex) {
+				itemTop = block->y + tops[itemIndex];
 				if (itemTop > top) {
 					t_assert(itemIndex > 0 || blockIndex > 0);
 					if (itemIndex > 0) {
@@ -1751,7 +1755,7 @@ HistoryItem *History::addNewInTheMiddle(HistoryItem *newItem, int32 blockIndex,
 	auto block = blocks.at(blockIndex);
 
 	newItem->attachToBlock(block, itemIndex);
-	block->items.insert(itemIndex, newItem);
+	block->insertItem(itemIndex, newItem);
 	newItem->previousItemChanged();
 	if (itemIndex + 1 < block->items.size()) {
 		for (int i = itemIndex + 1, l = block->items.size(); i < l; ++i) {
@@ -2257,10 +2261,33 @@ History::~History() {
 	clearOnDestroy();
 }
 
+void HistoryBlock::reserveItems(int count) {
+	items.reserve(count);
+	_itemIds.reserve(count);
+	_itemTops.reserve(count);
+	_itemFlags.reserve(count);
+}
+
+void HistoryBlock::insertItem(int index, HistoryItem *item) {
+	auto flags = uchar(0);
+	if (item->out()) flags |= ItemOut;
+	if (item->type() == HistoryItemMsg) flags |= ItemMessage;
+
+	items.insert(index, item);
+	_itemIds.insert(index, item->id);
+	_itemTops.insert(index, item->y);
+	_itemFlags.insert(index, flags);
+}
+
+void HistoryBlock::itemIdChanged(int index, MsgId newId) {
+	_itemIds[index] = newId;
+}
+
 int HistoryBlock::resizeGetHeight(int newWidth, bool resizeAllItems) {
 	int y = 0;
-	for_const (HistoryItem *item, items) {
-		item->y = y;
+	for (int i = 0, count = items.size(); i < count; ++i) {
+		auto item = items[i];
+		item->y = _itemTops[i] = y;
 		if (resizeAllItems || item->pendingResize()) {
 			y += item->resizeGetHeight(newWidth);
 		} else {
@@ -2274,6 +2301,9 @@ int HistoryBlock::resizeGetHeight(int newWidth, bool resizeAllItems) {
 void HistoryBlock::clear(bool leaveItems) {
 	Items lst;
 	std::swap(lst, items);
+	_itemIds.clear();
+	_itemTops.clear();
+	_itemFlags.clear();
 
 	if (leaveItems) {
 		for_const (HistoryItem *item, lst) {
@@ -2306,6 +2336,9 @@ void HistoryBlock::removeItem(HistoryItem *item) {
 
 	item->detachFast();
 	items.remove(itemIndex);
+	_itemIds.remove(itemIndex);
+	_itemTops.remove(itemIndex);
+	_itemFlags.remove(itemIndex);
 	for (int i = itemIndex, l = items.size(); i < l; ++i) {
 		items.at(i)->setIndexInBlock(i);
 	}
@@ -629,6 +629,30 @@ public:
 	typedef QVector<HistoryItem*> Items;
 	Items items;
 
+	// The items should be added only through these methods,
+	// they keep the hot data arrays below in sync with items.
+	void reserveItems(int count);
+	void insertItem(int index, HistoryItem *item);
+	void itemIdChanged(int index, MsgId newId);
+
+	// Hot data of the items as plain arrays, so that the loops over a long
+	// history (hit testing, scrolling, unread counting) scan contiguous memory
+	// instead of chasing the item pointers. Tops are valid after
+	// resizeGetHeight() like the HistoryItem::y values.
+	enum ItemFlag : uchar {
+		ItemOut = 0x01,
+		ItemMessage = 0x02, // type() == HistoryItemMsg
+	};
+	const QVector<MsgId> &itemIds() const {
+		return _itemIds;
+	}
+	const QVector<int> &itemTops() const {
+		return _itemTops;
+	}
+	const QVector<uchar> &itemFlags() const {
+		return _itemFlags;
+	}
+
 	void clear(bool leaveItems = false);
 	~HistoryBlock() {
 		clear();
@@ -663,4 +687,9 @@ public:
 protected:
 	int _indexInHistory;
 
+private:
+	QVector<MsgId> _itemIds;
+	QVector<int> _itemTops;
+	QVector<uchar> _itemFlags;
+
 };
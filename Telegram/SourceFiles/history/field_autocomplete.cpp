@@ -24,6 +24,7 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include "mainwindow.h"
 #include "apiwrap.h"
 #include "localstorage.h"
+#include "data/data_mention_index.h"
 #include "ui/widgets/scroll_area.h"
 #include "styles/style_history.h"
 #include "styles/style_widgets.h"
@@ -129,6 +130,11 @@ bool FieldAutocomplete::clearFilteredBotCommands() {
 }
 
 namespace {
+
+// Smaller groups are filtered by comparing the query with all the members.
+constexpr auto kMentionIndexMinCount = 100;
+constexpr auto kMentionIndexRowsLimit = 100;
+
 template <typename T, typename U>
 inline int indexOfInFirstN(const T &v, const U &elem, int last) {
 	for (auto b = v.cbegin(), i = b, e = b + qMax(v.size(), last); i != e; ++i) {
@@ -140,6 +146,13 @@ inline int indexOfInFirstN(const T &v, const U &elem, int last) {
 }
 }
 
+Data::MentionIndex *FieldAutocomplete::mentionIndex(PeerData *peer) {
+	if (!_mentionIndex || _mentionIndex->peer() != peer) {
+		_mentionIndex = std_::make_unique<Data::MentionIndex>(peer);
+	}
+	return _mentionIndex.get();
+}
+
 void FieldAutocomplete::updateFiltered(bool resetScroll) {
 	int32 now = unixtime(), recentInlineBots = 0;
 	internal::MentionRows mrows;
@@ -210,7 +223,15 @@ void FieldAutocomplete::updateFiltered(bool resetScroll) {
 				++recentInlineBots;
 			}
 		}
-		if (_chat) {
+		auto skipIndexed = [this, &mrows, recentInlineBots, listAllSuggestions, &filterNotPassedByName](UserData *user) {
+			if (!listAllSuggestions && filterNotPassedByName(user)) return true;
+			return (indexOfInFirstN(mrows, user, recentInlineBots) >= 0);
+		};
+		if (_chat && !_chat->noParticipantInfo() && _chat->participants.size() >= kMentionIndexMinCount) {
+			auto index = mentionIndex(_chat);
+			index->sync(_chat->participants);
+			mrows += index->find(_filter, _chat->lastAuthors, kMentionIndexRowsLimit, std_::move(skipIndexed));
+		} else if (_chat) {
 			QMultiMap<int32, UserData*> ordered;
 			mrows.reserve(mrows.size() + (_chat->participants.isEmpty() ? _chat->lastAuthors.size() : _chat->participants.size()));
 			if (_chat->noParticipantInfo()) {
@@ -243,6 +264,10 @@ void FieldAutocomplete::updateFiltered(bool resetScroll) {
 			QMultiMap<int32, UserData*> ordered;
 			if (_channel->mgInfo->lastParticipants.isEmpty() || _channel->lastParticipantsCountOutdated()) {
 				if (App::api()) App::api()->requestLastParticipants(_channel);
+			} else if (_channel->mgInfo->lastParticipants.size() >= kMentionIndexMinCount) {
+				auto index = mentionIndex(_channel);
+				index->sync(_channel->mgInfo->lastParticipants);
+				mrows += index->find(_filter, QList<UserData*>(), kMentionIndexRowsLimit, std_::move(skipIndexed));
 			} else {
 				mrows.reserve(mrows.size() + _channel->mgInfo->lastParticipants.size());
 				for_const (auto user, _channel->mgInfo->lastParticipants) {
@@ -351,6 +376,11 @@ void FieldAutocomplete::rowsUpdated(const internal::MentionRows &mrows, const in
 		_brows = brows;
 		_srows = srows;
 
+		// At most 4.5 rows are visible without scrolling, see recount().
+		for (auto i = 0, count = qMin(_mrows.size(), 5); i != count; ++i) {
+			_mrows[i]->prepareUserpic(st::mentionPhotoSize);
+		}
+
 		bool hidden = _hiding || isHidden();
 		if (hidden) {
 			show();
@@ -26,6 +26,10 @@ namespace Ui {
 class ScrollArea;
 } // namespace Ui
 
+namespace Data {
+class MentionIndex;
+} // namespace Data
+
 namespace internal {
 
 using MentionRows = QList<UserData*>;
@@ -99,6 +103,7 @@ private:
 
 	void updateFiltered(bool resetScroll = false);
 	void recount(bool resetScroll = false);
+	Data::MentionIndex *mentionIndex(PeerData *peer);
 
 	QPixmap _cache;
 	internal::MentionRows _mrows;
@@ -114,6 +119,7 @@ private:
 	ChatData *_chat = nullptr;
 	UserData *_user = nullptr;
 	ChannelData *_channel = nullptr;
+	std_::unique_ptr<Data::MentionIndex> _mentionIndex;
 	EmojiPtr _emoji;
 	enum class Type {
 		Mentions,
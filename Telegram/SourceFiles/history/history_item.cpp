@@ -732,6 +732,9 @@ void HistoryItem::setAttachToNext(bool attachToNext) {
 void HistoryItem::setId(MsgId newId) {
 	history()->changeMsgId(id, newId);
 	id = newId;
+	if (_block) {
+		_block->itemIdChanged(_indexInBlock, newId);
+	}
 
 	// We don't need to call Notify::replyMarkupUpdated(this) and update keyboard
 	// in history widget, because it can't exist for an outgoing message.
@@ -908,12 +911,22 @@ void HistoryItem::recountDisplayDate() {
 	}
 }
 
+int HistoryItem::textMemoryUsage() const {
+	if (_unloadedText) {
+		auto result = int(sizeof(Text) + sizeof(TextWithEntities));
+		result += _unloadedText->text.capacity() * sizeof(QChar);
+		result += _unloadedText->entities.capacity() * sizeof(EntityInText);
+		return result;
+	}
+	return _text.countMemoryUsage();
+}
+
 QString HistoryItem::notificationText() const {
 	auto getText = [this]() {
 		if (emptyText()) {
 			return _media ? _media->notificationText() : QString();
 		}
-		return _text.originalText();
+		return _unloadedText ? _unloadedText->text : _text.originalText();
 	};
 
 	auto result = getText();
@@ -926,7 +939,7 @@ QString HistoryItem::inDialogsText() const {
 		if (emptyText()) {
 			return _media ? _media->inDialogsText() : QString();
 		}
-		return textClean(_text.originalText());
+		return textClean(_unloadedText ? _unloadedText->text : _text.originalText());
 	};
 	auto plainText = getText();
 	if ((!_history->peer->isUser() || out()) && !isPost() && !isEmpty()) {
@@ -683,9 +683,18 @@ public:
 	void drawInDialog(Painter &p, const QRect &r, bool active, bool selected, const HistoryItem *&cacheFor, Text &cache) const;
 
 	bool emptyText() const {
-		return _text.isEmpty();
+		return !_unloadedText && _text.isEmpty();
 	}
 
+	// Messages scrolled far away from the viewport drop their text layout
+	// and rebuild it from the original text when it is needed again.
+	virtual void unloadTextLayout() {
+	}
+	bool textLayoutUnloaded() const {
+		return (_unloadedText != nullptr);
+	}
+	int textMemoryUsage() const;
+
 	bool canDelete() const {
 		ChannelData *channel = _history->peer->asChannel();
 		if (!channel) return !(_flags & MTPDmessage_ClientFlag::f_is_group_migrate);
@@ -820,9 +829,16 @@ public:
 	}
 	void setPendingInitDimensions() {
 		_flags |= MTPDmessage_ClientFlag::f_pending_init_dimensions;
+		++_contentVersion;
 		setPendingResize();
 	}
 
+	// Changed with each update of the item content, the painted
+	// item pixmaps are cached with it.
+	int contentVersion() const {
+		return _contentVersion;
+	}
+
 	int displayedDateHeight() const {
 		if (auto date = Get<HistoryMessageDate>()) {
 			return date->height();
@@ -860,7 +876,7 @@ public:
 	}
 
 	bool isEmpty() const {
-		return _text.isEmpty() && !_media;
+		return emptyText() && !_media;
 	}
 
 	void clipCallback(Media::Clip::Notification notification);
@@ -887,6 +903,7 @@ protected:
 	HistoryBlock *_block = nullptr;
 	int _indexInBlock = -1;
 	MTPDmessage::Flags _flags;
+	int _contentVersion = 0;
 
 	mutable int32 _authorNameVersion;
 
@@ -951,15 +968,26 @@ protected:
 	}
 
 	TextSelection toMediaSelection(TextSelection selection) const {
+		ensureTextLayout();
 		return internal::unshiftSelection(selection, _text);
 	}
 	TextSelection fromMediaSelection(TextSelection selection) const {
+		ensureTextLayout();
 		return internal::shiftSelection(selection, _text);
 	}
 
+	void ensureTextLayout() const {
+		if (_unloadedText) {
+			const_cast<HistoryItem*>(this)->restoreTextLayout();
+		}
+	}
+	virtual void restoreTextLayout() {
+	}
+
 	Text _text = { int(st::msgMinWidth) };
 	int _textWidth = -1;
 	int _textHeight = 0;
+	std_::unique_ptr<TextWithEntities> _unloadedText;
 
 	HistoryMediaPtr _media;
 
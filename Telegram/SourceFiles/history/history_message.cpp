@@ -96,7 +96,7 @@ void HistoryMessageVia::resize(int32 availw) const {
 		_text = QString();
 		_width = 0;
 	} else {
-		_text = lng_inline_bot_via(lt_inline_bot, '@' + _bot->username);
+		_text = textIntern(lng_inline_bot_via(lt_inline_bot, '@' + _bot->username));
 		if (availw < _maxWidth) {
 			_text = st::msgServiceNameFont->elided(_text, availw);
 			_width = st::msgServiceNameFont->width(_text);
@@ -713,10 +713,13 @@ void HistoryMessage::initMediaFromDocument(DocumentData *doc, const QString &cap
 }
 
 int32 HistoryMessage::plainMaxWidth() const {
+	ensureTextLayout();
 	return st::msgPadding.left() + _text.maxWidth() + st::msgPadding.right();
 }
 
 void HistoryMessage::initDimensions() {
+	ensureTextLayout();
+
 	auto reply = Get<HistoryMessageReply>();
 	if (reply) {
 		reply->updateName();
@@ -944,6 +947,7 @@ void HistoryMessage::eraseFromOverview() {
 }
 
 TextWithEntities HistoryMessage::selectedText(TextSelection selection) const {
+	ensureTextLayout();
 	TextWithEntities result, textResult, mediaResult;
 	if (selection == FullSelection) {
 		textResult = _text.originalTextWithEntities(AllTextSelection, ExpandLinksAll);
@@ -990,6 +994,7 @@ TextWithEntities HistoryMessage::selectedText(TextSelection selection) const {
 void HistoryMessage::setMedia(const MTPMessageMedia *media) {
 	if (!_media && (!media || media->type() == mtpc_messageMediaEmpty)) return;
 
+	ensureTextLayout();
 	bool mediaRemovedSkipBlock = false;
 	if (_media) {
 		// Don't update Game media because we loose the consumed text of the message.
@@ -1012,6 +1017,8 @@ void HistoryMessage::setMedia(const MTPMessageMedia *media) {
 }
 
 void HistoryMessage::setText(const TextWithEntities &textWithEntities) {
+	_unloadedText = nullptr;
+	++_contentVersion;
 	for_const (auto &entity, textWithEntities.entities) {
 		auto type = entity.type();
 		if (type == EntityInTextUrl || type == EntityInTextCustomUrl || type == EntityInTextEmail) {
@@ -1035,6 +1042,8 @@ void HistoryMessage::setText(const TextWithEntities &textWithEntities) {
 }
 
 void HistoryMessage::setEmptyText() {
+	_unloadedText = nullptr;
+	++_contentVersion;
 	_text.setMarkedText(st::messageTextStyle, { QString(), EntitiesInText() }, itemTextOptions(this));
 
 	_textWidth = -1;
@@ -1086,16 +1095,37 @@ void HistoryMessage::setReplyMarkup(const MTPReplyMarkup *markup) {
 }
 
 TextWithEntities HistoryMessage::originalText() const {
-	if (emptyText()) {
+	if (_unloadedText) {
+		return *_unloadedText;
+	} else if (emptyText()) {
 		return { QString(), EntitiesInText() };
 	}
 	return _text.originalTextWithEntities();
 }
 
 bool HistoryMessage::textHasLinks() const {
+	ensureTextLayout();
 	return emptyText() ? false : _text.hasLinks();
 }
 
+void HistoryMessage::unloadTextLayout() {
+	// Media may consume or decorate the message text, keep it as it is.
+	if (_unloadedText || _media || emptyText()) {
+		return;
+	}
+	_unloadedText = std_::make_unique<TextWithEntities>(_text.originalTextWithEntities());
+	_text.clear();
+}
+
+void HistoryMessage::restoreTextLayout() {
+	// The layout is the same, so the counted text size is still valid.
+	auto textWidth = _textWidth, textHeight = _textHeight;
+	auto unloadedText = base::take(_unloadedText);
+	setText(*unloadedText);
+	_textWidth = textWidth;
+	_textHeight = textHeight;
+}
+
 int HistoryMessage::infoWidth() const {
 	int result = _timeWidth;
 	if (auto views = Get<HistoryMessageViews>()) {
@@ -1210,6 +1240,7 @@ void HistoryMessage::setViewsCount(int32 count) {
 	if (was == views->_viewsWidth) {
 		Ui::repaintHistoryItem(this);
 	} else {
+		ensureTextLayout();
 		if (_text.hasSkipBlock()) {
 			_text.setSkipBlock(HistoryMessage::skipBlockWidth(), HistoryMessage::skipBlockHeight());
 			_textWidth = -1;
@@ -1225,6 +1256,7 @@ void HistoryMessage::setId(MsgId newId) {
 	if (wasPositive == positive) {
 		Ui::repaintHistoryItem(this);
 	} else {
+		ensureTextLayout();
 		if (_text.hasSkipBlock()) {
 			_text.setSkipBlock(HistoryMessage::skipBlockWidth(), HistoryMessage::skipBlockHeight());
 			_textWidth = -1;
@@ -1235,6 +1267,8 @@ void HistoryMessage::setId(MsgId newId) {
 }
 
 void HistoryMessage::draw(Painter &p, const QRect &r, TextSelection selection, TimeMs ms) const {
+	ensureTextLayout();
+
 	bool outbg = out() && !isPost(), bubble = drawBubble(), selected = (selection == FullSelection);
 
 	int left = 0, width = 0, height = _height;
@@ -1447,6 +1481,8 @@ int HistoryMessage::resizeGetHeight_(int width) {
 int HistoryMessage::performResizeGetHeight(int width) {
 	if (width < st::msgMinWidth) return _height;
 
+	ensureTextLayout();
+
 	width -= st::msgMargin.left() + st::msgMargin.right();
 	if (width < st::msgPadding.left() + st::msgPadding.right() + 1) {
 		width = st::msgPadding.left() + st::msgPadding.right() + 1;
@@ -1568,6 +1604,8 @@ bool HistoryMessage::pointInTime(int32 right, int32 bottom, int x, int y, InfoDi
 }
 
 HistoryTextState HistoryMessage::getState(int x, int y, HistoryStateRequest request) const {
+	ensureTextLayout();
+
 	HistoryTextState result;
 
 	int left = 0, width = 0, height = _height;
@@ -1720,6 +1758,7 @@ bool HistoryMessage::getStateText(int x, int y, QRect &trect, HistoryTextState *
 }
 
 TextSelection HistoryMessage::adjustSelection(TextSelection selection, TextSelectType type) const {
+	ensureTextLayout();
 	if (!_media || selection.to <= _text.length()) {
 		return _text.adjustSelection(selection, type);
 	}
@@ -107,6 +107,7 @@ public:
 	void setText(const TextWithEntities &textWithEntities) override;
 	TextWithEntities originalText() const override;
 	bool textHasLinks() const override;
+	void unloadTextLayout() override;
 
 	int infoWidth() const override;
 	int timeLeft() const override;
@@ -155,6 +156,7 @@ private:
 	friend class HistoryItemInstantiated<HistoryMessage>;
 
 	void setEmptyText();
+	void restoreTextLayout() override;
 
 	void initDimensions() override;
 	int resizeGetHeight_(int width) override;
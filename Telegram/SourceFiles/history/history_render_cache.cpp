@@ -0,0 +1,165 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#include "stdafx.h"
+#include "history/history_render_cache.h"
+
+#include "window/window_theme.h"
+
+namespace HistoryLayout {
+namespace {
+
+constexpr auto kCacheBytesLimit = 32 * 1024 * 1024;
+constexpr auto kAnimatingTimeout = 500;
+constexpr auto kInvalidationsCheckCount = 256;
+
+} // namespace
+
+RenderCache::RenderCache() {
+	subscribe(Global::RefItemRemoved(), [this](HistoryItem *item) {
+		remove(item);
+	});
+	subscribe(Window::Theme::Background(), [this](const Window::Theme::BackgroundUpdate &update) {
+		if (update.paletteChanged()) {
+			clear();
+		}
+	});
+}
+
+bool RenderCache::Enabled() {
+	return cHistoryRenderCache();
+}
+
+bool RenderCache::cacheable(const HistoryItem *item, TimeMs ms) const {
+	if (item->getMedia() || item->Has<HistoryMessageUnreadBar>()) {
+		return false;
+	}
+	auto i = _invalidations.constFind(item);
+	return (i == _invalidations.cend()) || (ms >= i.value() + kAnimatingTimeout);
+}
+
+void RenderCache::paint(Painter &p, const HistoryItem *item, int outerWidth, const QRect &clip, TextSelection selection, TimeMs ms) {
+	auto height = item->height();
+	if (!cacheable(item, ms) || outerWidth <= 0 || height <= 0) {
+		++_statistics.direct;
+		item->draw(p, clip, selection, ms);
+		return;
+	}
+
+	_invalidations.remove(item);
+	auto &entry = _entries[item];
+	if (entry.pixmap.isNull()
+		|| !(entry.msgId == item->fullId())
+		|| entry.contentVersion != item->contentVersion()
+		|| entry.unread != item->unread()
+		|| entry.views != item->viewsCount()
+		|| entry.width != outerWidth
+		|| entry.height != height
+		|| entry.selection != selection) {
+		++_statistics.misses;
+		render(entry, item, outerWidth, selection, ms);
+		evict(item);
+	} else {
+		++_statistics.hits;
+	}
+	entry.used = ++_useCounter;
+	p.drawPixmap(0, 0, entry.pixmap);
+}
+
+void RenderCache::render(Entry &entry, const HistoryItem *item, int outerWidth, TextSelection selection, TimeMs ms) {
+	if (!entry.pixmap.isNull()) {
+		_statistics.bytes -= entry.pixmap.width() * entry.pixmap.height() * 4;
+	}
+	entry.msgId = item->fullId();
+	entry.contentVersion = item->contentVersion();
+	entry.unread = item->unread();
+	entry.views = item->viewsCount();
+	entry.width = outerWidth;
+	entry.height = item->height();
+	entry.selection = selection;
+
+	auto image = QImage(entry.width * cIntRetinaFactor(), entry.height * cIntRetinaFactor(), QImage::Format_ARGB32_Premultiplied);
+	image.setDevicePixelRatio(cRetinaFactor());
+	image.fill(Qt::transparent);
+	{
+		Painter p(&image);
+		item->draw(p, QRect(0, 0, entry.width, entry.height), selection, ms);
+	}
+	entry.pixmap = App::pixmapFromImageInPlace(std_::move(image));
+	_statistics.bytes += entry.pixmap.width() * entry.pixmap.height() * 4;
+}
+
+void RenderCache::invalidate(const HistoryItem *item) {
+	auto ms = getms();
+	removeEntry(item);
+	if (_invalidations.size() >= kInvalidationsCheckCount) {
+		removeExpiredInvalidations(ms);
+	}
+	_invalidations.insert(item, ms);
+}
+
+void RenderCache::remove(const HistoryItem *item) {
+	removeEntry(item);
+	_invalidations.remove(item);
+}
+
+void RenderCache::removeEntry(const HistoryItem *item) {
+	auto i = _entries.find(item);
+	if (i != _entries.end()) {
+		_statistics.bytes -= i->pixmap.width() * i->pixmap.height() * 4;
+		_entries.erase(i);
+	}
+}
+
+void RenderCache::removeExpiredInvalidations(TimeMs ms) {
+	for (auto i = _invalidations.begin(); i != _invalidations.end();) {
+		if (ms >= i.value() + kAnimatingTimeout) {
+			i = _invalidations.erase(i);
+		} else {
+			++i;
+		}
+	}
+}
+
+void RenderCache::evict(const HistoryItem *except) {
+	while (_statistics.bytes > kCacheBytesLimit && _entries.size() > 1) {
+		auto oldest = _entries.end();
+		for (auto i = _entries.begin(), e = _entries.end(); i != e; ++i) {
+			if (i.key() != except && (oldest == _entries.end() || i->used < oldest->used)) {
+				oldest = i;
+			}
+		}
+		if (oldest == _entries.end()) {
+			break;
+		}
+		_statistics.bytes -= oldest->pixmap.width() * oldest->pixmap.height() * 4;
+		_invalidations.remove(oldest.key());
+		_entries.erase(oldest);
+		++_statistics.evicted;
+	}
+}
+
+void RenderCache::clear() {
+	_entries.clear();
+	_invalidations.clear();
+	_statistics.bytes = 0;
+}
+
+} // namespace HistoryLayout
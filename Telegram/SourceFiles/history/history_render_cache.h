@@ -0,0 +1,86 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#pragma once
+
+namespace HistoryLayout {
+
+// Raster cache of painted history items, keyed by width, height, selection,
+// the item content version and the state painted in the message info
+// (outbox read ticks and views).
+// An invalidated item drops its entry. While scrolling a cached item is blitted.
+// The cache is opt-in (-historycache launch argument) and only holds the
+// items without media, because media paints frames and radial progress
+// without a repaint request for the whole item.
+class RenderCache : private base::Subscriber {
+public:
+	RenderCache();
+
+	static bool Enabled();
+
+	// Paints the item at (0, 0), through the cache when it is possible.
+	void paint(Painter &p, const HistoryItem *item, int outerWidth, const QRect &clip, TextSelection selection, TimeMs ms);
+
+	void invalidate(const HistoryItem *item);
+	void clear();
+
+	struct Statistics {
+		int64 hits = 0;
+		int64 misses = 0;
+		int64 direct = 0;
+		int64 evicted = 0;
+		int bytes = 0;
+	};
+	const Statistics &statistics() const {
+		return _statistics;
+	}
+
+private:
+	struct Entry {
+		QPixmap pixmap;
+		FullMsgId msgId;
+		int contentVersion = 0;
+		bool unread = false;
+		int views = 0;
+		int width = 0;
+		int height = 0;
+		TextSelection selection;
+		uint64 used = 0;
+	};
+
+	bool cacheable(const HistoryItem *item, TimeMs ms) const;
+	void render(Entry &entry, const HistoryItem *item, int outerWidth, TextSelection selection, TimeMs ms);
+	void remove(const HistoryItem *item);
+	void removeEntry(const HistoryItem *item);
+	void removeExpiredInvalidations(TimeMs ms);
+	void evict(const HistoryItem *except);
+
+	QHash<const HistoryItem*, Entry> _entries;
+
+	// Items that were invalidated recently are animating, they are
+	// painted directly until they are left alone for a while.
+	QHash<const HistoryItem*, TimeMs> _invalidations;
+
+	uint64 _useCounter = 0;
+	Statistics _statistics;
+
+};
+
+} // namespace HistoryLayout
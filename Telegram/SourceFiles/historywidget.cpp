@@ -149,6 +149,10 @@ HistoryInner::HistoryInner(HistoryWidget *historyWidget, Ui::ScrollArea *scroll,
 	subscribe(Global::RefItemRemoved(), [this](HistoryItem *item) {
 		itemRemoved(item);
 	});
+
+	if (HistoryLayout::RenderCache::Enabled()) {
+		_renderCache = std_::make_unique<HistoryLayout::RenderCache>();
+	}
 }
 
 void HistoryInner::messagesReceived(PeerData *peer, const QVector<MTPMessage> &messages) {
@@ -175,8 +179,15 @@ void HistoryInner::messagesReceivedDown(PeerData *peer, const QVector<MTPMessage
 	}
 }
 
+void HistoryInner::invalidateItem(const HistoryItem *item) {
+	if (_renderCache) {
+		_renderCache->invalidate(item);
+	}
+}
+
 void HistoryInner::repaintItem(const HistoryItem *item) {
 	if (!item || item->detached() || !_history) return;
+	invalidateItem(item);
 	int32 msgy = itemTop(item);
 	if (msgy >= 0) {
 		update(0, msgy, width(), item->height());
@@ -185,15 +196,23 @@ void HistoryInner::repaintItem(const HistoryItem *item) {
 
 namespace {
 
+inline int blockOrItemTop(const HistoryBlock *block) {
+	return block->y;
+}
+
+inline int blockOrItemTop(int itemTop) {
+	return itemTop;
+}
+
 // helper binary search for an item in a list that is not completely
 // above the given top of the visible area or below the given bottom of the visible area
-// is applied once for blocks list in a history and once for items list in the found block
+// is applied once for blocks list in a history and once for item tops list in the found block
 template <bool TopToBottom, typename T>
 int binarySearchBlocksOrItems(const T &list, int edge) {
 	auto start = 0, end = list.size();
 	while (end - start > 1) {
 		auto middle = (start + end) / 2;
-		auto top = list[middle]->y;
+		auto top = blockOrItemTop(list[middle]);
 		auto chooseLeft = (TopToBottom ? (top <= edge) : (top < edge));
 		if (chooseLeft) {
 			start = middle;
@@ -225,7 +244,7 @@ void HistoryInner::enumerateItemsInHistory(History *history, int historytop, Met
 	auto block = history->blocks.at(blockIndex);
 	auto blocktop = historytop + block->y;
 	auto blockbottom = blocktop + block->height;
-	auto itemIndex = binarySearchBlocksOrItems<TopToBottom>(block->items, searchEdge - blocktop);
+	auto itemIndex = binarySearchBlocksOrItems<TopToBottom>(block->itemTops(), searchEdge - blocktop);
 
 	while (true) {
 		while (true) {
@@ -502,7 +521,7 @@ void HistoryInner::paintEvent(QPaintEvent *e) {
 						sel = i.value();
 					}
 				}
-				item->draw(p, r.translated(0, -y), sel, ms);
+				paintItem(p, item, r.translated(0, -y), sel, ms);
 
 				if (item->hasViews()) {
 					App::main()->scheduleViewIncrement(item);
@@ -549,7 +568,7 @@ void HistoryInner::paintEvent(QPaintEvent *e) {
 							sel = i.value();
 						}
 					}
-					item->draw(p, historyRect.translated(0, -y), sel, ms);
+					paintItem(p, item, historyRect.translated(0, -y), sel, ms);
 
 					if (item->hasViews()) {
 						App::main()->scheduleViewIncrement(item);
@@ -633,6 +652,81 @@ void HistoryInner::paintEvent(QPaintEvent *e) {
 			});
 		}
 	}
+
+	countPaint(getms() - ms);
+}
+
+void HistoryInner::paintItem(Painter &p, HistoryItem *item, const QRect &clip, TextSelection selection, TimeMs ms) {
+	if (_renderCache) {
+		_renderCache->paint(p, item, _history->width, clip, selection, ms);
+	} else {
+		item->draw(p, clip, selection, ms);
+	}
+}
+
+void HistoryInner::countPaint(TimeMs paintTime) {
+	constexpr auto kLogPaintsCount = 1000;
+
+	++_paintsCount;
+	_paintsTime += paintTime;
+	accumulate_max(_paintTimeMax, paintTime);
+	if (_paintsCount % kLogPaintsCount) {
+		return;
+	}
+
+	auto cache = QString("disabled");
+	if (_renderCache) {
+		auto &statistics = _renderCache->statistics();
+		cache = QString("%1 hits, %2 misses, %3 direct, %4 evicted, %5 KB").arg(statistics.hits).arg(statistics.misses).arg(statistics.direct).arg(statistics.evicted).arg(statistics.bytes / 1024);
+	}
+	DEBUG_LOG(("History Info: %1 paints, average %2ms, max %3ms, render cache: %4").arg(_paintsCount).arg(float64(_paintsTime) / _paintsCount).arg(_paintTimeMax).arg(cache));
+}
+
+void HistoryInner::unloadFarTextLayouts() {
+	// Messages further than a few screens from the visible area
+	// drop their text layouts, they are rebuilt when shown again.
+	constexpr auto kKeepTextLayoutsScreens = 5;
+	constexpr auto kLogChecksCount = 100;
+
+	auto visibleHeight = _visibleAreaBottom - _visibleAreaTop;
+	if (visibleHeight <= 0 || qAbs(_visibleAreaTop - _textLayoutsCheckedTop) < visibleHeight) {
+		return;
+	}
+	_textLayoutsCheckedTop = _visibleAreaTop;
+
+	auto logStatistics = !(++_textLayoutsChecksCount % kLogChecksCount);
+	auto keepTop = _visibleAreaTop - kKeepTextLayoutsScreens * visibleHeight;
+	auto keepBottom = _visibleAreaBottom + kKeepTextLayoutsScreens * visibleHeight;
+	auto messagesCount = 0, unloadedCount = 0;
+	auto messagesBytes = int64(0);
+	auto unloadFar = [&](History *history, int historyTop) {
+		if (!history || historyTop < 0) return;
+
+		for_const (auto block, history->blocks) {
+			auto blockTop = historyTop + block->y;
+			auto farAway = (blockTop + block->height <= keepTop || blockTop >= keepBottom);
+			if (!farAway && !logStatistics) continue;
+
+			for_const (auto item, block->items) {
+				if (farAway) {
+					item->unloadTextLayout();
+				}
+				if (logStatistics) {
+					++messagesCount;
+					messagesBytes += item->textMemoryUsage();
+					if (item->textLayoutUnloaded()) {
+						++unloadedCount;
+					}
+				}
+			}
+		}
+	};
+	unloadFar(_migrated, migratedTop());
+	unloadFar(_history, historyTop());
+
+	if (logStatistics && messagesCount > 0) {
+		DEBUG_LOG(("History Info: %1 messages, %2 without text layout, %3 text bytes per message, %4 interned strings").arg(messagesCount).arg(unloadedCount).arg(messagesBytes / messagesCount).arg(textInternedCount()));
+	}
 }
 
 bool HistoryInner::event(QEvent *e) {
@@ -1458,6 +1552,7 @@ void HistoryInner::savePhotoToFile(PhotoData *photo) {
 	auto filter = qsl("JPEG Image (*.jpg);;") + filedialogAllFilesFilter();
 	if (filedialogGetSaveFile(file, lang(lng_save_photo), filter, filedialogDefaultName(qsl("photo"), qsl(".jpg")))) {
 		if (!file.isEmpty()) {
+			photo->full->restore();
 			photo->full->pix().toImage().save(file, "JPG");
 		}
 	}
@@ -1470,6 +1565,7 @@ void HistoryInner::copyContextImage() {
 	PhotoData *photo = lnk->photo();
 	if (!photo || !photo->date || !photo->loaded()) return;
 
+	photo->full->restore();
 	QApplication::clipboard()->setPixmap(photo->full->pix());
 }
 
@@ -1746,6 +1842,7 @@ void HistoryInner::visibleAreaUpdated(int top, int bottom) {
 			}
 		}
 	}
+	unloadFarTextLayouts();
 	_scrollDateCheck.call();
 }
 
@@ -7031,6 +7128,9 @@ void HistoryWidget::ui_repaintHistoryItem(const HistoryItem *item) {
 		if (_lastScrolled + 100 <= ms) {
 			_list->repaintItem(item);
 		} else {
+			// The whole list is repainted later, the item must not be
+			// painted from the cache then.
+			_list->invalidateItem(item);
 			_updateHistoryItems.start(_lastScrolled + 100 - ms);
 		}
 	}
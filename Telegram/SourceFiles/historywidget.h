@@ -29,6 +29,7 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include "history/field_autocomplete.h"
 #include "window/section_widget.h"
 #include "core/single_timer.h"
+#include "history/history_render_cache.h"
 
 namespace InlineBots {
 namespace Layout {
@@ -83,6 +84,9 @@ public:
 
 	void repaintItem(const HistoryItem *item);
 
+	// Drops the cached painting of the item without a repaint.
+	void invalidateItem(const HistoryItem *item);
+
 	bool canCopySelected() const;
 	bool canDeleteSelected() const;
 
@@ -216,6 +220,18 @@ private:
 	style::cursor _cursor = style::cur_default;
 	using SelectedItems = QMap<HistoryItem*, TextSelection>;
 	SelectedItems _selected;
+
+	void paintItem(Painter &p, HistoryItem *item, const QRect &clip, TextSelection selection, TimeMs ms);
+	void countPaint(TimeMs paintTime);
+
+	std_::unique_ptr<HistoryLayout::RenderCache> _renderCache;
+	int64 _paintsCount = 0;
+	TimeMs _paintsTime = 0;
+	TimeMs _paintTimeMax = 0;
+
+	void unloadFarTextLayouts();
+	int _textLayoutsCheckedTop = 0;
+	int64 _textLayoutsChecksCount = 0;
 	void applyDragSelection();
 	void applyDragSelection(SelectedItems *toItems) const;
 	void addSelectionRange(SelectedItems *toItems, int32 fromblock, int32 fromitem, int32 toblock, int32 toitem, History *h) const;
@@ -280,6 +280,18 @@ bool Result::hasThumbDisplay() const {
 	return false;
 };
 
+void Result::preloadThumbnail() {
+	auto thumb = _thumb;
+	if (_document && !_document->thumb->isNull()) {
+		thumb = _document->thumb;
+	} else if (_photo && !_photo->thumb->isNull()) {
+		thumb = _photo->thumb;
+	}
+	if (!thumb->isNull()) {
+		thumb->load(false, false);
+	}
+}
+
 void Result::addToHistory(History *history, MTPDmessage::Flags flags, MsgId msgId, UserId fromId, MTPint mtpDate, UserId viaBotId, MsgId replyToId) const {
 	flags |= MTPDmessage_ClientFlag::f_from_inline_bot;
 
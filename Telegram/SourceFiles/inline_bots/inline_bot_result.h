@@ -67,6 +67,10 @@ public:
 
 	bool hasThumbDisplay() const;
 
+	// Starts loading the thumbnail with a low priority while the results
+	// are only cached, so that the layouts have it when they are shown.
+	void preloadThumbnail();
+
 	void addToHistory(History *history, MTPDmessage::Flags flags, MsgId msgId, UserId fromId, MTPint mtpDate, UserId viaBotId, MsgId replyToId) const;
 
 	// interface for Layout:: usage
@@ -150,6 +150,10 @@ public:
 	const QString &errors() const;
 	const QString &warnings() const;
 
+	bool hasValue(LangKey key) const {
+		return (key >= 0 && key < lngkeys_cnt) ? _found[key] : false;
+	}
+
 protected:
 	LangLoader() : _checked(false) {
 		memset(_found, 0, sizeof(_found));
@@ -0,0 +1,164 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#include "stdafx.h"
+#include "langloaderpack.h"
+
+#include "langloaderplain.h"
+
+namespace {
+
+// The format is duplicated in genlang.cpp
+constexpr auto kPackMagic = 0x4B50474CU;
+constexpr auto kPackVersion = 1U;
+constexpr auto kNoValue = 0xFFFFFFFFU;
+
+struct PackHeader {
+	uint32 magic;
+	uint32 version;
+	uint32 keysChecksum;
+	uint32 keysCount;
+	uint32 sourceChecksum;
+	uint32 dataChecksum;
+};
+
+// The strings of the loaded custom language point to this data.
+std_::unique_ptr<QFile> CustomPackFile;
+QByteArray CustomPackData;
+
+QString CustomPackPath() {
+	return cWorkingDir() + qsl("tdata/lang_custom.pack");
+}
+
+} // namespace
+
+LangLoaderPack::LangLoaderPack(const QByteArray &data, uint32 sourceChecksum) {
+	auto headerSize = int(sizeof(PackHeader));
+	auto offsetsSize = int(lngkeys_cnt * 2 * sizeof(uint32));
+	if (data.size() < headerSize + offsetsSize) {
+		error(qsl("Bad lang pack size: %1").arg(data.size()));
+		return;
+	}
+	auto header = reinterpret_cast<const PackHeader*>(data.constData());
+	if (header->magic != kPackMagic || header->version != kPackVersion) {
+		error(qsl("Bad lang pack format."));
+		return;
+	}
+	if (header->keysCount != uint32(lngkeys_cnt) || header->keysChecksum != lngkeys_checksum) {
+		error(qsl("Lang pack was made for other lang keys."));
+		return;
+	}
+	if (sourceChecksum && header->sourceChecksum != sourceChecksum) {
+		error(qsl("Lang pack was made from other source file."));
+		return;
+	}
+	auto body = data.constData() + headerSize;
+	auto bodySize = data.size() - headerSize;
+	if (uint32(hashCrc32(body, bodySize)) != header->dataChecksum) {
+		error(qsl("Bad lang pack checksum."));
+		return;
+	}
+
+	auto offsets = reinterpret_cast<const uint32*>(body);
+	auto values = reinterpret_cast<const QChar*>(body + offsetsSize);
+	auto valuesSize = uint32((bodySize - offsetsSize) / sizeof(QChar));
+	for (auto i = 0; i != lngkeys_cnt; ++i) {
+		auto offset = offsets[i * 2], length = offsets[i * 2 + 1];
+		if (offset != kNoValue && (offset > valuesSize || length > valuesSize - offset)) {
+			error(qsl("Bad value for key '%1' in lang pack.").arg(langKeyName(LangKey(i))));
+			return;
+		}
+	}
+	for (auto i = 0; i != lngkeys_cnt; ++i) {
+		auto offset = offsets[i * 2], length = offsets[i * 2 + 1];
+		if (offset != kNoValue) {
+			feedKeyValue(LangKey(i), QString::fromRawData(values + offset, length));
+		}
+	}
+}
+
+QByteArray LangLoaderPack::serialize(const LangLoader &loaded, uint32 sourceChecksum) {
+	auto offsets = QVector<uint32>(lngkeys_cnt * 2, 0);
+	auto values = QString();
+	for (auto i = 0; i != lngkeys_cnt; ++i) {
+		auto key = LangKey(i);
+		if (loaded.hasValue(key)) {
+			auto value = lang(key);
+			offsets[i * 2] = values.size();
+			offsets[i * 2 + 1] = value.size();
+			values.append(value);
+		} else {
+			offsets[i * 2] = kNoValue;
+		}
+	}
+	if (values.size() % 2) {
+		values.append(QChar(0)); // Keep the pack size aligned to four bytes.
+	}
+
+	auto body = QByteArray();
+	body.reserve(offsets.size() * sizeof(uint32) + values.size() * sizeof(QChar));
+	body.append(reinterpret_cast<const char*>(offsets.constData()), offsets.size() * sizeof(uint32));
+	body.append(reinterpret_cast<const char*>(values.constData()), values.size() * sizeof(QChar));
+
+	auto header = PackHeader { kPackMagic, kPackVersion, lngkeys_checksum, uint32(lngkeys_cnt), sourceChecksum, uint32(hashCrc32(body.constData(), body.size())) };
+	return QByteArray(reinterpret_cast<const char*>(&header), sizeof(header)) + body;
+}
+
+QString LangLoaderPack::loadCustom(const QString &file, QString *warnings) {
+	QFile source(file);
+	if (!source.open(QIODevice::ReadOnly)) {
+		return qsl("Could not open input file!");
+	}
+	auto sourceData = source.readAll();
+	auto sourceChecksum = uint32(hashCrc32(sourceData.constData(), sourceData.size()));
+	sourceData = QByteArray();
+	source.close();
+
+	auto pack = std_::make_unique<QFile>(CustomPackPath());
+	if (pack->open(QIODevice::ReadOnly)) {
+		auto size = pack->size();
+		auto mapped = pack->map(0, size);
+		auto data = mapped ? QByteArray::fromRawData(reinterpret_cast<const char*>(mapped), int(size)) : pack->readAll();
+		LangLoaderPack loader(data, sourceChecksum);
+		if (loader.errors().isEmpty()) {
+			if (mapped) {
+				CustomPackFile = std_::move(pack);
+			} else {
+				CustomPackData = data;
+			}
+			*warnings = loader.warnings();
+			return QString();
+		}
+		DEBUG_LOG(("Lang Info: compiled custom language skipped, %1").arg(loader.errors()));
+	}
+	pack = nullptr;
+
+	LangLoaderPlain loader(file);
+	if (!loader.errors().isEmpty()) {
+		return loader.errors();
+	}
+	*warnings = loader.warnings();
+
+	QFile compiled(CustomPackPath());
+	if (compiled.open(QIODevice::WriteOnly)) {
+		compiled.write(serialize(loader, sourceChecksum));
+	}
+	return QString();
+}
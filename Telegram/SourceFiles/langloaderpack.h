@@ -0,0 +1,41 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#pragma once
+
+#include "lang.h"
+
+// Reads the binary language pack made by MetaLang from 'lang_{code}.strings'
+// (see genlang.cpp) or by serialize() from the loaded custom language.
+// The values are not copied from the pack, so its data must stay alive
+// while the language is used.
+class LangLoaderPack : public LangLoader {
+public:
+	// The source file checksum is checked only if it is not zero.
+	LangLoaderPack(const QByteArray &data, uint32 sourceChecksum = 0);
+
+	static QByteArray serialize(const LangLoader &loaded, uint32 sourceChecksum);
+
+	// The compiled pack of the custom language file is kept in tdata,
+	// so that the file is parsed again only after it was changed.
+	// Returns the load errors, warnings are written to the passed string.
+	static QString loadCustom(const QString &file, QString *warnings);
+
+};
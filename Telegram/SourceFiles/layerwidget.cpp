@@ -749,7 +749,7 @@ void MediaPreviewWidget::paintEvent(QPaintEvent *e) {
 		int emojiLeft = (width() - emojiWidth) / 2;
 		int esize = EmojiSizes[EIndex + 1];
 		for_const (auto emoji, _emojiList) {
-			p.drawPixmapLeft(emojiLeft, (height() - h) / 2 - (_emojiSize * 2), width(), App::emojiLarge(), QRect(emoji->x * esize, emoji->y * esize, esize, esize));
+			p.drawPixmapLeft(emojiLeft, (height() - h) / 2 - (_emojiSize * 2), width(), App::emojiLarge(emoji), QRect(emoji->x * esize, 0, esize, esize));
 			emojiLeft += _emojiSize + st::stickerEmojiSkip;
 		}
 	}
@@ -925,6 +925,7 @@ QPixmap MediaPreviewWidget::currentImage() const {
 			}
 			if (_cacheStatus != CacheThumbLoaded && _document->thumb->loaded()) {
 				QSize s = currentDimensions();
+				_document->thumb->restore();
 				_cache = _document->thumb->pixBlurred(s.width(), s.height());
 				_cacheStatus = CacheThumbLoaded;
 			}
@@ -933,11 +934,13 @@ QPixmap MediaPreviewWidget::currentImage() const {
 		if (_cacheStatus != CacheLoaded) {
 			if (_photo->full->loaded()) {
 				QSize s = currentDimensions();
+				_photo->full->restore();
 				_cache = _photo->full->pix(s.width(), s.height());
 				_cacheStatus = CacheLoaded;
 			} else {
 				if (_cacheStatus != CacheThumbLoaded && _photo->thumb->loaded()) {
 					QSize s = currentDimensions();
+					_photo->thumb->restore();
 					_cache = _photo->thumb->pixBlurred(s.width(), s.height());
 					_cacheStatus = CacheThumbLoaded;
 				}
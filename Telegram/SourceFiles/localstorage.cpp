@@ -287,7 +287,9 @@ struct FileWriteDescriptor {
 		qint32 version = AppVersion;
 		md5.feed(&version, sizeof(version));
 		md5.feed(tdfMagic, tdfMagicLen);
-		file.write((const char*)md5.result(), 0x10);
+		char signature[base::hash::Md5::kSize];
+		md5.finish(signature);
+		file.write(signature, base::hash::Md5::kSize);
 		file.close();
 
 		if (!toDelete.isEmpty()) {
@@ -299,7 +301,7 @@ struct FileWriteDescriptor {
 
 	QString toDelete;
 
-	HashMd5 md5;
+	base::hash::Md5 md5;
 	int32 dataSize = 0;
 
 	~FileWriteDescriptor() {
@@ -375,12 +377,14 @@ bool readFile(FileReadDescriptor &result, const QString &name, FileOptions optio
 		}
 
 		// check signature
-		HashMd5 md5;
+		base::hash::Md5 md5;
 		md5.feed(bytes.constData(), dataSize);
 		md5.feed(&dataSize, sizeof(dataSize));
 		md5.feed(&version, sizeof(version));
 		md5.feed(magic, tdfMagicLen);
-		if (memcmp(md5.result(), bytes.constData() + dataSize, 16)) {
+		char signature[base::hash::Md5::kSize];
+		md5.finish(signature);
+		if (memcmp(signature, bytes.constData() + dataSize, base::hash::Md5::kSize)) {
 			DEBUG_LOG(("App Info: bad file '%1', signature did not match").arg(name));
 			continue;
 		}
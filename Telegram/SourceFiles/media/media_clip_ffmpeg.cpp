@@ -57,8 +57,10 @@ bool isAlignedImage(const QImage &image) {
 
 } // namespace
 
-FFMpegReaderImplementation::FFMpegReaderImplementation(FileLocation *location, QByteArray *data, uint64 playId) : ReaderImplementation(location, data)
-, _playId(playId) {
+FFMpegReaderImplementation::FFMpegReaderImplementation(FileLocation *location, QByteArray *data, uint64 playId, const FileLoadStreamingPtr &streaming, uint64 streamingId) : ReaderImplementation(location, data)
+, _playId(playId)
+, _streaming(streaming)
+, _streamingId(streamingId) {
 	_frame = av_frame_alloc();
 	av_init_packet(&_packetNull);
 	_packetNull.data = nullptr;
@@ -309,7 +311,14 @@ bool FFMpegReaderImplementation::start(Mode mode, TimeMs &positionMs) {
 	_mode = mode;
 
 	initDevice();
-	if (!_device->open(QIODevice::ReadOnly)) {
+
+	// The file is written by the loader in parallel, so it must not be buffered.
+	QIODevice::OpenMode openMode = QIODevice::ReadOnly;
+	if (_streaming) {
+		_dataSize = _streaming->size();
+		openMode |= QIODevice::Unbuffered;
+	}
+	if (!_device->open(openMode)) {
 		LOG(("Gif Error: Unable to open device %1").arg(logData()));
 		return false;
 	}
@@ -572,6 +581,13 @@ void FFMpegReaderImplementation::clearPacketQueue() {
 
 int FFMpegReaderImplementation::_read(void *opaque, uint8_t *buf, int buf_size) {
 	FFMpegReaderImplementation *l = reinterpret_cast<FFMpegReaderImplementation*>(opaque);
+	if (l->_streaming) {
+		auto available = l->_streaming->waitForData(l->_device->pos(), buf_size, l->_streamingId);
+		if (available <= 0) {
+			return int(available);
+		}
+		buf_size = int(available);
+	}
 	return int(l->_device->read((char*)(buf), buf_size));
 }
 
@@ -581,7 +597,10 @@ int64_t FFMpegReaderImplementation::_seek(void *opaque, int64_t offset, int when
 	switch (whence) {
 	case SEEK_SET: return l->_device->seek(offset) ? l->_device->pos() : -1;
 	case SEEK_CUR: return l->_device->seek(l->_device->pos() + offset) ? l->_device->pos() : -1;
-	case SEEK_END: return l->_device->seek(l->_device->size() + offset) ? l->_device->pos() : -1;
+	case SEEK_END: {
+		auto size = l->_streaming ? int64(l->_streaming->size()) : l->_device->size();
+		return l->_device->seek(size + offset) ? l->_device->pos() : -1;
+	} break;
 	}
 	return -1;
 }
@@ -35,7 +35,7 @@ namespace internal {
 
 class FFMpegReaderImplementation : public ReaderImplementation {
 public:
-	FFMpegReaderImplementation(FileLocation *location, QByteArray *data, uint64 playId);
+	FFMpegReaderImplementation(FileLocation *location, QByteArray *data, uint64 playId, const FileLoadStreamingPtr &streaming = FileLoadStreamingPtr(), uint64 streamingId = 0);
 
 	ReadResult readFramesTill(TimeMs frameMs, TimeMs systemMs) override;
 
@@ -110,6 +110,10 @@ private:
 	TimeMs _lastReadVideoMs = 0;
 	TimeMs _lastReadAudioMs = 0;
 
+	// If the file is still being downloaded all reads wait for the loader.
+	FileLoadStreamingPtr _streaming;
+	uint64 _streamingId = 0;
+
 	QQueue<FFMpeg::AVPacketDataWrap> _packetQueue;
 	AVPacket _packetNull; // for final decoding
 	int _packetStartedSize = 0;
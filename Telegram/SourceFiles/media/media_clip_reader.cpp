@@ -40,6 +40,10 @@ namespace {
 QVector<QThread*> threads;
 QVector<Manager*> managers;
 
+// Readers of files that are still being downloaded block while waiting
+// for the data, so they get a thread of their own instead of the GIF ones.
+int streamingThreadIndex = -1;
+
 QPixmap _prepareFrame(const FrameRequest &request, const QImage &original, bool hasAlpha, QImage &cache) {
 	bool badSize = (original.width() != request.framew) || (original.height() != request.frameh);
 	bool needOuter = (request.outerw != request.framew) || (request.outerh != request.frameh);
@@ -85,20 +89,28 @@ QPixmap _prepareFrame(const FrameRequest &request, const QImage &original, bool
 
 } // namespace
 
-Reader::Reader(const FileLocation &location, const QByteArray &data, Callback &&callback, Mode mode, int64 seekMs)
+Reader::Reader(const FileLocation &location, const QByteArray &data, Callback &&callback, Mode mode, int64 seekMs, const FileLoadStreamingPtr &streaming)
 : _callback(std_::move(callback))
 , _mode(mode)
 , _playId(rand_value<uint64>())
+, _streaming(streaming)
 , _seekPositionMs(seekMs) {
-	if (threads.size() < ClipThreadsCount) {
+	auto commonThreadsCount = threads.size() - ((streamingThreadIndex >= 0) ? 1 : 0);
+	if ((_streaming && streamingThreadIndex < 0) || (!_streaming && commonThreadsCount < ClipThreadsCount)) {
 		_threadIndex = threads.size();
 		threads.push_back(new QThread());
 		managers.push_back(new Manager(threads.back()));
 		threads.back()->start();
+		if (_streaming) {
+			streamingThreadIndex = _threadIndex;
+		}
+	} else if (_streaming) {
+		_threadIndex = streamingThreadIndex;
 	} else {
-		_threadIndex = int32(rand_value<uint32>() % threads.size());
+		_threadIndex = -1;
 		int32 loadLevel = 0x7FFFFFFF;
 		for (int32 i = 0, l = threads.size(); i < l; ++i) {
+			if (i == streamingThreadIndex) continue;
 			int32 level = managers.at(i)->loadLevel();
 			if (level < loadLevel) {
 				_threadIndex = i;
@@ -307,6 +319,9 @@ State Reader::state() const {
 }
 
 void Reader::stop() {
+	if (_streaming) {
+		_streaming->interrupt(_playId);
+	}
 	if (managers.size() <= _threadIndex) error();
 	if (_state != State::Error) {
 		managers.at(_threadIndex)->stop(this);
@@ -334,6 +349,7 @@ public:
 	, _mode(reader->mode())
 	, _playId(reader->playId())
 	, _seekPositionMs(reader->seekPositionMs())
+	, _streaming(reader->streaming())
 	, _data(data) {
 		if (_data.isEmpty()) {
 			_location = std_::make_unique<FileLocation>(location);
@@ -357,7 +373,7 @@ public:
 
 				auto firstFramePlayId = 0LL;
 				auto firstFramePositionMs = 0LL;
-				auto reader = std_::make_unique<internal::FFMpegReaderImplementation>(_location.get(), &_data, firstFramePlayId);
+				auto reader = std_::make_unique<internal::FFMpegReaderImplementation>(_location.get(), &_data, firstFramePlayId, _streaming, _playId);
 				if (reader->start(internal::ReaderImplementation::Mode::Normal, firstFramePositionMs)) {
 					auto firstFrameReadResult = reader->readFramesTill(-1, ms);
 					if (firstFrameReadResult == internal::ReaderImplementation::ReadResult::Success) {
@@ -454,7 +470,7 @@ public:
 	}
 
 	bool init() {
-		if (_data.isEmpty() && QFileInfo(_location->name()).size() <= AnimationInMemory) {
+		if (_data.isEmpty() && !_streaming && QFileInfo(_location->name()).size() <= AnimationInMemory) {
 			QFile f(_location->name());
 			if (f.open(QIODevice::ReadOnly)) {
 				_data = f.readAll();
@@ -464,7 +480,7 @@ public:
 			}
 		}
 
-		_implementation = std_::make_unique<internal::FFMpegReaderImplementation>(_location.get(), &_data, _playId);
+		_implementation = std_::make_unique<internal::FFMpegReaderImplementation>(_location.get(), &_data, _playId, _streaming, _playId);
 //		_implementation = new QtGifReaderImplementation(_location, &_data);
 
 		auto implementationMode = [this]() {
@@ -528,6 +544,7 @@ private:
 	Reader::Mode _mode;
 	uint64 _playId;
 	TimeMs _seekPositionMs = 0;
+	FileLoadStreamingPtr _streaming;
 
 	QByteArray _data;
 	std_::unique_ptr<FileLocation> _location;
@@ -616,6 +633,15 @@ bool Manager::carries(Reader *reader) const {
 	return _readerPointers.contains(reader);
 }
 
+void Manager::interruptStreaming() {
+	QMutexLocker lock(&_readerPointersMutex);
+	for (auto i = _readerPointers.cbegin(), e = _readerPointers.cend(); i != e; ++i) {
+		if (auto &streaming = i.key()->streaming()) {
+			streaming->interrupt(i.key()->playId());
+		}
+	}
+}
+
 Manager::ReaderPointers::iterator Manager::unsafeFindReaderPointer(ReaderPrivate *reader) {
 	ReaderPointers::iterator it = _readerPointers.find(reader->_interface);
 
@@ -864,6 +890,9 @@ MTPDocumentAttribute readAttributes(const QString &fname, const QByteArray &data
 
 void Finish() {
 	if (!threads.isEmpty()) {
+		for_const (auto manager, managers) {
+			manager->interruptStreaming();
+		}
 		for (int32 i = 0, l = threads.size(); i < l; ++i) {
 			threads.at(i)->quit();
 			DEBUG_LOG(("Waiting for clipThread to finish: %1").arg(i));
@@ -873,6 +902,7 @@ void Finish() {
 		}
 		threads.clear();
 		managers.clear();
+		streamingThreadIndex = -1;
 	}
 }
 
@@ -59,7 +59,7 @@ public:
 		Video,
 	};
 
-	Reader(const FileLocation &location, const QByteArray &data, Callback &&callback, Mode mode = Mode::Gif, TimeMs seekMs = 0);
+	Reader(const FileLocation &location, const QByteArray &data, Callback &&callback, Mode mode = Mode::Gif, TimeMs seekMs = 0, const FileLoadStreamingPtr &streaming = FileLoadStreamingPtr());
 	static void callback(Reader *reader, int threadIndex, Notification notification); // reader can be deleted
 
 	void setAutoplay() {
@@ -75,6 +75,9 @@ public:
 	TimeMs seekPositionMs() const {
 		return _seekPositionMs;
 	}
+	const FileLoadStreamingPtr &streaming() const {
+		return _streaming;
+	}
 
 	void start(int framew, int frameh, int outerw, int outerh, ImageRoundRadius radius, ImageRoundCorners corners);
 	QPixmap current(int framew, int frameh, int outerw, int outerh, ImageRoundRadius radius, ImageRoundCorners corners, TimeMs ms);
@@ -131,6 +134,7 @@ private:
 	State _state = State::Reading;
 
 	uint64 _playId;
+	FileLoadStreamingPtr _streaming;
 	bool _hasAudio = false;
 	TimeMs _durationMs = 0;
 	TimeMs _seekPositionMs = 0;
@@ -202,6 +206,7 @@ public:
 	void update(Reader *reader);
 	void stop(Reader *reader);
 	bool carries(Reader *reader) const;
+	void interruptStreaming();
 	~Manager();
 
 signals:
@@ -0,0 +1,232 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#include "stdafx.h"
+#include "media/view/media_view_prefetcher.h"
+
+#include "core/task_queue.h"
+
+namespace Media {
+namespace View {
+namespace {
+
+constexpr auto kMemoryLimit = 64 * 1024 * 1024LL;
+constexpr auto kLogStatisticsEach = 20;
+
+int64 PixmapMemory(const QPixmap &pix) {
+	return int64(pix.width()) * pix.height() * 4;
+}
+
+} // namespace
+
+Prefetcher::Prefetcher() : _shared(MakeShared<Shared>()) {
+	_shared->owner = this;
+	subscribe(FileDownload::ImageLoaded(), [this] {
+		for (auto i = _entries.begin(), e = _entries.end(); i != e; ++i) {
+			if (i->pix.isNull() && !i->requestId) {
+				startPreparing(i.key(), i.value());
+			}
+		}
+	});
+}
+
+void Prefetcher::setDirection(int delta) {
+	++_round;
+
+	auto direction = (delta > 0) ? 1 : (delta < 0 ? -1 : 0);
+	if (!direction) return;
+
+	if (_direction && direction != _direction) {
+		// The queued tasks check the generation before decoding anything.
+		_shared->generation.fetchAndAddOrdered(1);
+		for (auto i = _entries.begin(); i != _entries.end();) {
+			if (i->pix.isNull()) {
+				if (i->requestId) {
+					++_cancelled;
+				}
+				i = _entries.erase(i);
+			} else {
+				++i;
+			}
+		}
+	}
+	_direction = direction;
+}
+
+void Prefetcher::schedule(PhotoData *photo, QSize size, int distance) {
+	schedule(photo, photo, nullptr, size, distance);
+}
+
+void Prefetcher::schedule(DocumentData *document, QSize size, int distance) {
+	schedule(document, nullptr, document, size, distance);
+}
+
+void Prefetcher::schedule(Key key, PhotoData *photo, DocumentData *document, QSize size, int distance) {
+	if (size.isEmpty()) return;
+
+	auto i = _entries.find(key);
+	if (i == _entries.end()) {
+		i = _entries.insert(key, Entry());
+	} else if (i->size != size) {
+		_memory -= PixmapMemory(i->pix);
+		i->pix = QPixmap();
+		i->requestId = 0;
+	}
+	i->photo = photo;
+	i->document = document;
+	i->size = size;
+	i->round = _round;
+	i->distance = distance;
+	if (i->pix.isNull() && !i->requestId) {
+		startPreparing(key, i.value());
+	}
+}
+
+QPixmap Prefetcher::take(PhotoData *photo, QSize size) {
+	return take(Key(photo), size);
+}
+
+QPixmap Prefetcher::take(DocumentData *document, QSize size) {
+	return take(Key(document), size);
+}
+
+QPixmap Prefetcher::take(Key key, QSize size) {
+	auto i = _entries.constFind(key);
+	auto hit = (i != _entries.cend()) && (i->size == size) && !i->pix.isNull();
+	countTake(key, hit);
+	return hit ? i->pix : QPixmap();
+}
+
+ImagePtr Prefetcher::sourceImage(const Entry &entry) const {
+	return entry.photo ? entry.photo->full : entry.document->thumb;
+}
+
+void Prefetcher::startPreparing(Key key, Entry &entry) {
+	auto image = sourceImage(entry);
+	if (image->isNull() || !image->loaded()) {
+		return; // Will be started when the image is loaded.
+	}
+
+	auto saved = image->savedData();
+	auto format = image->savedFormat();
+	if (saved.isEmpty()) {
+		return;
+	}
+
+	auto requestId = entry.requestId = ++_lastRequestId;
+	auto size = entry.size;
+	auto options = entry.document ? (Images::Option::Smooth | Images::Option::Blurred) : Images::Options(Images::Option::Smooth);
+	auto weak = _shared.toWeakRef();
+	auto generation = _shared->generation.loadAcquire();
+	base::TaskQueue::Normal().Put([weak, generation, key, requestId, size, options, saved, format] {
+		if (auto shared = weak.toStrongRef()) {
+			if (shared->generation.loadAcquire() != generation) {
+				return;
+			}
+		} else {
+			return;
+		}
+
+		auto bytes = saved;
+		QBuffer buffer(&bytes);
+		QImageReader reader(&buffer, format);
+#ifndef OS_MAC_OLD
+		reader.setAutoTransform(true);
+#endif // OS_MAC_OLD
+		struct mutable_data {
+			mutable_data(QImage &&value) : value(std_::move(value)) {
+			}
+			mutable QImage value;
+		};
+		auto data = mutable_data(reader.read());
+		if (!data.value.isNull()) {
+			data.value = Images::prepare(std_::move(data.value), size.width(), size.height(), options, -1, -1);
+		}
+		base::TaskQueue::Main().Put([weak, key, requestId, data = std_::move(data)] {
+			if (auto shared = weak.toStrongRef()) {
+				if (shared->owner) {
+					shared->owner->prepared(key, requestId, std_::move(data.value));
+				}
+			}
+		});
+	});
+}
+
+void Prefetcher::prepared(Key key, uint64 requestId, QImage &&image) {
+	auto i = _entries.find(key);
+	if (i == _entries.end() || i->requestId != requestId) {
+		return;
+	}
+	i->requestId = 0;
+	if (image.isNull()) {
+		return;
+	}
+	i->pix = App::pixmapFromImageInPlace(std_::move(image));
+	_memory += PixmapMemory(i->pix);
+	checkMemoryLimit();
+}
+
+void Prefetcher::checkMemoryLimit() {
+	while (_memory > kMemoryLimit) {
+		// Drop the items scheduled in the older rounds first, then the farthest ones.
+		auto farthest = _entries.end();
+		for (auto i = _entries.begin(), e = _entries.end(); i != e; ++i) {
+			if (i->pix.isNull()) continue;
+			if (farthest == _entries.end()
+				|| i->round < farthest->round
+				|| (i->round == farthest->round && i->distance > farthest->distance)) {
+				farthest = i;
+			}
+		}
+		if (farthest == _entries.end()) break;
+		removeEntry(farthest);
+	}
+}
+
+void Prefetcher::removeEntry(QMap<Key, Entry>::iterator i) {
+	_memory -= PixmapMemory(i->pix);
+	_entries.erase(i);
+}
+
+void Prefetcher::countTake(Key key, bool hit) {
+	if (_lastTaken == key) return;
+	_lastTaken = key;
+
+	++(hit ? _hits : _misses);
+	if (!((_hits + _misses) % kLogStatisticsEach)) {
+		auto total = _hits + _misses;
+		DEBUG_LOG(("MediaView Info: prefetch hit rate %1% (%2 of %3), cancelled %4, prepared %5 items of %6 kb").arg(_hits * 100 / total).arg(_hits).arg(total).arg(_cancelled).arg(_entries.size()).arg(_memory / 1024));
+	}
+}
+
+void Prefetcher::clear() {
+	_shared->generation.fetchAndAddOrdered(1);
+	_entries.clear();
+	_memory = 0;
+	_direction = 0;
+	_lastTaken = nullptr;
+}
+
+Prefetcher::~Prefetcher() {
+	_shared->owner = nullptr;
+}
+
+} // namespace View
+} // namespace Media
@@ -0,0 +1,99 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#pragma once
+
+namespace Media {
+namespace View {
+
+// Prepares the media viewer neighbours ahead in the browsing direction:
+// full photos are decoded and scaled to the screen-fit size and video
+// thumbnails are blurred on the worker threads, so that flipping through
+// an album does not decode anything on the main thread.
+class Prefetcher : private base::Subscriber {
+public:
+	Prefetcher();
+
+	// Starts a new scheduling round, the work queued for the
+	// previous direction is cancelled if the direction was reversed.
+	void setDirection(int delta);
+
+	// Distance is the count of items from the shown one, the farthest
+	// prepared items are dropped first when the memory limit is reached.
+	void schedule(PhotoData *photo, QSize size, int distance);
+	void schedule(DocumentData *document, QSize size, int distance);
+
+	// Returns a null pixmap if the item was not prepared in that size.
+	// Repeated calls for the same item are counted as a single hit or miss.
+	QPixmap take(PhotoData *photo, QSize size);
+	QPixmap take(DocumentData *document, QSize size);
+
+	void clear();
+
+	int hits() const {
+		return _hits;
+	}
+	int misses() const {
+		return _misses;
+	}
+
+	~Prefetcher();
+
+private:
+	struct Shared {
+		Prefetcher *owner = nullptr;
+		QAtomicInt generation = 0;
+	};
+	struct Entry {
+		PhotoData *photo = nullptr;
+		DocumentData *document = nullptr;
+		QSize size;
+		int round = 0;
+		int distance = 0;
+		uint64 requestId = 0; // Non-zero while the item is being prepared.
+		QPixmap pix;
+	};
+	using Key = const void*;
+
+	void schedule(Key key, PhotoData *photo, DocumentData *document, QSize size, int distance);
+	QPixmap take(Key key, QSize size);
+	ImagePtr sourceImage(const Entry &entry) const;
+	void startPreparing(Key key, Entry &entry);
+	void prepared(Key key, uint64 requestId, QImage &&image);
+	void checkMemoryLimit();
+	void removeEntry(QMap<Key, Entry>::iterator i);
+	void countTake(Key key, bool hit);
+
+	QSharedPointer<Shared> _shared;
+	QMap<Key, Entry> _entries;
+	int64 _memory = 0;
+	uint64 _lastRequestId = 0;
+	int _round = 0;
+	int _direction = 0;
+
+	int _hits = 0;
+	int _misses = 0;
+	int _cancelled = 0;
+	Key _lastTaken = nullptr;
+
+};
+
+} // namespace View
+} // namespace Media
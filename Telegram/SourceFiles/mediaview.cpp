@@ -30,6 +30,7 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include "ui/widgets/buttons.h"
 #include "media/media_clip_reader.h"
 #include "media/view/media_clip_controller.h"
+#include "media/view/media_view_prefetcher.h"
 #include "styles/style_mediaview.h"
 #include "styles/style_history.h"
 #include "media/media_audio.h"
@@ -77,7 +78,8 @@ MediaView::MediaView(QWidget*) : TWidget(nullptr)
 , _lastAction(-st::mediaviewDeltaFromLastAction, -st::mediaviewDeltaFromLastAction)
 , _a_state(animation(this, &MediaView::step_state))
 , _dropdown(this, st::mediaviewDropdownMenu)
-, _dropdownShowTimer(this) {
+, _dropdownShowTimer(this)
+, _prefetcher(std_::make_unique<Media::View::Prefetcher>()) {
 	TextCustomTagsMap custom;
 	custom.insert(QChar('c'), qMakePair(textcmdStartLink(1), textcmdStopLink()));
 	_saveMsgText.setRichText(st::mediaviewSaveMsgStyle, lang(lng_mediaview_saved), _textDlgOptions, custom);
@@ -615,6 +617,7 @@ void MediaView::clearData() {
 	_doc = nullptr;
 	_fullScreenVideo = false;
 	_caption.clear();
+	_prefetcher->clear();
 }
 
 MediaView::~MediaView() {
@@ -778,6 +781,7 @@ void MediaView::onSaveAs() {
 		psShowOverAll(this);
 		if (gotName) {
 			if (!file.isEmpty()) {
+				_photo->full->restore();
 				_photo->full->pix().toImage().save(file, "JPG");
 			}
 		}
@@ -887,6 +891,7 @@ void MediaView::onDownload() {
 		} else {
 			if (!QDir().exists(path)) QDir().mkpath(path);
 			toName = filedialogDefaultName(qsl("photo"), qsl(".jpg"), path);
+			_photo->full->restore();
 			if (!_photo->full->pix().toImage().save(toName, "JPG")) {
 				toName = QString();
 			}
@@ -970,6 +975,7 @@ void MediaView::onCopy() {
 	} else {
 		if (!_photo || !_photo->loaded()) return;
 
+		_photo->full->restore();
 		QApplication::clipboard()->setPixmap(_photo->full->pix());
 	}
 }
@@ -1217,8 +1223,10 @@ void MediaView::displayDocument(DocumentData *doc, HistoryItem *item) { // empty
 		if (_doc->sticker()) {
 			_doc->checkSticker();
 			if (!_doc->sticker()->img->isNull()) {
+				_doc->sticker()->img->restore();
 				_current = _doc->sticker()->img->pix();
 			} else {
+				_doc->thumb->restore();
 				_current = _doc->thumb->pixBlurred(_doc->dimensions.width(), _doc->dimensions.height());
 			}
 		} else {
@@ -1380,16 +1388,52 @@ void MediaView::initAnimation() {
 	} else if (location.accessEnable()) {
 		createClipReader();
 		location.accessDisable();
+	} else if (_doc->streaming()) {
+		if (_doc->isVideo()) {
+			_autoplayVideoDocument = _doc;
+		}
+		createClipReader();
 	} else if (_doc->dimensions.width() && _doc->dimensions.height()) {
-		int w = _doc->dimensions.width();
-		int h = _doc->dimensions.height();
-		_current = _doc->thumb->pixNoCache(w, h, Images::Option::Smooth | Images::Option::Blurred, w / cIntRetinaFactor(), h / cIntRetinaFactor());
-		if (cRetina()) _current.setDevicePixelRatio(cRetinaFactor());
+		_current = videoPlaceholder();
 	} else {
 		_current = _doc->thumb->pixNoCache(_doc->thumb->width(), _doc->thumb->height(), Images::Option::Smooth | Images::Option::Blurred, st::mediaviewFileIconSize, st::mediaviewFileIconSize);
 	}
 }
 
+QPixmap MediaView::videoPlaceholder() const {
+	auto size = videoPlaceholderSize(_doc);
+	auto result = _prefetcher->take(_doc, size);
+	if (result.isNull()) {
+		auto w = size.width(), h = size.height();
+		result = _doc->thumb->pixNoCache(w, h, Images::Option::Smooth | Images::Option::Blurred, w / cIntRetinaFactor(), h / cIntRetinaFactor());
+	}
+	if (cRetina()) result.setDevicePixelRatio(cRetinaFactor());
+	return result;
+}
+
+QSize MediaView::videoPlaceholderSize(DocumentData *document) const {
+	if (!document->isVideo() && !document->isAnimation()) {
+		return QSize();
+	}
+	return document->dimensions;
+}
+
+QSize MediaView::photoScreenFitSize(PhotoData *photo) const {
+	// Same as the size computed in displayPhoto() and used in paintEvent().
+	auto w = convertScale(photo->full->width());
+	auto h = convertScale(photo->full->height());
+	if (w > width()) {
+		h = qRound(h * width() / float64(w));
+		w = width();
+	}
+	if (h > height()) {
+		w = qRound(w * height() / float64(h));
+		h = height();
+	}
+	w *= cIntRetinaFactor();
+	return QSize(w, int((photo->full->height() * (qreal(w) / qreal(photo->full->width()))) + 0.9999));
+}
+
 void MediaView::createClipReader() {
 	if (_gif) return;
 
@@ -1397,17 +1441,16 @@ void MediaView::createClipReader() {
 	t_assert(_doc->isAnimation() || _doc->isVideo());
 
 	if (_doc->dimensions.width() && _doc->dimensions.height()) {
-		int w = _doc->dimensions.width();
-		int h = _doc->dimensions.height();
-		_current = _doc->thumb->pixNoCache(w, h, Images::Option::Smooth | Images::Option::Blurred, w / cIntRetinaFactor(), h / cIntRetinaFactor());
-		if (cRetina()) _current.setDevicePixelRatio(cRetinaFactor());
+		_current = videoPlaceholder();
 	} else {
 		_current = _doc->thumb->pixNoCache(_doc->thumb->width(), _doc->thumb->height(), Images::Option::Smooth | Images::Option::Blurred, st::mediaviewFileIconSize, st::mediaviewFileIconSize);
 	}
 	auto mode = _doc->isVideo() ? Media::Clip::Reader::Mode::Video : Media::Clip::Reader::Mode::Gif;
-	_gif = std_::make_unique<Media::Clip::Reader>(_doc->location(), _doc->data(), [this](Media::Clip::Notification notification) {
+	auto streaming = _doc->loaded() ? FileLoadStreamingPtr() : _doc->streaming();
+	auto location = streaming ? FileLocation(StorageFilePartial, streaming->fileName()) : _doc->location();
+	_gif = std_::make_unique<Media::Clip::Reader>(location, _doc->data(), [this](Media::Clip::Notification notification) {
 		clipCallback(notification);
-	}, mode);
+	}, mode, 0, streaming);
 
 	// Correct values will be set when gif gets inited.
 	_videoPaused = _videoIsSilent = _videoStopped = false;
@@ -1528,9 +1571,13 @@ void MediaView::restartVideoAtSeekPosition(TimeMs positionMs) {
 	if (_current.isNull()) {
 		_current = _gif->current(_gif->width() / cIntRetinaFactor(), _gif->height() / cIntRetinaFactor(), _gif->width() / cIntRetinaFactor(), _gif->height() / cIntRetinaFactor(), ImageRoundRadius::None, ImageRoundCorner::None, getms());
 	}
-	_gif = std_::make_unique<Media::Clip::Reader>(_doc->location(), _doc->data(), [this](Media::Clip::Notification notification) {
+	// While the video is loading the restarted reader makes the loader
+	// fetch the parts around the new position first.
+	auto streaming = _doc->loaded() ? FileLoadStreamingPtr() : _doc->streaming();
+	auto location = streaming ? FileLocation(StorageFilePartial, streaming->fileName()) : _doc->location();
+	_gif = std_::make_unique<Media::Clip::Reader>(location, _doc->data(), [this](Media::Clip::Notification notification) {
 		clipCallback(notification);
-	}, Media::Clip::Reader::Mode::Video, positionMs);
+	}, Media::Clip::Reader::Mode::Video, positionMs, streaming);
 
 	// Correct values will be set when gif gets inited.
 	_videoPaused = _videoIsSilent = _videoStopped = false;
@@ -1644,9 +1691,22 @@ void MediaView::paintEvent(QPaintEvent *e) {
 	// photo
 	if (_photo) {
 		int32 w = _width * cIntRetinaFactor();
+		auto full = QPixmap();
 		if (_full <= 0 && _photo->loaded()) {
 			int32 h = int((_photo->full->height() * (qreal(w) / qreal(_photo->full->width()))) + 0.9999);
-			_current = _photo->full->pixNoCache(w, h, Images::Option::Smooth);
+			full = _prefetcher->take(_photo, QSize(w, h));
+			if (full.isNull()) {
+				// A forgotten image is decoded in the background, keep
+				// showing the medium one until it is ready.
+				auto forgotten = _photo->full->forgotten();
+				full = _photo->full->pixNoCache(w, h, Images::Option::Smooth);
+				if (forgotten) {
+					full = QPixmap();
+				}
+			}
+		}
+		if (!full.isNull()) {
+			_current = full;
 			if (cRetina()) _current.setDevicePixelRatio(cRetinaFactor());
 			_full = 1;
 		} else if (_full < 0 && _photo->medium->loaded()) {
@@ -2181,6 +2241,8 @@ bool MediaView::moveToNext(int32 delta) {
 }
 
 void MediaView::preloadData(int32 delta) {
+	_prefetcher->setDirection(delta);
+
 	int indexInOverview = _index;
 	bool indexOfMigratedItem = _msgmigrated;
 	if (_index < 0) {
@@ -2233,14 +2295,20 @@ void MediaView::preloadData(int32 delta) {
 			if (previewIndex >= 0 && previewIndex < previewHistory->overview[_overview].size() && (previewHistory != (indexOfMigratedItem ? _migrated : _history) || previewIndex != indexInOverview)) {
 				if (HistoryItem *item = App::histItemById(previewHistory->channelId(), previewHistory->overview[_overview][previewIndex])) {
 					if (HistoryMedia *media = item->getMedia()) {
+						auto distance = qAbs(i - indexInOverview);
 						switch (media->type()) {
-						case MediaTypePhoto: static_cast<HistoryPhoto*>(media)->photo()->download(); break;
+						case MediaTypePhoto: {
+							auto photo = static_cast<HistoryPhoto*>(media)->photo();
+							photo->download();
+							_prefetcher->schedule(photo, photoScreenFitSize(photo), distance);
+						} break;
 						case MediaTypeFile:
 						case MediaTypeVideo:
 						case MediaTypeGif: {
 							DocumentData *doc = media->getDocument();
 							doc->thumb->load();
 							doc->automaticLoad(item);
+							_prefetcher->schedule(doc, videoPlaceholderSize(doc), distance);
 						} break;
 						case MediaTypeSticker: media->getDocument()->sticker()->img->load(); break;
 						}
@@ -2256,7 +2324,9 @@ void MediaView::preloadData(int32 delta) {
 		}
 		for (int32 i = from; i <= to; ++i) {
 			if (i >= 0 && i < _user->photos.size() && i != indexInOverview) {
-				_user->photos[i]->download();
+				auto photo = _user->photos[i];
+				photo->download();
+				_prefetcher->schedule(photo, photoScreenFitSize(photo), qAbs(i - indexInOverview));
 			}
 		}
 		int32 forgetIndex = indexInOverview - delta * 2;
@@ -2541,6 +2611,10 @@ void MediaView::contextMenuEvent(QContextMenuEvent *e) {
 	}
 }
 
+void MediaView::hideEvent(QHideEvent *e) {
+	_prefetcher->clear();
+}
+
 void MediaView::touchEvent(QTouchEvent *e) {
 	switch (e->type()) {
 	case QEvent::TouchBegin:
@@ -30,6 +30,9 @@ struct TrackState;
 namespace Clip {
 class Controller;
 } // namespace Clip
+namespace View {
+class Prefetcher;
+} // namespace View
 } // namespace Media
 
 namespace Ui {
@@ -102,6 +105,7 @@ protected:
 	void mouseMoveEvent(QMouseEvent *e) override;
 	void mouseReleaseEvent(QMouseEvent *e) override;
 	void contextMenuEvent(QContextMenuEvent *e) override;
+	void hideEvent(QHideEvent *e) override;
 	void touchEvent(QTouchEvent *e);
 
 	bool event(QEvent *e) override;
@@ -180,6 +184,11 @@ private:
 
 	void initAnimation();
 	void createClipReader();
+	QPixmap videoPlaceholder() const;
+
+	// Sizes in which the prefetcher prepares the neighbour photos and video thumbnails.
+	QSize photoScreenFitSize(PhotoData *photo) const;
+	QSize videoPlaceholderSize(DocumentData *document) const;
 
 	void initThemePreview();
 	void destroyThemePreview();
@@ -371,4 +380,6 @@ private:
 	object_ptr<Ui::RoundButton> _themeApply = { nullptr };
 	object_ptr<Ui::RoundButton> _themeCancel = { nullptr };
 
+	std_::unique_ptr<Media::View::Prefetcher> _prefetcher;
+
 };
@@ -34,8 +34,11 @@ public:
 
 	void setKey(const void *from) {
 		memcpy(_key, from, 256);
-		uchar sha1Buffer[20];
-		_keyId = *(uint64*)(hashSha1(_key, 256, sha1Buffer) + 3);
+		uchar sha1Buffer[base::hash::Sha1::kSize];
+		base::hash::Sha1 sha1;
+		sha1.feed(_key, 256);
+		sha1.finish(sha1Buffer);
+		_keyId = *(uint64*)(sha1Buffer + 12);
 		_isset = true;
 	}
 
@@ -58,26 +61,31 @@ public:
 
 		uint32 x = send ? 0 : 8;
 
-		uchar data_a[16 + 32], sha1_a[20];
-		memcpy(data_a, &msgKey, 16);
-		memcpy(data_a + 16, _key + x, 32);
-		hashSha1(data_a, 16 + 32, sha1_a);
-
-		uchar data_b[16 + 16 + 16], sha1_b[20];
-		memcpy(data_b, _key + 32 + x, 16);
-		memcpy(data_b + 16, &msgKey, 16);
-		memcpy(data_b + 32, _key + 48 + x, 16);
-		hashSha1(data_b, 16 + 16 + 16, sha1_b);
-
-		uchar data_c[32 + 16], sha1_c[20];
-		memcpy(data_c, _key + 64 + x, 32);
-		memcpy(data_c + 32, &msgKey, 16);
-		hashSha1(data_c, 32 + 16, sha1_c);
-
-		uchar data_d[16 + 32], sha1_d[20];
-		memcpy(data_d, &msgKey, 16);
-		memcpy(data_d + 16, _key + 96 + x, 32);
-		hashSha1(data_d, 16 + 32, sha1_d);
+		// The key parts are fed to the hashes without copying them together.
+		uchar sha1_a[20];
+		base::hash::Sha1 a;
+		a.feed(&msgKey, 16);
+		a.feed(_key + x, 32);
+		a.finish(sha1_a);
+
+		uchar sha1_b[20];
+		base::hash::Sha1 b;
+		b.feed(_key + 32 + x, 16);
+		b.feed(&msgKey, 16);
+		b.feed(_key + 48 + x, 16);
+		b.finish(sha1_b);
+
+		uchar sha1_c[20];
+		base::hash::Sha1 c;
+		c.feed(_key + 64 + x, 32);
+		c.feed(&msgKey, 16);
+		c.finish(sha1_c);
+
+		uchar sha1_d[20];
+		base::hash::Sha1 d;
+		d.feed(&msgKey, 16);
+		d.feed(_key + 96 + x, 32);
+		d.finish(sha1_d);
 
 		uchar *key((uchar*)&aesKey), *iv((uchar*)&aesIV);
 		memcpy(key, sha1_a, 8);
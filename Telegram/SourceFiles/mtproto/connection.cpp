@@ -28,10 +28,11 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include <openssl/sha.h>
 #include <openssl/md5.h>
 #include <openssl/rand.h>
-#include "zlib.h"
 #include "lang.h"
 
 #include "mtproto/rsa_public_key.h"
+#include "mtproto/connection_pool.h"
+#include "mtproto/traffic_recorder.h"
 
 using std::string;
 
@@ -410,6 +411,24 @@ void ConnectionPrivate::createConn(bool createIPv4, bool createIPv6) {
 	oldConnectionTimer.start(MTPConnectionOldTimeout);
 }
 
+void ConnectionPrivate::countConnected(AbstractConnection *conn, bool ipv6) {
+	auto http = (conn->transport() == qstr("HTTP"));
+	auto latency = getms(true) - _connectingSince;
+	transportConnected(http ? (ipv6 ? Transport::HttpIPv6 : Transport::HttpIPv4) : (ipv6 ? Transport::TcpIPv6 : Transport::TcpIPv4), latency);
+	if (http && conn->tcpRaceLost()) {
+		transportFailed(ipv6 ? Transport::TcpIPv6 : Transport::TcpIPv4);
+	}
+}
+
+void ConnectionPrivate::countConnectFailed(bool ipv6) {
+	if (Global::ConnectionType() != dbictHttpProxy) {
+		transportFailed(ipv6 ? Transport::TcpIPv6 : Transport::TcpIPv4);
+	}
+	if (Global::ConnectionType() != dbictTcpProxy) {
+		transportFailed(ipv6 ? Transport::HttpIPv6 : Transport::HttpIPv4);
+	}
+}
+
 void ConnectionPrivate::destroyConn(AbstractConnection **conn) {
 	if (conn) {
 		AbstractConnection *toDisconnect = nullptr;
@@ -879,10 +898,15 @@ void ConnectionPrivate::tryToSend() {
 	bool needAnyResponse = false;
 	mtpRequest toSendRequest;
 	{
-		QWriteLocker locker1(sessionData->toSendMutex());
-
-		mtpPreRequestMap toSendDummy, &toSend(prependOnly ? toSendDummy : sessionData->toSendMap());
-		if (prependOnly) locker1.unlock();
+		// The whole queue is taken at once, so the session thread can add new
+		// requests while these are being serialized. Acks and resends for them
+		// are handled in this thread, after they are moved to haveSent.
+		auto toSend = mtpPreRequestMap();
+		if (!prependOnly) {
+			MeasuredWriteLocker locker1(sessionData->toSendMutex(), sessionData->lockContention());
+			toSend = base::take(sessionData->toSendMap());
+			sessionData->sendingTakenRequests() = !toSend.isEmpty();
+		}
 
 		uint32 toSendCount = toSend.size();
 		if (pingRequest) ++toSendCount;
@@ -896,10 +920,6 @@ void ConnectionPrivate::tryToSend() {
 		mtpRequest first = pingRequest ? pingRequest : (ackRequest ? ackRequest : (resendRequest ? resendRequest : (stateRequest ? stateRequest : (httpWaitRequest ? httpWaitRequest : toSend.cbegin().value()))));
 		if (toSendCount == 1 && first->msDate > 0) { // if can send without container
 			toSendRequest = first;
-			if (!prependOnly) {
-				toSend.clear();
-				locker1.unlock();
-			}
 
 			mtpMsgId msgId = prepareToSend(toSendRequest, msgid());
 			if (pingRequest) {
@@ -913,7 +933,7 @@ void ConnectionPrivate::tryToSend() {
 				if (mtpRequestData::needAck(toSendRequest)) {
 					toSendRequest->msDate = mtpRequestData::isStateRequest(toSendRequest) ? 0 : getms(true);
 
-					QWriteLocker locker2(sessionData->haveSentMutex());
+					MeasuredWriteLocker locker2(sessionData->haveSentMutex(), sessionData->lockContention());
 					mtpRequestMap &haveSent(sessionData->haveSentMap());
 					haveSent.insert(msgId, toSendRequest);
 
@@ -940,7 +960,7 @@ void ConnectionPrivate::tryToSend() {
 
 					needAnyResponse = true;
 				} else {
-					QWriteLocker locker3(sessionData->wereAckedMutex());
+					MeasuredWriteLocker locker3(sessionData->wereAckedMutex(), sessionData->lockContention());
 					sessionData->wereAckedMap().insert(msgId, toSendRequest->requestId);
 				}
 			}
@@ -972,10 +992,10 @@ void ConnectionPrivate::tryToSend() {
 
 			mtpMsgId bigMsgId = msgid(); // check for a valid container
 
-			QWriteLocker locker2(sessionData->haveSentMutex()); // the fact of this lock is used in replaceMsgId()
+			MeasuredWriteLocker locker2(sessionData->haveSentMutex(), sessionData->lockContention()); // the fact of this lock is used in replaceMsgId()
 			mtpRequestMap &haveSent(sessionData->haveSentMap());
 
-			QWriteLocker locker3(sessionData->wereAckedMutex()); // the fact of this lock is used in replaceMsgId()
+			MeasuredWriteLocker locker3(sessionData->wereAckedMutex(), sessionData->lockContention()); // the fact of this lock is used in replaceMsgId()
 			mtpRequestIdsMap &wereAcked(sessionData->wereAckedMap());
 
 			mtpRequest haveSentIdsWrap(mtpRequestData::prepare(idsWrapSize)); // prepare "request-like" wrap for msgId vector
@@ -1041,13 +1061,36 @@ void ConnectionPrivate::tryToSend() {
 			*(mtpMsgId*)(haveSentIdsWrap->data() + 4) = contMsgId;
 			(*haveSentIdsWrap)[6] = 0; // for container, msDate = 0, seqNo = 0
 			haveSent.insert(contMsgId, haveSentIdsWrap);
-			toSend.clear();
+		}
+		if (!toSend.isEmpty()) {
+			removeCancelledWhileSending(toSend);
 		}
 	}
 	mtpRequestData::padding(toSendRequest);
 	sendRequest(toSendRequest, needAnyResponse, lockFinished);
 }
 
+void ConnectionPrivate::removeCancelledWhileSending(const mtpPreRequestMap &sent) {
+	auto cancelled = QVector<mtpRequestId>();
+	{
+		MeasuredWriteLocker locker(sessionData->toSendMutex(), sessionData->lockContention());
+		sessionData->sendingTakenRequests() = false;
+		cancelled = base::take(sessionData->cancelledWhileSending());
+	}
+	if (cancelled.isEmpty()) return;
+
+	// The cancelled requests still go out, but they are not resent and
+	// their results are skipped, the same as for the cancelled sent ones.
+	MeasuredWriteLocker locker(sessionData->haveSentMutex(), sessionData->lockContention());
+	auto &haveSent = sessionData->haveSentMap();
+	for (auto requestId : cancelled) {
+		auto i = sent.constFind(requestId);
+		if (i != sent.cend()) {
+			haveSent.remove(*(mtpMsgId*)(i.value()->constData() + 4));
+		}
+	}
+}
+
 void ConnectionPrivate::retryByTimer() {
 	QReadLocker lockFinished(&sessionDataMutex);
 	if (!sessionData) return;
@@ -1146,6 +1189,17 @@ void ConnectionPrivate::socketStart(bool afterConfig) {
 			}
 		}
 	}
+#ifdef _DEBUG
+	if (!cMtpReplayHost().isEmpty()) {
+		// The replay server stands in for all the dcs, it accepts only TCP over IPv4.
+		for (auto protocol : { TcpProtocol, HttpProtocol }) {
+			ip[IPv4address][protocol] = cMtpReplayHost().toStdString();
+			port[IPv4address][protocol] = cMtpReplayPort();
+			flags[IPv4address][protocol] = 0;
+			port[IPv6address][protocol] = 0;
+		}
+	}
+#endif // _DEBUG
 	bool noIPv4 = !port[IPv4address][HttpProtocol], noIPv6 = (!Global::TryIPv6() || !port[IPv6address][HttpProtocol]);
 	if (noIPv4 && noIPv6) {
 		if (afterConfig) {
@@ -1162,7 +1216,17 @@ void ConnectionPrivate::socketStart(bool afterConfig) {
 
 	if (afterConfig && (_conn4 || _conn6)) return;
 
+	if (!noIPv4 && !noIPv6) {
+		auto healthyIPv4 = transportHealthy(Transport::TcpIPv4) || transportHealthy(Transport::HttpIPv4);
+		auto healthyIPv6 = transportHealthy(Transport::TcpIPv6) || transportHealthy(Transport::HttpIPv6);
+		if (healthyIPv4 != healthyIPv6) {
+			DEBUG_LOG(("MTP Info: IPv%1 keeps failing, connecting only through IPv%2 for a while.").arg(healthyIPv4 ? 6 : 4).arg(healthyIPv4 ? 4 : 6));
+			(healthyIPv4 ? noIPv6 : noIPv4) = true;
+		}
+	}
+
 	createConn(!noIPv4, !noIPv6);
+	_connectingSince = getms(true);
 	retryTimer.stop();
 	_waitForConnectedTimer.stop();
 
@@ -1236,9 +1300,9 @@ void ConnectionPrivate::onSentSome(uint64 size) {
 			}
 		}
 		if (isUplDcId(dc)) {
-			remain *= MTPUploadSessionsCount;
+			remain *= poolSessionsCount(PoolPurpose::Upload, bareDcId(dc));
 		} else if (isDldDcId(dc)) {
-			remain *= MTPDownloadSessionsCount;
+			remain *= poolSessionsCount(PoolPurpose::Download, bareDcId(dc));
 		}
 		_waitForReceivedTimer.start(remain);
 	}
@@ -1307,6 +1371,8 @@ void ConnectionPrivate::onWaitReceivedFailed() {
 
 void ConnectionPrivate::onWaitConnectedFailed() {
 	DEBUG_LOG(("MTP Info: can't connect in %1ms").arg(_waitForConnected));
+	if (_conn4) countConnectFailed(false);
+	if (_conn6) countConnectFailed(true);
 	if (_waitForConnected < MTPMaxConnectDelay) _waitForConnected *= 2;
 
 	doDisconnect();
@@ -1317,6 +1383,11 @@ void ConnectionPrivate::onWaitConnectedFailed() {
 }
 
 void ConnectionPrivate::onWaitIPv4Failed() {
+	if (_conn4) countConnectFailed(false);
+	useIPv6Connection();
+}
+
+void ConnectionPrivate::useIPv6Connection() {
 	_conn = _conn6;
 	destroyConn(&_conn4);
 
@@ -1437,6 +1508,10 @@ void ConnectionPrivate::handleReceived() {
 
 		_conn->received().pop_front();
 
+		if (recordingTraffic()) {
+			recordReceived(dc, key, data + 4, data + 8 + (msgLen >> 2));
+		}
+
 		int32 serverTime((int32)(msgId >> 32)), clientTime(unixtime());
 		bool isReply = ((msgId & 0x03) == 1);
 		if (!isReply && ((msgId & 0x03) != 3)) {
@@ -2060,50 +2135,14 @@ ConnectionPrivate::HandleResult ConnectionPrivate::handleOneReceived(const mtpPr
 	return HandleResult::Success;
 }
 
-mtpBuffer ConnectionPrivate::ungzip(const mtpPrime *from, const mtpPrime *end) const {
-	MTPstring packed(from, end); // read packed string as serialized mtp string type
-	uint32 packedLen = packed.c_string().v.size(), unpackedChunk = packedLen, unpackedLen = 0;
-
-	mtpBuffer result; // * 4 because of mtpPrime type
-	result.resize(0);
-	z_stream stream;
-	stream.zalloc = 0;
-	stream.zfree = 0;
-	stream.opaque = 0;
-	stream.avail_in = 0;
-	stream.next_in = 0;
-	int res = inflateInit2(&stream, 16 + MAX_WBITS);
-	if (res != Z_OK) {
-		LOG(("RPC Error: could not init zlib stream, code: %1").arg(res));
-		return result;
-	}
-	stream.avail_in = packedLen;
-	stream.next_in = (Bytef*)&packed._string().v[0];
-
-	stream.avail_out = 0;
-	while (!stream.avail_out) {
-		result.resize(result.size() + unpackedChunk);
-		stream.avail_out = unpackedChunk * sizeof(mtpPrime);
-		stream.next_out = (Bytef*)&result[result.size() - unpackedChunk];
-		int res = inflate(&stream, Z_NO_FLUSH);
-		if (res != Z_OK && res != Z_STREAM_END) {
-			inflateEnd(&stream);
-			LOG(("RPC Error: could not unpack gziped data, code: %1").arg(res));
-			DEBUG_LOG(("RPC Error: bad gzip: %1").arg(Logs::mb(&packed.c_string().v[0], packedLen).str()));
-			return mtpBuffer();
-		}
-	}
-	if (stream.avail_out & 0x03) {
-		uint32 badSize = result.size() * sizeof(mtpPrime) - stream.avail_out;
-		LOG(("RPC Error: bad length of unpacked data %1").arg(badSize));
-		DEBUG_LOG(("RPC Error: bad unpacked data %1").arg(Logs::mb(result.data(), badSize).str()));
+mtpBuffer ConnectionPrivate::ungzip(const mtpPrime *from, const mtpPrime *end) {
+	auto result = mtpBuffer();
+	auto packed = from;
+	if (!_inflater.unpack(from, end, result)) {
+		LOG(("RPC Error: %1").arg(_inflater.error()));
+		DEBUG_LOG(("RPC Error: bad gzip: %1").arg(Logs::mb(packed, (end - packed) * sizeof(mtpPrime)).str()));
 		return mtpBuffer();
 	}
-	result.resize(result.size() - (stream.avail_out >> 2));
-	inflateEnd(&stream);
-	if (!result.size()) {
-		LOG(("RPC Error: bad length of unpacked data 0"));
-	}
 	return result;
 }
 
@@ -2125,14 +2164,49 @@ void ConnectionPrivate::requestsAcked(const QVector<MTPlong> &ids, bool byRespon
 
 	DEBUG_LOG(("Message Info: requests acked, ids %1").arg(Logs::vector(ids)));
 
+	// hasCallbacks() waits for the parser map lock that the main thread holds
+	// while handling responses, so it is checked before the write locks are taken.
+	auto waitingResponse = QMap<mtpRequestId, bool>();
+	if (!byResponse) {
+		auto requestIds = QVector<mtpRequestId>();
+		requestIds.reserve(idsCount);
+		{
+			QReadLocker locker(sessionData->haveSentMutex());
+			const mtpRequestMap &haveSent(sessionData->haveSentMap());
+			for (uint32 i = 0; i < idsCount; ++i) {
+				auto req = haveSent.constFind(ids[i].v);
+				if (req != haveSent.cend() && req.value()->msDate) {
+					requestIds.push_back(req.value()->requestId);
+				}
+			}
+		}
+		{
+			QReadLocker locker(sessionData->toResendMutex());
+			const mtpRequestIdsMap &toResend(sessionData->toResendMap());
+			for (uint32 i = 0; i < idsCount; ++i) {
+				auto reqIt = toResend.constFind(ids[i].v);
+				if (reqIt != toResend.cend()) {
+					requestIds.push_back(reqIt.value());
+				}
+			}
+		}
+		for_const (auto requestId, requestIds) {
+			waitingResponse.insert(requestId, hasCallbacks(requestId));
+		}
+	}
+	auto needsResponse = [&waitingResponse](mtpRequestId requestId) {
+		auto i = waitingResponse.constFind(requestId);
+		return (i != waitingResponse.cend()) ? i.value() : hasCallbacks(requestId);
+	};
+
 	RPCCallbackClears clearedAcked;
 	QVector<MTPlong> toAckMore;
 	{
-		QWriteLocker locker1(sessionData->wereAckedMutex());
+		MeasuredWriteLocker locker1(sessionData->wereAckedMutex(), sessionData->lockContention());
 		mtpRequestIdsMap &wereAcked(sessionData->wereAckedMap());
 
 		{
-			QWriteLocker locker2(sessionData->haveSentMutex());
+			MeasuredWriteLocker locker2(sessionData->haveSentMutex(), sessionData->lockContention());
 			mtpRequestMap &haveSent(sessionData->haveSentMap());
 
 			for (uint32 i = 0; i < idsCount; ++i) {
@@ -2152,7 +2226,7 @@ void ConnectionPrivate::requestsAcked(const QVector<MTPlong> &ids, bool byRespon
 						mtpRequestId reqId = req.value()->requestId;
 						bool moveToAcked = byResponse;
 						if (!moveToAcked) { // ignore ACK, if we need a response (if we have a handler)
-							moveToAcked = !hasCallbacks(reqId);
+							moveToAcked = !needsResponse(reqId);
 						}
 						if (moveToAcked) {
 							wereAcked.insert(msgId, reqId);
@@ -2163,17 +2237,17 @@ void ConnectionPrivate::requestsAcked(const QVector<MTPlong> &ids, bool byRespon
 					}
 				} else {
 					DEBUG_LOG(("Message Info: msgId %1 was not found in recent sent, while acking requests, searching in resend...").arg(msgId));
-					QWriteLocker locker3(sessionData->toResendMutex());
+					MeasuredWriteLocker locker3(sessionData->toResendMutex(), sessionData->lockContention());
 					mtpRequestIdsMap &toResend(sessionData->toResendMap());
 					mtpRequestIdsMap::iterator reqIt = toResend.find(msgId);
 					if (reqIt != toResend.cend()) {
 						mtpRequestId reqId = reqIt.value();
 						bool moveToAcked = byResponse;
 						if (!moveToAcked) { // ignore ACK, if we need a response (if we have a handler)
-							moveToAcked = !hasCallbacks(reqId);
+							moveToAcked = !needsResponse(reqId);
 						}
 						if (moveToAcked) {
-							QWriteLocker locker4(sessionData->toSendMutex());
+							MeasuredWriteLocker locker4(sessionData->toSendMutex(), sessionData->lockContention());
 							mtpPreRequestMap &toSend(sessionData->toSendMap());
 							mtpPreRequestMap::iterator req = toSend.find(reqId);
 							if (req != toSend.cend()) {
@@ -2297,6 +2371,7 @@ void ConnectionPrivate::onConnected4() {
 
 	_conn = _conn4;
 	destroyConn(&_conn6);
+	countConnected(_conn4, false);
 
 	DEBUG_LOG(("MTP Info: connection through IPv4 succeed."));
 
@@ -2318,6 +2393,13 @@ void ConnectionPrivate::onConnected6() {
 		lockFinished.unlock();
 		return restart();
 	}
+	countConnected(_conn6, true);
+
+	if (!_conn4 || !(transportHealthy(Transport::TcpIPv4) || transportHealthy(Transport::HttpIPv4))) {
+		// IPv4 was not waited for, so it is not counted as failed once again.
+		lockFinished.unlock();
+		return useIPv6Connection();
+	}
 
 	DEBUG_LOG(("MTP Info: connection through IPv6 succeed, waiting IPv4 for %1ms.").arg(MTPIPv4ConnectionWaitTimeout));
 
@@ -2326,6 +2408,7 @@ void ConnectionPrivate::onConnected6() {
 
 void ConnectionPrivate::onDisconnected4() {
 	if (_conn && _conn == _conn6) return; // disconnected the unused
+	if (!_conn) countConnectFailed(false);
 
 	if (_conn || !_conn6) {
 		destroyConn();
@@ -2337,6 +2420,7 @@ void ConnectionPrivate::onDisconnected4() {
 
 void ConnectionPrivate::onDisconnected6() {
 	if (_conn && _conn == _conn4) return; // disconnected the unused
+	if (!_conn) countConnectFailed(true);
 
 	if (_conn || !_conn4) {
 		destroyConn();
@@ -2840,6 +2924,7 @@ void ConnectionPrivate::clearAuthKeyData() {
 
 void ConnectionPrivate::onError4(bool mayBeBadKey) {
 	if (_conn && _conn == _conn6) return; // error in the unused
+	if (!_conn) countConnectFailed(false);
 
 	if (_conn || !_conn6) {
 		destroyConn();
@@ -2854,6 +2939,7 @@ void ConnectionPrivate::onError4(bool mayBeBadKey) {
 
 void ConnectionPrivate::onError6(bool mayBeBadKey) {
 	if (_conn && _conn == _conn4) return; // error in the unused
+	if (!_conn) countConnectFailed(true);
 
 	if (_conn || !_conn4) {
 		destroyConn();
@@ -2970,6 +3056,9 @@ bool ConnectionPrivate::sendRequest(mtpRequest &request, bool needAnyResponse, Q
 
 	const mtpPrime *from = request->constData() + 4;
 	MTP_LOG(dc, ("Send: ") + mtpTextSerialize(from, from + messageSize));
+	if (recordingTraffic()) {
+		recordSent(dc, key, from, from + messageSize);
+	}
 
 	uchar encryptedSHA[20];
 	MTPint128 &msgKey(*(MTPint128*)(encryptedSHA + 4));
@@ -23,6 +23,7 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include "mtproto/core_types.h"
 #include "mtproto/auth_key.h"
 #include "mtproto/connection_abstract.h"
+#include "mtproto/inflater.h"
 #include "core/single_timer.h"
 
 namespace MTP {
@@ -157,9 +158,15 @@ private:
 	void createConn(bool createIPv4, bool createIPv6);
 	void destroyConn(AbstractConnection **conn = 0); // 0 - destory all
 
+	// Transports health is counted for the connection race in socketStart().
+	void countConnected(AbstractConnection *conn, bool ipv6);
+	void countConnectFailed(bool ipv6);
+	void useIPv6Connection();
+
 	mtpMsgId placeToContainer(mtpRequest &toSendRequest, mtpMsgId &bigMsgId, mtpMsgId *&haveSentArr, mtpRequest &req);
 	mtpMsgId prepareToSend(mtpRequest &request, mtpMsgId currentLastId);
 	mtpMsgId replaceMsgId(mtpRequest &request, mtpMsgId newId);
+	void removeCancelledWhileSending(const mtpPreRequestMap &sent);
 
 	bool sendRequest(mtpRequest &request, bool needAnyResponse, QReadLocker &lockFinished);
 	mtpRequestId wasSent(mtpMsgId msgId) const;
@@ -171,7 +178,7 @@ private:
 		ResetSession,
 	};
 	HandleResult handleOneReceived(const mtpPrime *from, const mtpPrime *end, uint64 msgId, int32 serverTime, uint64 serverSalt, bool badTime);
-	mtpBuffer ungzip(const mtpPrime *from, const mtpPrime *end) const;
+	mtpBuffer ungzip(const mtpPrime *from, const mtpPrime *end);
 	void handleMsgsStates(const QVector<MTPlong> &ids, const std::string &states, QVector<MTPlong> &acked);
 
 	void clearMessages();
@@ -199,9 +206,13 @@ private:
 	SingleTimer _waitForConnectedTimer, _waitForReceivedTimer, _waitForIPv4Timer;
 	uint32 _waitForReceived, _waitForConnected;
 	TimeMs firstSentAt = -1;
+	TimeMs _connectingSince = 0;
 
 	QVector<MTPlong> ackRequestData, resendRequestData;
 
+	// Lives in the connection thread together with this object.
+	Inflater _inflater;
+
 	// if badTime received - search for ids in sessionData->haveSent and sessionData->wereAcked and sync time/salt, return true if found
 	bool requestsFixTimeSalt(const QVector<MTPlong> &ids, int32 serverTime, uint64 serverSalt);
 
@@ -56,6 +56,11 @@ public:
 		return false;
 	}
 
+	// HTTP was chosen after TCP failed or did not connect in its full timeout.
+	virtual bool tcpRaceLost() const {
+		return false;
+	}
+
 	virtual int32 debugState() const = 0;
 
 	virtual QString transport() const = 0;
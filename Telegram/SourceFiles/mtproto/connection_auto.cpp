@@ -23,6 +23,7 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include "mtproto/connection_auto.h"
 
 #include "mtproto/connection_http.h"
+#include "mtproto/connection_pool.h"
 
 namespace MTP {
 namespace internal {
@@ -216,7 +217,11 @@ void AutoConnection::requestFinished(QNetworkReply *reply) {
 					if (res_pq_data.vnonce == httpNonce) {
 						if (status == WaitingBoth) {
 							status = HttpReady;
-							httpStartTimer.start(MTPTcpConnectionWaitTimeout);
+
+							// Don't wait for TCP if it keeps failing through this address family.
+							auto tcp = (_flagsHttp & MTPDdcOption::Flag::f_ipv6) ? Transport::TcpIPv6 : Transport::TcpIPv4;
+							_tcpWaitSkipped = !transportHealthy(tcp);
+							httpStartTimer.start(_tcpWaitSkipped ? 0 : MTPTcpConnectionWaitTimeout);
 						} else {
 							DEBUG_LOG(("Connection Info: HTTP/%1-transport chosen by pq-response, awaited").arg((_flagsHttp & MTPDdcOption::Flag::f_ipv6) ? "IPv6" : "IPv4"));
 							status = UsingHttp;
@@ -309,6 +314,11 @@ bool AutoConnection::needHttpWait() {
 	return (status == UsingHttp) ? requests.isEmpty() : false;
 }
 
+bool AutoConnection::tcpRaceLost() const {
+	// If the TCP wait was skipped TCP got no chance to fail once again.
+	return (status == UsingHttp) && !_tcpWaitSkipped;
+}
+
 int32 AutoConnection::debugState() const {
 	return (status == UsingHttp) ? -1 : (UsingTcp ? sock.state() : -777);
 }
@@ -40,6 +40,7 @@ public:
 	bool isConnected() const override;
 	bool usingHttpWait() override;
 	bool needHttpWait() override;
+	bool tcpRaceLost() const override;
 
 	int32 debugState() const override;
 
@@ -75,6 +76,7 @@ private:
 	Status status;
 	MTPint128 tcpNonce, httpNonce;
 	QTimer httpStartTimer;
+	bool _tcpWaitSkipped = false;
 
 	QNetworkAccessManager manager;
 	QUrl address;
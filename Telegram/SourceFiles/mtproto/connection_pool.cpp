@@ -0,0 +1,199 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#include "stdafx.h"
+#include "mtproto/connection_pool.h"
+
+namespace MTP {
+namespace {
+
+constexpr auto kMeasureWindow = 2000; // Throughput is measured in 2 second windows.
+constexpr auto kMeasurePause = 1000; // A window with a longer pause is not measured.
+constexpr auto kRequiredGrowthPercent = 10;
+constexpr auto kProbeAgainTimeout = 30000;
+constexpr auto kUnhealthyAfterFailures = 3;
+constexpr auto kRetryUnhealthyTimeout = 60000;
+constexpr auto kLogTransportsEach = 20;
+constexpr auto kTransportsCount = 4;
+
+struct PoolState {
+	int count = 0;
+	int64 bytes = 0;
+	TimeMs windowStart = 0;
+	TimeMs transferredAt = 0;
+	int64 previousThroughput = 0; // Bytes per second before the last session was added.
+	TimeMs stableTill = 0;
+
+	int64 bestThroughput = 0;
+	int grown = 0;
+	int shrunk = 0;
+};
+
+struct TransportState {
+	int connected = 0;
+	int failed = 0;
+	int failedInRow = 0;
+	TimeMs latency = 0; // Smoothed time to connect.
+	TimeMs failedAt = 0;
+};
+
+QMutex PoolMutex;
+QMap<DcId, PoolState> Pools[2];
+TransportState Transports[kTransportsCount];
+int TransportEvents = 0;
+
+int purposeIndex(PoolPurpose purpose) {
+	return (purpose == PoolPurpose::Download) ? 0 : 1;
+}
+
+QString purposeName(PoolPurpose purpose) {
+	return (purpose == PoolPurpose::Download) ? qsl("download") : qsl("upload");
+}
+
+int sessionsLimit(PoolPurpose purpose) {
+	return (purpose == PoolPurpose::Download) ? cDownloadSessionsLimit() : cUploadSessionsLimit();
+}
+
+int sessionsDefault(PoolPurpose purpose) {
+	auto result = (purpose == PoolPurpose::Download) ? int(MTPDownloadSessionsCount) : int(MTPUploadSessionsCount);
+	return qMin(result, sessionsLimit(purpose));
+}
+
+PoolState &poolState(PoolPurpose purpose, DcId dcId) {
+	auto &pools = Pools[purposeIndex(purpose)];
+	auto i = pools.find(dcId);
+	if (i == pools.end()) {
+		i = pools.insert(dcId, PoolState());
+		i->count = sessionsDefault(purpose);
+	}
+	return i.value();
+}
+
+QString poolDescription(PoolPurpose purpose, DcId dcId, const PoolState &pool) {
+	return qsl("%1 pool for dc %2: %3 sessions, best %4 kb/s, grown %5 times, shrunk %6 times").arg(purposeName(purpose)).arg(dcId).arg(pool.count).arg(pool.bestThroughput / 1024).arg(pool.grown).arg(pool.shrunk);
+}
+
+QString transportName(int index) {
+	switch (static_cast<internal::Transport>(index)) {
+	case internal::Transport::TcpIPv4: return qsl("TCP/IPv4");
+	case internal::Transport::TcpIPv6: return qsl("TCP/IPv6");
+	case internal::Transport::HttpIPv4: return qsl("HTTP/IPv4");
+	case internal::Transport::HttpIPv6: return qsl("HTTP/IPv6");
+	}
+	return QString();
+}
+
+QString transportsDescription() {
+	auto result = QStringList();
+	for (auto i = 0; i != kTransportsCount; ++i) {
+		auto &transport = Transports[i];
+		if (!transport.connected && !transport.failed) continue;
+		result.push_back(qsl("%1 connected %2, failed %3 (%4 in a row), connect %5 ms").arg(transportName(i)).arg(transport.connected).arg(transport.failed).arg(transport.failedInRow).arg(transport.latency));
+	}
+	return result.join(qsl("; "));
+}
+
+void countTransportEvent() {
+	if (!(++TransportEvents % kLogTransportsEach)) {
+		DEBUG_LOG(("MTP Info: transports %1").arg(transportsDescription()));
+	}
+}
+
+} // namespace
+
+int poolSessionsCount(PoolPurpose purpose, DcId dcId) {
+	QMutexLocker lock(&PoolMutex);
+	return poolState(purpose, dcId).count;
+}
+
+void poolTransferred(PoolPurpose purpose, DcId dcId, int64 bytes) {
+	auto ms = getms(true);
+
+	QMutexLocker lock(&PoolMutex);
+	auto &pool = poolState(purpose, dcId);
+	if (!pool.windowStart || ms - pool.transferredAt > kMeasurePause) {
+		pool.windowStart = ms;
+		pool.bytes = 0;
+	}
+	pool.transferredAt = ms;
+	pool.bytes += bytes;
+	if (ms - pool.windowStart < kMeasureWindow) {
+		return;
+	}
+
+	auto throughput = pool.bytes * 1000 / (ms - pool.windowStart);
+	pool.windowStart = ms;
+	pool.bytes = 0;
+	accumulate_max(pool.bestThroughput, throughput);
+
+	auto previous = base::take(pool.previousThroughput);
+	if (previous && throughput * 100 < previous * (100 + kRequiredGrowthPercent)) {
+		--pool.count;
+		++pool.shrunk;
+		pool.stableTill = ms + kProbeAgainTimeout;
+		DEBUG_LOG(("MTP Info: %1 pool for dc %2 shrunk to %3 sessions, %4 kb/s with one more session, %5 kb/s without").arg(purposeName(purpose)).arg(dcId).arg(pool.count).arg(throughput / 1024).arg(previous / 1024));
+	} else if (pool.stableTill <= ms && pool.count < sessionsLimit(purpose)) {
+		pool.previousThroughput = throughput;
+		++pool.count;
+		++pool.grown;
+		DEBUG_LOG(("MTP Info: %1 pool for dc %2 grown to %3 sessions, %4 kb/s before").arg(purposeName(purpose)).arg(dcId).arg(pool.count).arg(throughput / 1024));
+	}
+}
+
+void poolSessionsKilled(PoolPurpose purpose, DcId dcId) {
+	QMutexLocker lock(&PoolMutex);
+	auto &pools = Pools[purposeIndex(purpose)];
+	auto i = pools.find(dcId);
+	if (i != pools.end()) {
+		if (i->grown) {
+			DEBUG_LOG(("MTP Info: %1").arg(poolDescription(purpose, dcId, i.value())));
+		}
+		pools.erase(i);
+	}
+}
+
+namespace internal {
+
+void transportConnected(Transport transport, TimeMs latency) {
+	QMutexLocker lock(&PoolMutex);
+	auto &state = Transports[static_cast<int>(transport)];
+	state.latency = state.connected ? (state.latency * 3 + latency) / 4 : latency;
+	++state.connected;
+	state.failedInRow = 0;
+	countTransportEvent();
+}
+
+void transportFailed(Transport transport) {
+	QMutexLocker lock(&PoolMutex);
+	auto &state = Transports[static_cast<int>(transport)];
+	++state.failed;
+	++state.failedInRow;
+	state.failedAt = getms(true);
+	countTransportEvent();
+}
+
+bool transportHealthy(Transport transport) {
+	QMutexLocker lock(&PoolMutex);
+	auto &state = Transports[static_cast<int>(transport)];
+	return (state.failedInRow < kUnhealthyAfterFailures) || (getms(true) - state.failedAt >= kRetryUnhealthyTimeout);
+}
+
+} // namespace internal
+} // namespace MTP
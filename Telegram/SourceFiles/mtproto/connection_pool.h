@@ -0,0 +1,63 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#pragma once
+
+#include "mtproto/core_types.h"
+
+namespace MTP {
+
+enum class PoolPurpose {
+	Download,
+	Upload,
+};
+
+// Count of the file sessions to use for the dc right now, it starts with
+// MTPDownloadSessionsCount / MTPUploadSessionsCount and never exceeds the
+// limit passed in -downloadsessions / -uploadsessions command line args.
+// Uploading is always done to the main dc, so dcId is 0 for uploads.
+int poolSessionsCount(PoolPurpose purpose, DcId dcId);
+
+// Each measure window the pool adds a session while the throughput keeps
+// growing with it and removes the last added one if it did not help.
+void poolTransferred(PoolPurpose purpose, DcId dcId, int64 bytes);
+
+// The idle file sessions were killed, the next transfer starts measuring
+// from the default sessions count again.
+void poolSessionsKilled(PoolPurpose purpose, DcId dcId);
+
+namespace internal {
+
+enum class Transport {
+	TcpIPv4,
+	TcpIPv6,
+	HttpIPv4,
+	HttpIPv6,
+};
+
+// The transports health is shared by all connections: a transport that
+// failed to connect several times in a row is not waited for in the
+// connection race for a while, after that it is raced again.
+void transportConnected(Transport transport, TimeMs latency);
+void transportFailed(Transport transport);
+bool transportHealthy(Transport transport);
+
+} // namespace internal
+} // namespace MTP
@@ -99,7 +99,7 @@ constexpr ShiftedDcId lgtDcId(DcId dcId) {
 namespace internal {
 
 constexpr ShiftedDcId downloadDcId(DcId dcId, int index) {
-	static_assert(MTPDownloadSessionsCount < 0x10, "Too large MTPDownloadSessionsCount!");
+	static_assert(MTPDownloadSessionsMax < 0x10, "Too large MTPDownloadSessionsMax!");
 	return shiftDcId(dcId, 0x10 + index);
 };
 
@@ -107,18 +107,18 @@ constexpr ShiftedDcId downloadDcId(DcId dcId, int index) {
 
 // send(req, callbacks, MTP::dldDcId(dc, index)) - for download shifted dc id
 inline ShiftedDcId dldDcId(DcId dcId, int index) {
-	t_assert(index >= 0 && index < MTPDownloadSessionsCount);
+	t_assert(index >= 0 && index < MTPDownloadSessionsMax);
 	return internal::downloadDcId(dcId, index);
 }
 
 constexpr bool isDldDcId(ShiftedDcId shiftedDcId) {
-	return (shiftedDcId >= internal::downloadDcId(0, 0)) && (shiftedDcId < internal::downloadDcId(0, MTPDownloadSessionsCount - 1) + DCShift);
+	return (shiftedDcId >= internal::downloadDcId(0, 0)) && (shiftedDcId < internal::downloadDcId(0, MTPDownloadSessionsMax - 1) + DCShift);
 }
 
 namespace internal {
 
 constexpr ShiftedDcId uploadDcId(DcId dcId, int index) {
-	static_assert(MTPUploadSessionsCount < 0x10, "Too large MTPUploadSessionsCount!");
+	static_assert(MTPUploadSessionsMax < 0x10, "Too large MTPUploadSessionsMax!");
 	return shiftDcId(dcId, 0x20 + index);
 };
 
@@ -127,12 +127,12 @@ constexpr ShiftedDcId uploadDcId(DcId dcId, int index) {
 // send(req, callbacks, MTP::uplDcId(index)) - for upload shifted dc id
 // uploading always to the main dc so bareDcId == 0
 inline ShiftedDcId uplDcId(int index) {
-	t_assert(index >= 0 && index < MTPUploadSessionsCount);
+	t_assert(index >= 0 && index < MTPUploadSessionsMax);
 	return internal::uploadDcId(0, index);
 };
 
 constexpr bool isUplDcId(ShiftedDcId shiftedDcId) {
-	return (shiftedDcId >= internal::uploadDcId(0, 0)) && (shiftedDcId < internal::uploadDcId(0, MTPUploadSessionsCount - 1) + DCShift);
+	return (shiftedDcId >= internal::uploadDcId(0, 0)) && (shiftedDcId < internal::uploadDcId(0, MTPUploadSessionsMax - 1) + DCShift);
 }
 
 void start();
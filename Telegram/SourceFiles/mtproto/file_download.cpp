@@ -27,6 +27,7 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 
 #include "application.h"
 #include "localstorage.h"
+#include "mtproto/connection_pool.h"
 
 namespace {
 	int32 GlobalPriority = 1;
@@ -34,7 +35,7 @@ namespace {
 		DataRequested() {
 			memset(v, 0, sizeof(v));
 		}
-		int64 v[MTPDownloadSessionsCount];
+		int64 v[MTPDownloadSessionsMax];
 	};
 	QMap<int32, DataRequested> DataRequestedMap;
 }
@@ -60,6 +61,83 @@ namespace {
 	WebLoadMainManager *_webLoadMainManager = 0;
 }
 
+FileLoadStreaming::FileLoadStreaming(const QString &fileName, int32 size, int32 partSize)
+: _fileName(fileName)
+, _size(size)
+, _partSize(partSize)
+, _loaded((size + partSize - 1) / partSize, false) {
+}
+
+void FileLoadStreaming::partLoaded(int32 offset) {
+	QMutexLocker lock(&_mutex);
+	auto index = offset / _partSize;
+	if (index >= 0 && index < _loaded.size() && !_loaded[index]) {
+		_loaded[index] = true;
+		++_loadedCount;
+	}
+	_condition.wakeAll();
+}
+
+bool FileLoadStreaming::partLoadedAt(int32 offset) const {
+	QMutexLocker lock(&_mutex);
+	auto index = offset / _partSize;
+	return (index >= 0 && index < _loaded.size()) ? _loaded[index] : true;
+}
+
+bool FileLoadStreaming::loadedAll() const {
+	QMutexLocker lock(&_mutex);
+	return (_loadedCount == _loaded.size());
+}
+
+int32 FileLoadStreaming::takePriorityOffset() {
+	QMutexLocker lock(&_mutex);
+	auto result = _priorityOffset;
+	_priorityOffset = -1;
+	return result;
+}
+
+void FileLoadStreaming::fail() {
+	QMutexLocker lock(&_mutex);
+	_failed = true;
+	_condition.wakeAll();
+}
+
+int64 FileLoadStreaming::availableAt(int64 offset, int64 length) const {
+	auto till = qMin(offset + length, int64(_size));
+	auto from = offset;
+	while (from < till) {
+		auto index = int32(from / _partSize);
+		if (!_loaded[index]) {
+			break;
+		}
+		from = int64(index + 1) * _partSize;
+	}
+	return qMin(from, till) - offset;
+}
+
+int64 FileLoadStreaming::waitForData(int64 offset, int64 length, uint64 readerId) {
+	QMutexLocker lock(&_mutex);
+	if (offset < 0 || length <= 0 || offset >= _size) {
+		return 0;
+	}
+	while (!_interrupted.contains(readerId)) {
+		if (auto result = availableAt(offset, length)) {
+			return result;
+		} else if (_failed) {
+			break;
+		}
+		_priorityOffset = int32(offset - (offset % _partSize));
+		_condition.wait(&_mutex);
+	}
+	return -1;
+}
+
+void FileLoadStreaming::interrupt(uint64 readerId) {
+	QMutexLocker lock(&_mutex);
+	_interrupted.insert(readerId);
+	_condition.wakeAll();
+}
+
 FileLoader::FileLoader(const QString &toFile, int32 size, LocationType locationType, LoadToCacheSetting toCache, LoadFromCloudSetting fromCloud, bool autoLoading)
 : _autoLoading(autoLoading)
 , _file(toFile)
@@ -392,7 +470,14 @@ bool mtpFileLoader::loadPart() {
 		if (DebugLogging::FileLoader() && _id) DEBUG_LOG(("FileLoader(%1): loadPart() returned, _complete=%2, _lastComplete=%3, _requests.size()=%4, _size=%5").arg(_id).arg(Logs::b(_complete)).arg(Logs::b(_lastComplete)).arg(_requests.size()).arg(_size));
 		return false;
 	}
-	if (_size && _nextRequestOffset >= _size) {
+	auto offset = _nextRequestOffset;
+	if (_streaming) {
+		offset = nextStreamingOffset();
+		if (offset < 0) {
+			if (DebugLogging::FileLoader() && _id) DEBUG_LOG(("FileLoader(%1): loadPart() returned, all streaming parts requested, _requests=%2").arg(_id).arg(serializereqs(_requests)));
+			return false;
+		}
+	} else if (_size && _nextRequestOffset >= _size) {
 		if (DebugLogging::FileLoader() && _id) DEBUG_LOG(("FileLoader(%1): loadPart() returned, _size=%2, _nextRequestOffset=%3, _requests=%4").arg(_id).arg(_size).arg(_nextRequestOffset).arg(serializereqs(_requests)));
 		return false;
 	}
@@ -410,10 +495,10 @@ bool mtpFileLoader::loadPart() {
 		default: cancel(true); return false; break;
 		}
 	}
-	int32 offset = _nextRequestOffset, dcIndex = 0;
+	int32 dcIndex = 0;
 	DataRequested &dr(DataRequestedMap[_dc]);
 	if (_size) {
-		for (int32 i = 1; i < MTPDownloadSessionsCount; ++i) {
+		for (int32 i = 1, count = MTP::poolSessionsCount(MTP::PoolPurpose::Download, _dc); i < count; ++i) {
 			if (dr.v[i] < dr.v[dcIndex]) {
 				dcIndex = i;
 			}
@@ -427,7 +512,8 @@ bool mtpFileLoader::loadPart() {
 	++_queue->queries;
 	dr.v[dcIndex] += limit;
 	_requests.insert(reqId, dcIndex);
-	_nextRequestOffset += limit;
+	_requestedOffsets.insert(offset);
+	accumulate_max(_nextRequestOffset, offset + limit);
 
 	if (DebugLogging::FileLoader() && _id) DEBUG_LOG(("FileLoader(%1): requested part with offset=%2, _queue->queries=%3, _nextRequestOffset=%4, _requests=%5").arg(_id).arg(offset).arg(_queue->queries).arg(_nextRequestOffset).arg(serializereqs(_requests)));
 
@@ -451,9 +537,11 @@ void mtpFileLoader::partLoaded(int32 offset, const MTPupload_File &result, mtpRe
 
 	--_queue->queries;
 	_requests.erase(i);
+	_requestedOffsets.remove(offset);
 
 	auto &d = result.c_upload_file();
 	auto &bytes = d.vbytes.c_string().v;
+	MTP::poolTransferred(MTP::PoolPurpose::Download, _dc, bytes.size());
 
 	if (DebugLogging::FileLoader() && _id) DEBUG_LOG(("FileLoader(%1): got part with offset=%2, bytes=%3, _queue->queries=%4, _nextRequestOffset=%5, _requests=%6").arg(_id).arg(offset).arg(bytes.size()).arg(_queue->queries).arg(_nextRequestOffset).arg(serializereqs(_requests)));
 
@@ -469,6 +557,9 @@ void mtpFileLoader::partLoaded(int32 offset, const MTPupload_File &result, mtpRe
 			if (_file.write(bytes.data(), bytes.size()) != qint64(bytes.size())) {
 				return cancel(true);
 			}
+			if (_streaming) {
+				_file.flush();
+			}
 		} else {
 			_data.reserve(offset + bytes.size());
 			if (offset > _data.size()) {
@@ -486,10 +577,13 @@ void mtpFileLoader::partLoaded(int32 offset, const MTPupload_File &result, mtpRe
 			}
 		}
 	}
-	if (!bytes.size() || (bytes.size() % 1024)) { // bad next offset
+	if (_streaming) {
+		_streaming->partLoaded(offset);
+	} else if (!bytes.size() || (bytes.size() % 1024)) { // bad next offset
 		_lastComplete = true;
 	}
-	if (_requests.isEmpty() && (_lastComplete || (_size && _nextRequestOffset >= _size))) {
+	auto allRequested = _streaming ? _streaming->loadedAll() : (_lastComplete || (_size && _nextRequestOffset >= _size));
+	if (_requests.isEmpty() && allRequested) {
 		if (!_fname.isEmpty() && (_toCache == LoadToCacheAsWell)) {
 			if (!_fileIsOpen) _fileIsOpen = _file.open(QIODevice::WriteOnly);
 			if (!_fileIsOpen) {
@@ -546,7 +640,63 @@ bool mtpFileLoader::partFailed(const RPCError &error) {
 	return true;
 }
 
+int32 mtpFileLoader::partSize() const {
+	return _location ? DownloadPartSize : DocumentDownloadPartSize;
+}
+
+int32 mtpFileLoader::nextStreamingOffset() {
+	auto size = partSize();
+	auto priorityOffset = _streaming->takePriorityOffset();
+	if (priorityOffset >= 0) {
+		_streamingOffset = priorityOffset;
+	}
+
+	// Continue from the part the reader needs and wrap around to the skipped ones.
+	for (auto i = 0, count = (_size + size - 1) / size; i != count; ++i) {
+		auto offset = _streamingOffset;
+		_streamingOffset += size;
+		if (_streamingOffset >= _size) {
+			_streamingOffset = 0;
+		}
+		if (!_requestedOffsets.contains(offset) && !_streaming->partLoadedAt(offset)) {
+			return offset;
+		}
+	}
+	return -1;
+}
+
+FileLoadStreamingPtr mtpFileLoader::streaming() {
+	if (!_streaming && !_fileIsOpen && !_fname.isEmpty() && _toCache == LoadToFileOnly && !_complete) {
+		// The file is opened in start(), but the loader could be created
+		// earlier, so the parts that are in memory are written to it here.
+		_fileIsOpen = _file.open(QIODevice::WriteOnly);
+		if (_fileIsOpen && _file.write(_data) != qint64(_data.size())) {
+			cancel(true);
+			return FileLoadStreamingPtr();
+		}
+		_data = QByteArray();
+	}
+	if (!_streaming && _fileIsOpen && _size > 0 && !_location && !_complete) {
+		auto size = partSize();
+		_file.flush();
+		_streaming = MakeShared<FileLoadStreaming>(_fname, _size, size);
+
+		// Everything before _nextRequestOffset that is not in flight is written already.
+		for (auto offset = 0; offset < _nextRequestOffset && offset < _size; offset += size) {
+			if (!_requestedOffsets.contains(offset)) {
+				_streaming->partLoaded(offset);
+			}
+		}
+		_streamingOffset = (_nextRequestOffset < _size) ? _nextRequestOffset : 0;
+	}
+	return _streaming;
+}
+
 void mtpFileLoader::cancelRequests() {
+	if (_streaming && !_streaming->loadedAll()) {
+		_streaming->fail();
+	}
+	_requestedOffsets.clear();
 	if (_requests.isEmpty()) return;
 
 	int32 limit = (_locationType == UnknownFileLocation) ? DownloadPartSize : DocumentDownloadPartSize;
@@ -105,6 +105,55 @@ enum LoadToCacheSetting {
 	LoadToCacheAsWell,
 };
 
+// Shared between a document loader and the clip readers that play
+// the file while it is still being downloaded. The loader marks parts
+// as written and the readers block in waitForData() until the part
+// they need is on disk, asking the loader to fetch it next.
+class FileLoadStreaming {
+public:
+	FileLoadStreaming(const QString &fileName, int32 size, int32 partSize);
+
+	QString fileName() const {
+		return _fileName;
+	}
+	int32 size() const {
+		return _size;
+	}
+	int32 partSize() const {
+		return _partSize;
+	}
+
+	// Called by the loader from the main thread.
+	void partLoaded(int32 offset);
+	bool partLoadedAt(int32 offset) const;
+	bool loadedAll() const;
+	int32 takePriorityOffset();
+	void fail();
+
+	// Called by the readers from their threads. Returns the count of bytes
+	// available at the offset (up to the length), zero at the end of file and
+	// -1 if the download has failed or the reader was interrupted.
+	int64 waitForData(int64 offset, int64 length, uint64 readerId);
+	void interrupt(uint64 readerId);
+
+private:
+	int64 availableAt(int64 offset, int64 length) const;
+
+	QString _fileName;
+	int32 _size;
+	int32 _partSize;
+
+	mutable QMutex _mutex;
+	QWaitCondition _condition;
+	QVector<bool> _loaded;
+	int32 _loadedCount = 0;
+	int32 _priorityOffset = -1;
+	bool _failed = false;
+	QSet<uint64> _interrupted;
+
+};
+using FileLoadStreamingPtr = QSharedPointer<FileLoadStreaming>;
+
 class mtpFileLoader;
 class webFileLoader;
 
@@ -247,6 +296,11 @@ public:
 		rpcClear();
 	}
 
+	// Switches the loader to streaming mode, where parts are requested
+	// in the order the readers need them. Returns null if the file
+	// is not loaded directly to disk or its size is not known.
+	FileLoadStreamingPtr streaming();
+
 	~mtpFileLoader();
 
 protected:
@@ -259,11 +313,17 @@ protected:
 	virtual bool loadPart();
 	void partLoaded(int32 offset, const MTPupload_File &result, mtpRequestId req);
 	bool partFailed(const RPCError &error);
+	int32 partSize() const;
+	int32 nextStreamingOffset();
 
 	bool _lastComplete = false;
 	int32 _skippedBytes = 0;
 	int32 _nextRequestOffset = 0;
 
+	FileLoadStreamingPtr _streaming;
+	QSet<int32> _requestedOffsets;
+	int32 _streamingOffset = 0;
+
 	int32 _dc;
 	const StorageImageLocation *_location = nullptr;
 
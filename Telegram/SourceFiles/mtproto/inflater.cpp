@@ -0,0 +1,154 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#include "stdafx.h"
+#include "mtproto/inflater.h"
+
+#include "zlib.h"
+
+namespace MTP {
+namespace internal {
+namespace {
+
+// Deflate can't compress better than that, so a larger size
+// in the gzip trailer is not trusted for the preallocation.
+constexpr auto kMaxCompressionRatio = 1032U;
+
+// Reads the packed bytes in place, the same way MTPstring::read() does.
+bool ReadPacked(const mtpPrime *&from, const mtpPrime *end, const uchar *&data, uint32 &length) {
+	if (from + 1 > end) return false;
+
+	auto buffer = reinterpret_cast<const uchar*>(from);
+	auto skip = uint32(0);
+	if (buffer[0] == 254) {
+		length = uint32(buffer[1]) + (uint32(buffer[2]) << 8) + (uint32(buffer[3]) << 16);
+		data = buffer + 4;
+		skip = length + 4;
+	} else {
+		length = uint32(buffer[0]);
+		data = buffer + 1;
+		skip = length + 1;
+	}
+	auto next = from + (skip >> 2) + ((skip & 0x03) ? 1 : 0);
+	if (next > end) return false;
+
+	from = next;
+	return true;
+}
+
+// The last four bytes of a gzip member hold the unpacked size modulo 2^32.
+uint32 ExpectedPrimes(const uchar *data, uint32 length) {
+	if (length < 18) return 0;
+
+	auto trailer = data + length - 4;
+	auto size = uint32(trailer[0]) | (uint32(trailer[1]) << 8) | (uint32(trailer[2]) << 16) | (uint32(trailer[3]) << 24);
+	if (!size || (size & 0x03) || size / kMaxCompressionRatio > length) {
+		return 0;
+	}
+	return size / sizeof(mtpPrime);
+}
+
+} // namespace
+
+Inflater::Inflater() : _stream(std_::make_unique<z_stream_s>()) {
+	_stream->zalloc = nullptr;
+	_stream->zfree = nullptr;
+	_stream->opaque = nullptr;
+	_stream->avail_in = 0;
+	_stream->next_in = nullptr;
+}
+
+bool Inflater::prepare() {
+	if (_initialized) {
+		auto res = inflateReset(_stream.get());
+		if (res == Z_OK) {
+			return true;
+		}
+		inflateEnd(_stream.get());
+		_initialized = false;
+	}
+	auto res = inflateInit2(_stream.get(), 16 + MAX_WBITS);
+	if (res != Z_OK) {
+		return fail(QString("could not init zlib stream, code: %1").arg(res));
+	}
+	_initialized = true;
+	return true;
+}
+
+bool Inflater::fail(const QString &error) {
+	_error = error;
+	return false;
+}
+
+bool Inflater::unpack(const mtpPrime *&from, const mtpPrime *end, mtpBuffer &result) {
+	result.resize(0);
+
+	auto packed = static_cast<const uchar*>(nullptr);
+	auto packedLength = uint32(0);
+	if (!ReadPacked(from, end, packed, packedLength)) {
+		return fail(QString("bad packed data length"));
+	}
+	if (!prepare()) {
+		return false;
+	}
+	_stream->avail_in = packedLength;
+	_stream->next_in = const_cast<Bytef*>(packed);
+
+	// With a trusted size from the trailer the result is allocated once,
+	// otherwise it grows by the packed length chunks, as it did before.
+	auto chunk = qMax(packedLength, 1U);
+	auto expected = ExpectedPrimes(packed, packedLength);
+	result.resize(expected ? expected : chunk);
+
+	auto filled = uint32(0); // in bytes
+	while (true) {
+		auto capacity = uint32(result.size() * sizeof(mtpPrime));
+		_stream->next_out = reinterpret_cast<Bytef*>(result.data()) + filled;
+		_stream->avail_out = capacity - filled;
+		auto res = inflate(_stream.get(), Z_NO_FLUSH);
+		filled = capacity - _stream->avail_out;
+		if (res != Z_OK && res != Z_STREAM_END) {
+			result.resize(0);
+			return fail(QString("could not unpack gziped data, code: %1").arg(res));
+		}
+		if (res == Z_STREAM_END || _stream->avail_out) {
+			break;
+		}
+		result.resize(result.size() + chunk);
+	}
+	if (filled & 0x03) {
+		result.resize(0);
+		return fail(QString("bad length of unpacked data %1").arg(filled));
+	}
+	result.resize(filled / sizeof(mtpPrime));
+	if (result.isEmpty()) {
+		return fail(QString("bad length of unpacked data 0"));
+	}
+	return true;
+}
+
+Inflater::~Inflater() {
+	if (_initialized) {
+		inflateEnd(_stream.get());
+	}
+}
+
+} // namespace internal
+} // namespace MTP
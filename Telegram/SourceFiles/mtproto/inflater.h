@@ -0,0 +1,57 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#pragma once
+
+#include "mtproto/core_types.h"
+
+struct z_stream_s;
+
+namespace MTP {
+namespace internal {
+
+// Unpacks the gzip_packed objects, the zlib stream is allocated once
+// and reset for each object, so one instance is kept per thread.
+class Inflater final {
+public:
+	Inflater();
+
+	// from points right after the gzip_packed constructor id and is moved
+	// past the packed string, like in MTPstring::read(), but nothing is copied.
+	// Returns false and leaves the description in error() if the data is bad.
+	bool unpack(const mtpPrime *&from, const mtpPrime *end, mtpBuffer &result);
+	const QString &error() const {
+		return _error;
+	}
+
+	~Inflater();
+
+private:
+	bool prepare();
+	bool fail(const QString &error);
+
+	std_::unique_ptr<z_stream_s> _stream;
+	bool _initialized = false;
+	QString _error;
+
+};
+
+} // namespace internal
+} // namespace MTP
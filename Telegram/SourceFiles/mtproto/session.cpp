@@ -24,6 +24,11 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 
 namespace MTP {
 namespace internal {
+namespace {
+
+constexpr auto kLogLockStatisticsEach = 60; // checkRequestsByTimer() calls
+
+} // namespace
 
 void SessionData::clear() {
 	RPCCallbackClears clearCallbacks;
@@ -238,6 +243,14 @@ void Session::sendMsgsStateInfo(quint64 msgId, QByteArray data) {
 }
 
 void Session::checkRequestsByTimer() {
+	if (++_lockStatisticsTicks >= kLogLockStatisticsEach) {
+		_lockStatisticsTicks = 0;
+		auto acquired = 0, contended = 0, waitedUs = 0;
+		if (data.lockContention().take(acquired, contended, waitedUs) && contended) {
+			DEBUG_LOG(("MTP Info: dc %1 session locks contended %2 of %3 times, waited %4 us").arg(dcWithShift).arg(contended).arg(acquired).arg(waitedUs));
+		}
+	}
+
 	QVector<mtpMsgId> resendingIds;
 	QVector<mtpMsgId> removingIds; // remove very old (10 minutes) containers and resend requests
 	QVector<mtpMsgId> stateRequestIds;
@@ -313,7 +326,9 @@ void Session::onResetDone() {
 void Session::cancel(mtpRequestId requestId, mtpMsgId msgId) {
 	if (requestId) {
 		QWriteLocker locker(data.toSendMutex());
-		data.toSendMap().remove(requestId);
+		if (!data.toSendMap().remove(requestId) && data.sendingTakenRequests()) {
+			data.cancelledWhileSending().push_back(requestId);
+		}
 	}
 	if (msgId) {
 		QWriteLocker locker(data.haveSentMutex());
@@ -349,7 +364,7 @@ int32 Session::requestState(mtpRequestId requestId) const {
 	}
 	if (!requestId) return MTP::RequestSent;
 
-	QWriteLocker locker(data.toSendMutex());
+	QReadLocker locker(data.toSendMutex());
 	const mtpPreRequestMap &toSend(data.toSendMap());
 	mtpPreRequestMap::const_iterator i = toSend.constFind(requestId);
 	if (i != toSend.cend()) {
@@ -449,7 +464,7 @@ void Session::resendAll() {
 
 void Session::sendPrepared(const mtpRequest &request, TimeMs msCanWait, bool newRequest) { // returns true, if emit of needToSend() is needed
 	{
-		QWriteLocker locker(data.toSendMutex());
+		MeasuredWriteLocker locker(data.toSendMutex(), data.lockContention());
 		data.toSendMap().insert(request->requestId, request);
 
 		if (newRequest) {
@@ -82,6 +82,63 @@ private:
 
 };
 
+// Counts how often the SessionData locks in the send and ack paths had
+// to be waited for, both the session and the connection threads use them.
+class LockContention {
+public:
+	void acquired(bool contended, int64 waitedUs) {
+		_acquired.fetchAndAddRelaxed(1);
+		if (contended) {
+			_contended.fetchAndAddRelaxed(1);
+			_waitedUs.fetchAndAddRelaxed(int(qMin(waitedUs, int64(INT_MAX))));
+		}
+	}
+
+	// Returns false if there were no acquisitions since the last call.
+	bool take(int &acquired, int &contended, int &waitedUs) {
+		acquired = _acquired.fetchAndStoreRelaxed(0);
+		contended = _contended.fetchAndStoreRelaxed(0);
+		waitedUs = _waitedUs.fetchAndStoreRelaxed(0);
+		return (acquired > 0);
+	}
+
+private:
+	QAtomicInt _acquired = 0;
+	QAtomicInt _contended = 0;
+	QAtomicInt _waitedUs = 0;
+
+};
+
+// QWriteLocker that reports the waiting to LockContention.
+class MeasuredWriteLocker {
+public:
+	MeasuredWriteLocker(QReadWriteLock *lock, LockContention &contention) : _lock(lock) {
+		if (_lock->tryLockForWrite()) {
+			contention.acquired(false, 0);
+		} else {
+			QElapsedTimer timer;
+			timer.start();
+			_lock->lockForWrite();
+			contention.acquired(true, timer.nsecsElapsed() / 1000);
+		}
+	}
+	MeasuredWriteLocker(const MeasuredWriteLocker &other) = delete;
+	MeasuredWriteLocker &operator=(const MeasuredWriteLocker &other) = delete;
+
+	void unlock() {
+		if (_lock) {
+			base::take(_lock)->unlock();
+		}
+	}
+	~MeasuredWriteLocker() {
+		unlock();
+	}
+
+private:
+	QReadWriteLock *_lock;
+
+};
+
 class Session;
 class SessionData {
 public:
@@ -213,6 +270,16 @@ public:
 		return stateRequest;
 	}
 
+	// Both must be locked by toSendMutex(). While the connection serializes
+	// the requests taken from toSend they are in neither toSend nor haveSent,
+	// so the requests cancelled in that time are removed after it.
+	bool &sendingTakenRequests() {
+		return _sendingTakenRequests;
+	}
+	QVector<mtpRequestId> &cancelledWhileSending() {
+		return _cancelledWhileSending;
+	}
+
 	mtpRequestId nextFakeRequestId() { // must be locked by haveReceivedMutex()
 		if (haveReceived.isEmpty() || haveReceived.cbegin().key() > 0) {
 			_fakeRequestId = -2000000000;
@@ -229,6 +296,10 @@ public:
 		return _owner;
 	}
 
+	LockContention &lockContention() const {
+		return _lockContention;
+	}
+
 	uint32 nextRequestSeqNumber(bool needAck = true) {
 		QWriteLocker locker(&lock);
 		uint32 result(_messagesSent);
@@ -258,6 +329,8 @@ private:
 	mtpRequestIdsMap wereAcked; // map of msg_id -> request_id, this msg_ids already were acked or do not need ack
 	mtpResponseMap haveReceived; // map of request_id -> response, that should be processed in other thread
 	mtpMsgIdsSet stateRequest; // set of msg_id's, whose state should be requested
+	bool _sendingTakenRequests = false;
+	QVector<mtpRequestId> _cancelledWhileSending;
 
 	// mutexes
 	mutable QReadWriteLock lock;
@@ -268,6 +341,7 @@ private:
 	mutable QReadWriteLock wereAckedLock;
 	mutable QReadWriteLock haveReceivedLock;
 	mutable QReadWriteLock stateRequestLock;
+	mutable LockContention _lockContention;
 
 };
 
@@ -347,6 +421,7 @@ private:
 
 	QTimer timeouter;
 	SingleTimer sender;
+	int _lockStatisticsTicks = 0;
 
 };
 
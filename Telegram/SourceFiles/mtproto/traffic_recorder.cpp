@@ -0,0 +1,108 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#include "stdafx.h"
+#include "mtproto/traffic_recorder.h"
+
+namespace MTP {
+namespace internal {
+namespace {
+
+struct Recorder {
+	QFile file;
+	QDataStream stream;
+	TimeMs started = 0;
+	QMap<ShiftedDcId, uint64> writtenKeys;
+	bool failed = false;
+};
+
+QMutex RecorderMutex;
+
+Recorder *recorder() {
+	static Recorder data;
+	if (data.failed) {
+		return nullptr;
+	} else if (!data.file.isOpen()) {
+		data.file.setFileName(cMtpRecordPath());
+		if (!data.file.open(QIODevice::WriteOnly)) {
+			LOG(("MTP Error: could not open '%1' to record the traffic.").arg(cMtpRecordPath()));
+			data.failed = true;
+			return nullptr;
+		}
+		// Nothing is written until no one but the owner can read the file.
+		if (!data.file.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner)) {
+			LOG(("MTP Error: could not restrict the permissions of '%1' to record the traffic.").arg(cMtpRecordPath()));
+			data.file.close();
+			data.file.remove();
+			data.failed = true;
+			return nullptr;
+		}
+		data.stream.setDevice(&data.file);
+		data.stream.setVersion(QDataStream::Qt_5_1);
+		data.stream << Capture::kSignature << Capture::kVersion;
+		data.started = getms(true);
+		LOG(("MTP Info: recording the traffic to '%1'.").arg(cMtpRecordPath()));
+	}
+	return &data;
+}
+
+void writeRecord(Recorder *data, Capture::Record type, ShiftedDcId dc, const QByteArray &bytes) {
+	data->stream << qint32(type) << qint32(dc) << qint64(getms(true) - data->started) << bytes;
+}
+
+void record(Capture::Record type, ShiftedDcId dc, const AuthKeyPtr &key, const mtpPrime *from, const mtpPrime *end) {
+	QMutexLocker lock(&RecorderMutex);
+	auto data = recorder();
+	if (!data) return;
+
+	if (data->writtenKeys.value(dc) != key->keyId()) {
+		data->writtenKeys.insert(dc, key->keyId());
+
+		auto bytes = QByteArray();
+		{
+			QDataStream keyStream(&bytes, QIODevice::WriteOnly);
+			key->write(keyStream);
+		}
+		writeRecord(data, Capture::Record::Key, dc, bytes);
+	}
+	writeRecord(data, type, dc, QByteArray(reinterpret_cast<const char*>(from), (end - from) * sizeof(mtpPrime)));
+	data->file.flush();
+}
+
+} // namespace
+
+bool recordingTraffic() {
+#ifdef _DEBUG
+	return !cMtpRecordPath().isEmpty();
+#else // _DEBUG
+	return false;
+#endif // _DEBUG
+}
+
+void recordSent(ShiftedDcId dc, const AuthKeyPtr &key, const mtpPrime *from, const mtpPrime *end) {
+	record(Capture::Record::Sent, dc, key, from, end);
+}
+
+void recordReceived(ShiftedDcId dc, const AuthKeyPtr &key, const mtpPrime *from, const mtpPrime *end) {
+	record(Capture::Record::Received, dc, key, from, end);
+}
+
+} // namespace internal
+} // namespace MTP
@@ -0,0 +1,55 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#pragma once
+
+#include "mtproto/auth_key.h"
+
+namespace MTP {
+namespace internal {
+
+// The traffic capture written by debug builds with -mtprecord {path} and
+// replayed by the ReplayServer utility. After the signature and the version
+// each record is qint32 type, qint32 dc, qint64 time in ms from the recording
+// start and QByteArray data. A key record comes before the first message of the dc
+// encrypted with that key and holds its 256 bytes, a message record holds
+// the plaintext from msg_id to the end of the message body without padding.
+namespace Capture {
+
+constexpr auto kSignature = quint32(0x50414354);
+constexpr auto kVersion = qint32(1);
+
+enum class Record : qint32 {
+	Key,
+	Sent,
+	Received,
+};
+
+} // namespace Capture
+
+bool recordingTraffic();
+
+// Both are called with the decrypted message, the capture must never be
+// shared: it has the auth keys and the whole account traffic in it.
+void recordSent(ShiftedDcId dc, const AuthKeyPtr &key, const mtpPrime *from, const mtpPrime *end);
+void recordReceived(ShiftedDcId dc, const AuthKeyPtr &key, const mtpPrime *from, const mtpPrime *end);
+
+} // namespace internal
+} // namespace MTP
@@ -293,6 +293,12 @@ void Photo::invalidateCache() {
 	}
 }
 
+void Photo::prefetch() {
+	if (!_data->loaded()) {
+		_data->medium->automaticLoad(_parent);
+	}
+}
+
 Video::Video(DocumentData *video, HistoryItem *parent) : RadialProgressItem(parent)
 , _data(video)
 , _duration(formatDurationText(_data->duration()))
@@ -447,6 +453,10 @@ void Video::invalidateCache() {
 	}
 }
 
+void Video::prefetch() {
+	_data->thumb->load();
+}
+
 void Video::getState(ClickHandlerPtr &link, HistoryCursorState &cursor, int x, int y) const {
 	bool loaded = _data->loaded();
 
@@ -789,6 +799,7 @@ void Document::paint(Painter &p, const QRect &clip, TextSelection selection, con
 						_thumbForLoaded = loaded;
 						auto options = Images::Option::Smooth | Images::Option::None;
 						if (!_thumbForLoaded) options |= Images::Option::Blurred;
+						_data->thumb->restore();
 						_thumb = _data->thumb->pixNoCache(_thumbw * cIntRetinaFactor(), 0, options, _st.fileThumbSize, _st.fileThumbSize);
 					}
 					p.drawPixmap(rthumb.topLeft(), _thumb);
@@ -62,6 +62,10 @@ public:
 	virtual void invalidateCache() {
 	}
 
+	// Starts loading what paint() will need when the item is scrolled into view.
+	virtual void prefetch() {
+	}
+
 };
 
 class ItemBase : public AbstractItem {
@@ -190,6 +194,7 @@ public:
 	void clickHandlerPressedChanged(const ClickHandlerPtr &action, bool pressed) override;
 
 	void invalidateCache() override;
+	void prefetch() override;
 
 private:
 	void ensureCheckboxCreated();
@@ -217,6 +222,7 @@ public:
 	void clickHandlerPressedChanged(const ClickHandlerPtr &action, bool pressed) override;
 
 	void invalidateCache() override;
+	void prefetch() override;
 
 protected:
 	float64 dataProgress() const override {
@@ -180,10 +180,10 @@ void OverviewInner::fixItemIndex(int32 &current, MsgId msgId) const {
 		current = -1;
 	} else {
 		int32 l = _items.size();
-		if (current < 0 || current >= l || complexMsgId(_items.at(current)->getItem()) != msgId) {
+		if (current < 0 || current >= l || complexMsgIdAt(current) != msgId) {
 			current = -1;
 			for (int32 i = 0; i < l; ++i) {
-				if (complexMsgId(_items.at(i)->getItem()) == msgId) {
+				if (complexMsgIdAt(i) == msgId) {
 					current = i;
 					break;
 				}
@@ -192,6 +192,39 @@ void OverviewInner::fixItemIndex(int32 &current, MsgId msgId) const {
 	}
 }
 
+MsgId OverviewInner::complexMsgIdAt(int32 index) const {
+	if (isGrid()) {
+		return _gridIds.at(index);
+	}
+	return complexMsgId(_items.at(index)->getItem());
+}
+
+bool OverviewInner::gridItemValid(HistoryItem *item) const {
+	auto media = item ? item->getMedia() : nullptr;
+	if (!media) return false;
+	return (_type == OverviewPhotos) ? (media->type() == MediaTypePhoto) : (media->type() == MediaTypeVideo);
+}
+
+Overview::Layout::ItemBase *OverviewInner::gridItem(int32 index) {
+	if (auto result = _items.at(index)) {
+		return static_cast<Overview::Layout::ItemBase*>(result);
+	}
+	auto msgId = _gridIds.at(index);
+	auto layout = layoutPrepare(App::histItemById(itemChannel(msgId), itemMsgId(msgId)));
+	if (!layout) return nullptr;
+
+	layout->resizeGetHeight(_rowWidth);
+	_items[index] = layout;
+	if (_gridLayoutsFrom >= _gridLayoutsTill) {
+		_gridLayoutsFrom = index;
+		_gridLayoutsTill = index + 1;
+	} else {
+		accumulate_min(_gridLayoutsFrom, index);
+		accumulate_max(_gridLayoutsTill, index + 1);
+	}
+	return layout;
+}
+
 void OverviewInner::searchReceived(SearchRequestType type, const MTPmessages_Messages &result, mtpRequestId req) {
 	if (!_search->text().isEmpty()) {
 		if (type == SearchFromStart) {
@@ -322,14 +355,14 @@ void OverviewInner::moveToNextItem(MsgId &msgId, int32 &index, MsgId upTo, int32
 	}
 
 	index += delta;
-	while (index >= 0 && index < _items.size() && !_items.at(index)->toMediaItem()) {
+	while (!isGrid() && index >= 0 && index < _items.size() && !_items.at(index)->toMediaItem()) {
 		index += (delta > 0) ? 1 : -1;
 	}
 	if (index < 0 || index >= _items.size()) {
 		msgId = 0;
 		index = -1;
 	} else {
-		msgId = complexMsgId(_items.at(index)->getItem());
+		msgId = complexMsgIdAt(index);
 	}
 }
 
@@ -649,7 +682,7 @@ void OverviewInner::touchScrollUpdated(const QPoint &screenPos) {
 void OverviewInner::addSelectionRange(int32 selFrom, int32 selTo, History *history) {
 	if (selFrom < 0 || selTo < 0) return;
 	for (int32 i = selFrom; i <= selTo; ++i) {
-		MsgId msgid = complexMsgId(_items.at(i)->getItem());
+		MsgId msgid = complexMsgIdAt(i);
 		if (!msgid) continue;
 
 		SelectedItems::iterator j = _selected.find(msgid);
@@ -720,6 +753,8 @@ void OverviewInner::clear() {
 	}
 	_layoutDates.clear();
 	_items.clear();
+	_gridIds.clear();
+	_gridLayoutsFrom = _gridLayoutsTill = 0;
 
 	App::clearMousedItems();
 }
@@ -761,6 +796,51 @@ void OverviewInner::preloadMore() {
 	}
 }
 
+void OverviewInner::prefetchGrid(int32 scrollTop, int32 scrollHeight) {
+	if (_type != OverviewPhotos && _type != OverviewVideos) return;
+
+	auto delta = scrollTop - _prefetchScrollTop;
+	_prefetchScrollTop = scrollTop;
+	if (!delta) return;
+
+	auto from = (delta > 0) ? (scrollTop + scrollHeight) : (scrollTop - scrollHeight);
+	auto till = from + scrollHeight;
+	int32 count = _items.size(), rowsCount = count / _photosInRow + ((count % _photosInRow) ? 1 : 0);
+	int32 rowFrom = floorclamp(from - _marginTop - st::overviewPhotoSkip, _rowWidth + st::overviewPhotoSkip, 0, rowsCount);
+	int32 rowTill = ceilclamp(till - _marginTop - st::overviewPhotoSkip, _rowWidth + st::overviewPhotoSkip, 0, rowsCount);
+	for (int32 i = rowFrom * _photosInRow, l = qMin(count, rowTill * _photosInRow); i < l; ++i) {
+		if (auto layout = gridItem(i)) {
+			layout->prefetch();
+		}
+	}
+}
+
+void OverviewInner::recycleGrid(int32 scrollTop, int32 scrollHeight) {
+	if (!isGrid() || _gridLayoutsFrom >= _gridLayoutsTill) return;
+
+	// Layouts are kept for two screens around the visible part,
+	// that covers the screen prepared ahead in prefetchGrid().
+	auto from = scrollTop - 2 * scrollHeight;
+	auto till = scrollTop + 3 * scrollHeight;
+	int32 count = _items.size(), rowsCount = count / _photosInRow + ((count % _photosInRow) ? 1 : 0);
+	int32 rowFrom = floorclamp(from - _marginTop - st::overviewPhotoSkip, _rowWidth + st::overviewPhotoSkip, 0, rowsCount);
+	int32 rowTill = ceilclamp(till - _marginTop - st::overviewPhotoSkip, _rowWidth + st::overviewPhotoSkip, 0, rowsCount);
+	int32 keepFrom = rowFrom * _photosInRow, keepTill = qMin(count, rowTill * _photosInRow);
+	for (int32 i = _gridLayoutsFrom, l = qMin(_gridLayoutsTill, count); i < l; ++i) {
+		if (i >= keepFrom && i < keepTill) {
+			i = keepTill - 1;
+			continue;
+		}
+		if (auto layout = _items.at(i)) {
+			_layoutItems.remove(layout->getItem());
+			delete layout;
+			_items[i] = nullptr;
+		}
+	}
+	_gridLayoutsFrom = qMax(_gridLayoutsFrom, keepFrom);
+	_gridLayoutsTill = qMin(_gridLayoutsTill, keepTill);
+}
+
 bool OverviewInner::preloadLocal() {
 	if (_itemsToBeLoaded >= migratedIndexSkip() + _history->overview[_type].size()) return false;
 	_itemsToBeLoaded += LinksOverviewPerPage;
@@ -774,11 +854,11 @@ TextSelection OverviewInner::itemSelectedValue(int32 index) const {
 		selfrom = _dragSelToIndex;
 		selto = _dragSelFromIndex;
 	}
-	if (_items.at(index)->toMediaItem()) { // draw item
+	if (isGrid() || _items.at(index)->toMediaItem()) { // draw item
 		if (index >= _dragSelToIndex && index <= _dragSelFromIndex && _dragSelToIndex >= 0) {
-			return (_dragSelecting && _items.at(index)->msgId() > 0) ? FullSelection : TextSelection{ 0, 0 };
+			return (_dragSelecting && itemMsgId(complexMsgIdAt(index)) > 0) ? FullSelection : TextSelection{ 0, 0 };
 		} else if (!_selected.isEmpty()) {
-			SelectedItems::const_iterator j = _selected.constFind(complexMsgId(_items.at(index)->getItem()));
+			SelectedItems::const_iterator j = _selected.constFind(complexMsgIdAt(index));
 			if (j != _selected.cend()) {
 				return j.value();
 			}
@@ -831,9 +911,12 @@ void OverviewInner::paintEvent(QPaintEvent *e) {
 				if (i < 0) continue;
 				if (i >= count) break;
 
+				auto layout = gridItem(i);
+				if (!layout) continue;
+
 				QPoint pos(int32(col * w + st::overviewPhotoSkip), _marginTop + row * (_rowWidth + st::overviewPhotoSkip) + st::overviewPhotoSkip);
 				p.translate(pos.x(), pos.y());
-				_items.at(i)->paint(p, r.translated(-pos.x(), -pos.y()), itemSelectedValue(i), &context);
+				layout->paint(p, r.translated(-pos.x(), -pos.y()), itemSelectedValue(i), &context);
 				p.translate(-pos.x(), -pos.y());
 			}
 		}
@@ -896,7 +979,7 @@ void OverviewInner::onUpdateSelected() {
 			upon = false;
 		}
 		if (i >= 0) {
-			if (auto media = _items.at(i)->toMediaItem()) {
+			if (auto media = gridItem(i)) {
 				item = media->getItem();
 				index = i;
 				if (upon) {
@@ -1322,8 +1405,10 @@ int32 OverviewInner::resizeToWidth(int32 nwidth, int32 scrollTop, int32 minHeigh
 	_cancelSearch->moveToLeft(_rowsLeft + _rowWidth - _cancelSearch->width(), _search->y());
 
 	if (_type == OverviewPhotos || _type == OverviewVideos) {
-		for (int32 i = 0, l = _items.size(); i < l; ++i) {
-			_items.at(i)->resizeGetHeight(_rowWidth);
+		for (int32 i = _gridLayoutsFrom, l = qMin(_gridLayoutsTill, _items.size()); i < l; ++i) {
+			if (auto layout = _items.at(i)) {
+				layout->resizeGetHeight(_rowWidth);
+			}
 		}
 		_height = countHeight();
 	} else {
@@ -1608,30 +1693,46 @@ void OverviewInner::mediaOverviewUpdated() {
 	if (_type == OverviewPhotos || _type == OverviewVideos) {
 		History::MediaOverview &o(_history->overview[_type]), *migratedOverview = _migrated ? &_migrated->overview[_type] : 0;
 		int32 migrateCount = migratedIndexSkip();
-		int32 wasCount = _items.size(), fullCount = (migrateCount + o.size());
+		int32 fullCount = (migrateCount + o.size());
 		int32 tocheck = qMin(fullCount, _itemsToBeLoaded);
+		_gridIds.reserve(tocheck);
 		_items.reserve(tocheck);
 
+		// Only the ids are collected here, layouts are created in gridItem().
 		int32 index = 0;
 		bool allGood = true;
 		for (int32 i = fullCount, l = fullCount - tocheck; i > l;) {
 			--i;
 			MsgId msgid = ((i < migrateCount) ? -migratedOverview->at(i) : o.at(i - migrateCount));
 			if (allGood) {
-				if (_items.size() > index && complexMsgId(_items.at(index)->getItem()) == msgid) {
+				if (_gridIds.size() > index && _gridIds.at(index) == msgid) {
 					++index;
 					continue;
 				}
 				allGood = false;
 			}
 			HistoryItem *item = App::histItemById(itemChannel(msgid), itemMsgId(msgid));
-			auto layout = layoutPrepare(item);
-			if (!layout) continue;
+			if (!gridItemValid(item)) continue;
 
-			setLayoutItem(index, layout, 0);
+			auto layout = _layoutItems.value(item, nullptr);
+			if (_gridIds.size() > index) {
+				_gridIds[index] = msgid;
+				_items[index] = layout;
+			} else {
+				_gridIds.push_back(msgid);
+				_items.push_back(layout);
+			}
 			++index;
 		}
-		if (_items.size() > index) _items.resize(index);
+		if (_gridIds.size() > index) {
+			_gridIds.resize(index);
+			_items.resize(index);
+		}
+		if (!allGood) {
+			// Existing layouts could move anywhere, next recycleGrid() checks all.
+			_gridLayoutsFrom = 0;
+			_gridLayoutsTill = _items.size();
+		}
 
 		_height = countHeight();
 	} else {
@@ -1746,9 +1847,17 @@ void OverviewInner::itemRemoved(HistoryItem *item) {
 		_overview->updateTopBarSelection();
 	}
 
+	if (isGrid()) {
+		auto index = _gridIds.indexOf(msgId);
+		if (index >= 0) {
+			_gridIds.remove(index);
+			_items.remove(index);
+			accumulate_min(_gridLayoutsFrom, index);
+		}
+	}
 	auto j = _layoutItems.find(item);
 	if (j != _layoutItems.cend()) {
-		int32 index = _items.indexOf(j.value());
+		int32 index = isGrid() ? -1 : _items.indexOf(j.value());
 		if (index >= 0) {
 			_items.remove(index);
 		}
@@ -1778,8 +1887,8 @@ void OverviewInner::repaintItem(const HistoryItem *msg) {
 	if ((history == _history || migrateindex > 0) && (_inSearch || history->overviewHasMsgId(_type, msgid))) {
 		if (_type == OverviewPhotos || _type == OverviewVideos) {
 			if (history == _migrated) msgid = -msgid;
-			for (int32 i = 0, l = _items.size(); i != l; ++i) {
-				if (complexMsgId(_items.at(i)->getItem()) == msgid) {
+			for (int32 i = 0, l = _gridIds.size(); i != l; ++i) {
+				if (_gridIds.at(i) == msgid) {
 					float64 w = (float64(width() - st::overviewPhotoSkip) / _photosInRow);
 					int32 vsize = (_rowWidth + st::overviewPhotoSkip);
 					int32 row = i / _photosInRow, col = i % _photosInRow;
@@ -1932,6 +2041,8 @@ void OverviewWidget::onScroll() {
 	if (needToPreload) {
 		_inner->preloadMore();
 	}
+	_inner->prefetchGrid(_scroll->scrollTop(), _scroll->height());
+	_inner->recycleGrid(_scroll->scrollTop(), _scroll->height());
 	if (!_noDropResizeIndex) {
 		_inner->dropResizeIndex();
 	}
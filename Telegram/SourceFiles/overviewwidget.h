@@ -59,6 +59,10 @@ public:
 	bool preloadLocal();
 	void preloadMore();
 
+	// Starts loading the grid thumbnails one screen ahead in the scroll direction.
+	void prefetchGrid(int32 scrollTop, int32 scrollHeight);
+	void recycleGrid(int32 scrollTop, int32 scrollHeight);
+
 	void showContextMenu(QContextMenuEvent *e, bool showFromTouch = false);
 
 	void dragActionStart(const QPoint &screenPos, Qt::MouseButton button = Qt::LeftButton);
@@ -142,6 +146,7 @@ private:
 	int32 migratedIndexSkip() const;
 
 	void fixItemIndex(int32 &current, MsgId msgId) const;
+	MsgId complexMsgIdAt(int32 index) const;
 	bool itemHasPoint(MsgId msgId, int32 index, int32 x, int32 y) const;
 	int32 itemHeight(MsgId msgId, int32 index) const;
 	void moveToNextItem(MsgId &msgId, int32 &index, MsgId upTo, int32 delta) const;
@@ -194,6 +199,18 @@ private:
 
 	// photos
 	int32 _photosInRow = 1;
+	int32 _prefetchScrollTop = 0;
+
+	// The grid keeps the ids of all loaded items in _gridIds and the layouts
+	// only for the rows around the visible part, other _items are nullptr.
+	bool isGrid() const {
+		return (_type == OverviewPhotos || _type == OverviewVideos);
+	}
+	bool gridItemValid(HistoryItem *item) const;
+	Overview::Layout::ItemBase *gridItem(int32 index);
+	QVector<MsgId> _gridIds;
+	int32 _gridLayoutsFrom = 0;
+	int32 _gridLayoutsTill = 0;
 
 	QTimer _searchTimer;
 	QString _searchQuery;
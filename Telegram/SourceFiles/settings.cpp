@@ -37,6 +37,7 @@ QByteArray gBetaPrivateKey;
 bool gTestMode = false;
 bool gDebug = false;
 bool gManyInstance = false;
+bool gHistoryRenderCache = false;
 QString gKeyFile;
 QString gWorkingDir, gExeDir, gExeName;
 
@@ -113,6 +114,11 @@ DBIPlatform gPlatform = dbipLinux32;
 #endif
 QString gPlatformString;
 QUrl gUpdateURL;
+int32 gDownloadSessionsLimit = MTPDownloadSessionsCount * 2;
+int32 gUploadSessionsLimit = MTPUploadSessionsCount * 2;
+QString gMtpRecordPath;
+QString gMtpReplayHost;
+int32 gMtpReplayPort = 0;
 bool gIsElCapitan = false;
 
 bool gContactsReceived = false;
@@ -189,6 +195,8 @@ void settingsParseArgs(int argc, char *argv[]) {
 			gTestMode = true;
 		} else if (qstr("-debug") == argv[i]) {
 			gDebug = true;
+		} else if (qstr("-historycache") == argv[i]) {
+			gHistoryRenderCache = true;
 		} else if (qstr("-many") == argv[i]) {
 			gManyInstance = true;
 		} else if (qstr("-key") == argv[i] && i + 1 < argc) {
@@ -202,6 +210,23 @@ void settingsParseArgs(int argc, char *argv[]) {
 		} else if (qstr("-crash") == argv[i] && i + 1 < argc) {
 			gLaunchMode = LaunchModeShowCrash;
 			gStartUrl = fromUtf8Safe(argv[++i]);
+		} else if (qstr("-updateurl") == argv[i] && i + 1 < argc) {
+			gUpdateURL = QUrl(fromUtf8Safe(argv[++i])); // packages are still checked with the built-in keys
+		} else if (qstr("-downloadsessions") == argv[i] && i + 1 < argc) {
+			gDownloadSessionsLimit = snap(fromUtf8Safe(argv[++i]).toInt(), 1, int(MTPDownloadSessionsMax));
+		} else if (qstr("-uploadsessions") == argv[i] && i + 1 < argc) {
+			gUploadSessionsLimit = snap(fromUtf8Safe(argv[++i]).toInt(), 1, int(MTPUploadSessionsMax));
+#ifdef _DEBUG
+		} else if (qstr("-mtprecord") == argv[i] && i + 1 < argc) { // the capture has the auth keys in it
+			gMtpRecordPath = fromUtf8Safe(argv[++i]);
+		} else if (qstr("-mtpreplay") == argv[i] && i + 1 < argc) { // all the dcs are connected to that address
+			auto address = fromUtf8Safe(argv[++i]);
+			auto colon = address.lastIndexOf(':');
+			if (colon > 0) {
+				gMtpReplayHost = address.mid(0, colon);
+				gMtpReplayPort = address.mid(colon + 1).toInt();
+			}
+#endif // _DEBUG
 		} else if (qstr("-noupdate") == argv[i]) {
 			gNoStartUpdate = true;
 		} else if (qstr("-tosettings") == argv[i]) {
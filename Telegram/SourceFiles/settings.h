@@ -112,6 +112,7 @@ DeclareSetting(bool, NoStartUpdate);
 DeclareSetting(bool, StartToSettings);
 DeclareSetting(bool, ReplaceEmojis);
 DeclareReadSetting(bool, ManyInstance);
+DeclareReadSetting(bool, HistoryRenderCache);
 
 DeclareSetting(QByteArray, LocalSalt);
 DeclareSetting(DBIScale, RealScale);
@@ -260,6 +261,11 @@ DeclareReadSetting(DBIPlatform, Platform);
 DeclareReadSetting(QString, PlatformString);
 DeclareReadSetting(bool, IsElCapitan);
 DeclareReadSetting(QUrl, UpdateURL);
+DeclareReadSetting(int32, DownloadSessionsLimit);
+DeclareReadSetting(int32, UploadSessionsLimit);
+DeclareReadSetting(QString, MtpRecordPath); // Decrypted traffic capture, see mtproto/traffic_recorder.h
+DeclareReadSetting(QString, MtpReplayHost); // All dcs are connected through the ReplayServer if set, debug builds only
+DeclareReadSetting(int32, MtpReplayPort);
 
 DeclareSetting(bool, ContactsReceived);
 DeclareSetting(bool, DialogsReceived);
@@ -39,6 +39,26 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include "apiwrap.h"
 #include "mainwidget.h"
 
+namespace {
+
+// The inline bot results of the least recently used queries are dropped
+// when any of the limits is reached, the shown query is never dropped.
+constexpr auto kInlineCacheEntriesLimit = 64;
+constexpr auto kInlineCacheResultsLimit = 1024;
+
+// The next results page is requested while the last screens are shown.
+constexpr auto kInlinePreloadScreens = 2;
+
+QSize StickerPanPixmapSize(DocumentData *sticker) {
+	auto coef = qMin((st::stickerPanSize.width() - st::buttonRadius * 2) / float64(sticker->dimensions.width()), (st::stickerPanSize.height() - st::buttonRadius * 2) / float64(sticker->dimensions.height()));
+	if (coef > 1) coef = 1;
+	auto w = qMax(qRound(coef * sticker->dimensions.width()), 1);
+	auto h = qMax(qRound(coef * sticker->dimensions.height()), 1);
+	return QSize(w, h);
+}
+
+} // namespace
+
 namespace internal {
 
 EmojiColorPicker::EmojiColorPicker(QWidget *parent) : TWidget(parent) {
@@ -243,7 +263,7 @@ void EmojiColorPicker::drawVariant(Painter &p, int variant) {
 		App::roundRect(p, QRect(tl, st::emojiPanSize), st::emojiPanHover, StickerHoverCorners);
 	}
 	int esize = EmojiSizes[EIndex + 1];
-	p.drawPixmapLeft(w.x() + (st::emojiPanSize.width() - (esize / cIntRetinaFactor())) / 2, w.y() + (st::emojiPanSize.height() - (esize / cIntRetinaFactor())) / 2, width(), App::emojiLarge(), QRect(_variants[variant]->x * esize, _variants[variant]->y * esize, esize, esize));
+	p.drawPixmapLeft(w.x() + (st::emojiPanSize.width() - (esize / cIntRetinaFactor())) / 2, w.y() + (st::emojiPanSize.height() - (esize / cIntRetinaFactor())) / 2, width(), App::emojiLarge(_variants[variant]), QRect(_variants[variant]->x * esize, 0, esize, esize));
 }
 
 EmojiPanInner::EmojiPanInner(QWidget *parent) : TWidget(parent)
@@ -347,7 +367,7 @@ void EmojiPanInner::paintEvent(QPaintEvent *e) {
 					if (rtl()) tl.setX(width() - tl.x() - st::emojiPanSize.width());
 					App::roundRect(p, QRect(tl, st::emojiPanSize), st::emojiPanHover, StickerHoverCorners);
 				}
-				p.drawPixmapLeft(w.x() + (st::emojiPanSize.width() - (_esize / cIntRetinaFactor())) / 2, w.y() + (st::emojiPanSize.height() - (_esize / cIntRetinaFactor())) / 2, width(), App::emojiLarge(), QRect(_emojis[c][index]->x * _esize, _emojis[c][index]->y * _esize, _esize, _esize));
+				p.drawPixmapLeft(w.x() + (st::emojiPanSize.width() - (_esize / cIntRetinaFactor())) / 2, w.y() + (st::emojiPanSize.height() - (_esize / cIntRetinaFactor())) / 2, width(), App::emojiLarge(_emojis[c][index]), QRect(_emojis[c][index]->x * _esize, 0, _esize, _esize));
 			}
 		}
 	}
@@ -705,7 +725,8 @@ StickerPanInner::StickerPanInner(QWidget *parent) : TWidget(parent)
 , _section(cShowingSavedGifs() ? Section::Gifs : Section::Stickers)
 , _addText(lang(lng_stickers_featured_add).toUpper())
 , _addWidth(st::stickersTrendingAdd.font->width(_addText))
-, _settings(this, lang(lng_stickers_you_have)) {
+, _settings(this, lang(lng_stickers_you_have))
+, _stickerPixmaps([this] { update(); }) {
 	setMaxHeight(st::emojiPanMaxHeight - st::emojiCategory.height);
 
 	setMouseTracking(true);
@@ -736,6 +757,7 @@ void StickerPanInner::setVisibleTopBottom(int visibleTop, int visibleBottom) {
 	if (_visibleTop != visibleTop) {
 		_visibleTop = visibleTop;
 		_lastScrolled = getms();
+		_stickerPixmaps.newRound();
 	}
 	if (_section == Section::Featured) {
 		readVisibleSets();
@@ -1050,19 +1072,24 @@ void StickerPanInner::paintSticker(Painter &p, Set &set, int y, int index, bool
 	if (goodThumb) {
 		sticker->thumb->load();
 	} else {
-		sticker->checkSticker();
+		sticker->automaticLoad(nullptr);
 	}
 
-	float64 coef = qMin((st::stickerPanSize.width() - st::buttonRadius * 2) / float64(sticker->dimensions.width()), (st::stickerPanSize.height() - st::buttonRadius * 2) / float64(sticker->dimensions.height()));
-	if (coef > 1) coef = 1;
-	int32 w = qRound(coef * sticker->dimensions.width()), h = qRound(coef * sticker->dimensions.height());
-	if (w < 1) w = 1;
-	if (h < 1) h = 1;
+	auto size = StickerPanPixmapSize(sticker);
+	int32 w = size.width(), h = size.height();
 	QPoint ppos = pos + QPoint((st::stickerPanSize.width() - w) / 2, (st::stickerPanSize.height() - h) / 2);
 	if (goodThumb) {
 		p.drawPixmapLeft(ppos, width(), sticker->thumb->pix(w, h));
 	} else if (!sticker->sticker()->img->isNull()) {
+		// Already decoded for a message or the preview.
 		p.drawPixmapLeft(ppos, width(), sticker->sticker()->img->pix(w, h));
+	} else {
+		auto pix = _stickerPixmaps.find(sticker, size);
+		if (pix.isNull()) {
+			_stickerPixmaps.schedule(sticker, size, 0);
+		} else {
+			p.drawPixmapLeft(ppos, width(), pix);
+		}
 	}
 
 	if (selected && set.id == Stickers::RecentSetId && _custom.at(index)) {
@@ -1498,6 +1525,16 @@ void StickerPanInner::deleteUnusedGifLayouts() {
 	}
 }
 
+void StickerPanInner::inlineResultsDeleted(const InlineResults &results) {
+	for_const (auto result, results) {
+		auto i = _inlineLayouts.find(result);
+		if (i != _inlineLayouts.cend()) {
+			delete i.value();
+			_inlineLayouts.erase(i);
+		}
+	}
+}
+
 void StickerPanInner::deleteUnusedInlineLayouts() {
 	if (_inlineRows.isEmpty() || _section == Section::Gifs) { // delete all
 		for_const (auto item, _inlineLayouts) {
@@ -1576,6 +1613,9 @@ void StickerPanInner::preloadImages() {
 				sticker->thumb->load();
 			} else {
 				sticker->automaticLoad(0);
+				if (sticker->sticker()->img->isNull()) {
+					_stickerPixmaps.schedule(sticker, StickerPanPixmapSize(sticker), k);
+				}
 			}
 		}
 		if (k > StickerPanPerRow * (StickerPanPerRow + 1)) break;
@@ -3327,7 +3367,11 @@ void EmojiPan::hideAnimated() {
 	startOpacityAnimation(true);
 }
 
-EmojiPan::~EmojiPan() = default;
+EmojiPan::~EmojiPan() {
+	while (!_inlineCache.isEmpty()) {
+		removeInlineCacheEntry(_inlineCache.begin());
+	}
+}
 
 void EmojiPan::hideFinished() {
 	hide();
@@ -3545,7 +3589,7 @@ void EmojiPan::onScrollStickers() {
 	updatePanelsPositions(s_panels, st);
 
 	validateSelectedIcon(ValidateIconAnimations::Full);
-	if (st + s_scroll->height() > s_scroll->scrollTopMax()) {
+	if (st + s_scroll->height() * kInlinePreloadScreens > s_scroll->scrollTopMax()) {
 		onInlineRequest();
 	}
 
@@ -3780,10 +3824,7 @@ void EmojiPan::inlineBotChanged() {
 	_inlineRequestId = 0;
 	_inlineQuery = _inlineNextQuery = _inlineNextOffset = QString();
 	_inlineBot = nullptr;
-	for (InlineCache::const_iterator i = _inlineCache.cbegin(), e = _inlineCache.cend(); i != e; ++i) {
-		delete i.value();
-	}
-	_inlineCache.clear();
+	_inlineShownEntry = nullptr;
 	s_inner->inlineBotChanged();
 	s_inner->hideInlineRowsPanel();
 
@@ -3794,7 +3835,8 @@ void EmojiPan::inlineResultsDone(const MTPmessages_BotResults &result) {
 	_inlineRequestId = 0;
 	Notify::inlineBotRequesting(false);
 
-	auto it = _inlineCache.find(_inlineQuery);
+	auto key = inlineCacheKey(_inlineQuery);
+	auto it = _inlineCache.find(key);
 
 	bool adding = (it != _inlineCache.cend());
 	if (result.type() == mtpc_messages_botResults) {
@@ -3803,9 +3845,11 @@ void EmojiPan::inlineResultsDone(const MTPmessages_BotResults &result) {
 		uint64 queryId(d.vquery_id.v);
 
 		if (!adding) {
-			it = _inlineCache.insert(_inlineQuery, new internal::InlineCacheEntry());
+			it = _inlineCache.insert(key, new internal::InlineCacheEntry());
 		}
 		it.value()->nextOffset = qs(d.vnext_offset);
+		it.value()->validTill = getms(true) + d.vcache_time.v * 1000LL;
+		it.value()->used = ++_inlineCacheUseCounter;
 		if (d.has_switch_pm() && d.vswitch_pm.type() == mtpc_inlineBotSwitchPM) {
 			const auto &switchPm = d.vswitch_pm.c_inlineBotSwitchPM();
 			it.value()->switchPmText = qs(switchPm.vtext);
@@ -3819,9 +3863,11 @@ void EmojiPan::inlineResultsDone(const MTPmessages_BotResults &result) {
 		for_const (const auto &res, v) {
 			if (auto result = InlineBots::Result::create(queryId, res)) {
 				++added;
+				result->preloadThumbnail();
 				it.value()->results.push_back(result.release());
 			}
 		}
+		_inlineCacheResults += added;
 
 		if (!added) {
 			it.value()->nextOffset = QString();
@@ -3833,6 +3879,7 @@ void EmojiPan::inlineResultsDone(const MTPmessages_BotResults &result) {
 	if (!showInlineRows(!adding)) {
 		it.value()->nextOffset = QString();
 	}
+	checkInlineCacheLimits();
 	onScrollStickers();
 }
 
@@ -3844,7 +3891,7 @@ bool EmojiPan::inlineResultsFail(const RPCError &error) {
 }
 
 void EmojiPan::queryInlineBot(UserData *bot, PeerData *peer, QString query) {
-	bool force = false;
+	bool force = (peer != _inlineQueryPeer);
 	_inlineQueryPeer = peer;
 	if (bot != _inlineBot) {
 		inlineBotChanged();
@@ -3864,13 +3911,31 @@ void EmojiPan::queryInlineBot(UserData *bot, PeerData *peer, QString query) {
 			_inlineRequestId = 0;
 			Notify::inlineBotRequesting(false);
 		}
-		if (_inlineCache.contains(query)) {
+		if (findInlineCacheEntry(query)) {
 			_inlineRequestTimer.stop();
 			_inlineQuery = _inlineNextQuery = query;
 			showInlineRows(true);
 		} else {
 			_inlineNextQuery = query;
 			_inlineRequestTimer.start(InlineBotRequestDelay);
+			showInlinePrefixRows(query);
+		}
+	}
+}
+
+void EmojiPan::showInlinePrefixRows(const QString &query) {
+	// While the request is pending the results of the longest cached
+	// prefix of the query are shown instead of the previous query ones.
+	auto prefix = query;
+	while (!prefix.isEmpty()) {
+		prefix.chop(1);
+		auto entry = findInlineCacheEntry(prefix);
+		if (entry && !entry->results.isEmpty()) {
+			_inlineQuery = prefix;
+			if (entry != _inlineShownEntry) {
+				showInlineRows(true);
+			}
+			return;
 		}
 	}
 }
@@ -3880,9 +3945,8 @@ void EmojiPan::onInlineRequest() {
 	_inlineQuery = _inlineNextQuery;
 
 	QString nextOffset;
-	InlineCache::const_iterator i = _inlineCache.constFind(_inlineQuery);
-	if (i != _inlineCache.cend()) {
-		nextOffset = i.value()->nextOffset;
+	if (auto entry = findInlineCacheEntry(_inlineQuery)) {
+		nextOffset = entry->nextOffset;
 		if (nextOffset.isEmpty()) return;
 	}
 	Notify::inlineBotRequesting(true);
@@ -3901,12 +3965,51 @@ void EmojiPan::onEmptyInlineRows() {
 	}
 }
 
+internal::InlineCacheKey EmojiPan::inlineCacheKey(const QString &query) const {
+	return { _inlineBot, _inlineQueryPeer, query };
+}
+
+internal::InlineCacheEntry *EmojiPan::findInlineCacheEntry(const QString &query) {
+	auto i = _inlineCache.find(inlineCacheKey(query));
+	if (i == _inlineCache.cend()) {
+		return nullptr;
+	}
+	if (i.value() != _inlineShownEntry && i.value()->validTill <= getms(true)) {
+		removeInlineCacheEntry(i);
+		return nullptr;
+	}
+	i.value()->used = ++_inlineCacheUseCounter;
+	return i.value();
+}
+
+void EmojiPan::removeInlineCacheEntry(InlineCache::iterator i) {
+	auto entry = i.value();
+	s_inner->inlineResultsDeleted(entry->results);
+	_inlineCacheResults -= entry->results.size();
+	_inlineCache.erase(i);
+	delete entry;
+}
+
+void EmojiPan::checkInlineCacheLimits() {
+	while (_inlineCache.size() > kInlineCacheEntriesLimit || _inlineCacheResults > kInlineCacheResultsLimit) {
+		auto oldest = _inlineCache.end();
+		for (auto i = _inlineCache.begin(), e = _inlineCache.end(); i != e; ++i) {
+			if (i.value() == _inlineShownEntry) continue;
+			if (oldest == _inlineCache.end() || i.value()->used < oldest.value()->used) {
+				oldest = i;
+			}
+		}
+		if (oldest == _inlineCache.end()) break;
+		removeInlineCacheEntry(oldest);
+	}
+}
+
 bool EmojiPan::refreshInlineRows(int32 *added) {
-	auto i = _inlineCache.constFind(_inlineQuery);
+	auto i = _inlineCache.constFind(inlineCacheKey(_inlineQuery));
 	const internal::InlineCacheEntry *entry = nullptr;
 	if (i != _inlineCache.cend()) {
 		if (!i.value()->results.isEmpty() || !i.value()->switchPmText.isEmpty()) {
-			entry = i.value();
+			entry = _inlineShownEntry = i.value();
 		}
 		_inlineNextOffset = i.value()->nextOffset;
 	}
@@ -23,6 +23,7 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include "ui/twidget.h"
 #include "ui/abstract_button.h"
 #include "ui/effects/panel_animation.h"
+#include "stickers/stickers_panel_cache.h"
 
 namespace InlineBots {
 namespace Layout {
@@ -55,9 +56,22 @@ struct InlineCacheEntry {
 	QString nextOffset;
 	QString switchPmText, switchPmStartToken;
 	InlineResults results; // owns this results list
+	TimeMs validTill = 0; // by the cache_time of the last received page
+	uint64 used = 0;
 	void clearResults();
 };
 
+struct InlineCacheKey {
+	UserData *bot;
+	PeerData *peer;
+	QString query;
+};
+inline bool operator<(const InlineCacheKey &a, const InlineCacheKey &b) {
+	if (a.bot != b.bot) return (a.bot < b.bot);
+	if (a.peer != b.peer) return (a.peer < b.peer);
+	return (a.query < b.query);
+}
+
 class EmojiColorPicker : public TWidget {
 	Q_OBJECT
 
@@ -228,6 +242,9 @@ public:
 	void hideInlineRowsPanel();
 	void clearInlineRowsPanel();
 
+	// Deletes the layouts of the results that were dropped from the cache.
+	void inlineResultsDeleted(const InlineResults &results);
+
 	void fillIcons(QList<StickerIcon> &icons);
 	void fillPanels(QVector<EmojiPanel*> &panels);
 	void refreshPanels(QVector<EmojiPanel*> &panels);
@@ -384,6 +401,8 @@ private:
 	InlineLayouts _inlineLayouts;
 	InlineItem *layoutPrepareInlineResult(InlineResult *result, int32 position);
 
+	Stickers::PanelCache _stickerPixmaps;
+
 	bool inlineRowsAddItem(DocumentData *savedGif, InlineResult *result, InlineRow &row, int32 &sumWidth);
 	bool inlineRowFinalize(InlineRow &row, int32 &sumWidth, bool force = false);
 
@@ -678,10 +697,19 @@ private:
 	QTimer _saveConfigTimer;
 
 	// inline bots
-	typedef QMap<QString, internal::InlineCacheEntry*> InlineCache;
+	typedef QMap<internal::InlineCacheKey, internal::InlineCacheEntry*> InlineCache;
 	InlineCache _inlineCache;
+	int _inlineCacheResults = 0;
+	uint64 _inlineCacheUseCounter = 0;
+	const internal::InlineCacheEntry *_inlineShownEntry = nullptr;
 	QTimer _inlineRequestTimer;
 
+	internal::InlineCacheKey inlineCacheKey(const QString &query) const;
+	internal::InlineCacheEntry *findInlineCacheEntry(const QString &query);
+	void showInlinePrefixRows(const QString &query);
+	void removeInlineCacheEntry(InlineCache::iterator i);
+	void checkInlineCacheLimits();
+
 	void inlineBotChanged();
 	int32 showInlineRows(bool newResults);
 	bool hideOnNoInlineResults();
@@ -0,0 +1,192 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#include "stdafx.h"
+#include "stickers/stickers_panel_cache.h"
+
+#include "core/task_queue.h"
+
+namespace Stickers {
+namespace {
+
+constexpr auto kMemoryLimit = 24 * 1024 * 1024LL;
+constexpr auto kDecodingLimit = 4;
+
+int64 PixmapMemory(const QPixmap &pix) {
+	return int64(pix.width()) * pix.height() * 4;
+}
+
+} // namespace
+
+PanelCache::PanelCache(base::lambda<void()> &&prepared)
+: _prepared(std_::move(prepared))
+, _shared(MakeShared<Shared>()) {
+	_shared->owner = this;
+}
+
+void PanelCache::schedule(DocumentData *sticker, QSize size, int priority) {
+	if (size.isEmpty()) return;
+
+	auto i = _entries.find(sticker);
+	if (i == _entries.end()) {
+		i = _entries.insert(sticker, Entry());
+	} else if (i->size != size) {
+		_memory -= PixmapMemory(i->pix);
+		i->pix = QPixmap();
+		i->failed = false;
+		if (i->requestId) {
+			i->requestId = 0;
+			--_decoding;
+		}
+	} else if (i->failed || (i->round == _round && i->priority <= priority)) {
+		return;
+	}
+	i->size = size;
+	i->round = _round;
+	i->priority = priority;
+	if (i->pix.isNull() && !i->requestId) {
+		startDecoding();
+	}
+}
+
+QPixmap PanelCache::find(DocumentData *sticker, QSize size) {
+	auto i = _entries.find(sticker);
+	if (i == _entries.end() || i->size != size) {
+		return QPixmap();
+	}
+	i->used = ++_useCounter;
+	return i->pix;
+}
+
+void PanelCache::startDecoding() {
+	while (_decoding < kDecodingLimit) {
+		// The latest round first, then the lowest priority value.
+		auto next = _entries.end();
+		for (auto i = _entries.begin(), e = _entries.end(); i != e; ++i) {
+			if (!i->pix.isNull() || i->requestId || i->failed) continue;
+			if (next == _entries.end()
+				|| i->round > next->round
+				|| (i->round == next->round && i->priority < next->priority)) {
+				next = i;
+			}
+		}
+		if (next == _entries.end()) {
+			break;
+		}
+		if (!startDecoding(next.key(), next.value())) {
+			// Not loaded yet, it will be scheduled again when painted.
+			_entries.erase(next);
+		}
+	}
+}
+
+bool PanelCache::startDecoding(DocumentData *sticker, Entry &entry) {
+	if (!sticker->loaded()) {
+		return false;
+	}
+	// The file is read on the worker thread, the access to it is enabled
+	// here and disabled back on the main thread when the sticker is decoded.
+	auto bytes = sticker->data();
+	auto location = FileLocation();
+	auto path = QString();
+	if (bytes.isEmpty()) {
+		location = sticker->location(true);
+		if (!location.accessEnable()) {
+			return false;
+		}
+		path = location.name();
+	}
+
+	auto requestId = entry.requestId = ++_lastRequestId;
+	auto size = entry.size * cIntRetinaFactor();
+	auto weak = _shared.toWeakRef();
+	++_decoding;
+	base::TaskQueue::Normal().Put([weak, sticker, requestId, size, bytes, location, path] {
+		auto copy = bytes;
+		if (copy.isEmpty()) {
+			QFile file(path);
+			if (file.open(QIODevice::ReadOnly)) {
+				copy = file.readAll();
+			}
+		}
+		QBuffer buffer(&copy);
+		QImageReader reader(&buffer);
+		struct mutable_data {
+			mutable_data(QImage &&value) : value(std_::move(value)) {
+			}
+			mutable QImage value;
+		};
+		auto data = mutable_data(reader.read());
+		if (!data.value.isNull()) {
+			data.value = Images::prepare(std_::move(data.value), size.width(), size.height(), Images::Option::Smooth, -1, -1);
+		}
+		base::TaskQueue::Main().Put([weak, sticker, requestId, location, data = std_::move(data)] {
+			location.accessDisable();
+			if (auto shared = weak.toStrongRef()) {
+				if (shared->owner) {
+					shared->owner->prepared(sticker, requestId, std_::move(data.value));
+				}
+			}
+		});
+	});
+	return true;
+}
+
+void PanelCache::prepared(DocumentData *sticker, uint64 requestId, QImage &&image) {
+	auto i = _entries.find(sticker);
+	if (i == _entries.end() || i->requestId != requestId) {
+		return; // The decoding counter was decreased when the request was dropped.
+	}
+	--_decoding;
+	i->requestId = 0;
+	if (image.isNull()) {
+		// Keep the entry, so that the repaints don't decode it again.
+		i->failed = true;
+		startDecoding();
+		return;
+	}
+	i->pix = App::pixmapFromImageInPlace(std_::move(image));
+	i->used = ++_useCounter;
+	_memory += PixmapMemory(i->pix);
+	checkMemoryLimit();
+	startDecoding();
+	if (_prepared) _prepared();
+}
+
+void PanelCache::checkMemoryLimit() {
+	while (_memory > kMemoryLimit) {
+		auto oldest = _entries.end();
+		for (auto i = _entries.begin(), e = _entries.end(); i != e; ++i) {
+			if (i->pix.isNull()) continue;
+			if (oldest == _entries.end() || i->used < oldest->used) {
+				oldest = i;
+			}
+		}
+		if (oldest == _entries.end()) break;
+		_memory -= PixmapMemory(oldest->pix);
+		_entries.erase(oldest);
+	}
+}
+
+PanelCache::~PanelCache() {
+	_shared->owner = nullptr;
+}
+
+} // namespace Stickers
@@ -0,0 +1,78 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#pragma once
+
+namespace Stickers {
+
+// Stickers decoded from webp and scaled for the panel on the worker threads,
+// instead of DocumentData::checkSticker() decoding them on the main thread in
+// the first paint. Only a few stickers are decoded at the same time and the
+// ones scheduled in the latest round (after the latest scroll) go first, so
+// the workers are not busy with the sections that were scrolled past.
+class PanelCache {
+public:
+	PanelCache(base::lambda<void()> &&prepared);
+
+	// Starts a new scheduling round, call it when the panel is scrolled.
+	void newRound() {
+		++_round;
+	}
+
+	// Lower priority values are decoded first in the same round,
+	// the stickers that are painted now are scheduled with zero.
+	void schedule(DocumentData *sticker, QSize size, int priority);
+
+	// Returns a null pixmap while the sticker is not prepared in that size.
+	QPixmap find(DocumentData *sticker, QSize size);
+
+	~PanelCache();
+
+private:
+	struct Shared {
+		PanelCache *owner = nullptr;
+	};
+	struct Entry {
+		QSize size;
+		int round = 0;
+		int priority = 0;
+		uint64 used = 0;
+		uint64 requestId = 0; // Non-zero while the sticker is being decoded.
+		bool failed = false; // The sticker can't be decoded in this size.
+		QPixmap pix;
+	};
+
+	void startDecoding();
+	bool startDecoding(DocumentData *sticker, Entry &entry);
+	void prepared(DocumentData *sticker, uint64 requestId, QImage &&image);
+	void checkMemoryLimit();
+
+	base::lambda<void()> _prepared;
+	QSharedPointer<Shared> _shared;
+	QMap<DocumentData*, Entry> _entries;
+	int64 _memory = 0;
+	int _decoding = 0;
+	int _round = 0;
+	uint64 _useCounter = 0;
+	uint64 _lastRequestId = 0;
+
+};
+
+} // namespace Stickers
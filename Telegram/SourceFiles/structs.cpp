@@ -36,6 +36,7 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include "history/history_media_types.h"
 #include "styles/style_history.h"
 #include "window/window_theme.h"
+#include "data/data_userpic_cache.h"
 
 namespace {
 
@@ -327,19 +328,53 @@ ImagePtr PeerData::currentUserpic() const {
 }
 
 void PeerData::paintUserpic(Painter &p, int x, int y, int size) const {
-	if (auto userpic = currentUserpic()) {
-		p.drawPixmap(x, y, userpic->pixCircled(size, size));
-	} else {
-		_userpicEmpty.paint(p, x, y, x + size + x, size);
-	}
+	p.drawPixmap(x, y, cachedUserpic(size, Data::UserpicShape::Circle));
 }
 
 void PeerData::paintUserpicRounded(Painter &p, int x, int y, int size) const {
-	if (auto userpic = currentUserpic()) {
-		p.drawPixmap(x, y, userpic->pixRounded(size, size, ImageRoundRadius::Small));
+	p.drawPixmap(x, y, cachedUserpic(size, Data::UserpicShape::Rounded));
+}
+
+QPixmap PeerData::cachedUserpic(int size, Data::UserpicShape shape) const {
+	auto circle = (shape == Data::UserpicShape::Circle);
+	auto userpic = currentUserpic();
+	if (userpic && (photoLoc.isNull() || userpic->forgotten())) {
+		// No unique key for this photo or it is being decoded back.
+		return circle ? userpic->pixCircled(size, size) : userpic->pixRounded(size, size, ImageRoundRadius::Small);
+	}
+
+	auto key = userpicUniqueKey();
+	auto result = Data::findUserpic(key, size, shape);
+	if (!result.isNull()) {
+		return result;
+	}
+	if (userpic) {
+		auto options = Images::Option::Smooth | (circle ? Images::Option::Circled : (Images::Option::RoundedSmall | Images::Option::RoundedTopLeft | Images::Option::RoundedTopRight | Images::Option::RoundedBottomLeft | Images::Option::RoundedBottomRight));
+		result = userpic->pixNoCache(size * cIntRetinaFactor(), size * cIntRetinaFactor(), options);
+		result.setDevicePixelRatio(cRetinaFactor());
 	} else {
-		_userpicEmpty.paintRounded(p, x, y, x + size + x, size);
+		auto image = QImage(QSize(size, size) * cIntRetinaFactor(), QImage::Format_ARGB32_Premultiplied);
+		image.setDevicePixelRatio(cRetinaFactor());
+		image.fill(Qt::transparent);
+		{
+			Painter p(&image);
+			if (circle) {
+				_userpicEmpty.paint(p, 0, 0, size, size);
+			} else {
+				_userpicEmpty.paintRounded(p, 0, 0, size, size);
+			}
+		}
+		result = App::pixmapFromImageInPlace(std_::move(image));
+	}
+	return Data::insertUserpic(key, size, shape, std_::move(result));
+}
+
+void PeerData::prepareUserpic(int size) const {
+	auto userpic = currentUserpic();
+	if (!userpic || photoLoc.isNull() || userpic->forgotten()) {
+		return; // Letter avatars are cheap to draw on the first paint.
 	}
+	Data::prepareUserpicAsync(userpicUniqueKey(), size, Data::UserpicShape::Circle, userpic->savedData(), userpic->savedFormat());
 }
 
 StorageKey PeerData::userpicUniqueKey() const {
@@ -956,6 +991,7 @@ ImagePtr PhotoData::makeReplyPreview() {
 			int w = thumb->width(), h = thumb->height();
 			if (w <= 0) w = 1;
 			if (h <= 0) h = 1;
+			thumb->restore();
 			replyPreview = ImagePtr(w > h ? thumb->pix(w * st::msgReplyBarSize.height() / h, st::msgReplyBarSize.height()) : thumb->pix(st::msgReplyBarSize.height()), "PNG");
 		} else {
 			thumb->load();
@@ -1252,7 +1288,17 @@ void DocumentOpenClickHandler::doOpen(DocumentData *data, HistoryItem *context,
 		if (filename.isEmpty()) return;
 	}
 
-	data->save(filename, action, msgId);
+	// Play the video in the media viewer while it is being loaded
+	// instead of opening it in an external player when it is ready.
+	data->save(filename, playVideo ? ActionOnLoadNone : action, msgId);
+	if (playVideo) {
+		if (data->streaming()) {
+			App::wnd()->showDocument(data, context);
+			if (App::main()) App::main()->mediaMarkRead(data);
+		} else {
+			data->setActionOnLoad(action, msgId);
+		}
+	}
 }
 
 void DocumentOpenClickHandler::onClickImpl() const {
@@ -1573,6 +1619,15 @@ QString DocumentData::loadingFilePath() const {
 	return loading() ? _loader->fileName() : QString();
 }
 
+FileLoadStreamingPtr DocumentData::streaming() const {
+	if (loading() && (isVideo() || isAnimation())) {
+		if (auto loader = _loader->mtpLoader()) {
+			return loader->streaming();
+		}
+	}
+	return FileLoadStreamingPtr();
+}
+
 bool DocumentData::displayLoading() const {
 	return loading() ? (!_loader->loadingLocal() || !_loader->autoLoading()) : uploading();
 }
@@ -1644,6 +1699,14 @@ void DocumentData::save(const QString &toFile, ActionOnLoad action, const FullMs
 	notifyLayoutChanged();
 }
 
+void DocumentData::setActionOnLoad(ActionOnLoad action, const FullMsgId &actionMsgId) {
+	_actionOnLoad = action;
+	_actionOnLoadMsgId = actionMsgId;
+	if (!loading() && loaded(FilePathResolveChecked)) {
+		performActionOnLoad();
+	}
+}
+
 void DocumentData::cancel() {
 	if (!loading()) return;
 
@@ -1743,6 +1806,7 @@ ImagePtr DocumentData::makeReplyPreview() {
 			int w = thumb->width(), h = thumb->height();
 			if (w <= 0) w = 1;
 			if (h <= 0) h = 1;
+			thumb->restore();
 			replyPreview = ImagePtr(w > h ? thumb->pix(w * st::msgReplyBarSize.height() / h, st::msgReplyBarSize.height()) : thumb->pix(st::msgReplyBarSize.height()), "PNG");
 		} else {
 			thumb->load();
@@ -20,6 +20,10 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 */
 #pragma once
 
+namespace Data {
+enum class UserpicShape;
+} // namespace Data
+
 typedef int32 UserId;
 typedef int32 ChatId;
 typedef int32 ChannelId;
@@ -320,6 +324,9 @@ public:
 		paintUserpic(p, rtl() ? (w - x - size) : x, y, size);
 	}
 	void paintUserpicRounded(Painter &p, int x, int y, int size) const;
+
+	// Decodes the loaded photo for paintUserpic() of that size on a worker thread.
+	void prepareUserpic(int size) const;
 	void loadUserpic(bool loadFirst = false, bool prior = true) {
 		_userpic->load(loadFirst, prior);
 	}
@@ -361,6 +368,7 @@ protected:
 
 private:
 	void fillNames();
+	QPixmap cachedUserpic(int size, Data::UserpicShape shape) const;
 
 	ClickHandlerPtr _openLink;
 
@@ -1110,8 +1118,10 @@ public:
 	bool loaded(FilePathResolveType type = FilePathResolveCached) const;
 	bool loading() const;
 	QString loadingFilePath() const;
+	FileLoadStreamingPtr streaming() const; // null if can't be played while loading
 	bool displayLoading() const;
 	void save(const QString &toFile, ActionOnLoad action = ActionOnLoadNone, const FullMsgId &actionMsgId = FullMsgId(), LoadFromCloudSetting fromCloud = LoadFromCloudOrLocal, bool autoLoading = false);
+	void setActionOnLoad(ActionOnLoad action, const FullMsgId &actionMsgId); // after save()
 	void cancel();
 	float64 progress() const;
 	int32 loadOffset() const;
@@ -40,6 +40,10 @@ ReaderPointer::~ReaderPointer() {
 
 namespace {
 
+constexpr auto kHiddenFrameDelta = 100;
+constexpr auto kWindowsExposedCheckDelta = 250;
+constexpr auto kStatisticsLogFrames = 3600;
+
 AnimationManager *_manager = nullptr;
 
 } // namespace
@@ -110,6 +114,10 @@ void registerClipManager(Media::Clip::Manager *manager) {
 	manager->connect(manager, SIGNAL(callback(Media::Clip::Reader*,qint32,qint32)), _manager, SLOT(clipCallback(Media::Clip::Reader*,qint32,qint32)));
 }
 
+FrameStatistics frameStatistics() {
+	return _manager ? _manager->statistics() : FrameStatistics();
+}
+
 } // anim
 
 void BasicAnimation::start() {
@@ -129,6 +137,7 @@ void BasicAnimation::stop() {
 
 AnimationManager::AnimationManager() : _timer(this), _iterating(false) {
 	_timer.setSingleShot(false);
+	_timer.setTimerType(Qt::PreciseTimer);
 	connect(&_timer, SIGNAL(timeout()), this, SLOT(timeout()));
 }
 
@@ -139,10 +148,8 @@ void AnimationManager::start(BasicAnimation *obj) {
 			_stopping.remove(obj);
 		}
 	} else {
-		if (_objects.isEmpty()) {
-			_timer.start(AnimationTimerDelta);
-		}
 		_objects.insert(obj);
+		ensureTimer();
 	}
 }
 
@@ -156,19 +163,47 @@ void AnimationManager::stop(BasicAnimation *obj) {
 		auto i = _objects.find(obj);
 		if (i != _objects.cend()) {
 			_objects.erase(i);
-			if (_objects.empty()) {
+			if (_objects.empty() && _clipRepaints.empty()) {
 				_timer.stop();
 			}
 		}
 	}
 }
 
+void AnimationManager::ensureTimer() {
+	if (!_timer.isActive()) {
+		_timer.start(_windowsExposed ? AnimationTimerDelta : kHiddenFrameDelta);
+	}
+}
+
+void AnimationManager::updateWindowsExposed(TimeMs ms) {
+	if (ms < _windowsExposedChecked + kWindowsExposedCheckDelta) {
+		return;
+	}
+	_windowsExposedChecked = ms;
+
+	auto exposed = false;
+	for_const (auto widget, QApplication::topLevelWidgets()) {
+		if (widget->isVisible() && !widget->isMinimized()) {
+			exposed = true;
+			break;
+		}
+	}
+	if (_windowsExposed != exposed) {
+		_windowsExposed = exposed;
+		_timer.setInterval(_windowsExposed ? AnimationTimerDelta : kHiddenFrameDelta);
+	}
+}
+
 void AnimationManager::timeout() {
-	_iterating = true;
 	auto ms = getms();
+	updateWindowsExposed(ms);
+
+	_iterating = true;
 	for_const (auto object, _objects) {
 		if (!_stopping.contains(object)) {
 			object->step(ms, true);
+			++_statistics.steps;
 		}
 	}
 	_iterating = false;
@@ -185,12 +220,73 @@ void AnimationManager::timeout() {
 		}
 		_stopping.clear();
 	}
-	if (_objects.empty()) {
+
+	// While all the windows are hidden nobody will see the new clip
+	// frames, so the repaints wait until some window is exposed again.
+	if (_windowsExposed) {
+		deliverClipRepaints();
+	}
+
+	countFrame(ms, getms());
+
+	if (_objects.empty() && _clipRepaints.empty()) {
 		_timer.stop();
 	}
 }
 
+void AnimationManager::countFrame(TimeMs frameStart, TimeMs frameFinish) {
+	++_statistics.frames;
+	if (!_windowsExposed) {
+		++_statistics.hiddenFrames;
+	}
+
+	auto frameTime = frameFinish - frameStart;
+	_statistics.frameTimeTotal += frameTime;
+	accumulate_max(_statistics.frameTimeMax, frameTime);
+
+	// Only the intervals inside one continuous animation run are counted.
+	if (_lastFrame && frameStart - _lastFrame < kHiddenFrameDelta) {
+		accumulate_max(_statistics.frameIntervalMax, frameStart - _lastFrame);
+	}
+	_lastFrame = frameStart;
+
+	if (!(_statistics.frames % kStatisticsLogFrames)) {
+		DEBUG_LOG(("Animations Info: %1 frames, %2 steps, average frame %3ms, max frame %4ms, max interval %5ms, clip repaints %6 (%7 merged), %8 hidden frames"
+			).arg(_statistics.frames
+			).arg(_statistics.steps
+			).arg(float64(_statistics.frameTimeTotal) / _statistics.frames
+			).arg(_statistics.frameTimeMax
+			).arg(_statistics.frameIntervalMax
+			).arg(_statistics.clipRepaints
+			).arg(_statistics.clipRepaintsMerged
+			).arg(_statistics.hiddenFrames));
+	}
+}
+
 void AnimationManager::clipCallback(Media::Clip::Reader *reader, qint32 threadIndex, qint32 notification) {
-	Media::Clip::Reader::callback(reader, threadIndex, Media::Clip::Notification(notification));
+	if (Media::Clip::Notification(notification) != Media::Clip::NotificationRepaint) {
+		Media::Clip::Reader::callback(reader, threadIndex, Media::Clip::Notification(notification));
+		return;
+	}
+
+	++_statistics.clipRepaints;
+	auto repaint = ClipRepaint(reader, threadIndex);
+	if (_clipRepaints.contains(repaint)) {
+		++_statistics.clipRepaintsMerged;
+		return;
+	}
+	_clipRepaints.insert(repaint);
+	ensureTimer();
 }
 
+void AnimationManager::deliverClipRepaints() {
+	if (_clipRepaints.empty()) {
+		return;
+	}
+
+	// Reader::callback() checks that the reader is still alive.
+	auto repaints = base::take(_clipRepaints);
+	for_const (auto &repaint, repaints) {
+		Media::Clip::Reader::callback(repaint.first, repaint.second, Media::Clip::NotificationRepaint);
+	}
+}
@@ -162,6 +162,18 @@ void startManager();
 void stopManager();
 void registerClipManager(Media::Clip::Manager *manager);
 
+struct FrameStatistics {
+	int64 frames = 0;
+	int64 steps = 0;
+	int64 clipRepaints = 0;
+	int64 clipRepaintsMerged = 0;
+	int64 hiddenFrames = 0;
+	TimeMs frameTimeTotal = 0;
+	TimeMs frameTimeMax = 0;
+	TimeMs frameIntervalMax = 0; // Timer jitter, the longest gap between two frames.
+};
+FrameStatistics frameStatistics();
+
 FORCE_INLINE int interpolate(int a, int b, float64 b_ratio) {
 	return qRound(a + float64(b - a) * b_ratio);
 }
@@ -661,15 +673,36 @@ public:
 	void start(BasicAnimation *obj);
 	void stop(BasicAnimation *obj);
 
+	const anim::FrameStatistics &statistics() const {
+		return _statistics;
+	}
+
 public slots:
 	void timeout();
 
 	void clipCallback(Media::Clip::Reader *reader, qint32 threadIndex, qint32 notification);
 
 private:
+	void ensureTimer();
+	void updateWindowsExposed(TimeMs ms);
+	void deliverClipRepaints();
+	void countFrame(TimeMs frameStart, TimeMs frameFinish);
+
 	using AnimatingObjects = OrderedSet<BasicAnimation*>;
 	AnimatingObjects _objects, _starting, _stopping;
+
+	// Clip repaint notifications are delivered once per frame together
+	// with the animation steps, so that all the updates requested in one
+	// frame are merged by Qt into a single repaint of each window.
+	using ClipRepaint = QPair<Media::Clip::Reader*, qint32>;
+	OrderedSet<ClipRepaint> _clipRepaints;
+
 	QTimer _timer;
 	bool _iterating;
 
+	bool _windowsExposed = true;
+	TimeMs _windowsExposedChecked = 0;
+	TimeMs _lastFrame = 0;
+	anim::FrameStatistics _statistics;
+
 };
@@ -1652,1441 +1652,1345 @@ void emojiInit() {
 	new (toFill++) EmojiData(12, 5, 0xD83EDD18U, 0, 4, 0, 0xD83CDFFFU);
 };
 
-EmojiPtr emojiGet(uint32 code) {
-	if (!emojis) return 0;
-
-	uint32 highCode = code >> 16;
-	if (!highCode) {
-		switch (code) {
-			case 0xA9U: return &emojis[0];
-			case 0xAEU: return &emojis[1];
-		}
+namespace {
 
-		if (code < 0x203CU || code > 0x3299U) return 0;
+struct EmojiCodeEntry {
+	uint32 code;
+	int16 index; // -1 for the first part of a two symbol emoji
+};
 
-		switch (code) {
-			case 0x203CU: return &emojis[2];
-			case 0x2049U: return &emojis[3];
-			case 0x2122U: return &emojis[4];
-			case 0x2139U: return &emojis[5];
-			case 0x2194U: return &emojis[6];
-			case 0x2195U: return &emojis[7];
-			case 0x2196U: return &emojis[8];
-			case 0x2197U: return &emojis[9];
-			case 0x2198U: return &emojis[10];
-			case 0x2199U: return &emojis[11];
-			case 0x21A9U: return &emojis[12];
-			case 0x21AAU: return &emojis[13];
-			case 0x231AU: return &emojis[14];
-			case 0x231BU: return &emojis[15];
-			case 0x2328U: return &emojis[16];
-			case 0x23E9U: return &emojis[17];
-			case 0x23EAU: return &emojis[18];
-			case 0x23EBU: return &emojis[19];
-			case 0x23ECU: return &emojis[20];
-			case 0x23EDU: return &emojis[21];
-			case 0x23EEU: return &emojis[22];
-			case 0x23EFU: return &emojis[23];
-			case 0x23F0U: return &emojis[24];
-			case 0x23F1U: return &emojis[25];
-			case 0x23F2U: return &emojis[26];
-			case 0x23F3U: return &emojis[27];
-			case 0x23F8U: return &emojis[28];
-			case 0x23F9U: return &emojis[29];
-			case 0x23FAU: return &emojis[30];
-			case 0x24C2U: return &emojis[31];
-			case 0x25AAU: return &emojis[32];
-			case 0x25ABU: return &emojis[33];
-			case 0x25B6U: return &emojis[34];
-			case 0x25C0U: return &emojis[35];
-			case 0x25FBU: return &emojis[36];
-			case 0x25FCU: return &emojis[37];
-			case 0x25FDU: return &emojis[38];
-			case 0x25FEU: return &emojis[39];
-			case 0x2600U: return &emojis[40];
-			case 0x2601U: return &emojis[41];
-			case 0x2602U: return &emojis[42];
-			case 0x2603U: return &emojis[43];
-			case 0x2604U: return &emojis[44];
-			case 0x260EU: return &emojis[45];
-			case 0x2611U: return &emojis[46];
-			case 0x2614U: return &emojis[47];
-			case 0x2615U: return &emojis[48];
-			case 0x2618U: return &emojis[49];
-			case 0x261DU: return &emojis[50];
-			case 0x2620U: return &emojis[51];
-			case 0x2622U: return &emojis[52];
-			case 0x2623U: return &emojis[53];
-			case 0x2626U: return &emojis[54];
-			case 0x262AU: return &emojis[55];
-			case 0x262EU: return &emojis[56];
-			case 0x262FU: return &emojis[57];
-			case 0x2638U: return &emojis[58];
-			case 0x2639U: return &emojis[59];
-			case 0x263AU: return &emojis[60];
-			case 0x2648U: return &emojis[61];
-			case 0x2649U: return &emojis[62];
-			case 0x264AU: return &emojis[63];
-			case 0x264BU: return &emojis[64];
-			case 0x264CU: return &emojis[65];
-			case 0x264DU: return &emojis[66];
-			case 0x264EU: return &emojis[67];
-			case 0x264FU: return &emojis[68];
-			case 0x2650U: return &emojis[69];
-			case 0x2651U: return &emojis[70];
-			case 0x2652U: return &emojis[71];
-			case 0x2653U: return &emojis[72];
-			case 0x2660U: return &emojis[73];
-			case 0x2663U: return &emojis[74];
-			case 0x2665U: return &emojis[75];
-			case 0x2666U: return &emojis[76];
-			case 0x2668U: return &emojis[77];
-			case 0x267BU: return &emojis[78];
-			case 0x267FU: return &emojis[79];
-			case 0x2692U: return &emojis[80];
-			case 0x2693U: return &emojis[81];
-			case 0x2694U: return &emojis[82];
-			case 0x2696U: return &emojis[83];
-			case 0x2697U: return &emojis[84];
-			case 0x2699U: return &emojis[85];
-			case 0x269BU: return &emojis[86];
-			case 0x269CU: return &emojis[87];
-			case 0x26A0U: return &emojis[88];
-			case 0x26A1U: return &emojis[89];
-			case 0x26AAU: return &emojis[90];
-			case 0x26ABU: return &emojis[91];
-			case 0x26B0U: return &emojis[92];
-			case 0x26B1U: return &emojis[93];
-			case 0x26BDU: return &emojis[94];
-			case 0x26BEU: return &emojis[95];
-			case 0x26C4U: return &emojis[96];
-			case 0x26C5U: return &emojis[97];
-			case 0x26C8U: return &emojis[98];
-			case 0x26CEU: return &emojis[99];
-			case 0x26CFU: return &emojis[100];
-			case 0x26D1U: return &emojis[101];
-			case 0x26D3U: return &emojis[102];
-			case 0x26D4U: return &emojis[103];
-			case 0x26E9U: return &emojis[104];
-			case 0x26EAU: return &emojis[105];
-			case 0x26F0U: return &emojis[106];
-			case 0x26F1U: return &emojis[107];
-			case 0x26F2U: return &emojis[108];
-			case 0x26F3U: return &emojis[109];
-			case 0x26F4U: return &emojis[110];
-			case 0x26F5U: return &emojis[111];
-			case 0x26F7U: return &emojis[112];
-			case 0x26F8U: return &emojis[113];
-			case 0x26F9U: return &emojis[114];
-			case 0x26FAU: return &emojis[115];
-			case 0x26FDU: return &emojis[116];
-			case 0x2702U: return &emojis[117];
-			case 0x2705U: return &emojis[118];
-			case 0x2708U: return &emojis[119];
-			case 0x2709U: return &emojis[120];
-			case 0x270AU: return &emojis[121];
-			case 0x270BU: return &emojis[122];
-			case 0x270CU: return &emojis[123];
-			case 0x270DU: return &emojis[124];
-			case 0x270FU: return &emojis[125];
-			case 0x2712U: return &emojis[126];
-			case 0x2714U: return &emojis[127];
-			case 0x2716U: return &emojis[128];
-			case 0x271DU: return &emojis[129];
-			case 0x2721U: return &emojis[130];
-			case 0x2728U: return &emojis[131];
-			case 0x2733U: return &emojis[132];
-			case 0x2734U: return &emojis[133];
-			case 0x2744U: return &emojis[134];
-			case 0x2747U: return &emojis[135];
-			case 0x274CU: return &emojis[136];
-			case 0x274EU: return &emojis[137];
-			case 0x2753U: return &emojis[138];
-			case 0x2754U: return &emojis[139];
-			case 0x2755U: return &emojis[140];
-			case 0x2757U: return &emojis[141];
-			case 0x2763U: return &emojis[142];
-			case 0x2764U: return &emojis[143];
-			case 0x2795U: return &emojis[144];
-			case 0x2796U: return &emojis[145];
-			case 0x2797U: return &emojis[146];
-			case 0x27A1U: return &emojis[147];
-			case 0x27B0U: return &emojis[148];
-			case 0x27BFU: return &emojis[149];
-			case 0x2934U: return &emojis[150];
-			case 0x2935U: return &emojis[151];
-			case 0x2B05U: return &emojis[152];
-			case 0x2B06U: return &emojis[153];
-			case 0x2B07U: return &emojis[154];
-			case 0x2B1BU: return &emojis[155];
-			case 0x2B1CU: return &emojis[156];
-			case 0x2B50U: return &emojis[157];
-			case 0x2B55U: return &emojis[158];
-			case 0x3030U: return &emojis[159];
-			case 0x303DU: return &emojis[160];
-			case 0x3297U: return &emojis[161];
-			case 0x3299U: return &emojis[162];
-		}
+constexpr EmojiCodeEntry emojiCodes[] = {
+	{ 0xA9U, 0 },
+	{ 0xAEU, 1 },
+	{ 0x203CU, 2 },
+	{ 0x2049U, 3 },
+	{ 0x2122U, 4 },
+	{ 0x2139U, 5 },
+	{ 0x2194U, 6 },
+	{ 0x2195U, 7 },
+	{ 0x2196U, 8 },
+	{ 0x2197U, 9 },
+	{ 0x2198U, 10 },
+	{ 0x2199U, 11 },
+	{ 0x21A9U, 12 },
+	{ 0x21AAU, 13 },
+	{ 0x231AU, 14 },
+	{ 0x231BU, 15 },
+	{ 0x2328U, 16 },
+	{ 0x23E9U, 17 },
+	{ 0x23EAU, 18 },
+	{ 0x23EBU, 19 },
+	{ 0x23ECU, 20 },
+	{ 0x23EDU, 21 },
+	{ 0x23EEU, 22 },
+	{ 0x23EFU, 23 },
+	{ 0x23F0U, 24 },
+	{ 0x23F1U, 25 },
+	{ 0x23F2U, 26 },
+	{ 0x23F3U, 27 },
+	{ 0x23F8U, 28 },
+	{ 0x23F9U, 29 },
+	{ 0x23FAU, 30 },
+	{ 0x24C2U, 31 },
+	{ 0x25AAU, 32 },
+	{ 0x25ABU, 33 },
+	{ 0x25B6U, 34 },
+	{ 0x25C0U, 35 },
+	{ 0x25FBU, 36 },
+	{ 0x25FCU, 37 },
+	{ 0x25FDU, 38 },
+	{ 0x25FEU, 39 },
+	{ 0x2600U, 40 },
+	{ 0x2601U, 41 },
+	{ 0x2602U, 42 },
+	{ 0x2603U, 43 },
+	{ 0x2604U, 44 },
+	{ 0x260EU, 45 },
+	{ 0x2611U, 46 },
+	{ 0x2614U, 47 },
+	{ 0x2615U, 48 },
+	{ 0x2618U, 49 },
+	{ 0x261DU, 50 },
+	{ 0x2620U, 51 },
+	{ 0x2622U, 52 },
+	{ 0x2623U, 53 },
+	{ 0x2626U, 54 },
+	{ 0x262AU, 55 },
+	{ 0x262EU, 56 },
+	{ 0x262FU, 57 },
+	{ 0x2638U, 58 },
+	{ 0x2639U, 59 },
+	{ 0x263AU, 60 },
+	{ 0x2648U, 61 },
+	{ 0x2649U, 62 },
+	{ 0x264AU, 63 },
+	{ 0x264BU, 64 },
+	{ 0x264CU, 65 },
+	{ 0x264DU, 66 },
+	{ 0x264EU, 67 },
+	{ 0x264FU, 68 },
+	{ 0x2650U, 69 },
+	{ 0x2651U, 70 },
+	{ 0x2652U, 71 },
+	{ 0x2653U, 72 },
+	{ 0x2660U, 73 },
+	{ 0x2663U, 74 },
+	{ 0x2665U, 75 },
+	{ 0x2666U, 76 },
+	{ 0x2668U, 77 },
+	{ 0x267BU, 78 },
+	{ 0x267FU, 79 },
+	{ 0x2692U, 80 },
+	{ 0x2693U, 81 },
+	{ 0x2694U, 82 },
+	{ 0x2696U, 83 },
+	{ 0x2697U, 84 },
+	{ 0x2699U, 85 },
+	{ 0x269BU, 86 },
+	{ 0x269CU, 87 },
+	{ 0x26A0U, 88 },
+	{ 0x26A1U, 89 },
+	{ 0x26AAU, 90 },
+	{ 0x26ABU, 91 },
+	{ 0x26B0U, 92 },
+	{ 0x26B1U, 93 },
+	{ 0x26BDU, 94 },
+	{ 0x26BEU, 95 },
+	{ 0x26C4U, 96 },
+	{ 0x26C5U, 97 },
+	{ 0x26C8U, 98 },
+	{ 0x26CEU, 99 },
+	{ 0x26CFU, 100 },
+	{ 0x26D1U, 101 },
+	{ 0x26D3U, 102 },
+	{ 0x26D4U, 103 },
+	{ 0x26E9U, 104 },
+	{ 0x26EAU, 105 },
+	{ 0x26F0U, 106 },
+	{ 0x26F1U, 107 },
+	{ 0x26F2U, 108 },
+	{ 0x26F3U, 109 },
+	{ 0x26F4U, 110 },
+	{ 0x26F5U, 111 },
+	{ 0x26F7U, 112 },
+	{ 0x26F8U, 113 },
+	{ 0x26F9U, 114 },
+	{ 0x26FAU, 115 },
+	{ 0x26FDU, 116 },
+	{ 0x2702U, 117 },
+	{ 0x2705U, 118 },
+	{ 0x2708U, 119 },
+	{ 0x2709U, 120 },
+	{ 0x270AU, 121 },
+	{ 0x270BU, 122 },
+	{ 0x270CU, 123 },
+	{ 0x270DU, 124 },
+	{ 0x270FU, 125 },
+	{ 0x2712U, 126 },
+	{ 0x2714U, 127 },
+	{ 0x2716U, 128 },
+	{ 0x271DU, 129 },
+	{ 0x2721U, 130 },
+	{ 0x2728U, 131 },
+	{ 0x2733U, 132 },
+	{ 0x2734U, 133 },
+	{ 0x2744U, 134 },
+	{ 0x2747U, 135 },
+	{ 0x274CU, 136 },
+	{ 0x274EU, 137 },
+	{ 0x2753U, 138 },
+	{ 0x2754U, 139 },
+	{ 0x2755U, 140 },
+	{ 0x2757U, 141 },
+	{ 0x2763U, 142 },
+	{ 0x2764U, 143 },
+	{ 0x2795U, 144 },
+	{ 0x2796U, 145 },
+	{ 0x2797U, 146 },
+	{ 0x27A1U, 147 },
+	{ 0x27B0U, 148 },
+	{ 0x27BFU, 149 },
+	{ 0x2934U, 150 },
+	{ 0x2935U, 151 },
+	{ 0x2B05U, 152 },
+	{ 0x2B06U, 153 },
+	{ 0x2B07U, 154 },
+	{ 0x2B1BU, 155 },
+	{ 0x2B1CU, 156 },
+	{ 0x2B50U, 157 },
+	{ 0x2B55U, 158 },
+	{ 0x3030U, 159 },
+	{ 0x303DU, 160 },
+	{ 0x3297U, 161 },
+	{ 0x3299U, 162 },
+	{ 0x2320E3U, 163 },
+	{ 0x2A20E3U, 164 },
+	{ 0x3020E3U, 165 },
+	{ 0x3120E3U, 166 },
+	{ 0x3220E3U, 167 },
+	{ 0x3320E3U, 168 },
+	{ 0x3420E3U, 169 },
+	{ 0x3520E3U, 170 },
+	{ 0x3620E3U, 171 },
+	{ 0x3720E3U, 172 },
+	{ 0x3820E3U, 173 },
+	{ 0x3920E3U, 174 },
+	{ 0xD83CDC04U, 175 },
+	{ 0xD83CDCCFU, 176 },
+	{ 0xD83CDD70U, 177 },
+	{ 0xD83CDD71U, 178 },
+	{ 0xD83CDD7EU, 179 },
+	{ 0xD83CDD7FU, 180 },
+	{ 0xD83CDD8EU, 181 },
+	{ 0xD83CDD91U, 182 },
+	{ 0xD83CDD92U, 183 },
+	{ 0xD83CDD93U, 184 },
+	{ 0xD83CDD94U, 185 },
+	{ 0xD83CDD95U, 186 },
+	{ 0xD83CDD96U, 187 },
+	{ 0xD83CDD97U, 188 },
+	{ 0xD83CDD98U, 189 },
+	{ 0xD83CDD99U, 190 },
+	{ 0xD83CDD9AU, 191 },
+	{ 0xD83CDDE6U, -1 },
+	{ 0xD83CDDE7U, -1 },
+	{ 0xD83CDDE8U, -1 },
+	{ 0xD83CDDE9U, -1 },
+	{ 0xD83CDDEAU, -1 },
+	{ 0xD83CDDEBU, -1 },
+	{ 0xD83CDDECU, -1 },
+	{ 0xD83CDDEDU, -1 },
+	{ 0xD83CDDEEU, -1 },
+	{ 0xD83CDDEFU, -1 },
+	{ 0xD83CDDF0U, -1 },
+	{ 0xD83CDDF1U, -1 },
+	{ 0xD83CDDF2U, -1 },
+	{ 0xD83CDDF3U, -1 },
+	{ 0xD83CDDF4U, -1 },
+	{ 0xD83CDDF5U, -1 },
+	{ 0xD83CDDF6U, -1 },
+	{ 0xD83CDDF7U, -1 },
+	{ 0xD83CDDF8U, -1 },
+	{ 0xD83CDDF9U, -1 },
+	{ 0xD83CDDFAU, -1 },
+	{ 0xD83CDDFBU, -1 },
+	{ 0xD83CDDFCU, -1 },
+	{ 0xD83CDDFDU, -1 },
+	{ 0xD83CDDFEU, -1 },
+	{ 0xD83CDDFFU, -1 },
+	{ 0xD83CDE01U, 192 },
+	{ 0xD83CDE02U, 193 },
+	{ 0xD83CDE1AU, 194 },
+	{ 0xD83CDE2FU, 195 },
+	{ 0xD83CDE32U, 196 },
+	{ 0xD83CDE33U, 197 },
+	{ 0xD83CDE34U, 198 },
+	{ 0xD83CDE35U, 199 },
+	{ 0xD83CDE36U, 200 },
+	{ 0xD83CDE37U, 201 },
+	{ 0xD83CDE38U, 202 },
+	{ 0xD83CDE39U, 203 },
+	{ 0xD83CDE3AU, 204 },
+	{ 0xD83CDE50U, 205 },
+	{ 0xD83CDE51U, 206 },
+	{ 0xD83CDF00U, 207 },
+	{ 0xD83CDF01U, 208 },
+	{ 0xD83CDF02U, 209 },
+	{ 0xD83CDF03U, 210 },
+	{ 0xD83CDF04U, 211 },
+	{ 0xD83CDF05U, 212 },
+	{ 0xD83CDF06U, 213 },
+	{ 0xD83CDF07U, 214 },
+	{ 0xD83CDF08U, 215 },
+	{ 0xD83CDF09U, 216 },
+	{ 0xD83CDF0AU, 217 },
+	{ 0xD83CDF0BU, 218 },
+	{ 0xD83CDF0CU, 219 },
+	{ 0xD83CDF0DU, 220 },
+	{ 0xD83CDF0EU, 221 },
+	{ 0xD83CDF0FU, 222 },
+	{ 0xD83CDF10U, 223 },
+	{ 0xD83CDF11U, 224 },
+	{ 0xD83CDF12U, 225 },
+	{ 0xD83CDF13U, 226 },
+	{ 0xD83CDF14U, 227 },
+	{ 0xD83CDF15U, 228 },
+	{ 0xD83CDF16U, 229 },
+	{ 0xD83CDF17U, 230 },
+	{ 0xD83CDF18U, 231 },
+	{ 0xD83CDF19U, 232 },
+	{ 0xD83CDF1AU, 233 },
+	{ 0xD83CDF1BU, 234 },
+	{ 0xD83CDF1CU, 235 },
+	{ 0xD83CDF1DU, 236 },
+	{ 0xD83CDF1EU, 237 },
+	{ 0xD83CDF1FU, 238 },
+	{ 0xD83CDF20U, 239 },
+	{ 0xD83CDF21U, 240 },
+	{ 0xD83CDF24U, 241 },
+	{ 0xD83CDF25U, 242 },
+	{ 0xD83CDF26U, 243 },
+	{ 0xD83CDF27U, 244 },
+	{ 0xD83CDF28U, 245 },
+	{ 0xD83CDF29U, 246 },
+	{ 0xD83CDF2AU, 247 },
+	{ 0xD83CDF2BU, 248 },
+	{ 0xD83CDF2CU, 249 },
+	{ 0xD83CDF2DU, 250 },
+	{ 0xD83CDF2EU, 251 },
+	{ 0xD83CDF2FU, 252 },
+	{ 0xD83CDF30U, 253 },
+	{ 0xD83CDF31U, 254 },
+	{ 0xD83CDF32U, 255 },
+	{ 0xD83CDF33U, 256 },
+	{ 0xD83CDF34U, 257 },
+	{ 0xD83CDF35U, 258 },
+	{ 0xD83CDF36U, 259 },
+	{ 0xD83CDF37U, 260 },
+	{ 0xD83CDF38U, 261 },
+	{ 0xD83CDF39U, 262 },
+	{ 0xD83CDF3AU, 263 },
+	{ 0xD83CDF3BU, 264 },
+	{ 0xD83CDF3CU, 265 },
+	{ 0xD83CDF3DU, 266 },
+	{ 0xD83CDF3EU, 267 },
+	{ 0xD83CDF3FU, 268 },
+	{ 0xD83CDF40U, 269 },
+	{ 0xD83CDF41U, 270 },
+	{ 0xD83CDF42U, 271 },
+	{ 0xD83CDF43U, 272 },
+	{ 0xD83CDF44U, 273 },
+	{ 0xD83CDF45U, 274 },
+	{ 0xD83CDF46U, 275 },
+	{ 0xD83CDF47U, 276 },
+	{ 0xD83CDF48U, 277 },
+	{ 0xD83CDF49U, 278 },
+	{ 0xD83CDF4AU, 279 },
+	{ 0xD83CDF4BU, 280 },
+	{ 0xD83CDF4CU, 281 },
+	{ 0xD83CDF4DU, 282 },
+	{ 0xD83CDF4EU, 283 },
+	{ 0xD83CDF4FU, 284 },
+	{ 0xD83CDF50U, 285 },
+	{ 0xD83CDF51U, 286 },
+	{ 0xD83CDF52U, 287 },
+	{ 0xD83CDF53U, 288 },
+	{ 0xD83CDF54U, 289 },
+	{ 0xD83CDF55U, 290 },
+	{ 0xD83CDF56U, 291 },
+	{ 0xD83CDF57U, 292 },
+	{ 0xD83CDF58U, 293 },
+	{ 0xD83CDF59U, 294 },
+	{ 0xD83CDF5AU, 295 },
+	{ 0xD83CDF5BU, 296 },
+	{ 0xD83CDF5CU, 297 },
+	{ 0xD83CDF5DU, 298 },
+	{ 0xD83CDF5EU, 299 },
+	{ 0xD83CDF5FU, 300 },
+	{ 0xD83CDF60U, 301 },
+	{ 0xD83CDF61U, 302 },
+	{ 0xD83CDF62U, 303 },
+	{ 0xD83CDF63U, 304 },
+	{ 0xD83CDF64U, 305 },
+	{ 0xD83CDF65U, 306 },
+	{ 0xD83CDF66U, 307 },
+	{ 0xD83CDF67U, 308 },
+	{ 0xD83CDF68U, 309 },
+	{ 0xD83CDF69U, 310 },
+	{ 0xD83CDF6AU, 311 },
+	{ 0xD83CDF6BU, 312 },
+	{ 0xD83CDF6CU, 313 },
+	{ 0xD83CDF6DU, 314 },
+	{ 0xD83CDF6EU, 315 },
+	{ 0xD83CDF6FU, 316 },
+	{ 0xD83CDF70U, 317 },
+	{ 0xD83CDF71U, 318 },
+	{ 0xD83CDF72U, 319 },
+	{ 0xD83CDF73U, 320 },
+	{ 0xD83CDF74U, 321 },
+	{ 0xD83CDF75U, 322 },
+	{ 0xD83CDF76U, 323 },
+	{ 0xD83CDF77U, 324 },
+	{ 0xD83CDF78U, 325 },
+	{ 0xD83CDF79U, 326 },
+	{ 0xD83CDF7AU, 327 },
+	{ 0xD83CDF7BU, 328 },
+	{ 0xD83CDF7CU, 329 },
+	{ 0xD83CDF7DU, 330 },
+	{ 0xD83CDF7EU, 331 },
+	{ 0xD83CDF7FU, 332 },
+	{ 0xD83CDF80U, 333 },
+	{ 0xD83CDF81U, 334 },
+	{ 0xD83CDF82U, 335 },
+	{ 0xD83CDF83U, 336 },
+	{ 0xD83CDF84U, 337 },
+	{ 0xD83CDF85U, 338 },
+	{ 0xD83CDF86U, 339 },
+	{ 0xD83CDF87U, 340 },
+	{ 0xD83CDF88U, 341 },
+	{ 0xD83CDF89U, 342 },
+	{ 0xD83CDF8AU, 343 },
+	{ 0xD83CDF8BU, 344 },
+	{ 0xD83CDF8CU, 345 },
+	{ 0xD83CDF8DU, 346 },
+	{ 0xD83CDF8EU, 347 },
+	{ 0xD83CDF8FU, 348 },
+	{ 0xD83CDF90U, 349 },
+	{ 0xD83CDF91U, 350 },
+	{ 0xD83CDF92U, 351 },
+	{ 0xD83CDF93U, 352 },
+	{ 0xD83CDF96U, 353 },
+	{ 0xD83CDF97U, 354 },
+	{ 0xD83CDF99U, 355 },
+	{ 0xD83CDF9AU, 356 },
+	{ 0xD83CDF9BU, 357 },
+	{ 0xD83CDF9EU, 358 },
+	{ 0xD83CDF9FU, 359 },
+	{ 0xD83CDFA0U, 360 },
+	{ 0xD83CDFA1U, 361 },
+	{ 0xD83CDFA2U, 362 },
+	{ 0xD83CDFA3U, 363 },
+	{ 0xD83CDFA4U, 364 },
+	{ 0xD83CDFA5U, 365 },
+	{ 0xD83CDFA6U, 366 },
+	{ 0xD83CDFA7U, 367 },
+	{ 0xD83CDFA8U, 368 },
+	{ 0xD83CDFA9U, 369 },
+	{ 0xD83CDFAAU, 370 },
+	{ 0xD83CDFABU, 371 },
+	{ 0xD83CDFACU, 372 },
+	{ 0xD83CDFADU, 373 },
+	{ 0xD83CDFAEU, 374 },
+	{ 0xD83CDFAFU, 375 },
+	{ 0xD83CDFB0U, 376 },
+	{ 0xD83CDFB1U, 377 },
+	{ 0xD83CDFB2U, 378 },
+	{ 0xD83CDFB3U, 379 },
+	{ 0xD83CDFB4U, 380 },
+	{ 0xD83CDFB5U, 381 },
+	{ 0xD83CDFB6U, 382 },
+	{ 0xD83CDFB7U, 383 },
+	{ 0xD83CDFB8U, 384 },
+	{ 0xD83CDFB9U, 385 },
+	{ 0xD83CDFBAU, 386 },
+	{ 0xD83CDFBBU, 387 },
+	{ 0xD83CDFBCU, 388 },
+	{ 0xD83CDFBDU, 389 },
+	{ 0xD83CDFBEU, 390 },
+	{ 0xD83CDFBFU, 391 },
+	{ 0xD83CDFC0U, 392 },
+	{ 0xD83CDFC1U, 393 },
+	{ 0xD83CDFC2U, 394 },
+	{ 0xD83CDFC3U, 395 },
+	{ 0xD83CDFC4U, 396 },
+	{ 0xD83CDFC5U, 397 },
+	{ 0xD83CDFC6U, 398 },
+	{ 0xD83CDFC7U, 399 },
+	{ 0xD83CDFC8U, 400 },
+	{ 0xD83CDFC9U, 401 },
+	{ 0xD83CDFCAU, 402 },
+	{ 0xD83CDFCBU, 403 },
+	{ 0xD83CDFCCU, 404 },
+	{ 0xD83CDFCDU, 405 },
+	{ 0xD83CDFCEU, 406 },
+	{ 0xD83CDFCFU, 407 },
+	{ 0xD83CDFD0U, 408 },
+	{ 0xD83CDFD1U, 409 },
+	{ 0xD83CDFD2U, 410 },
+	{ 0xD83CDFD3U, 411 },
+	{ 0xD83CDFD4U, 412 },
+	{ 0xD83CDFD5U, 413 },
+	{ 0xD83CDFD6U, 414 },
+	{ 0xD83CDFD7U, 415 },
+	{ 0xD83CDFD8U, 416 },
+	{ 0xD83CDFD9U, 417 },
+	{ 0xD83CDFDAU, 418 },
+	{ 0xD83CDFDBU, 419 },
+	{ 0xD83CDFDCU, 420 },
+	{ 0xD83CDFDDU, 421 },
+	{ 0xD83CDFDEU, 422 },
+	{ 0xD83CDFDFU, 423 },
+	{ 0xD83CDFE0U, 424 },
+	{ 0xD83CDFE1U, 425 },
+	{ 0xD83CDFE2U, 426 },
+	{ 0xD83CDFE3U, 427 },
+	{ 0xD83CDFE4U, 428 },
+	{ 0xD83CDFE5U, 429 },
+	{ 0xD83CDFE6U, 430 },
+	{ 0xD83CDFE7U, 431 },
+	{ 0xD83CDFE8U, 432 },
+	{ 0xD83CDFE9U, 433 },
+	{ 0xD83CDFEAU, 434 },
+	{ 0xD83CDFEBU, 435 },
+	{ 0xD83CDFECU, 436 },
+	{ 0xD83CDFEDU, 437 },
+	{ 0xD83CDFEEU, 438 },
+	{ 0xD83CDFEFU, 439 },
+	{ 0xD83CDFF0U, 440 },
+	{ 0xD83CDFF3U, 441 },
+	{ 0xD83CDFF4U, 442 },
+	{ 0xD83CDFF5U, 443 },
+	{ 0xD83CDFF7U, 444 },
+	{ 0xD83CDFF8U, 445 },
+	{ 0xD83CDFF9U, 446 },
+	{ 0xD83CDFFAU, 447 },
+	{ 0xD83DDC00U, 448 },
+	{ 0xD83DDC01U, 449 },
+	{ 0xD83DDC02U, 450 },
+	{ 0xD83DDC03U, 451 },
+	{ 0xD83DDC04U, 452 },
+	{ 0xD83DDC05U, 453 },
+	{ 0xD83DDC06U, 454 },
+	{ 0xD83DDC07U, 455 },
+	{ 0xD83DDC08U, 456 },
+	{ 0xD83DDC09U, 457 },
+	{ 0xD83DDC0AU, 458 },
+	{ 0xD83DDC0BU, 459 },
+	{ 0xD83DDC0CU, 460 },
+	{ 0xD83DDC0DU, 461 },
+	{ 0xD83DDC0EU, 462 },
+	{ 0xD83DDC0FU, 463 },
+	{ 0xD83DDC10U, 464 },
+	{ 0xD83DDC11U, 465 },
+	{ 0xD83DDC12U, 466 },
+	{ 0xD83DDC13U, 467 },
+	{ 0xD83DDC14U, 468 },
+	{ 0xD83DDC15U, 469 },
+	{ 0xD83DDC16U, 470 },
+	{ 0xD83DDC17U, 471 },
+	{ 0xD83DDC18U, 472 },
+	{ 0xD83DDC19U, 473 },
+	{ 0xD83DDC1AU, 474 },
+	{ 0xD83DDC1BU, 475 },
+	{ 0xD83DDC1CU, 476 },
+	{ 0xD83DDC1DU, 477 },
+	{ 0xD83DDC1EU, 478 },
+	{ 0xD83DDC1FU, 479 },
+	{ 0xD83DDC20U, 480 },
+	{ 0xD83DDC21U, 481 },
+	{ 0xD83DDC22U, 482 },
+	{ 0xD83DDC23U, 483 },
+	{ 0xD83DDC24U, 484 },
+	{ 0xD83DDC25U, 485 },
+	{ 0xD83DDC26U, 486 },
+	{ 0xD83DDC27U, 487 },
+	{ 0xD83DDC28U, 488 },
+	{ 0xD83DDC29U, 489 },
+	{ 0xD83DDC2AU, 490 },
+	{ 0xD83DDC2BU, 491 },
+	{ 0xD83DDC2CU, 492 },
+	{ 0xD83DDC2DU, 493 },
+	{ 0xD83DDC2EU, 494 },
+	{ 0xD83DDC2FU, 495 },
+	{ 0xD83DDC30U, 496 },
+	{ 0xD83DDC31U, 497 },
+	{ 0xD83DDC32U, 498 },
+	{ 0xD83DDC33U, 499 },
+	{ 0xD83DDC34U, 500 },
+	{ 0xD83DDC35U, 501 },
+	{ 0xD83DDC36U, 502 },
+	{ 0xD83DDC37U, 503 },
+	{ 0xD83DDC38U, 504 },
+	{ 0xD83DDC39U, 505 },
+	{ 0xD83DDC3AU, 506 },
+	{ 0xD83DDC3BU, 507 },
+	{ 0xD83DDC3CU, 508 },
+	{ 0xD83DDC3DU, 509 },
+	{ 0xD83DDC3EU, 510 },
+	{ 0xD83DDC3FU, 511 },
+	{ 0xD83DDC40U, 512 },
+	{ 0xD83DDC41U, 513 },
+	{ 0xD83DDC42U, 514 },
+	{ 0xD83DDC43U, 515 },
+	{ 0xD83DDC44U, 516 },
+	{ 0xD83DDC45U, 517 },
+	{ 0xD83DDC46U, 518 },
+	{ 0xD83DDC47U, 519 },
+	{ 0xD83DDC48U, 520 },
+	{ 0xD83DDC49U, 521 },
+	{ 0xD83DDC4AU, 522 },
+	{ 0xD83DDC4BU, 523 },
+	{ 0xD83DDC4CU, 524 },
+	{ 0xD83DDC4DU, 525 },
+	{ 0xD83DDC4EU, 526 },
+	{ 0xD83DDC4FU, 527 },
+	{ 0xD83DDC50U, 528 },
+	{ 0xD83DDC51U, 529 },
+	{ 0xD83DDC52U, 530 },
+	{ 0xD83DDC53U, 531 },
+	{ 0xD83DDC54U, 532 },
+	{ 0xD83DDC55U, 533 },
+	{ 0xD83DDC56U, 534 },
+	{ 0xD83DDC57U, 535 },
+	{ 0xD83DDC58U, 536 },
+	{ 0xD83DDC59U, 537 },
+	{ 0xD83DDC5AU, 538 },
+	{ 0xD83DDC5BU, 539 },
+	{ 0xD83DDC5CU, 540 },
+	{ 0xD83DDC5DU, 541 },
+	{ 0xD83DDC5EU, 542 },
+	{ 0xD83DDC5FU, 543 },
+	{ 0xD83DDC60U, 544 },
+	{ 0xD83DDC61U, 545 },
+	{ 0xD83DDC62U, 546 },
+	{ 0xD83DDC63U, 547 },
+	{ 0xD83DDC64U, 548 },
+	{ 0xD83DDC65U, 549 },
+	{ 0xD83DDC66U, 550 },
+	{ 0xD83DDC67U, 551 },
+	{ 0xD83DDC68U, 552 },
+	{ 0xD83DDC69U, 553 },
+	{ 0xD83DDC6AU, 554 },
+	{ 0xD83DDC6BU, 555 },
+	{ 0xD83DDC6CU, 556 },
+	{ 0xD83DDC6DU, 557 },
+	{ 0xD83DDC6EU, 558 },
+	{ 0xD83DDC6FU, 559 },
+	{ 0xD83DDC70U, 560 },
+	{ 0xD83DDC71U, 561 },
+	{ 0xD83DDC72U, 562 },
+	{ 0xD83DDC73U, 563 },
+	{ 0xD83DDC74U, 564 },
+	{ 0xD83DDC75U, 565 },
+	{ 0xD83DDC76U, 566 },
+	{ 0xD83DDC77U, 567 },
+	{ 0xD83DDC78U, 568 },
+	{ 0xD83DDC79U, 569 },
+	{ 0xD83DDC7AU, 570 },
+	{ 0xD83DDC7BU, 571 },
+	{ 0xD83DDC7CU, 572 },
+	{ 0xD83DDC7DU, 573 },
+	{ 0xD83DDC7EU, 574 },
+	{ 0xD83DDC7FU, 575 },
+	{ 0xD83DDC80U, 576 },
+	{ 0xD83DDC81U, 577 },
+	{ 0xD83DDC82U, 578 },
+	{ 0xD83DDC83U, 579 },
+	{ 0xD83DDC84U, 580 },
+	{ 0xD83DDC85U, 581 },
+	{ 0xD83DDC86U, 582 },
+	{ 0xD83DDC87U, 583 },
+	{ 0xD83DDC88U, 584 },
+	{ 0xD83DDC89U, 585 },
+	{ 0xD83DDC8AU, 586 },
+	{ 0xD83DDC8BU, 587 },
+	{ 0xD83DDC8CU, 588 },
+	{ 0xD83DDC8DU, 589 },
+	{ 0xD83DDC8EU, 590 },
+	{ 0xD83DDC8FU, 591 },
+	{ 0xD83DDC90U, 592 },
+	{ 0xD83DDC91U, 593 },
+	{ 0xD83DDC92U, 594 },
+	{ 0xD83DDC93U, 595 },
+	{ 0xD83DDC94U, 596 },
+	{ 0xD83DDC95U, 597 },
+	{ 0xD83DDC96U, 598 },
+	{ 0xD83DDC97U, 599 },
+	{ 0xD83DDC98U, 600 },
+	{ 0xD83DDC99U, 601 },
+	{ 0xD83DDC9AU, 602 },
+	{ 0xD83DDC9BU, 603 },
+	{ 0xD83DDC9CU, 604 },
+	{ 0xD83DDC9DU, 605 },
+	{ 0xD83DDC9EU, 606 },
+	{ 0xD83DDC9FU, 607 },
+	{ 0xD83DDCA0U, 608 },
+	{ 0xD83DDCA1U, 609 },
+	{ 0xD83DDCA2U, 610 },
+	{ 0xD83DDCA3U, 611 },
+	{ 0xD83DDCA4U, 612 },
+	{ 0xD83DDCA5U, 613 },
+	{ 0xD83DDCA6U, 614 },
+	{ 0xD83DDCA7U, 615 },
+	{ 0xD83DDCA8U, 616 },
+	{ 0xD83DDCA9U, 617 },
+	{ 0xD83DDCAAU, 618 },
+	{ 0xD83DDCABU, 619 },
+	{ 0xD83DDCACU, 620 },
+	{ 0xD83DDCADU, 621 },
+	{ 0xD83DDCAEU, 622 },
+	{ 0xD83DDCAFU, 623 },
+	{ 0xD83DDCB0U, 624 },
+	{ 0xD83DDCB1U, 625 },
+	{ 0xD83DDCB2U, 626 },
+	{ 0xD83DDCB3U, 627 },
+	{ 0xD83DDCB4U, 628 },
+	{ 0xD83DDCB5U, 629 },
+	{ 0xD83DDCB6U, 630 },
+	{ 0xD83DDCB7U, 631 },
+	{ 0xD83DDCB8U, 632 },
+	{ 0xD83DDCB9U, 633 },
+	{ 0xD83DDCBAU, 634 },
+	{ 0xD83DDCBBU, 635 },
+	{ 0xD83DDCBCU, 636 },
+	{ 0xD83DDCBDU, 637 },
+	{ 0xD83DDCBEU, 638 },
+	{ 0xD83DDCBFU, 639 },
+	{ 0xD83DDCC0U, 640 },
+	{ 0xD83DDCC1U, 641 },
+	{ 0xD83DDCC2U, 642 },
+	{ 0xD83DDCC3U, 643 },
+	{ 0xD83DDCC4U, 644 },
+	{ 0xD83DDCC5U, 645 },
+	{ 0xD83DDCC6U, 646 },
+	{ 0xD83DDCC7U, 647 },
+	{ 0xD83DDCC8U, 648 },
+	{ 0xD83DDCC9U, 649 },
+	{ 0xD83DDCCAU, 650 },
+	{ 0xD83DDCCBU, 651 },
+	{ 0xD83DDCCCU, 652 },
+	{ 0xD83DDCCDU, 653 },
+	{ 0xD83DDCCEU, 654 },
+	{ 0xD83DDCCFU, 655 },
+	{ 0xD83DDCD0U, 656 },
+	{ 0xD83DDCD1U, 657 },
+	{ 0xD83DDCD2U, 658 },
+	{ 0xD83DDCD3U, 659 },
+	{ 0xD83DDCD4U, 660 },
+	{ 0xD83DDCD5U, 661 },
+	{ 0xD83DDCD6U, 662 },
+	{ 0xD83DDCD7U, 663 },
+	{ 0xD83DDCD8U, 664 },
+	{ 0xD83DDCD9U, 665 },
+	{ 0xD83DDCDAU, 666 },
+	{ 0xD83DDCDBU, 667 },
+	{ 0xD83DDCDCU, 668 },
+	{ 0xD83DDCDDU, 669 },
+	{ 0xD83DDCDEU, 670 },
+	{ 0xD83DDCDFU, 671 },
+	{ 0xD83DDCE0U, 672 },
+	{ 0xD83DDCE1U, 673 },
+	{ 0xD83DDCE2U, 674 },
+	{ 0xD83DDCE3U, 675 },
+	{ 0xD83DDCE4U, 676 },
+	{ 0xD83DDCE5U, 677 },
+	{ 0xD83DDCE6U, 678 },
+	{ 0xD83DDCE7U, 679 },
+	{ 0xD83DDCE8U, 680 },
+	{ 0xD83DDCE9U, 681 },
+	{ 0xD83DDCEAU, 682 },
+	{ 0xD83DDCEBU, 683 },
+	{ 0xD83DDCECU, 684 },
+	{ 0xD83DDCEDU, 685 },
+	{ 0xD83DDCEEU, 686 },
+	{ 0xD83DDCEFU, 687 },
+	{ 0xD83DDCF0U, 688 },
+	{ 0xD83DDCF1U, 689 },
+	{ 0xD83DDCF2U, 690 },
+	{ 0xD83DDCF3U, 691 },
+	{ 0xD83DDCF4U, 692 },
+	{ 0xD83DDCF5U, 693 },
+	{ 0xD83DDCF6U, 694 },
+	{ 0xD83DDCF7U, 695 },
+	{ 0xD83DDCF8U, 696 },
+	{ 0xD83DDCF9U, 697 },
+	{ 0xD83DDCFAU, 698 },
+	{ 0xD83DDCFBU, 699 },
+	{ 0xD83DDCFCU, 700 },
+	{ 0xD83DDCFDU, 701 },
+	{ 0xD83DDCFFU, 702 },
+	{ 0xD83DDD00U, 703 },
+	{ 0xD83DDD01U, 704 },
+	{ 0xD83DDD02U, 705 },
+	{ 0xD83DDD03U, 706 },
+	{ 0xD83DDD04U, 707 },
+	{ 0xD83DDD05U, 708 },
+	{ 0xD83DDD06U, 709 },
+	{ 0xD83DDD07U, 710 },
+	{ 0xD83DDD08U, 711 },
+	{ 0xD83DDD09U, 712 },
+	{ 0xD83DDD0AU, 713 },
+	{ 0xD83DDD0BU, 714 },
+	{ 0xD83DDD0CU, 715 },
+	{ 0xD83DDD0DU, 716 },
+	{ 0xD83DDD0EU, 717 },
+	{ 0xD83DDD0FU, 718 },
+	{ 0xD83DDD10U, 719 },
+	{ 0xD83DDD11U, 720 },
+	{ 0xD83DDD12U, 721 },
+	{ 0xD83DDD13U, 722 },
+	{ 0xD83DDD14U, 723 },
+	{ 0xD83DDD15U, 724 },
+	{ 0xD83DDD16U, 725 },
+	{ 0xD83DDD17U, 726 },
+	{ 0xD83DDD18U, 727 },
+	{ 0xD83DDD19U, 728 },
+	{ 0xD83DDD1AU, 729 },
+	{ 0xD83DDD1BU, 730 },
+	{ 0xD83DDD1CU, 731 },
+	{ 0xD83DDD1DU, 732 },
+	{ 0xD83DDD1EU, 733 },
+	{ 0xD83DDD1FU, 734 },
+	{ 0xD83DDD20U, 735 },
+	{ 0xD83DDD21U, 736 },
+	{ 0xD83DDD22U, 737 },
+	{ 0xD83DDD23U, 738 },
+	{ 0xD83DDD24U, 739 },
+	{ 0xD83DDD25U, 740 },
+	{ 0xD83DDD26U, 741 },
+	{ 0xD83DDD27U, 742 },
+	{ 0xD83DDD28U, 743 },
+	{ 0xD83DDD29U, 744 },
+	{ 0xD83DDD2AU, 745 },
+	{ 0xD83DDD2BU, 746 },
+	{ 0xD83DDD2CU, 747 },
+	{ 0xD83DDD2DU, 748 },
+	{ 0xD83DDD2EU, 749 },
+	{ 0xD83DDD2FU, 750 },
+	{ 0xD83DDD30U, 751 },
+	{ 0xD83DDD31U, 752 },
+	{ 0xD83DDD32U, 753 },
+	{ 0xD83DDD33U, 754 },
+	{ 0xD83DDD34U, 755 },
+	{ 0xD83DDD35U, 756 },
+	{ 0xD83DDD36U, 757 },
+	{ 0xD83DDD37U, 758 },
+	{ 0xD83DDD38U, 759 },
+	{ 0xD83DDD39U, 760 },
+	{ 0xD83DDD3AU, 761 },
+	{ 0xD83DDD3BU, 762 },
+	{ 0xD83DDD3CU, 763 },
+	{ 0xD83DDD3DU, 764 },
+	{ 0xD83DDD49U, 765 },
+	{ 0xD83DDD4AU, 766 },
+	{ 0xD83DDD4BU, 767 },
+	{ 0xD83DDD4CU, 768 },
+	{ 0xD83DDD4DU, 769 },
+	{ 0xD83DDD4EU, 770 },
+	{ 0xD83DDD50U, 771 },
+	{ 0xD83DDD51U, 772 },
+	{ 0xD83DDD52U, 773 },
+	{ 0xD83DDD53U, 774 },
+	{ 0xD83DDD54U, 775 },
+	{ 0xD83DDD55U, 776 },
+	{ 0xD83DDD56U, 777 },
+	{ 0xD83DDD57U, 778 },
+	{ 0xD83DDD58U, 779 },
+	{ 0xD83DDD59U, 780 },
+	{ 0xD83DDD5AU, 781 },
+	{ 0xD83DDD5BU, 782 },
+	{ 0xD83DDD5CU, 783 },
+	{ 0xD83DDD5DU, 784 },
+	{ 0xD83DDD5EU, 785 },
+	{ 0xD83DDD5FU, 786 },
+	{ 0xD83DDD60U, 787 },
+	{ 0xD83DDD61U, 788 },
+	{ 0xD83DDD62U, 789 },
+	{ 0xD83DDD63U, 790 },
+	{ 0xD83DDD64U, 791 },
+	{ 0xD83DDD65U, 792 },
+	{ 0xD83DDD66U, 793 },
+	{ 0xD83DDD67U, 794 },
+	{ 0xD83DDD6FU, 795 },
+	{ 0xD83DDD70U, 796 },
+	{ 0xD83DDD73U, 797 },
+	{ 0xD83DDD74U, 798 },
+	{ 0xD83DDD75U, 799 },
+	{ 0xD83DDD76U, 800 },
+	{ 0xD83DDD77U, 801 },
+	{ 0xD83DDD78U, 802 },
+	{ 0xD83DDD79U, 803 },
+	{ 0xD83DDD87U, 804 },
+	{ 0xD83DDD8AU, 805 },
+	{ 0xD83DDD8BU, 806 },
+	{ 0xD83DDD8CU, 807 },
+	{ 0xD83DDD8DU, 808 },
+	{ 0xD83DDD90U, 809 },
+	{ 0xD83DDD95U, 810 },
+	{ 0xD83DDD96U, 811 },
+	{ 0xD83DDDA5U, 812 },
+	{ 0xD83DDDA8U, 813 },
+	{ 0xD83DDDB1U, 814 },
+	{ 0xD83DDDB2U, 815 },
+	{ 0xD83DDDBCU, 816 },
+	{ 0xD83DDDC2U, 817 },
+	{ 0xD83DDDC3U, 818 },
+	{ 0xD83DDDC4U, 819 },
+	{ 0xD83DDDD1U, 820 },
+	{ 0xD83DDDD2U, 821 },
+	{ 0xD83DDDD3U, 822 },
+	{ 0xD83DDDDCU, 823 },
+	{ 0xD83DDDDDU, 824 },
+	{ 0xD83DDDDEU, 825 },
+	{ 0xD83DDDE1U, 826 },
+	{ 0xD83DDDE3U, 827 },
+	{ 0xD83DDDEFU, 828 },
+	{ 0xD83DDDF3U, 829 },
+	{ 0xD83DDDFAU, 830 },
+	{ 0xD83DDDFBU, 831 },
+	{ 0xD83DDDFCU, 832 },
+	{ 0xD83DDDFDU, 833 },
+	{ 0xD83DDDFEU, 834 },
+	{ 0xD83DDDFFU, 835 },
+	{ 0xD83DDE00U, 836 },
+	{ 0xD83DDE01U, 837 },
+	{ 0xD83DDE02U, 838 },
+	{ 0xD83DDE03U, 839 },
+	{ 0xD83DDE04U, 840 },
+	{ 0xD83DDE05U, 841 },
+	{ 0xD83DDE06U, 842 },
+	{ 0xD83DDE07U, 843 },
+	{ 0xD83DDE08U, 844 },
+	{ 0xD83DDE09U, 845 },
+	{ 0xD83DDE0AU, 846 },
+	{ 0xD83DDE0BU, 847 },
+	{ 0xD83DDE0CU, 848 },
+	{ 0xD83DDE0DU, 849 },
+	{ 0xD83DDE0EU, 850 },
+	{ 0xD83DDE0FU, 851 },
+	{ 0xD83DDE10U, 852 },
+	{ 0xD83DDE11U, 853 },
+	{ 0xD83DDE12U, 854 },
+	{ 0xD83DDE13U, 855 },
+	{ 0xD83DDE14U, 856 },
+	{ 0xD83DDE15U, 857 },
+	{ 0xD83DDE16U, 858 },
+	{ 0xD83DDE17U, 859 },
+	{ 0xD83DDE18U, 860 },
+	{ 0xD83DDE19U, 861 },
+	{ 0xD83DDE1AU, 862 },
+	{ 0xD83DDE1BU, 863 },
+	{ 0xD83DDE1CU, 864 },
+	{ 0xD83DDE1DU, 865 },
+	{ 0xD83DDE1EU, 866 },
+	{ 0xD83DDE1FU, 867 },
+	{ 0xD83DDE20U, 868 },
+	{ 0xD83DDE21U, 869 },
+	{ 0xD83DDE22U, 870 },
+	{ 0xD83DDE23U, 871 },
+	{ 0xD83DDE24U, 872 },
+	{ 0xD83DDE25U, 873 },
+	{ 0xD83DDE26U, 874 },
+	{ 0xD83DDE27U, 875 },
+	{ 0xD83DDE28U, 876 },
+	{ 0xD83DDE29U, 877 },
+	{ 0xD83DDE2AU, 878 },
+	{ 0xD83DDE2BU, 879 },
+	{ 0xD83DDE2CU, 880 },
+	{ 0xD83DDE2DU, 881 },
+	{ 0xD83DDE2EU, 882 },
+	{ 0xD83DDE2FU, 883 },
+	{ 0xD83DDE30U, 884 },
+	{ 0xD83DDE31U, 885 },
+	{ 0xD83DDE32U, 886 },
+	{ 0xD83DDE33U, 887 },
+	{ 0xD83DDE34U, 888 },
+	{ 0xD83DDE35U, 889 },
+	{ 0xD83DDE36U, 890 },
+	{ 0xD83DDE37U, 891 },
+	{ 0xD83DDE38U, 892 },
+	{ 0xD83DDE39U, 893 },
+	{ 0xD83DDE3AU, 894 },
+	{ 0xD83DDE3BU, 895 },
+	{ 0xD83DDE3CU, 896 },
+	{ 0xD83DDE3DU, 897 },
+	{ 0xD83DDE3EU, 898 },
+	{ 0xD83DDE3FU, 899 },
+	{ 0xD83DDE40U, 900 },
+	{ 0xD83DDE41U, 901 },
+	{ 0xD83DDE42U, 902 },
+	{ 0xD83DDE43U, 903 },
+	{ 0xD83DDE44U, 904 },
+	{ 0xD83DDE45U, 905 },
+	{ 0xD83DDE46U, 906 },
+	{ 0xD83DDE47U, 907 },
+	{ 0xD83DDE48U, 908 },
+	{ 0xD83DDE49U, 909 },
+	{ 0xD83DDE4AU, 910 },
+	{ 0xD83DDE4BU, 911 },
+	{ 0xD83DDE4CU, 912 },
+	{ 0xD83DDE4DU, 913 },
+	{ 0xD83DDE4EU, 914 },
+	{ 0xD83DDE4FU, 915 },
+	{ 0xD83DDE80U, 916 },
+	{ 0xD83DDE81U, 917 },
+	{ 0xD83DDE82U, 918 },
+	{ 0xD83DDE83U, 919 },
+	{ 0xD83DDE84U, 920 },
+	{ 0xD83DDE85U, 921 },
+	{ 0xD83DDE86U, 922 },
+	{ 0xD83DDE87U, 923 },
+	{ 0xD83DDE88U, 924 },
+	{ 0xD83DDE89U, 925 },
+	{ 0xD83DDE8AU, 926 },
+	{ 0xD83DDE8BU, 927 },
+	{ 0xD83DDE8CU, 928 },
+	{ 0xD83DDE8DU, 929 },
+	{ 0xD83DDE8EU, 930 },
+	{ 0xD83DDE8FU, 931 },
+	{ 0xD83DDE90U, 932 },
+	{ 0xD83DDE91U, 933 },
+	{ 0xD83DDE92U, 934 },
+	{ 0xD83DDE93U, 935 },
+	{ 0xD83DDE94U, 936 },
+	{ 0xD83DDE95U, 937 },
+	{ 0xD83DDE96U, 938 },
+	{ 0xD83DDE97U, 939 },
+	{ 0xD83DDE98U, 940 },
+	{ 0xD83DDE99U, 941 },
+	{ 0xD83DDE9AU, 942 },
+	{ 0xD83DDE9BU, 943 },
+	{ 0xD83DDE9CU, 944 },
+	{ 0xD83DDE9DU, 945 },
+	{ 0xD83DDE9EU, 946 },
+	{ 0xD83DDE9FU, 947 },
+	{ 0xD83DDEA0U, 948 },
+	{ 0xD83DDEA1U, 949 },
+	{ 0xD83DDEA2U, 950 },
+	{ 0xD83DDEA3U, 951 },
+	{ 0xD83DDEA4U, 952 },
+	{ 0xD83DDEA5U, 953 },
+	{ 0xD83DDEA6U, 954 },
+	{ 0xD83DDEA7U, 955 },
+	{ 0xD83DDEA8U, 956 },
+	{ 0xD83DDEA9U, 957 },
+	{ 0xD83DDEAAU, 958 },
+	{ 0xD83DDEABU, 959 },
+	{ 0xD83DDEACU, 960 },
+	{ 0xD83DDEADU, 961 },
+	{ 0xD83DDEAEU, 962 },
+	{ 0xD83DDEAFU, 963 },
+	{ 0xD83DDEB0U, 964 },
+	{ 0xD83DDEB1U, 965 },
+	{ 0xD83DDEB2U, 966 },
+	{ 0xD83DDEB3U, 967 },
+	{ 0xD83DDEB4U, 968 },
+	{ 0xD83DDEB5U, 969 },
+	{ 0xD83DDEB6U, 970 },
+	{ 0xD83DDEB7U, 971 },
+	{ 0xD83DDEB8U, 972 },
+	{ 0xD83DDEB9U, 973 },
+	{ 0xD83DDEBAU, 974 },
+	{ 0xD83DDEBBU, 975 },
+	{ 0xD83DDEBCU, 976 },
+	{ 0xD83DDEBDU, 977 },
+	{ 0xD83DDEBEU, 978 },
+	{ 0xD83DDEBFU, 979 },
+	{ 0xD83DDEC0U, 980 },
+	{ 0xD83DDEC1U, 981 },
+	{ 0xD83DDEC2U, 982 },
+	{ 0xD83DDEC3U, 983 },
+	{ 0xD83DDEC4U, 984 },
+	{ 0xD83DDEC5U, 985 },
+	{ 0xD83DDECBU, 986 },
+	{ 0xD83DDECCU, 987 },
+	{ 0xD83DDECDU, 988 },
+	{ 0xD83DDECEU, 989 },
+	{ 0xD83DDECFU, 990 },
+	{ 0xD83DDED0U, 991 },
+	{ 0xD83DDEE0U, 992 },
+	{ 0xD83DDEE1U, 993 },
+	{ 0xD83DDEE2U, 994 },
+	{ 0xD83DDEE3U, 995 },
+	{ 0xD83DDEE4U, 996 },
+	{ 0xD83DDEE5U, 997 },
+	{ 0xD83DDEE9U, 998 },
+	{ 0xD83DDEEBU, 999 },
+	{ 0xD83DDEECU, 1000 },
+	{ 0xD83DDEF0U, 1001 },
+	{ 0xD83DDEF3U, 1002 },
+	{ 0xD83EDD10U, 1003 },
+	{ 0xD83EDD11U, 1004 },
+	{ 0xD83EDD12U, 1005 },
+	{ 0xD83EDD13U, 1006 },
+	{ 0xD83EDD14U, 1007 },
+	{ 0xD83EDD15U, 1008 },
+	{ 0xD83EDD16U, 1009 },
+	{ 0xD83EDD17U, 1010 },
+	{ 0xD83EDD18U, 1011 },
+	{ 0xD83EDD80U, 1012 },
+	{ 0xD83EDD81U, 1013 },
+	{ 0xD83EDD82U, 1014 },
+	{ 0xD83EDD83U, 1015 },
+	{ 0xD83EDD84U, 1016 },
+	{ 0xD83EDDC0U, 1017 },
+};
 
-		return 0;
-	}
+struct EmojiPairEntry {
+	uint64 key; // (code << 32) | code2
+	int16 index;
+};
 
-	if (highCode == 0x23 || highCode == 0x2A || (highCode >= 0x30 && highCode < 0x3A)) {
-		if ((code & 0xFFFFU) != 0x20E3U) return 0;
+constexpr EmojiPairEntry emojiPairs[] = {
+	{ 0xD83CDDE6D83CDDE9LLU, 1067 },
+	{ 0xD83CDDE6D83CDDEALLU, 1068 },
+	{ 0xD83CDDE6D83CDDEBLLU, 1069 },
+	{ 0xD83CDDE6D83CDDECLLU, 1070 },
+	{ 0xD83CDDE6D83CDDEELLU, 1071 },
+	{ 0xD83CDDE6D83CDDF1LLU, 1072 },
+	{ 0xD83CDDE6D83CDDF2LLU, 1073 },
+	{ 0xD83CDDE6D83CDDF4LLU, 1074 },
+	{ 0xD83CDDE6D83CDDF6LLU, 1075 },
+	{ 0xD83CDDE6D83CDDF7LLU, 1076 },
+	{ 0xD83CDDE6D83CDDF8LLU, 1077 },
+	{ 0xD83CDDE6D83CDDF9LLU, 1078 },
+	{ 0xD83CDDE6D83CDDFALLU, 1079 },
+	{ 0xD83CDDE6D83CDDFCLLU, 1080 },
+	{ 0xD83CDDE6D83CDDFDLLU, 1081 },
+	{ 0xD83CDDE6D83CDDFFLLU, 1082 },
+	{ 0xD83CDDE7D83CDDE6LLU, 1083 },
+	{ 0xD83CDDE7D83CDDE7LLU, 1084 },
+	{ 0xD83CDDE7D83CDDE9LLU, 1085 },
+	{ 0xD83CDDE7D83CDDEALLU, 1086 },
+	{ 0xD83CDDE7D83CDDEBLLU, 1087 },
+	{ 0xD83CDDE7D83CDDECLLU, 1088 },
+	{ 0xD83CDDE7D83CDDEDLLU, 1089 },
+	{ 0xD83CDDE7D83CDDEELLU, 1090 },
+	{ 0xD83CDDE7D83CDDEFLLU, 1091 },
+	{ 0xD83CDDE7D83CDDF1LLU, 1092 },
+	{ 0xD83CDDE7D83CDDF2LLU, 1093 },
+	{ 0xD83CDDE7D83CDDF3LLU, 1094 },
+	{ 0xD83CDDE7D83CDDF4LLU, 1095 },
+	{ 0xD83CDDE7D83CDDF6LLU, 1096 },
+	{ 0xD83CDDE7D83CDDF7LLU, 1097 },
+	{ 0xD83CDDE7D83CDDF8LLU, 1098 },
+	{ 0xD83CDDE7D83CDDF9LLU, 1099 },
+	{ 0xD83CDDE7D83CDDFCLLU, 1100 },
+	{ 0xD83CDDE7D83CDDFELLU, 1101 },
+	{ 0xD83CDDE7D83CDDFFLLU, 1102 },
+	{ 0xD83CDDE8D83CDDE6LLU, 1103 },
+	{ 0xD83CDDE8D83CDDE8LLU, 1104 },
+	{ 0xD83CDDE8D83CDDE9LLU, 1105 },
+	{ 0xD83CDDE8D83CDDEBLLU, 1106 },
+	{ 0xD83CDDE8D83CDDECLLU, 1107 },
+	{ 0xD83CDDE8D83CDDEDLLU, 1108 },
+	{ 0xD83CDDE8D83CDDEELLU, 1109 },
+	{ 0xD83CDDE8D83CDDF0LLU, 1110 },
+	{ 0xD83CDDE8D83CDDF1LLU, 1111 },
+	{ 0xD83CDDE8D83CDDF2LLU, 1112 },
+	{ 0xD83CDDE8D83CDDF3LLU, 1113 },
+	{ 0xD83CDDE8D83CDDF4LLU, 1114 },
+	{ 0xD83CDDE8D83CDDF7LLU, 1115 },
+	{ 0xD83CDDE8D83CDDFALLU, 1116 },
+	{ 0xD83CDDE8D83CDDFBLLU, 1117 },
+	{ 0xD83CDDE8D83CDDFCLLU, 1118 },
+	{ 0xD83CDDE8D83CDDFDLLU, 1119 },
+	{ 0xD83CDDE8D83CDDFELLU, 1120 },
+	{ 0xD83CDDE8D83CDDFFLLU, 1121 },
+	{ 0xD83CDDE9D83CDDEALLU, 1122 },
+	{ 0xD83CDDE9D83CDDEFLLU, 1123 },
+	{ 0xD83CDDE9D83CDDF0LLU, 1124 },
+	{ 0xD83CDDE9D83CDDF2LLU, 1125 },
+	{ 0xD83CDDE9D83CDDF4LLU, 1126 },
+	{ 0xD83CDDE9D83CDDFFLLU, 1127 },
+	{ 0xD83CDDEAD83CDDE8LLU, 1128 },
+	{ 0xD83CDDEAD83CDDEALLU, 1129 },
+	{ 0xD83CDDEAD83CDDECLLU, 1130 },
+	{ 0xD83CDDEAD83CDDEDLLU, 1131 },
+	{ 0xD83CDDEAD83CDDF7LLU, 1132 },
+	{ 0xD83CDDEAD83CDDF8LLU, 1133 },
+	{ 0xD83CDDEAD83CDDF9LLU, 1134 },
+	{ 0xD83CDDEAD83CDDFALLU, 1135 },
+	{ 0xD83CDDEBD83CDDEELLU, 1136 },
+	{ 0xD83CDDEBD83CDDEFLLU, 1137 },
+	{ 0xD83CDDEBD83CDDF0LLU, 1138 },
+	{ 0xD83CDDEBD83CDDF2LLU, 1139 },
+	{ 0xD83CDDEBD83CDDF4LLU, 1140 },
+	{ 0xD83CDDEBD83CDDF7LLU, 1141 },
+	{ 0xD83CDDECD83CDDE6LLU, 1142 },
+	{ 0xD83CDDECD83CDDE7LLU, 1143 },
+	{ 0xD83CDDECD83CDDE9LLU, 1144 },
+	{ 0xD83CDDECD83CDDEALLU, 1145 },
+	{ 0xD83CDDECD83CDDEBLLU, 1146 },
+	{ 0xD83CDDECD83CDDECLLU, 1147 },
+	{ 0xD83CDDECD83CDDEDLLU, 1148 },
+	{ 0xD83CDDECD83CDDEELLU, 1149 },
+	{ 0xD83CDDECD83CDDF1LLU, 1150 },
+	{ 0xD83CDDECD83CDDF2LLU, 1151 },
+	{ 0xD83CDDECD83CDDF3LLU, 1152 },
+	{ 0xD83CDDECD83CDDF5LLU, 1153 },
+	{ 0xD83CDDECD83CDDF6LLU, 1154 },
+	{ 0xD83CDDECD83CDDF7LLU, 1155 },
+	{ 0xD83CDDECD83CDDF8LLU, 1156 },
+	{ 0xD83CDDECD83CDDF9LLU, 1157 },
+	{ 0xD83CDDECD83CDDFALLU, 1158 },
+	{ 0xD83CDDECD83CDDFCLLU, 1159 },
+	{ 0xD83CDDECD83CDDFELLU, 1160 },
+	{ 0xD83CDDEDD83CDDF0LLU, 1161 },
+	{ 0xD83CDDEDD83CDDF3LLU, 1162 },
+	{ 0xD83CDDEDD83CDDF7LLU, 1163 },
+	{ 0xD83CDDEDD83CDDF9LLU, 1164 },
+	{ 0xD83CDDEDD83CDDFALLU, 1165 },
+	{ 0xD83CDDEED83CDDE8LLU, 1166 },
+	{ 0xD83CDDEED83CDDE9LLU, 1167 },
+	{ 0xD83CDDEED83CDDEALLU, 1168 },
+	{ 0xD83CDDEED83CDDF1LLU, 1169 },
+	{ 0xD83CDDEED83CDDF2LLU, 1170 },
+	{ 0xD83CDDEED83CDDF3LLU, 1171 },
+	{ 0xD83CDDEED83CDDF4LLU, 1172 },
+	{ 0xD83CDDEED83CDDF6LLU, 1173 },
+	{ 0xD83CDDEED83CDDF7LLU, 1174 },
+	{ 0xD83CDDEED83CDDF8LLU, 1175 },
+	{ 0xD83CDDEED83CDDF9LLU, 1176 },
+	{ 0xD83CDDEFD83CDDEALLU, 1177 },
+	{ 0xD83CDDEFD83CDDF2LLU, 1178 },
+	{ 0xD83CDDEFD83CDDF4LLU, 1179 },
+	{ 0xD83CDDEFD83CDDF5LLU, 1180 },
+	{ 0xD83CDDF0D83CDDEALLU, 1181 },
+	{ 0xD83CDDF0D83CDDECLLU, 1182 },
+	{ 0xD83CDDF0D83CDDEDLLU, 1183 },
+	{ 0xD83CDDF0D83CDDEELLU, 1184 },
+	{ 0xD83CDDF0D83CDDF2LLU, 1185 },
+	{ 0xD83CDDF0D83CDDF3LLU, 1186 },
+	{ 0xD83CDDF0D83CDDF5LLU, 1187 },
+	{ 0xD83CDDF0D83CDDF7LLU, 1188 },
+	{ 0xD83CDDF0D83CDDFCLLU, 1189 },
+	{ 0xD83CDDF0D83CDDFELLU, 1190 },
+	{ 0xD83CDDF0D83CDDFFLLU, 1191 },
+	{ 0xD83CDDF1D83CDDE6LLU, 1192 },
+	{ 0xD83CDDF1D83CDDE7LLU, 1193 },
+	{ 0xD83CDDF1D83CDDE8LLU, 1194 },
+	{ 0xD83CDDF1D83CDDEELLU, 1195 },
+	{ 0xD83CDDF1D83CDDF0LLU, 1196 },
+	{ 0xD83CDDF1D83CDDF7LLU, 1197 },
+	{ 0xD83CDDF1D83CDDF8LLU, 1198 },
+	{ 0xD83CDDF1D83CDDF9LLU, 1199 },
+	{ 0xD83CDDF1D83CDDFALLU, 1200 },
+	{ 0xD83CDDF1D83CDDFBLLU, 1201 },
+	{ 0xD83CDDF1D83CDDFELLU, 1202 },
+	{ 0xD83CDDF2D83CDDE6LLU, 1203 },
+	{ 0xD83CDDF2D83CDDE8LLU, 1204 },
+	{ 0xD83CDDF2D83CDDE9LLU, 1205 },
+	{ 0xD83CDDF2D83CDDEALLU, 1206 },
+	{ 0xD83CDDF2D83CDDECLLU, 1207 },
+	{ 0xD83CDDF2D83CDDEDLLU, 1208 },
+	{ 0xD83CDDF2D83CDDF0LLU, 1209 },
+	{ 0xD83CDDF2D83CDDF1LLU, 1210 },
+	{ 0xD83CDDF2D83CDDF2LLU, 1211 },
+	{ 0xD83CDDF2D83CDDF3LLU, 1212 },
+	{ 0xD83CDDF2D83CDDF4LLU, 1213 },
+	{ 0xD83CDDF2D83CDDF5LLU, 1214 },
+	{ 0xD83CDDF2D83CDDF6LLU, 1215 },
+	{ 0xD83CDDF2D83CDDF7LLU, 1216 },
+	{ 0xD83CDDF2D83CDDF8LLU, 1217 },
+	{ 0xD83CDDF2D83CDDF9LLU, 1218 },
+	{ 0xD83CDDF2D83CDDFALLU, 1219 },
+	{ 0xD83CDDF2D83CDDFBLLU, 1220 },
+	{ 0xD83CDDF2D83CDDFCLLU, 1221 },
+	{ 0xD83CDDF2D83CDDFDLLU, 1222 },
+	{ 0xD83CDDF2D83CDDFELLU, 1223 },
+	{ 0xD83CDDF2D83CDDFFLLU, 1224 },
+	{ 0xD83CDDF3D83CDDE6LLU, 1225 },
+	{ 0xD83CDDF3D83CDDE8LLU, 1226 },
+	{ 0xD83CDDF3D83CDDEALLU, 1227 },
+	{ 0xD83CDDF3D83CDDEBLLU, 1228 },
+	{ 0xD83CDDF3D83CDDECLLU, 1229 },
+	{ 0xD83CDDF3D83CDDEELLU, 1230 },
+	{ 0xD83CDDF3D83CDDF1LLU, 1231 },
+	{ 0xD83CDDF3D83CDDF4LLU, 1232 },
+	{ 0xD83CDDF3D83CDDF5LLU, 1233 },
+	{ 0xD83CDDF3D83CDDF7LLU, 1234 },
+	{ 0xD83CDDF3D83CDDFALLU, 1235 },
+	{ 0xD83CDDF3D83CDDFFLLU, 1236 },
+	{ 0xD83CDDF4D83CDDF2LLU, 1237 },
+	{ 0xD83CDDF5D83CDDE6LLU, 1238 },
+	{ 0xD83CDDF5D83CDDEALLU, 1239 },
+	{ 0xD83CDDF5D83CDDEBLLU, 1240 },
+	{ 0xD83CDDF5D83CDDECLLU, 1241 },
+	{ 0xD83CDDF5D83CDDEDLLU, 1242 },
+	{ 0xD83CDDF5D83CDDF0LLU, 1243 },
+	{ 0xD83CDDF5D83CDDF1LLU, 1244 },
+	{ 0xD83CDDF5D83CDDF2LLU, 1245 },
+	{ 0xD83CDDF5D83CDDF3LLU, 1246 },
+	{ 0xD83CDDF5D83CDDF7LLU, 1247 },
+	{ 0xD83CDDF5D83CDDF8LLU, 1248 },
+	{ 0xD83CDDF5D83CDDF9LLU, 1249 },
+	{ 0xD83CDDF5D83CDDFCLLU, 1250 },
+	{ 0xD83CDDF5D83CDDFELLU, 1251 },
+	{ 0xD83CDDF6D83CDDE6LLU, 1252 },
+	{ 0xD83CDDF7D83CDDEALLU, 1253 },
+	{ 0xD83CDDF7D83CDDF4LLU, 1254 },
+	{ 0xD83CDDF7D83CDDF8LLU, 1255 },
+	{ 0xD83CDDF7D83CDDFALLU, 1256 },
+	{ 0xD83CDDF7D83CDDFCLLU, 1257 },
+	{ 0xD83CDDF8D83CDDE6LLU, 1258 },
+	{ 0xD83CDDF8D83CDDE7LLU, 1259 },
+	{ 0xD83CDDF8D83CDDE8LLU, 1260 },
+	{ 0xD83CDDF8D83CDDE9LLU, 1261 },
+	{ 0xD83CDDF8D83CDDEALLU, 1262 },
+	{ 0xD83CDDF8D83CDDECLLU, 1263 },
+	{ 0xD83CDDF8D83CDDEDLLU, 1264 },
+	{ 0xD83CDDF8D83CDDEELLU, 1265 },
+	{ 0xD83CDDF8D83CDDF0LLU, 1266 },
+	{ 0xD83CDDF8D83CDDF1LLU, 1267 },
+	{ 0xD83CDDF8D83CDDF2LLU, 1268 },
+	{ 0xD83CDDF8D83CDDF3LLU, 1269 },
+	{ 0xD83CDDF8D83CDDF4LLU, 1270 },
+	{ 0xD83CDDF8D83CDDF7LLU, 1271 },
+	{ 0xD83CDDF8D83CDDF8LLU, 1272 },
+	{ 0xD83CDDF8D83CDDF9LLU, 1273 },
+	{ 0xD83CDDF8D83CDDFBLLU, 1274 },
+	{ 0xD83CDDF8D83CDDFDLLU, 1275 },
+	{ 0xD83CDDF8D83CDDFELLU, 1276 },
+	{ 0xD83CDDF8D83CDDFFLLU, 1277 },
+	{ 0xD83CDDF9D83CDDE8LLU, 1278 },
+	{ 0xD83CDDF9D83CDDE9LLU, 1279 },
+	{ 0xD83CDDF9D83CDDEBLLU, 1280 },
+	{ 0xD83CDDF9D83CDDECLLU, 1281 },
+	{ 0xD83CDDF9D83CDDEDLLU, 1282 },
+	{ 0xD83CDDF9D83CDDEFLLU, 1283 },
+	{ 0xD83CDDF9D83CDDF0LLU, 1284 },
+	{ 0xD83CDDF9D83CDDF1LLU, 1285 },
+	{ 0xD83CDDF9D83CDDF2LLU, 1286 },
+	{ 0xD83CDDF9D83CDDF3LLU, 1287 },
+	{ 0xD83CDDF9D83CDDF4LLU, 1288 },
+	{ 0xD83CDDF9D83CDDF7LLU, 1289 },
+	{ 0xD83CDDF9D83CDDF9LLU, 1290 },
+	{ 0xD83CDDF9D83CDDFBLLU, 1291 },
+	{ 0xD83CDDF9D83CDDFCLLU, 1292 },
+	{ 0xD83CDDF9D83CDDFFLLU, 1293 },
+	{ 0xD83CDDFAD83CDDE6LLU, 1294 },
+	{ 0xD83CDDFAD83CDDECLLU, 1295 },
+	{ 0xD83CDDFAD83CDDF8LLU, 1296 },
+	{ 0xD83CDDFAD83CDDFELLU, 1297 },
+	{ 0xD83CDDFAD83CDDFFLLU, 1298 },
+	{ 0xD83CDDFBD83CDDE6LLU, 1299 },
+	{ 0xD83CDDFBD83CDDE8LLU, 1300 },
+	{ 0xD83CDDFBD83CDDEALLU, 1301 },
+	{ 0xD83CDDFBD83CDDECLLU, 1302 },
+	{ 0xD83CDDFBD83CDDEELLU, 1303 },
+	{ 0xD83CDDFBD83CDDF3LLU, 1304 },
+	{ 0xD83CDDFBD83CDDFALLU, 1305 },
+	{ 0xD83CDDFCD83CDDEBLLU, 1306 },
+	{ 0xD83CDDFCD83CDDF8LLU, 1307 },
+	{ 0xD83CDDFDD83CDDF0LLU, 1308 },
+	{ 0xD83CDDFED83CDDEALLU, 1309 },
+	{ 0xD83CDDFED83CDDF9LLU, 1310 },
+	{ 0xD83CDDFFD83CDDE6LLU, 1311 },
+	{ 0xD83CDDFFD83CDDF2LLU, 1312 },
+	{ 0xD83CDDFFD83CDDFCLLU, 1313 },
+};
 
-		switch (code) {
-			case 0x2320E3U: return &emojis[163];
-			case 0x2A20E3U: return &emojis[164];
-			case 0x3020E3U: return &emojis[165];
-			case 0x3120E3U: return &emojis[166];
-			case 0x3220E3U: return &emojis[167];
-			case 0x3320E3U: return &emojis[168];
-			case 0x3420E3U: return &emojis[169];
-			case 0x3520E3U: return &emojis[170];
-			case 0x3620E3U: return &emojis[171];
-			case 0x3720E3U: return &emojis[172];
-			case 0x3820E3U: return &emojis[173];
-			case 0x3920E3U: return &emojis[174];
-		}
+} // namespace
 
-		return 0;
-	}
+EmojiPtr emojiGet(uint32 code) {
+	if (!emojis) return 0;
 
-	if (highCode == 0xFFFFU) {
+	if ((code >> 16) == 0xFFFFU) {
 		static const int sequenceOffset = 1018;
 
 		uint32 index = (code & 0xFFFFU);
 		return (index < 19) ? &emojis[sequenceOffset + index] : 0;
 	}
 
-	if (code < 0xD83CDC04U || code > 0xD83EDDC0U) return 0;
+	auto i = std::lower_bound(std::begin(emojiCodes), std::end(emojiCodes), code, [](const EmojiCodeEntry &entry, uint32 code) {
+		return entry.code < code;
+	});
+	if (i == std::end(emojiCodes) || i->code != code) return 0;
 
-	switch (code) {
-		case 0xD83CDC04U: return &emojis[175];
-		case 0xD83CDCCFU: return &emojis[176];
-		case 0xD83CDD70U: return &emojis[177];
-		case 0xD83CDD71U: return &emojis[178];
-		case 0xD83CDD7EU: return &emojis[179];
-		case 0xD83CDD7FU: return &emojis[180];
-		case 0xD83CDD8EU: return &emojis[181];
-		case 0xD83CDD91U: return &emojis[182];
-		case 0xD83CDD92U: return &emojis[183];
-		case 0xD83CDD93U: return &emojis[184];
-		case 0xD83CDD94U: return &emojis[185];
-		case 0xD83CDD95U: return &emojis[186];
-		case 0xD83CDD96U: return &emojis[187];
-		case 0xD83CDD97U: return &emojis[188];
-		case 0xD83CDD98U: return &emojis[189];
-		case 0xD83CDD99U: return &emojis[190];
-		case 0xD83CDD9AU: return &emojis[191];
-		case 0xD83CDE01U: return &emojis[192];
-		case 0xD83CDE02U: return &emojis[193];
-		case 0xD83CDE1AU: return &emojis[194];
-		case 0xD83CDE2FU: return &emojis[195];
-		case 0xD83CDE32U: return &emojis[196];
-		case 0xD83CDE33U: return &emojis[197];
-		case 0xD83CDE34U: return &emojis[198];
-		case 0xD83CDE35U: return &emojis[199];
-		case 0xD83CDE36U: return &emojis[200];
-		case 0xD83CDE37U: return &emojis[201];
-		case 0xD83CDE38U: return &emojis[202];
-		case 0xD83CDE39U: return &emojis[203];
-		case 0xD83CDE3AU: return &emojis[204];
-		case 0xD83CDE50U: return &emojis[205];
-		case 0xD83CDE51U: return &emojis[206];
-		case 0xD83CDF00U: return &emojis[207];
-		case 0xD83CDF01U: return &emojis[208];
-		case 0xD83CDF02U: return &emojis[209];
-		case 0xD83CDF03U: return &emojis[210];
-		case 0xD83CDF04U: return &emojis[211];
-		case 0xD83CDF05U: return &emojis[212];
-		case 0xD83CDF06U: return &emojis[213];
-		case 0xD83CDF07U: return &emojis[214];
-		case 0xD83CDF08U: return &emojis[215];
-		case 0xD83CDF09U: return &emojis[216];
-		case 0xD83CDF0AU: return &emojis[217];
-		case 0xD83CDF0BU: return &emojis[218];
-		case 0xD83CDF0CU: return &emojis[219];
-		case 0xD83CDF0DU: return &emojis[220];
-		case 0xD83CDF0EU: return &emojis[221];
-		case 0xD83CDF0FU: return &emojis[222];
-		case 0xD83CDF10U: return &emojis[223];
-		case 0xD83CDF11U: return &emojis[224];
-		case 0xD83CDF12U: return &emojis[225];
-		case 0xD83CDF13U: return &emojis[226];
-		case 0xD83CDF14U: return &emojis[227];
-		case 0xD83CDF15U: return &emojis[228];
-		case 0xD83CDF16U: return &emojis[229];
-		case 0xD83CDF17U: return &emojis[230];
-		case 0xD83CDF18U: return &emojis[231];
-		case 0xD83CDF19U: return &emojis[232];
-		case 0xD83CDF1AU: return &emojis[233];
-		case 0xD83CDF1BU: return &emojis[234];
-		case 0xD83CDF1CU: return &emojis[235];
-		case 0xD83CDF1DU: return &emojis[236];
-		case 0xD83CDF1EU: return &emojis[237];
-		case 0xD83CDF1FU: return &emojis[238];
-		case 0xD83CDF20U: return &emojis[239];
-		case 0xD83CDF21U: return &emojis[240];
-		case 0xD83CDF24U: return &emojis[241];
-		case 0xD83CDF25U: return &emojis[242];
-		case 0xD83CDF26U: return &emojis[243];
-		case 0xD83CDF27U: return &emojis[244];
-		case 0xD83CDF28U: return &emojis[245];
-		case 0xD83CDF29U: return &emojis[246];
-		case 0xD83CDF2AU: return &emojis[247];
-		case 0xD83CDF2BU: return &emojis[248];
-		case 0xD83CDF2CU: return &emojis[249];
-		case 0xD83CDF2DU: return &emojis[250];
-		case 0xD83CDF2EU: return &emojis[251];
-		case 0xD83CDF2FU: return &emojis[252];
-		case 0xD83CDF30U: return &emojis[253];
-		case 0xD83CDF31U: return &emojis[254];
-		case 0xD83CDF32U: return &emojis[255];
-		case 0xD83CDF33U: return &emojis[256];
-		case 0xD83CDF34U: return &emojis[257];
-		case 0xD83CDF35U: return &emojis[258];
-		case 0xD83CDF36U: return &emojis[259];
-		case 0xD83CDF37U: return &emojis[260];
-		case 0xD83CDF38U: return &emojis[261];
-		case 0xD83CDF39U: return &emojis[262];
-		case 0xD83CDF3AU: return &emojis[263];
-		case 0xD83CDF3BU: return &emojis[264];
-		case 0xD83CDF3CU: return &emojis[265];
-		case 0xD83CDF3DU: return &emojis[266];
-		case 0xD83CDF3EU: return &emojis[267];
-		case 0xD83CDF3FU: return &emojis[268];
-		case 0xD83CDF40U: return &emojis[269];
-		case 0xD83CDF41U: return &emojis[270];
-		case 0xD83CDF42U: return &emojis[271];
-		case 0xD83CDF43U: return &emojis[272];
-		case 0xD83CDF44U: return &emojis[273];
-		case 0xD83CDF45U: return &emojis[274];
-		case 0xD83CDF46U: return &emojis[275];
-		case 0xD83CDF47U: return &emojis[276];
-		case 0xD83CDF48U: return &emojis[277];
-		case 0xD83CDF49U: return &emojis[278];
-		case 0xD83CDF4AU: return &emojis[279];
-		case 0xD83CDF4BU: return &emojis[280];
-		case 0xD83CDF4CU: return &emojis[281];
-		case 0xD83CDF4DU: return &emojis[282];
-		case 0xD83CDF4EU: return &emojis[283];
-		case 0xD83CDF4FU: return &emojis[284];
-		case 0xD83CDF50U: return &emojis[285];
-		case 0xD83CDF51U: return &emojis[286];
-		case 0xD83CDF52U: return &emojis[287];
-		case 0xD83CDF53U: return &emojis[288];
-		case 0xD83CDF54U: return &emojis[289];
-		case 0xD83CDF55U: return &emojis[290];
-		case 0xD83CDF56U: return &emojis[291];
-		case 0xD83CDF57U: return &emojis[292];
-		case 0xD83CDF58U: return &emojis[293];
-		case 0xD83CDF59U: return &emojis[294];
-		case 0xD83CDF5AU: return &emojis[295];
-		case 0xD83CDF5BU: return &emojis[296];
-		case 0xD83CDF5CU: return &emojis[297];
-		case 0xD83CDF5DU: return &emojis[298];
-		case 0xD83CDF5EU: return &emojis[299];
-		case 0xD83CDF5FU: return &emojis[300];
-		case 0xD83CDF60U: return &emojis[301];
-		case 0xD83CDF61U: return &emojis[302];
-		case 0xD83CDF62U: return &emojis[303];
-		case 0xD83CDF63U: return &emojis[304];
-		case 0xD83CDF64U: return &emojis[305];
-		case 0xD83CDF65U: return &emojis[306];
-		case 0xD83CDF66U: return &emojis[307];
-		case 0xD83CDF67U: return &emojis[308];
-		case 0xD83CDF68U: return &emojis[309];
-		case 0xD83CDF69U: return &emojis[310];
-		case 0xD83CDF6AU: return &emojis[311];
-		case 0xD83CDF6BU: return &emojis[312];
-		case 0xD83CDF6CU: return &emojis[313];
-		case 0xD83CDF6DU: return &emojis[314];
-		case 0xD83CDF6EU: return &emojis[315];
-		case 0xD83CDF6FU: return &emojis[316];
-		case 0xD83CDF70U: return &emojis[317];
-		case 0xD83CDF71U: return &emojis[318];
-		case 0xD83CDF72U: return &emojis[319];
-		case 0xD83CDF73U: return &emojis[320];
-		case 0xD83CDF74U: return &emojis[321];
-		case 0xD83CDF75U: return &emojis[322];
-		case 0xD83CDF76U: return &emojis[323];
-		case 0xD83CDF77U: return &emojis[324];
-		case 0xD83CDF78U: return &emojis[325];
-		case 0xD83CDF79U: return &emojis[326];
-		case 0xD83CDF7AU: return &emojis[327];
-		case 0xD83CDF7BU: return &emojis[328];
-		case 0xD83CDF7CU: return &emojis[329];
-		case 0xD83CDF7DU: return &emojis[330];
-		case 0xD83CDF7EU: return &emojis[331];
-		case 0xD83CDF7FU: return &emojis[332];
-		case 0xD83CDF80U: return &emojis[333];
-		case 0xD83CDF81U: return &emojis[334];
-		case 0xD83CDF82U: return &emojis[335];
-		case 0xD83CDF83U: return &emojis[336];
-		case 0xD83CDF84U: return &emojis[337];
-		case 0xD83CDF85U: return &emojis[338];
-		case 0xD83CDF86U: return &emojis[339];
-		case 0xD83CDF87U: return &emojis[340];
-		case 0xD83CDF88U: return &emojis[341];
-		case 0xD83CDF89U: return &emojis[342];
-		case 0xD83CDF8AU: return &emojis[343];
-		case 0xD83CDF8BU: return &emojis[344];
-		case 0xD83CDF8CU: return &emojis[345];
-		case 0xD83CDF8DU: return &emojis[346];
-		case 0xD83CDF8EU: return &emojis[347];
-		case 0xD83CDF8FU: return &emojis[348];
-		case 0xD83CDF90U: return &emojis[349];
-		case 0xD83CDF91U: return &emojis[350];
-		case 0xD83CDF92U: return &emojis[351];
-		case 0xD83CDF93U: return &emojis[352];
-		case 0xD83CDF96U: return &emojis[353];
-		case 0xD83CDF97U: return &emojis[354];
-		case 0xD83CDF99U: return &emojis[355];
-		case 0xD83CDF9AU: return &emojis[356];
-		case 0xD83CDF9BU: return &emojis[357];
-		case 0xD83CDF9EU: return &emojis[358];
-		case 0xD83CDF9FU: return &emojis[359];
-		case 0xD83CDFA0U: return &emojis[360];
-		case 0xD83CDFA1U: return &emojis[361];
-		case 0xD83CDFA2U: return &emojis[362];
-		case 0xD83CDFA3U: return &emojis[363];
-		case 0xD83CDFA4U: return &emojis[364];
-		case 0xD83CDFA5U: return &emojis[365];
-		case 0xD83CDFA6U: return &emojis[366];
-		case 0xD83CDFA7U: return &emojis[367];
-		case 0xD83CDFA8U: return &emojis[368];
-		case 0xD83CDFA9U: return &emojis[369];
-		case 0xD83CDFAAU: return &emojis[370];
-		case 0xD83CDFABU: return &emojis[371];
-		case 0xD83CDFACU: return &emojis[372];
-		case 0xD83CDFADU: return &emojis[373];
-		case 0xD83CDFAEU: return &emojis[374];
-		case 0xD83CDFAFU: return &emojis[375];
-		case 0xD83CDFB0U: return &emojis[376];
-		case 0xD83CDFB1U: return &emojis[377];
-		case 0xD83CDFB2U: return &emojis[378];
-		case 0xD83CDFB3U: return &emojis[379];
-		case 0xD83CDFB4U: return &emojis[380];
-		case 0xD83CDFB5U: return &emojis[381];
-		case 0xD83CDFB6U: return &emojis[382];
-		case 0xD83CDFB7U: return &emojis[383];
-		case 0xD83CDFB8U: return &emojis[384];
-		case 0xD83CDFB9U: return &emojis[385];
-		case 0xD83CDFBAU: return &emojis[386];
-		case 0xD83CDFBBU: return &emojis[387];
-		case 0xD83CDFBCU: return &emojis[388];
-		case 0xD83CDFBDU: return &emojis[389];
-		case 0xD83CDFBEU: return &emojis[390];
-		case 0xD83CDFBFU: return &emojis[391];
-		case 0xD83CDFC0U: return &emojis[392];
-		case 0xD83CDFC1U: return &emojis[393];
-		case 0xD83CDFC2U: return &emojis[394];
-		case 0xD83CDFC3U: return &emojis[395];
-		case 0xD83CDFC4U: return &emojis[396];
-		case 0xD83CDFC5U: return &emojis[397];
-		case 0xD83CDFC6U: return &emojis[398];
-		case 0xD83CDFC7U: return &emojis[399];
-		case 0xD83CDFC8U: return &emojis[400];
-		case 0xD83CDFC9U: return &emojis[401];
-		case 0xD83CDFCAU: return &emojis[402];
-		case 0xD83CDFCBU: return &emojis[403];
-		case 0xD83CDFCCU: return &emojis[404];
-		case 0xD83CDFCDU: return &emojis[405];
-		case 0xD83CDFCEU: return &emojis[406];
-		case 0xD83CDFCFU: return &emojis[407];
-		case 0xD83CDFD0U: return &emojis[408];
-		case 0xD83CDFD1U: return &emojis[409];
-		case 0xD83CDFD2U: return &emojis[410];
-		case 0xD83CDFD3U: return &emojis[411];
-		case 0xD83CDFD4U: return &emojis[412];
-		case 0xD83CDFD5U: return &emojis[413];
-		case 0xD83CDFD6U: return &emojis[414];
-		case 0xD83CDFD7U: return &emojis[415];
-		case 0xD83CDFD8U: return &emojis[416];
-		case 0xD83CDFD9U: return &emojis[417];
-		case 0xD83CDFDAU: return &emojis[418];
-		case 0xD83CDFDBU: return &emojis[419];
-		case 0xD83CDFDCU: return &emojis[420];
-		case 0xD83CDFDDU: return &emojis[421];
-		case 0xD83CDFDEU: return &emojis[422];
-		case 0xD83CDFDFU: return &emojis[423];
-		case 0xD83CDFE0U: return &emojis[424];
-		case 0xD83CDFE1U: return &emojis[425];
-		case 0xD83CDFE2U: return &emojis[426];
-		case 0xD83CDFE3U: return &emojis[427];
-		case 0xD83CDFE4U: return &emojis[428];
-		case 0xD83CDFE5U: return &emojis[429];
-		case 0xD83CDFE6U: return &emojis[430];
-		case 0xD83CDFE7U: return &emojis[431];
-		case 0xD83CDFE8U: return &emojis[432];
-		case 0xD83CDFE9U: return &emojis[433];
-		case 0xD83CDFEAU: return &emojis[434];
-		case 0xD83CDFEBU: return &emojis[435];
-		case 0xD83CDFECU: return &emojis[436];
-		case 0xD83CDFEDU: return &emojis[437];
-		case 0xD83CDFEEU: return &emojis[438];
-		case 0xD83CDFEFU: return &emojis[439];
-		case 0xD83CDFF0U: return &emojis[440];
-		case 0xD83CDFF3U: return &emojis[441];
-		case 0xD83CDFF4U: return &emojis[442];
-		case 0xD83CDFF5U: return &emojis[443];
-		case 0xD83CDFF7U: return &emojis[444];
-		case 0xD83CDFF8U: return &emojis[445];
-		case 0xD83CDFF9U: return &emojis[446];
-		case 0xD83CDFFAU: return &emojis[447];
-		case 0xD83DDC00U: return &emojis[448];
-		case 0xD83DDC01U: return &emojis[449];
-		case 0xD83DDC02U: return &emojis[450];
-		case 0xD83DDC03U: return &emojis[451];
-		case 0xD83DDC04U: return &emojis[452];
-		case 0xD83DDC05U: return &emojis[453];
-		case 0xD83DDC06U: return &emojis[454];
-		case 0xD83DDC07U: return &emojis[455];
-		case 0xD83DDC08U: return &emojis[456];
-		case 0xD83DDC09U: return &emojis[457];
-		case 0xD83DDC0AU: return &emojis[458];
-		case 0xD83DDC0BU: return &emojis[459];
-		case 0xD83DDC0CU: return &emojis[460];
-		case 0xD83DDC0DU: return &emojis[461];
-		case 0xD83DDC0EU: return &emojis[462];
-		case 0xD83DDC0FU: return &emojis[463];
-		case 0xD83DDC10U: return &emojis[464];
-		case 0xD83DDC11U: return &emojis[465];
-		case 0xD83DDC12U: return &emojis[466];
-		case 0xD83DDC13U: return &emojis[467];
-		case 0xD83DDC14U: return &emojis[468];
-		case 0xD83DDC15U: return &emojis[469];
-		case 0xD83DDC16U: return &emojis[470];
-		case 0xD83DDC17U: return &emojis[471];
-		case 0xD83DDC18U: return &emojis[472];
-		case 0xD83DDC19U: return &emojis[473];
-		case 0xD83DDC1AU: return &emojis[474];
-		case 0xD83DDC1BU: return &emojis[475];
-		case 0xD83DDC1CU: return &emojis[476];
-		case 0xD83DDC1DU: return &emojis[477];
-		case 0xD83DDC1EU: return &emojis[478];
-		case 0xD83DDC1FU: return &emojis[479];
-		case 0xD83DDC20U: return &emojis[480];
-		case 0xD83DDC21U: return &emojis[481];
-		case 0xD83DDC22U: return &emojis[482];
-		case 0xD83DDC23U: return &emojis[483];
-		case 0xD83DDC24U: return &emojis[484];
-		case 0xD83DDC25U: return &emojis[485];
-		case 0xD83DDC26U: return &emojis[486];
-		case 0xD83DDC27U: return &emojis[487];
-		case 0xD83DDC28U: return &emojis[488];
-		case 0xD83DDC29U: return &emojis[489];
-		case 0xD83DDC2AU: return &emojis[490];
-		case 0xD83DDC2BU: return &emojis[491];
-		case 0xD83DDC2CU: return &emojis[492];
-		case 0xD83DDC2DU: return &emojis[493];
-		case 0xD83DDC2EU: return &emojis[494];
-		case 0xD83DDC2FU: return &emojis[495];
-		case 0xD83DDC30U: return &emojis[496];
-		case 0xD83DDC31U: return &emojis[497];
-		case 0xD83DDC32U: return &emojis[498];
-		case 0xD83DDC33U: return &emojis[499];
-		case 0xD83DDC34U: return &emojis[500];
-		case 0xD83DDC35U: return &emojis[501];
-		case 0xD83DDC36U: return &emojis[502];
-		case 0xD83DDC37U: return &emojis[503];
-		case 0xD83DDC38U: return &emojis[504];
-		case 0xD83DDC39U: return &emojis[505];
-		case 0xD83DDC3AU: return &emojis[506];
-		case 0xD83DDC3BU: return &emojis[507];
-		case 0xD83DDC3CU: return &emojis[508];
-		case 0xD83DDC3DU: return &emojis[509];
-		case 0xD83DDC3EU: return &emojis[510];
-		case 0xD83DDC3FU: return &emojis[511];
-		case 0xD83DDC40U: return &emojis[512];
-		case 0xD83DDC41U: return &emojis[513];
-		case 0xD83DDC42U: return &emojis[514];
-		case 0xD83DDC43U: return &emojis[515];
-		case 0xD83DDC44U: return &emojis[516];
-		case 0xD83DDC45U: return &emojis[517];
-		case 0xD83DDC46U: return &emojis[518];
-		case 0xD83DDC47U: return &emojis[519];
-		case 0xD83DDC48U: return &emojis[520];
-		case 0xD83DDC49U: return &emojis[521];
-		case 0xD83DDC4AU: return &emojis[522];
-		case 0xD83DDC4BU: return &emojis[523];
-		case 0xD83DDC4CU: return &emojis[524];
-		case 0xD83DDC4DU: return &emojis[525];
-		case 0xD83DDC4EU: return &emojis[526];
-		case 0xD83DDC4FU: return &emojis[527];
-		case 0xD83DDC50U: return &emojis[528];
-		case 0xD83DDC51U: return &emojis[529];
-		case 0xD83DDC52U: return &emojis[530];
-		case 0xD83DDC53U: return &emojis[531];
-		case 0xD83DDC54U: return &emojis[532];
-		case 0xD83DDC55U: return &emojis[533];
-		case 0xD83DDC56U: return &emojis[534];
-		case 0xD83DDC57U: return &emojis[535];
-		case 0xD83DDC58U: return &emojis[536];
-		case 0xD83DDC59U: return &emojis[537];
-		case 0xD83DDC5AU: return &emojis[538];
-		case 0xD83DDC5BU: return &emojis[539];
-		case 0xD83DDC5CU: return &emojis[540];
-		case 0xD83DDC5DU: return &emojis[541];
-		case 0xD83DDC5EU: return &emojis[542];
-		case 0xD83DDC5FU: return &emojis[543];
-		case 0xD83DDC60U: return &emojis[544];
-		case 0xD83DDC61U: return &emojis[545];
-		case 0xD83DDC62U: return &emojis[546];
-		case 0xD83DDC63U: return &emojis[547];
-		case 0xD83DDC64U: return &emojis[548];
-		case 0xD83DDC65U: return &emojis[549];
-		case 0xD83DDC66U: return &emojis[550];
-		case 0xD83DDC67U: return &emojis[551];
-		case 0xD83DDC68U: return &emojis[552];
-		case 0xD83DDC69U: return &emojis[553];
-		case 0xD83DDC6AU: return &emojis[554];
-		case 0xD83DDC6BU: return &emojis[555];
-		case 0xD83DDC6CU: return &emojis[556];
-		case 0xD83DDC6DU: return &emojis[557];
-		case 0xD83DDC6EU: return &emojis[558];
-		case 0xD83DDC6FU: return &emojis[559];
-		case 0xD83DDC70U: return &emojis[560];
-		case 0xD83DDC71U: return &emojis[561];
-		case 0xD83DDC72U: return &emojis[562];
-		case 0xD83DDC73U: return &emojis[563];
-		case 0xD83DDC74U: return &emojis[564];
-		case 0xD83DDC75U: return &emojis[565];
-		case 0xD83DDC76U: return &emojis[566];
-		case 0xD83DDC77U: return &emojis[567];
-		case 0xD83DDC78U: return &emojis[568];
-		case 0xD83DDC79U: return &emojis[569];
-		case 0xD83DDC7AU: return &emojis[570];
-		case 0xD83DDC7BU: return &emojis[571];
-		case 0xD83DDC7CU: return &emojis[572];
-		case 0xD83DDC7DU: return &emojis[573];
-		case 0xD83DDC7EU: return &emojis[574];
-		case 0xD83DDC7FU: return &emojis[575];
-		case 0xD83DDC80U: return &emojis[576];
-		case 0xD83DDC81U: return &emojis[577];
-		case 0xD83DDC82U: return &emojis[578];
-		case 0xD83DDC83U: return &emojis[579];
-		case 0xD83DDC84U: return &emojis[580];
-		case 0xD83DDC85U: return &emojis[581];
-		case 0xD83DDC86U: return &emojis[582];
-		case 0xD83DDC87U: return &emojis[583];
-		case 0xD83DDC88U: return &emojis[584];
-		case 0xD83DDC89U: return &emojis[585];
-		case 0xD83DDC8AU: return &emojis[586];
-		case 0xD83DDC8BU: return &emojis[587];
-		case 0xD83DDC8CU: return &emojis[588];
-		case 0xD83DDC8DU: return &emojis[589];
-		case 0xD83DDC8EU: return &emojis[590];
-		case 0xD83DDC8FU: return &emojis[591];
-		case 0xD83DDC90U: return &emojis[592];
-		case 0xD83DDC91U: return &emojis[593];
-		case 0xD83DDC92U: return &emojis[594];
-		case 0xD83DDC93U: return &emojis[595];
-		case 0xD83DDC94U: return &emojis[596];
-		case 0xD83DDC95U: return &emojis[597];
-		case 0xD83DDC96U: return &emojis[598];
-		case 0xD83DDC97U: return &emojis[599];
-		case 0xD83DDC98U: return &emojis[600];
-		case 0xD83DDC99U: return &emojis[601];
-		case 0xD83DDC9AU: return &emojis[602];
-		case 0xD83DDC9BU: return &emojis[603];
-		case 0xD83DDC9CU: return &emojis[604];
-		case 0xD83DDC9DU: return &emojis[605];
-		case 0xD83DDC9EU: return &emojis[606];
-		case 0xD83DDC9FU: return &emojis[607];
-		case 0xD83DDCA0U: return &emojis[608];
-		case 0xD83DDCA1U: return &emojis[609];
-		case 0xD83DDCA2U: return &emojis[610];
-		case 0xD83DDCA3U: return &emojis[611];
-		case 0xD83DDCA4U: return &emojis[612];
-		case 0xD83DDCA5U: return &emojis[613];
-		case 0xD83DDCA6U: return &emojis[614];
-		case 0xD83DDCA7U: return &emojis[615];
-		case 0xD83DDCA8U: return &emojis[616];
-		case 0xD83DDCA9U: return &emojis[617];
-		case 0xD83DDCAAU: return &emojis[618];
-		case 0xD83DDCABU: return &emojis[619];
-		case 0xD83DDCACU: return &emojis[620];
-		case 0xD83DDCADU: return &emojis[621];
-		case 0xD83DDCAEU: return &emojis[622];
-		case 0xD83DDCAFU: return &emojis[623];
-		case 0xD83DDCB0U: return &emojis[624];
-		case 0xD83DDCB1U: return &emojis[625];
-		case 0xD83DDCB2U: return &emojis[626];
-		case 0xD83DDCB3U: return &emojis[627];
-		case 0xD83DDCB4U: return &emojis[628];
-		case 0xD83DDCB5U: return &emojis[629];
-		case 0xD83DDCB6U: return &emojis[630];
-		case 0xD83DDCB7U: return &emojis[631];
-		case 0xD83DDCB8U: return &emojis[632];
-		case 0xD83DDCB9U: return &emojis[633];
-		case 0xD83DDCBAU: return &emojis[634];
-		case 0xD83DDCBBU: return &emojis[635];
-		case 0xD83DDCBCU: return &emojis[636];
-		case 0xD83DDCBDU: return &emojis[637];
-		case 0xD83DDCBEU: return &emojis[638];
-		case 0xD83DDCBFU: return &emojis[639];
-		case 0xD83DDCC0U: return &emojis[640];
-		case 0xD83DDCC1U: return &emojis[641];
-		case 0xD83DDCC2U: return &emojis[642];
-		case 0xD83DDCC3U: return &emojis[643];
-		case 0xD83DDCC4U: return &emojis[644];
-		case 0xD83DDCC5U: return &emojis[645];
-		case 0xD83DDCC6U: return &emojis[646];
-		case 0xD83DDCC7U: return &emojis[647];
-		case 0xD83DDCC8U: return &emojis[648];
-		case 0xD83DDCC9U: return &emojis[649];
-		case 0xD83DDCCAU: return &emojis[650];
-		case 0xD83DDCCBU: return &emojis[651];
-		case 0xD83DDCCCU: return &emojis[652];
-		case 0xD83DDCCDU: return &emojis[653];
-		case 0xD83DDCCEU: return &emojis[654];
-		case 0xD83DDCCFU: return &emojis[655];
-		case 0xD83DDCD0U: return &emojis[656];
-		case 0xD83DDCD1U: return &emojis[657];
-		case 0xD83DDCD2U: return &emojis[658];
-		case 0xD83DDCD3U: return &emojis[659];
-		case 0xD83DDCD4U: return &emojis[660];
-		case 0xD83DDCD5U: return &emojis[661];
-		case 0xD83DDCD6U: return &emojis[662];
-		case 0xD83DDCD7U: return &emojis[663];
-		case 0xD83DDCD8U: return &emojis[664];
-		case 0xD83DDCD9U: return &emojis[665];
-		case 0xD83DDCDAU: return &emojis[666];
-		case 0xD83DDCDBU: return &emojis[667];
-		case 0xD83DDCDCU: return &emojis[668];
-		case 0xD83DDCDDU: return &emojis[669];
-		case 0xD83DDCDEU: return &emojis[670];
-		case 0xD83DDCDFU: return &emojis[671];
-		case 0xD83DDCE0U: return &emojis[672];
-		case 0xD83DDCE1U: return &emojis[673];
-		case 0xD83DDCE2U: return &emojis[674];
-		case 0xD83DDCE3U: return &emojis[675];
-		case 0xD83DDCE4U: return &emojis[676];
-		case 0xD83DDCE5U: return &emojis[677];
-		case 0xD83DDCE6U: return &emojis[678];
-		case 0xD83DDCE7U: return &emojis[679];
-		case 0xD83DDCE8U: return &emojis[680];
-		case 0xD83DDCE9U: return &emojis[681];
-		case 0xD83DDCEAU: return &emojis[682];
-		case 0xD83DDCEBU: return &emojis[683];
-		case 0xD83DDCECU: return &emojis[684];
-		case 0xD83DDCEDU: return &emojis[685];
-		case 0xD83DDCEEU: return &emojis[686];
-		case 0xD83DDCEFU: return &emojis[687];
-		case 0xD83DDCF0U: return &emojis[688];
-		case 0xD83DDCF1U: return &emojis[689];
-		case 0xD83DDCF2U: return &emojis[690];
-		case 0xD83DDCF3U: return &emojis[691];
-		case 0xD83DDCF4U: return &emojis[692];
-		case 0xD83DDCF5U: return &emojis[693];
-		case 0xD83DDCF6U: return &emojis[694];
-		case 0xD83DDCF7U: return &emojis[695];
-		case 0xD83DDCF8U: return &emojis[696];
-		case 0xD83DDCF9U: return &emojis[697];
-		case 0xD83DDCFAU: return &emojis[698];
-		case 0xD83DDCFBU: return &emojis[699];
-		case 0xD83DDCFCU: return &emojis[700];
-		case 0xD83DDCFDU: return &emojis[701];
-		case 0xD83DDCFFU: return &emojis[702];
-		case 0xD83DDD00U: return &emojis[703];
-		case 0xD83DDD01U: return &emojis[704];
-		case 0xD83DDD02U: return &emojis[705];
-		case 0xD83DDD03U: return &emojis[706];
-		case 0xD83DDD04U: return &emojis[707];
-		case 0xD83DDD05U: return &emojis[708];
-		case 0xD83DDD06U: return &emojis[709];
-		case 0xD83DDD07U: return &emojis[710];
-		case 0xD83DDD08U: return &emojis[711];
-		case 0xD83DDD09U: return &emojis[712];
-		case 0xD83DDD0AU: return &emojis[713];
-		case 0xD83DDD0BU: return &emojis[714];
-		case 0xD83DDD0CU: return &emojis[715];
-		case 0xD83DDD0DU: return &emojis[716];
-		case 0xD83DDD0EU: return &emojis[717];
-		case 0xD83DDD0FU: return &emojis[718];
-		case 0xD83DDD10U: return &emojis[719];
-		case 0xD83DDD11U: return &emojis[720];
-		case 0xD83DDD12U: return &emojis[721];
-		case 0xD83DDD13U: return &emojis[722];
-		case 0xD83DDD14U: return &emojis[723];
-		case 0xD83DDD15U: return &emojis[724];
-		case 0xD83DDD16U: return &emojis[725];
-		case 0xD83DDD17U: return &emojis[726];
-		case 0xD83DDD18U: return &emojis[727];
-		case 0xD83DDD19U: return &emojis[728];
-		case 0xD83DDD1AU: return &emojis[729];
-		case 0xD83DDD1BU: return &emojis[730];
-		case 0xD83DDD1CU: return &emojis[731];
-		case 0xD83DDD1DU: return &emojis[732];
-		case 0xD83DDD1EU: return &emojis[733];
-		case 0xD83DDD1FU: return &emojis[734];
-		case 0xD83DDD20U: return &emojis[735];
-		case 0xD83DDD21U: return &emojis[736];
-		case 0xD83DDD22U: return &emojis[737];
-		case 0xD83DDD23U: return &emojis[738];
-		case 0xD83DDD24U: return &emojis[739];
-		case 0xD83DDD25U: return &emojis[740];
-		case 0xD83DDD26U: return &emojis[741];
-		case 0xD83DDD27U: return &emojis[742];
-		case 0xD83DDD28U: return &emojis[743];
-		case 0xD83DDD29U: return &emojis[744];
-		case 0xD83DDD2AU: return &emojis[745];
-		case 0xD83DDD2BU: return &emojis[746];
-		case 0xD83DDD2CU: return &emojis[747];
-		case 0xD83DDD2DU: return &emojis[748];
-		case 0xD83DDD2EU: return &emojis[749];
-		case 0xD83DDD2FU: return &emojis[750];
-		case 0xD83DDD30U: return &emojis[751];
-		case 0xD83DDD31U: return &emojis[752];
-		case 0xD83DDD32U: return &emojis[753];
-		case 0xD83DDD33U: return &emojis[754];
-		case 0xD83DDD34U: return &emojis[755];
-		case 0xD83DDD35U: return &emojis[756];
-		case 0xD83DDD36U: return &emojis[757];
-		case 0xD83DDD37U: return &emojis[758];
-		case 0xD83DDD38U: return &emojis[759];
-		case 0xD83DDD39U: return &emojis[760];
-		case 0xD83DDD3AU: return &emojis[761];
-		case 0xD83DDD3BU: return &emojis[762];
-		case 0xD83DDD3CU: return &emojis[763];
-		case 0xD83DDD3DU: return &emojis[764];
-		case 0xD83DDD49U: return &emojis[765];
-		case 0xD83DDD4AU: return &emojis[766];
-		case 0xD83DDD4BU: return &emojis[767];
-		case 0xD83DDD4CU: return &emojis[768];
-		case 0xD83DDD4DU: return &emojis[769];
-		case 0xD83DDD4EU: return &emojis[770];
-		case 0xD83DDD50U: return &emojis[771];
-		case 0xD83DDD51U: return &emojis[772];
-		case 0xD83DDD52U: return &emojis[773];
-		case 0xD83DDD53U: return &emojis[774];
-		case 0xD83DDD54U: return &emojis[775];
-		case 0xD83DDD55U: return &emojis[776];
-		case 0xD83DDD56U: return &emojis[777];
-		case 0xD83DDD57U: return &emojis[778];
-		case 0xD83DDD58U: return &emojis[779];
-		case 0xD83DDD59U: return &emojis[780];
-		case 0xD83DDD5AU: return &emojis[781];
-		case 0xD83DDD5BU: return &emojis[782];
-		case 0xD83DDD5CU: return &emojis[783];
-		case 0xD83DDD5DU: return &emojis[784];
-		case 0xD83DDD5EU: return &emojis[785];
-		case 0xD83DDD5FU: return &emojis[786];
-		case 0xD83DDD60U: return &emojis[787];
-		case 0xD83DDD61U: return &emojis[788];
-		case 0xD83DDD62U: return &emojis[789];
-		case 0xD83DDD63U: return &emojis[790];
-		case 0xD83DDD64U: return &emojis[791];
-		case 0xD83DDD65U: return &emojis[792];
-		case 0xD83DDD66U: return &emojis[793];
-		case 0xD83DDD67U: return &emojis[794];
-		case 0xD83DDD6FU: return &emojis[795];
-		case 0xD83DDD70U: return &emojis[796];
-		case 0xD83DDD73U: return &emojis[797];
-		case 0xD83DDD74U: return &emojis[798];
-		case 0xD83DDD75U: return &emojis[799];
-		case 0xD83DDD76U: return &emojis[800];
-		case 0xD83DDD77U: return &emojis[801];
-		case 0xD83DDD78U: return &emojis[802];
-		case 0xD83DDD79U: return &emojis[803];
-		case 0xD83DDD87U: return &emojis[804];
-		case 0xD83DDD8AU: return &emojis[805];
-		case 0xD83DDD8BU: return &emojis[806];
-		case 0xD83DDD8CU: return &emojis[807];
-		case 0xD83DDD8DU: return &emojis[808];
-		case 0xD83DDD90U: return &emojis[809];
-		case 0xD83DDD95U: return &emojis[810];
-		case 0xD83DDD96U: return &emojis[811];
-		case 0xD83DDDA5U: return &emojis[812];
-		case 0xD83DDDA8U: return &emojis[813];
-		case 0xD83DDDB1U: return &emojis[814];
-		case 0xD83DDDB2U: return &emojis[815];
-		case 0xD83DDDBCU: return &emojis[816];
-		case 0xD83DDDC2U: return &emojis[817];
-		case 0xD83DDDC3U: return &emojis[818];
-		case 0xD83DDDC4U: return &emojis[819];
-		case 0xD83DDDD1U: return &emojis[820];
-		case 0xD83DDDD2U: return &emojis[821];
-		case 0xD83DDDD3U: return &emojis[822];
-		case 0xD83DDDDCU: return &emojis[823];
-		case 0xD83DDDDDU: return &emojis[824];
-		case 0xD83DDDDEU: return &emojis[825];
-		case 0xD83DDDE1U: return &emojis[826];
-		case 0xD83DDDE3U: return &emojis[827];
-		case 0xD83DDDEFU: return &emojis[828];
-		case 0xD83DDDF3U: return &emojis[829];
-		case 0xD83DDDFAU: return &emojis[830];
-		case 0xD83DDDFBU: return &emojis[831];
-		case 0xD83DDDFCU: return &emojis[832];
-		case 0xD83DDDFDU: return &emojis[833];
-		case 0xD83DDDFEU: return &emojis[834];
-		case 0xD83DDDFFU: return &emojis[835];
-		case 0xD83DDE00U: return &emojis[836];
-		case 0xD83DDE01U: return &emojis[837];
-		case 0xD83DDE02U: return &emojis[838];
-		case 0xD83DDE03U: return &emojis[839];
-		case 0xD83DDE04U: return &emojis[840];
-		case 0xD83DDE05U: return &emojis[841];
-		case 0xD83DDE06U: return &emojis[842];
-		case 0xD83DDE07U: return &emojis[843];
-		case 0xD83DDE08U: return &emojis[844];
-		case 0xD83DDE09U: return &emojis[845];
-		case 0xD83DDE0AU: return &emojis[846];
-		case 0xD83DDE0BU: return &emojis[847];
-		case 0xD83DDE0CU: return &emojis[848];
-		case 0xD83DDE0DU: return &emojis[849];
-		case 0xD83DDE0EU: return &emojis[850];
-		case 0xD83DDE0FU: return &emojis[851];
-		case 0xD83DDE10U: return &emojis[852];
-		case 0xD83DDE11U: return &emojis[853];
-		case 0xD83DDE12U: return &emojis[854];
-		case 0xD83DDE13U: return &emojis[855];
-		case 0xD83DDE14U: return &emojis[856];
-		case 0xD83DDE15U: return &emojis[857];
-		case 0xD83DDE16U: return &emojis[858];
-		case 0xD83DDE17U: return &emojis[859];
-		case 0xD83DDE18U: return &emojis[860];
-		case 0xD83DDE19U: return &emojis[861];
-		case 0xD83DDE1AU: return &emojis[862];
-		case 0xD83DDE1BU: return &emojis[863];
-		case 0xD83DDE1CU: return &emojis[864];
-		case 0xD83DDE1DU: return &emojis[865];
-		case 0xD83DDE1EU: return &emojis[866];
-		case 0xD83DDE1FU: return &emojis[867];
-		case 0xD83DDE20U: return &emojis[868];
-		case 0xD83DDE21U: return &emojis[869];
-		case 0xD83DDE22U: return &emojis[870];
-		case 0xD83DDE23U: return &emojis[871];
-		case 0xD83DDE24U: return &emojis[872];
-		case 0xD83DDE25U: return &emojis[873];
-		case 0xD83DDE26U: return &emojis[874];
-		case 0xD83DDE27U: return &emojis[875];
-		case 0xD83DDE28U: return &emojis[876];
-		case 0xD83DDE29U: return &emojis[877];
-		case 0xD83DDE2AU: return &emojis[878];
-		case 0xD83DDE2BU: return &emojis[879];
-		case 0xD83DDE2CU: return &emojis[880];
-		case 0xD83DDE2DU: return &emojis[881];
-		case 0xD83DDE2EU: return &emojis[882];
-		case 0xD83DDE2FU: return &emojis[883];
-		case 0xD83DDE30U: return &emojis[884];
-		case 0xD83DDE31U: return &emojis[885];
-		case 0xD83DDE32U: return &emojis[886];
-		case 0xD83DDE33U: return &emojis[887];
-		case 0xD83DDE34U: return &emojis[888];
-		case 0xD83DDE35U: return &emojis[889];
-		case 0xD83DDE36U: return &emojis[890];
-		case 0xD83DDE37U: return &emojis[891];
-		case 0xD83DDE38U: return &emojis[892];
-		case 0xD83DDE39U: return &emojis[893];
-		case 0xD83DDE3AU: return &emojis[894];
-		case 0xD83DDE3BU: return &emojis[895];
-		case 0xD83DDE3CU: return &emojis[896];
-		case 0xD83DDE3DU: return &emojis[897];
-		case 0xD83DDE3EU: return &emojis[898];
-		case 0xD83DDE3FU: return &emojis[899];
-		case 0xD83DDE40U: return &emojis[900];
-		case 0xD83DDE41U: return &emojis[901];
-		case 0xD83DDE42U: return &emojis[902];
-		case 0xD83DDE43U: return &emojis[903];
-		case 0xD83DDE44U: return &emojis[904];
-		case 0xD83DDE45U: return &emojis[905];
-		case 0xD83DDE46U: return &emojis[906];
-		case 0xD83DDE47U: return &emojis[907];
-		case 0xD83DDE48U: return &emojis[908];
-		case 0xD83DDE49U: return &emojis[909];
-		case 0xD83DDE4AU: return &emojis[910];
-		case 0xD83DDE4BU: return &emojis[911];
-		case 0xD83DDE4CU: return &emojis[912];
-		case 0xD83DDE4DU: return &emojis[913];
-		case 0xD83DDE4EU: return &emojis[914];
-		case 0xD83DDE4FU: return &emojis[915];
-		case 0xD83DDE80U: return &emojis[916];
-		case 0xD83DDE81U: return &emojis[917];
-		case 0xD83DDE82U: return &emojis[918];
-		case 0xD83DDE83U: return &emojis[919];
-		case 0xD83DDE84U: return &emojis[920];
-		case 0xD83DDE85U: return &emojis[921];
-		case 0xD83DDE86U: return &emojis[922];
-		case 0xD83DDE87U: return &emojis[923];
-		case 0xD83DDE88U: return &emojis[924];
-		case 0xD83DDE89U: return &emojis[925];
-		case 0xD83DDE8AU: return &emojis[926];
-		case 0xD83DDE8BU: return &emojis[927];
-		case 0xD83DDE8CU: return &emojis[928];
-		case 0xD83DDE8DU: return &emojis[929];
-		case 0xD83DDE8EU: return &emojis[930];
-		case 0xD83DDE8FU: return &emojis[931];
-		case 0xD83DDE90U: return &emojis[932];
-		case 0xD83DDE91U: return &emojis[933];
-		case 0xD83DDE92U: return &emojis[934];
-		case 0xD83DDE93U: return &emojis[935];
-		case 0xD83DDE94U: return &emojis[936];
-		case 0xD83DDE95U: return &emojis[937];
-		case 0xD83DDE96U: return &emojis[938];
-		case 0xD83DDE97U: return &emojis[939];
-		case 0xD83DDE98U: return &emojis[940];
-		case 0xD83DDE99U: return &emojis[941];
-		case 0xD83DDE9AU: return &emojis[942];
-		case 0xD83DDE9BU: return &emojis[943];
-		case 0xD83DDE9CU: return &emojis[944];
-		case 0xD83DDE9DU: return &emojis[945];
-		case 0xD83DDE9EU: return &emojis[946];
-		case 0xD83DDE9FU: return &emojis[947];
-		case 0xD83DDEA0U: return &emojis[948];
-		case 0xD83DDEA1U: return &emojis[949];
-		case 0xD83DDEA2U: return &emojis[950];
-		case 0xD83DDEA3U: return &emojis[951];
-		case 0xD83DDEA4U: return &emojis[952];
-		case 0xD83DDEA5U: return &emojis[953];
-		case 0xD83DDEA6U: return &emojis[954];
-		case 0xD83DDEA7U: return &emojis[955];
-		case 0xD83DDEA8U: return &emojis[956];
-		case 0xD83DDEA9U: return &emojis[957];
-		case 0xD83DDEAAU: return &emojis[958];
-		case 0xD83DDEABU: return &emojis[959];
-		case 0xD83DDEACU: return &emojis[960];
-		case 0xD83DDEADU: return &emojis[961];
-		case 0xD83DDEAEU: return &emojis[962];
-		case 0xD83DDEAFU: return &emojis[963];
-		case 0xD83DDEB0U: return &emojis[964];
-		case 0xD83DDEB1U: return &emojis[965];
-		case 0xD83DDEB2U: return &emojis[966];
-		case 0xD83DDEB3U: return &emojis[967];
-		case 0xD83DDEB4U: return &emojis[968];
-		case 0xD83DDEB5U: return &emojis[969];
-		case 0xD83DDEB6U: return &emojis[970];
-		case 0xD83DDEB7U: return &emojis[971];
-		case 0xD83DDEB8U: return &emojis[972];
-		case 0xD83DDEB9U: return &emojis[973];
-		case 0xD83DDEBAU: return &emojis[974];
-		case 0xD83DDEBBU: return &emojis[975];
-		case 0xD83DDEBCU: return &emojis[976];
-		case 0xD83DDEBDU: return &emojis[977];
-		case 0xD83DDEBEU: return &emojis[978];
-		case 0xD83DDEBFU: return &emojis[979];
-		case 0xD83DDEC0U: return &emojis[980];
-		case 0xD83DDEC1U: return &emojis[981];
-		case 0xD83DDEC2U: return &emojis[982];
-		case 0xD83DDEC3U: return &emojis[983];
-		case 0xD83DDEC4U: return &emojis[984];
-		case 0xD83DDEC5U: return &emojis[985];
-		case 0xD83DDECBU: return &emojis[986];
-		case 0xD83DDECCU: return &emojis[987];
-		case 0xD83DDECDU: return &emojis[988];
-		case 0xD83DDECEU: return &emojis[989];
-		case 0xD83DDECFU: return &emojis[990];
-		case 0xD83DDED0U: return &emojis[991];
-		case 0xD83DDEE0U: return &emojis[992];
-		case 0xD83DDEE1U: return &emojis[993];
-		case 0xD83DDEE2U: return &emojis[994];
-		case 0xD83DDEE3U: return &emojis[995];
-		case 0xD83DDEE4U: return &emojis[996];
-		case 0xD83DDEE5U: return &emojis[997];
-		case 0xD83DDEE9U: return &emojis[998];
-		case 0xD83DDEEBU: return &emojis[999];
-		case 0xD83DDEECU: return &emojis[1000];
-		case 0xD83DDEF0U: return &emojis[1001];
-		case 0xD83DDEF3U: return &emojis[1002];
-		case 0xD83EDD10U: return &emojis[1003];
-		case 0xD83EDD11U: return &emojis[1004];
-		case 0xD83EDD12U: return &emojis[1005];
-		case 0xD83EDD13U: return &emojis[1006];
-		case 0xD83EDD14U: return &emojis[1007];
-		case 0xD83EDD15U: return &emojis[1008];
-		case 0xD83EDD16U: return &emojis[1009];
-		case 0xD83EDD17U: return &emojis[1010];
-		case 0xD83EDD18U: return &emojis[1011];
-		case 0xD83EDD80U: return &emojis[1012];
-		case 0xD83EDD81U: return &emojis[1013];
-		case 0xD83EDD82U: return &emojis[1014];
-		case 0xD83EDD83U: return &emojis[1015];
-		case 0xD83EDD84U: return &emojis[1016];
-		case 0xD83EDDC0U: return &emojis[1017];
-		case 0xFFFF0000U: return &emojis[1018];
-		case 0xFFFF0001U: return &emojis[1019];
-		case 0xFFFF0002U: return &emojis[1020];
-		case 0xFFFF0003U: return &emojis[1021];
-		case 0xFFFF0004U: return &emojis[1022];
-		case 0xFFFF0005U: return &emojis[1023];
-		case 0xFFFF0006U: return &emojis[1024];
-		case 0xFFFF0007U: return &emojis[1025];
-		case 0xFFFF0008U: return &emojis[1026];
-		case 0xFFFF0009U: return &emojis[1027];
-		case 0xFFFF000AU: return &emojis[1028];
-		case 0xFFFF000BU: return &emojis[1029];
-		case 0xFFFF000CU: return &emojis[1030];
-		case 0xFFFF000DU: return &emojis[1031];
-		case 0xFFFF000EU: return &emojis[1032];
-		case 0xFFFF000FU: return &emojis[1033];
-		case 0xFFFF0010U: return &emojis[1034];
-		case 0xFFFF0011U: return &emojis[1035];
-		case 0xFFFF0012U: return &emojis[1036];
-		case 0xD83CDDE6U: return TwoSymbolEmoji;
-		case 0xD83CDDE7U: return TwoSymbolEmoji;
-		case 0xD83CDDE8U: return TwoSymbolEmoji;
-		case 0xD83CDDE9U: return TwoSymbolEmoji;
-		case 0xD83CDDEAU: return TwoSymbolEmoji;
-		case 0xD83CDDEBU: return TwoSymbolEmoji;
-		case 0xD83CDDECU: return TwoSymbolEmoji;
-		case 0xD83CDDEDU: return TwoSymbolEmoji;
-		case 0xD83CDDEEU: return TwoSymbolEmoji;
-		case 0xD83CDDEFU: return TwoSymbolEmoji;
-		case 0xD83CDDF0U: return TwoSymbolEmoji;
-		case 0xD83CDDF1U: return TwoSymbolEmoji;
-		case 0xD83CDDF2U: return TwoSymbolEmoji;
-		case 0xD83CDDF3U: return TwoSymbolEmoji;
-		case 0xD83CDDF4U: return TwoSymbolEmoji;
-		case 0xD83CDDF5U: return TwoSymbolEmoji;
-		case 0xD83CDDF6U: return TwoSymbolEmoji;
-		case 0xD83CDDF7U: return TwoSymbolEmoji;
-		case 0xD83CDDF8U: return TwoSymbolEmoji;
-		case 0xD83CDDF9U: return TwoSymbolEmoji;
-		case 0xD83CDDFAU: return TwoSymbolEmoji;
-		case 0xD83CDDFBU: return TwoSymbolEmoji;
-		case 0xD83CDDFCU: return TwoSymbolEmoji;
-		case 0xD83CDDFDU: return TwoSymbolEmoji;
-		case 0xD83CDDFEU: return TwoSymbolEmoji;
-		case 0xD83CDDFFU: return TwoSymbolEmoji;
-	}
-
-	return 0;
+	return (i->index < 0) ? TwoSymbolEmoji : &emojis[i->index];
 }
 
 EmojiPtr emojiGet(uint32 code, uint32 code2) {
-	if (code < 0xD83CDDE6U || code > 0xD83CDDFFU) return 0;
+	if (!emojis) return 0;
 
-	switch (code) {
-		case 0xD83CDDE6U: switch (code2) {
-			case 0xD83CDDE9U: return &emojis[1067];
-			case 0xD83CDDEAU: return &emojis[1068];
-			case 0xD83CDDEBU: return &emojis[1069];
-			case 0xD83CDDECU: return &emojis[1070];
-			case 0xD83CDDEEU: return &emojis[1071];
-			case 0xD83CDDF1U: return &emojis[1072];
-			case 0xD83CDDF2U: return &emojis[1073];
-			case 0xD83CDDF4U: return &emojis[1074];
-			case 0xD83CDDF6U: return &emojis[1075];
-			case 0xD83CDDF7U: return &emojis[1076];
-			case 0xD83CDDF8U: return &emojis[1077];
-			case 0xD83CDDF9U: return &emojis[1078];
-			case 0xD83CDDFAU: return &emojis[1079];
-			case 0xD83CDDFCU: return &emojis[1080];
-			case 0xD83CDDFDU: return &emojis[1081];
-			case 0xD83CDDFFU: return &emojis[1082];
-			default: return 0;
-		} break;
-		case 0xD83CDDE7U: switch (code2) {
-			case 0xD83CDDE6U: return &emojis[1083];
-			case 0xD83CDDE7U: return &emojis[1084];
-			case 0xD83CDDE9U: return &emojis[1085];
-			case 0xD83CDDEAU: return &emojis[1086];
-			case 0xD83CDDEBU: return &emojis[1087];
-			case 0xD83CDDECU: return &emojis[1088];
-			case 0xD83CDDEDU: return &emojis[1089];
-			case 0xD83CDDEEU: return &emojis[1090];
-			case 0xD83CDDEFU: return &emojis[1091];
-			case 0xD83CDDF1U: return &emojis[1092];
-			case 0xD83CDDF2U: return &emojis[1093];
-			case 0xD83CDDF3U: return &emojis[1094];
-			case 0xD83CDDF4U: return &emojis[1095];
-			case 0xD83CDDF6U: return &emojis[1096];
-			case 0xD83CDDF7U: return &emojis[1097];
-			case 0xD83CDDF8U: return &emojis[1098];
-			case 0xD83CDDF9U: return &emojis[1099];
-			case 0xD83CDDFCU: return &emojis[1100];
-			case 0xD83CDDFEU: return &emojis[1101];
-			case 0xD83CDDFFU: return &emojis[1102];
-			default: return 0;
-		} break;
-		case 0xD83CDDE8U: switch (code2) {
-			case 0xD83CDDE6U: return &emojis[1103];
-			case 0xD83CDDE8U: return &emojis[1104];
-			case 0xD83CDDE9U: return &emojis[1105];
-			case 0xD83CDDEBU: return &emojis[1106];
-			case 0xD83CDDECU: return &emojis[1107];
-			case 0xD83CDDEDU: return &emojis[1108];
-			case 0xD83CDDEEU: return &emojis[1109];
-			case 0xD83CDDF0U: return &emojis[1110];
-			case 0xD83CDDF1U: return &emojis[1111];
-			case 0xD83CDDF2U: return &emojis[1112];
-			case 0xD83CDDF3U: return &emojis[1113];
-			case 0xD83CDDF4U: return &emojis[1114];
-			case 0xD83CDDF7U: return &emojis[1115];
-			case 0xD83CDDFAU: return &emojis[1116];
-			case 0xD83CDDFBU: return &emojis[1117];
-			case 0xD83CDDFCU: return &emojis[1118];
-			case 0xD83CDDFDU: return &emojis[1119];
-			case 0xD83CDDFEU: return &emojis[1120];
-			case 0xD83CDDFFU: return &emojis[1121];
-			default: return 0;
-		} break;
-		case 0xD83CDDE9U: switch (code2) {
-			case 0xD83CDDEAU: return &emojis[1122];
-			case 0xD83CDDEFU: return &emojis[1123];
-			case 0xD83CDDF0U: return &emojis[1124];
-			case 0xD83CDDF2U: return &emojis[1125];
-			case 0xD83CDDF4U: return &emojis[1126];
-			case 0xD83CDDFFU: return &emojis[1127];
-			default: return 0;
-		} break;
-		case 0xD83CDDEAU: switch (code2) {
-			case 0xD83CDDE8U: return &emojis[1128];
-			case 0xD83CDDEAU: return &emojis[1129];
-			case 0xD83CDDECU: return &emojis[1130];
-			case 0xD83CDDEDU: return &emojis[1131];
-			case 0xD83CDDF7U: return &emojis[1132];
-			case 0xD83CDDF8U: return &emojis[1133];
-			case 0xD83CDDF9U: return &emojis[1134];
-			case 0xD83CDDFAU: return &emojis[1135];
-			default: return 0;
-		} break;
-		case 0xD83CDDEBU: switch (code2) {
-			case 0xD83CDDEEU: return &emojis[1136];
-			case 0xD83CDDEFU: return &emojis[1137];
-			case 0xD83CDDF0U: return &emojis[1138];
-			case 0xD83CDDF2U: return &emojis[1139];
-			case 0xD83CDDF4U: return &emojis[1140];
-			case 0xD83CDDF7U: return &emojis[1141];
-			default: return 0;
-		} break;
-		case 0xD83CDDECU: switch (code2) {
-			case 0xD83CDDE6U: return &emojis[1142];
-			case 0xD83CDDE7U: return &emojis[1143];
-			case 0xD83CDDE9U: return &emojis[1144];
-			case 0xD83CDDEAU: return &emojis[1145];
-			case 0xD83CDDEBU: return &emojis[1146];
-			case 0xD83CDDECU: return &emojis[1147];
-			case 0xD83CDDEDU: return &emojis[1148];
-			case 0xD83CDDEEU: return &emojis[1149];
-			case 0xD83CDDF1U: return &emojis[1150];
-			case 0xD83CDDF2U: return &emojis[1151];
-			case 0xD83CDDF3U: return &emojis[1152];
-			case 0xD83CDDF5U: return &emojis[1153];
-			case 0xD83CDDF6U: return &emojis[1154];
-			case 0xD83CDDF7U: return &emojis[1155];
-			case 0xD83CDDF8U: return &emojis[1156];
-			case 0xD83CDDF9U: return &emojis[1157];
-			case 0xD83CDDFAU: return &emojis[1158];
-			case 0xD83CDDFCU: return &emojis[1159];
-			case 0xD83CDDFEU: return &emojis[1160];
-			default: return 0;
-		} break;
-		case 0xD83CDDEDU: switch (code2) {
-			case 0xD83CDDF0U: return &emojis[1161];
-			case 0xD83CDDF3U: return &emojis[1162];
-			case 0xD83CDDF7U: return &emojis[1163];
-			case 0xD83CDDF9U: return &emojis[1164];
-			case 0xD83CDDFAU: return &emojis[1165];
-			default: return 0;
-		} break;
-		case 0xD83CDDEEU: switch (code2) {
-			case 0xD83CDDE8U: return &emojis[1166];
-			case 0xD83CDDE9U: return &emojis[1167];
-			case 0xD83CDDEAU: return &emojis[1168];
-			case 0xD83CDDF1U: return &emojis[1169];
-			case 0xD83CDDF2U: return &emojis[1170];
-			case 0xD83CDDF3U: return &emojis[1171];
-			case 0xD83CDDF4U: return &emojis[1172];
-			case 0xD83CDDF6U: return &emojis[1173];
-			case 0xD83CDDF7U: return &emojis[1174];
-			case 0xD83CDDF8U: return &emojis[1175];
-			case 0xD83CDDF9U: return &emojis[1176];
-			default: return 0;
-		} break;
-		case 0xD83CDDEFU: switch (code2) {
-			case 0xD83CDDEAU: return &emojis[1177];
-			case 0xD83CDDF2U: return &emojis[1178];
-			case 0xD83CDDF4U: return &emojis[1179];
-			case 0xD83CDDF5U: return &emojis[1180];
-			default: return 0;
-		} break;
-		case 0xD83CDDF0U: switch (code2) {
-			case 0xD83CDDEAU: return &emojis[1181];
-			case 0xD83CDDECU: return &emojis[1182];
-			case 0xD83CDDEDU: return &emojis[1183];
-			case 0xD83CDDEEU: return &emojis[1184];
-			case 0xD83CDDF2U: return &emojis[1185];
-			case 0xD83CDDF3U: return &emojis[1186];
-			case 0xD83CDDF5U: return &emojis[1187];
-			case 0xD83CDDF7U: return &emojis[1188];
-			case 0xD83CDDFCU: return &emojis[1189];
-			case 0xD83CDDFEU: return &emojis[1190];
-			case 0xD83CDDFFU: return &emojis[1191];
-			default: return 0;
-		} break;
-		case 0xD83CDDF1U: switch (code2) {
-			case 0xD83CDDE6U: return &emojis[1192];
-			case 0xD83CDDE7U: return &emojis[1193];
-			case 0xD83CDDE8U: return &emojis[1194];
-			case 0xD83CDDEEU: return &emojis[1195];
-			case 0xD83CDDF0U: return &emojis[1196];
-			case 0xD83CDDF7U: return &emojis[1197];
-			case 0xD83CDDF8U: return &emojis[1198];
-			case 0xD83CDDF9U: return &emojis[1199];
-			case 0xD83CDDFAU: return &emojis[1200];
-			case 0xD83CDDFBU: return &emojis[1201];
-			case 0xD83CDDFEU: return &emojis[1202];
-			default: return 0;
-		} break;
-		case 0xD83CDDF2U: switch (code2) {
-			case 0xD83CDDE6U: return &emojis[1203];
-			case 0xD83CDDE8U: return &emojis[1204];
-			case 0xD83CDDE9U: return &emojis[1205];
-			case 0xD83CDDEAU: return &emojis[1206];
-			case 0xD83CDDECU: return &emojis[1207];
-			case 0xD83CDDEDU: return &emojis[1208];
-			case 0xD83CDDF0U: return &emojis[1209];
-			case 0xD83CDDF1U: return &emojis[1210];
-			case 0xD83CDDF2U: return &emojis[1211];
-			case 0xD83CDDF3U: return &emojis[1212];
-			case 0xD83CDDF4U: return &emojis[1213];
-			case 0xD83CDDF5U: return &emojis[1214];
-			case 0xD83CDDF6U: return &emojis[1215];
-			case 0xD83CDDF7U: return &emojis[1216];
-			case 0xD83CDDF8U: return &emojis[1217];
-			case 0xD83CDDF9U: return &emojis[1218];
-			case 0xD83CDDFAU: return &emojis[1219];
-			case 0xD83CDDFBU: return &emojis[1220];
-			case 0xD83CDDFCU: return &emojis[1221];
-			case 0xD83CDDFDU: return &emojis[1222];
-			case 0xD83CDDFEU: return &emojis[1223];
-			case 0xD83CDDFFU: return &emojis[1224];
-			default: return 0;
-		} break;
-		case 0xD83CDDF3U: switch (code2) {
-			case 0xD83CDDE6U: return &emojis[1225];
-			case 0xD83CDDE8U: return &emojis[1226];
-			case 0xD83CDDEAU: return &emojis[1227];
-			case 0xD83CDDEBU: return &emojis[1228];
-			case 0xD83CDDECU: return &emojis[1229];
-			case 0xD83CDDEEU: return &emojis[1230];
-			case 0xD83CDDF1U: return &emojis[1231];
-			case 0xD83CDDF4U: return &emojis[1232];
-			case 0xD83CDDF5U: return &emojis[1233];
-			case 0xD83CDDF7U: return &emojis[1234];
-			case 0xD83CDDFAU: return &emojis[1235];
-			case 0xD83CDDFFU: return &emojis[1236];
-			default: return 0;
-		} break;
-		case 0xD83CDDF4U: switch (code2) {
-			case 0xD83CDDF2U: return &emojis[1237];
-			default: return 0;
-		} break;
-		case 0xD83CDDF5U: switch (code2) {
-			case 0xD83CDDE6U: return &emojis[1238];
-			case 0xD83CDDEAU: return &emojis[1239];
-			case 0xD83CDDEBU: return &emojis[1240];
-			case 0xD83CDDECU: return &emojis[1241];
-			case 0xD83CDDEDU: return &emojis[1242];
-			case 0xD83CDDF0U: return &emojis[1243];
-			case 0xD83CDDF1U: return &emojis[1244];
-			case 0xD83CDDF2U: return &emojis[1245];
-			case 0xD83CDDF3U: return &emojis[1246];
-			case 0xD83CDDF7U: return &emojis[1247];
-			case 0xD83CDDF8U: return &emojis[1248];
-			case 0xD83CDDF9U: return &emojis[1249];
-			case 0xD83CDDFCU: return &emojis[1250];
-			case 0xD83CDDFEU: return &emojis[1251];
-			default: return 0;
-		} break;
-		case 0xD83CDDF6U: switch (code2) {
-			case 0xD83CDDE6U: return &emojis[1252];
-			default: return 0;
-		} break;
-		case 0xD83CDDF7U: switch (code2) {
-			case 0xD83CDDEAU: return &emojis[1253];
-			case 0xD83CDDF4U: return &emojis[1254];
-			case 0xD83CDDF8U: return &emojis[1255];
-			case 0xD83CDDFAU: return &emojis[1256];
-			case 0xD83CDDFCU: return &emojis[1257];
-			default: return 0;
-		} break;
-		case 0xD83CDDF8U: switch (code2) {
-			case 0xD83CDDE6U: return &emojis[1258];
-			case 0xD83CDDE7U: return &emojis[1259];
-			case 0xD83CDDE8U: return &emojis[1260];
-			case 0xD83CDDE9U: return &emojis[1261];
-			case 0xD83CDDEAU: return &emojis[1262];
-			case 0xD83CDDECU: return &emojis[1263];
-			case 0xD83CDDEDU: return &emojis[1264];
-			case 0xD83CDDEEU: return &emojis[1265];
-			case 0xD83CDDF0U: return &emojis[1266];
-			case 0xD83CDDF1U: return &emojis[1267];
-			case 0xD83CDDF2U: return &emojis[1268];
-			case 0xD83CDDF3U: return &emojis[1269];
-			case 0xD83CDDF4U: return &emojis[1270];
-			case 0xD83CDDF7U: return &emojis[1271];
-			case 0xD83CDDF8U: return &emojis[1272];
-			case 0xD83CDDF9U: return &emojis[1273];
-			case 0xD83CDDFBU: return &emojis[1274];
-			case 0xD83CDDFDU: return &emojis[1275];
-			case 0xD83CDDFEU: return &emojis[1276];
-			case 0xD83CDDFFU: return &emojis[1277];
-			default: return 0;
-		} break;
-		case 0xD83CDDF9U: switch (code2) {
-			case 0xD83CDDE8U: return &emojis[1278];
-			case 0xD83CDDE9U: return &emojis[1279];
-			case 0xD83CDDEBU: return &emojis[1280];
-			case 0xD83CDDECU: return &emojis[1281];
-			case 0xD83CDDEDU: return &emojis[1282];
-			case 0xD83CDDEFU: return &emojis[1283];
-			case 0xD83CDDF0U: return &emojis[1284];
-			case 0xD83CDDF1U: return &emojis[1285];
-			case 0xD83CDDF2U: return &emojis[1286];
-			case 0xD83CDDF3U: return &emojis[1287];
-			case 0xD83CDDF4U: return &emojis[1288];
-			case 0xD83CDDF7U: return &emojis[1289];
-			case 0xD83CDDF9U: return &emojis[1290];
-			case 0xD83CDDFBU: return &emojis[1291];
-			case 0xD83CDDFCU: return &emojis[1292];
-			case 0xD83CDDFFU: return &emojis[1293];
-			default: return 0;
-		} break;
-		case 0xD83CDDFAU: switch (code2) {
-			case 0xD83CDDE6U: return &emojis[1294];
-			case 0xD83CDDECU: return &emojis[1295];
-			case 0xD83CDDF8U: return &emojis[1296];
-			case 0xD83CDDFEU: return &emojis[1297];
-			case 0xD83CDDFFU: return &emojis[1298];
-			default: return 0;
-		} break;
-		case 0xD83CDDFBU: switch (code2) {
-			case 0xD83CDDE6U: return &emojis[1299];
-			case 0xD83CDDE8U: return &emojis[1300];
-			case 0xD83CDDEAU: return &emojis[1301];
-			case 0xD83CDDECU: return &emojis[1302];
-			case 0xD83CDDEEU: return &emojis[1303];
-			case 0xD83CDDF3U: return &emojis[1304];
-			case 0xD83CDDFAU: return &emojis[1305];
-			default: return 0;
-		} break;
-		case 0xD83CDDFCU: switch (code2) {
-			case 0xD83CDDEBU: return &emojis[1306];
-			case 0xD83CDDF8U: return &emojis[1307];
-			default: return 0;
-		} break;
-		case 0xD83CDDFDU: switch (code2) {
-			case 0xD83CDDF0U: return &emojis[1308];
-			default: return 0;
-		} break;
-		case 0xD83CDDFEU: switch (code2) {
-			case 0xD83CDDEAU: return &emojis[1309];
-			case 0xD83CDDF9U: return &emojis[1310];
-			default: return 0;
-		} break;
-		case 0xD83CDDFFU: switch (code2) {
-			case 0xD83CDDE6U: return &emojis[1311];
-			case 0xD83CDDF2U: return &emojis[1312];
-			case 0xD83CDDFCU: return &emojis[1313];
-			default: return 0;
-		} break;
-	}
+	auto key = (uint64(code) << 32) | uint64(code2);
+	auto i = std::lower_bound(std::begin(emojiPairs), std::end(emojiPairs), key, [](const EmojiPairEntry &entry, uint64 key) {
+		return entry.key < key;
+	});
+	if (i == std::end(emojiPairs) || i->key != key) return 0;
 
-	return 0;
+	return &emojis[i->index];
 }
 
 EmojiPtr emojiGet(EmojiPtr emoji, uint32 color) {
@@ -3205,441 +3109,127 @@ QString emojiGetSequence(int index) {
 	return (index >= 0 && index < sequences.size()) ? sequences.at(index) : QString();
 }
 
+namespace {
+
+struct EmojiReplaceNode {
+	ushort ch;
+	uint16 childrenStart, childrenCount;
+	uint32 code; // 0 if no replacement ends in this node
+};
+
+constexpr int kEmojiReplaceMaxLength = 9;
+constexpr EmojiReplaceNode emojiReplaceTrie[] = {
+	{ 0x0, 1, 10, 0x0U },
+	{ 0x33, 11, 2, 0x0U }, // 3
+	{ 0x38, 13, 3, 0x0U }, // 8
+	{ 0x3A, 16, 15, 0x0U }, // :
+	{ 0x3B, 31, 2, 0x0U }, // ;
+	{ 0x3C, 33, 1, 0x0U }, // <
+	{ 0x3E, 34, 1, 0x0U }, // >
+	{ 0x42, 35, 1, 0x0U }, // B
+	{ 0x4F, 36, 1, 0x0U }, // O
+	{ 0x78, 37, 1, 0x0U }, // x
+	{ 0x7D, 38, 1, 0x0U }, // }
+	{ 0x28, 39, 0, 0xD83DDE14U }, // 3(
+	{ 0x2D, 39, 1, 0x0U }, // 3-
+	{ 0x2D, 40, 1, 0x0U }, // 8-
+	{ 0x6F, 41, 0, 0xD83DDE32U }, // 8o
+	{ 0x7C, 41, 0, 0xD83DDE33U }, // 8|
+	{ 0x27, 41, 1, 0x0U }, // :'
+	{ 0x28, 42, 1, 0x0U }, // :(
+	{ 0x2D, 43, 5, 0x0U }, // :-
+	{ 0x58, 48, 0, 0xD83DDE37U }, // :X
+	{ 0x5D, 48, 0, 0xD83DDE0FU }, // :]
+	{ 0x5F, 48, 1, 0x0U }, // :_
+	{ 0x64, 49, 1, 0x0U }, // :d
+	{ 0x67, 50, 1, 0x0U }, // :g
+	{ 0x6A, 51, 1, 0x0U }, // :j
+	{ 0x6B, 52, 1, 0x0U }, // :k
+	{ 0x6C, 53, 1, 0x0U }, // :l
+	{ 0x6F, 54, 1, 0xD83DDE28U }, // :o
+	{ 0x75, 55, 1, 0x0U }, // :u
+	{ 0x76, 56, 1, 0x0U }, // :v
+	{ 0x7C, 57, 0, 0xD83DDE10U }, // :|
+	{ 0x2D, 57, 2, 0x0U }, // ;-
+	{ 0x6F, 59, 0, 0xD83DDE30U }, // ;o
+	{ 0x33, 59, 0, 0x2764U }, // <3
+	{ 0x28, 59, 1, 0xD83DDE20U }, // >(
+	{ 0x2D, 60, 1, 0x0U }, // B-
+	{ 0x3A, 61, 1, 0x0U }, // O:
+	{ 0x44, 62, 0, 0xD83DDE06U }, // xD
+	{ 0x3A, 62, 1, 0x0U }, // }:
+	{ 0x29, 63, 0, 0xD83DDE0CU }, // 3-)
+	{ 0x29, 63, 0, 0xD83DDE0DU }, // 8-)
+	{ 0x28, 63, 0, 0xD83DDE22U }, // :'(
+	{ 0x28, 63, 0, 0xD83DDE29U }, // :((
+	{ 0x28, 63, 0, 0xD83DDE1EU }, // :-(
+	{ 0x29, 63, 0, 0xD83DDE0AU }, // :-)
+	{ 0x2A, 63, 0, 0xD83DDE1AU }, // :-*
+	{ 0x44, 63, 0, 0xD83DDE03U }, // :-D
+	{ 0x70, 63, 0, 0xD83DDE0BU }, // :-p
+	{ 0x28, 63, 0, 0xD83DDE2DU }, // :_(
+	{ 0x69, 63, 1, 0x0U }, // :di
+	{ 0x72, 64, 1, 0x0U }, // :gr
+	{ 0x6F, 65, 1, 0x0U }, // :jo
+	{ 0x69, 66, 1, 0x0U }, // :ki
+	{ 0x69, 67, 1, 0x0U }, // :li
+	{ 0x6B, 68, 1, 0x0U }, // :ok
+	{ 0x70, 69, 1, 0x0U }, // :up
+	{ 0x3A, 70, 0, 0x270CU }, // :v:
+	{ 0x29, 70, 0, 0xD83DDE09U }, // ;-)
+	{ 0x50, 70, 0, 0xD83DDE1CU }, // ;-P
+	{ 0x28, 70, 0, 0xD83DDE21U }, // >((
+	{ 0x29, 70, 0, 0xD83DDE0EU }, // B-)
+	{ 0x29, 70, 0, 0xD83DDE07U }, // O:)
+	{ 0x29, 70, 0, 0xD83DDE08U }, // }:)
+	{ 0x73, 70, 1, 0x0U }, // :dis
+	{ 0x69, 71, 1, 0x0U }, // :gri
+	{ 0x79, 72, 1, 0x0U }, // :joy
+	{ 0x73, 73, 1, 0x0U }, // :kis
+	{ 0x6B, 74, 1, 0x0U }, // :lik
+	{ 0x3A, 75, 0, 0xD83DDC4CU }, // :ok:
+	{ 0x3A, 75, 0, 0x261DU }, // :up:
+	{ 0x6C, 75, 1, 0x0U }, // :disl
+	{ 0x6E, 76, 1, 0x0U }, // :grin
+	{ 0x3A, 77, 0, 0xD83DDE02U }, // :joy:
+	{ 0x73, 77, 1, 0x0U }, // :kiss
+	{ 0x65, 78, 1, 0x0U }, // :like
+	{ 0x69, 79, 1, 0x0U }, // :disli
+	{ 0x3A, 80, 0, 0xD83DDE01U }, // :grin:
+	{ 0x3A, 80, 0, 0xD83DDC8BU }, // :kiss:
+	{ 0x3A, 80, 0, 0xD83DDC4DU }, // :like:
+	{ 0x6B, 80, 1, 0x0U }, // :dislik
+	{ 0x65, 81, 1, 0x0U }, // :dislike
+	{ 0x3A, 82, 0, 0xD83DDC4EU }, // :dislike:
+};
+
+} // namespace
+
 void emojiFind(const QChar *ch, const QChar *e, const QChar *&newEmojiEnd, uint32 &emojiCode) {
-	switch (ch->unicode()) {
-	case '}':
-		if (ch + 1 != e) switch ((ch + 1)->unicode()) {
-		case ':':
-			if (ch + 2 != e) switch ((ch + 2)->unicode()) {
-			case ')':
-				newEmojiEnd = ch + 3;
-				if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-					emojiCode = 0xD83DDE08U;
-					return;
-				}
-			break;
-			}
-		break;
-		}
-	break;
-	case 'x':
-		if (ch + 1 != e) switch ((ch + 1)->unicode()) {
-		case 'D':
-			newEmojiEnd = ch + 2;
-			if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-				emojiCode = 0xD83DDE06U;
-				return;
-			}
-		break;
-		}
-	break;
-	case 'O':
-		if (ch + 1 != e) switch ((ch + 1)->unicode()) {
-		case ':':
-			if (ch + 2 != e) switch ((ch + 2)->unicode()) {
-			case ')':
-				newEmojiEnd = ch + 3;
-				if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-					emojiCode = 0xD83DDE07U;
-					return;
-				}
-			break;
-			}
-		break;
-		}
-	break;
-	case 'B':
-		if (ch + 1 != e) switch ((ch + 1)->unicode()) {
-		case '-':
-			if (ch + 2 != e) switch ((ch + 2)->unicode()) {
-			case ')':
-				newEmojiEnd = ch + 3;
-				if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-					emojiCode = 0xD83DDE0EU;
-					return;
-				}
-			break;
-			}
-		break;
-		}
-	break;
-	case '>':
-		if (ch + 1 != e) switch ((ch + 1)->unicode()) {
-		case '(':
-			if (ch + 2 != e) switch ((ch + 2)->unicode()) {
-			case '(':
-				newEmojiEnd = ch + 3;
-				if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-					emojiCode = 0xD83DDE21U;
-					return;
-				}
-			break;
-			}
-			newEmojiEnd = ch + 2;
-			if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-				emojiCode = 0xD83DDE20U;
-				return;
-			}
-		break;
-		}
-	break;
-	case '<':
-		if (ch + 1 != e) switch ((ch + 1)->unicode()) {
-		case '3':
-			newEmojiEnd = ch + 2;
-			if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-				emojiCode = 0x2764U;
-				return;
-			}
-		break;
-		}
-	break;
-	case ';':
-		if (ch + 1 != e) switch ((ch + 1)->unicode()) {
-		case 'o':
-			newEmojiEnd = ch + 2;
-			if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-				emojiCode = 0xD83DDE30U;
-				return;
-			}
-		break;
-		case '-':
-			if (ch + 2 != e) switch ((ch + 2)->unicode()) {
-			case 'P':
-				newEmojiEnd = ch + 3;
-				if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-					emojiCode = 0xD83DDE1CU;
-					return;
-				}
-			break;
-			case ')':
-				newEmojiEnd = ch + 3;
-				if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-					emojiCode = 0xD83DDE09U;
-					return;
-				}
-			break;
-			}
-		break;
-		}
-	break;
-	case ':':
-		if (ch + 1 != e) switch ((ch + 1)->unicode()) {
-		case '|':
-			newEmojiEnd = ch + 2;
-			if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-				emojiCode = 0xD83DDE10U;
-				return;
-			}
-		break;
-		case 'v':
-			if (ch + 2 != e) switch ((ch + 2)->unicode()) {
-			case ':':
-				newEmojiEnd = ch + 3;
-				if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-					emojiCode = 0x270CU;
-					return;
-				}
-			break;
-			}
-		break;
-		case 'u':
-			if (ch + 2 != e) switch ((ch + 2)->unicode()) {
-			case 'p':
-				if (ch + 3 != e) switch ((ch + 3)->unicode()) {
-				case ':':
-					newEmojiEnd = ch + 4;
-					if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-						emojiCode = 0x261DU;
-						return;
-					}
-				break;
-				}
-			break;
-			}
-		break;
-		case 'o':
-			if (ch + 2 != e) switch ((ch + 2)->unicode()) {
-			case 'k':
-				if (ch + 3 != e) switch ((ch + 3)->unicode()) {
-				case ':':
-					newEmojiEnd = ch + 4;
-					if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-						emojiCode = 0xD83DDC4CU;
-						return;
-					}
-				break;
-				}
-			break;
-			}
-			newEmojiEnd = ch + 2;
-			if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-				emojiCode = 0xD83DDE28U;
-				return;
-			}
-		break;
-		case 'l':
-			if (ch + 2 != e) switch ((ch + 2)->unicode()) {
-			case 'i':
-				if (ch + 3 != e) switch ((ch + 3)->unicode()) {
-				case 'k':
-					if (ch + 4 != e) switch ((ch + 4)->unicode()) {
-					case 'e':
-						if (ch + 5 != e) switch ((ch + 5)->unicode()) {
-						case ':':
-							newEmojiEnd = ch + 6;
-							if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-								emojiCode = 0xD83DDC4DU;
-								return;
-							}
-						break;
-						}
-					break;
-					}
-				break;
-				}
-			break;
-			}
-		break;
-		case 'k':
-			if (ch + 2 != e) switch ((ch + 2)->unicode()) {
-			case 'i':
-				if (ch + 3 != e) switch ((ch + 3)->unicode()) {
-				case 's':
-					if (ch + 4 != e) switch ((ch + 4)->unicode()) {
-					case 's':
-						if (ch + 5 != e) switch ((ch + 5)->unicode()) {
-						case ':':
-							newEmojiEnd = ch + 6;
-							if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-								emojiCode = 0xD83DDC8BU;
-								return;
-							}
-						break;
-						}
-					break;
-					}
-				break;
-				}
-			break;
-			}
-		break;
-		case 'j':
-			if (ch + 2 != e) switch ((ch + 2)->unicode()) {
-			case 'o':
-				if (ch + 3 != e) switch ((ch + 3)->unicode()) {
-				case 'y':
-					if (ch + 4 != e) switch ((ch + 4)->unicode()) {
-					case ':':
-						newEmojiEnd = ch + 5;
-						if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-							emojiCode = 0xD83DDE02U;
-							return;
-						}
-					break;
-					}
-				break;
-				}
-			break;
-			}
-		break;
-		case 'g':
-			if (ch + 2 != e) switch ((ch + 2)->unicode()) {
-			case 'r':
-				if (ch + 3 != e) switch ((ch + 3)->unicode()) {
-				case 'i':
-					if (ch + 4 != e) switch ((ch + 4)->unicode()) {
-					case 'n':
-						if (ch + 5 != e) switch ((ch + 5)->unicode()) {
-						case ':':
-							newEmojiEnd = ch + 6;
-							if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-								emojiCode = 0xD83DDE01U;
-								return;
-							}
-						break;
-						}
-					break;
-					}
-				break;
-				}
-			break;
-			}
-		break;
-		case 'd':
-			if (ch + 2 != e) switch ((ch + 2)->unicode()) {
-			case 'i':
-				if (ch + 3 != e) switch ((ch + 3)->unicode()) {
-				case 's':
-					if (ch + 4 != e) switch ((ch + 4)->unicode()) {
-					case 'l':
-						if (ch + 5 != e) switch ((ch + 5)->unicode()) {
-						case 'i':
-							if (ch + 6 != e) switch ((ch + 6)->unicode()) {
-							case 'k':
-								if (ch + 7 != e) switch ((ch + 7)->unicode()) {
-								case 'e':
-									if (ch + 8 != e) switch ((ch + 8)->unicode()) {
-									case ':':
-										newEmojiEnd = ch + 9;
-										if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-											emojiCode = 0xD83DDC4EU;
-											return;
-										}
-									break;
-									}
-								break;
-								}
-							break;
-							}
-						break;
-						}
-					break;
-					}
-				break;
-				}
-			break;
-			}
-		break;
-		case '_':
-			if (ch + 2 != e) switch ((ch + 2)->unicode()) {
-			case '(':
-				newEmojiEnd = ch + 3;
-				if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-					emojiCode = 0xD83DDE2DU;
-					return;
-				}
-			break;
-			}
-		break;
-		case ']':
-			newEmojiEnd = ch + 2;
-			if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-				emojiCode = 0xD83DDE0FU;
-				return;
-			}
-		break;
-		case 'X':
-			newEmojiEnd = ch + 2;
-			if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-				emojiCode = 0xD83DDE37U;
-				return;
-			}
-		break;
-		case '-':
-			if (ch + 2 != e) switch ((ch + 2)->unicode()) {
-			case 'p':
-				newEmojiEnd = ch + 3;
-				if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-					emojiCode = 0xD83DDE0BU;
-					return;
-				}
-			break;
-			case 'D':
-				newEmojiEnd = ch + 3;
-				if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-					emojiCode = 0xD83DDE03U;
-					return;
-				}
-			break;
-			case '*':
-				newEmojiEnd = ch + 3;
-				if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-					emojiCode = 0xD83DDE1AU;
-					return;
-				}
-			break;
-			case ')':
-				newEmojiEnd = ch + 3;
-				if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-					emojiCode = 0xD83DDE0AU;
-					return;
-				}
-			break;
-			case '(':
-				newEmojiEnd = ch + 3;
-				if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-					emojiCode = 0xD83DDE1EU;
-					return;
-				}
-			break;
-			}
-		break;
-		case '(':
-			if (ch + 2 != e) switch ((ch + 2)->unicode()) {
-			case '(':
-				newEmojiEnd = ch + 3;
-				if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-					emojiCode = 0xD83DDE29U;
-					return;
-				}
-			break;
-			}
-		break;
-		case '\'':
-			if (ch + 2 != e) switch ((ch + 2)->unicode()) {
-			case '(':
-				newEmojiEnd = ch + 3;
-				if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-					emojiCode = 0xD83DDE22U;
-					return;
-				}
-			break;
-			}
-		break;
-		}
-	break;
-	case '8':
-		if (ch + 1 != e) switch ((ch + 1)->unicode()) {
-		case '|':
-			newEmojiEnd = ch + 2;
-			if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-				emojiCode = 0xD83DDE33U;
-				return;
-			}
-		break;
-		case 'o':
-			newEmojiEnd = ch + 2;
-			if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-				emojiCode = 0xD83DDE32U;
-				return;
-			}
-		break;
-		case '-':
-			if (ch + 2 != e) switch ((ch + 2)->unicode()) {
-			case ')':
-				newEmojiEnd = ch + 3;
-				if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-					emojiCode = 0xD83DDE0DU;
-					return;
-				}
-			break;
-			}
-		break;
-		}
-	break;
-	case '3':
-		if (ch + 1 != e) switch ((ch + 1)->unicode()) {
-		case '-':
-			if (ch + 2 != e) switch ((ch + 2)->unicode()) {
-			case ')':
-				newEmojiEnd = ch + 3;
-				if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-					emojiCode = 0xD83DDE0CU;
-					return;
-				}
-			break;
-			}
-		break;
-		case '(':
-			newEmojiEnd = ch + 2;
-			if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
-				emojiCode = 0xD83DDE14U;
-				return;
-			}
-		break;
+	const EmojiReplaceNode *found[kEmojiReplaceMaxLength] = { nullptr };
+	auto node = &emojiReplaceTrie[0];
+	auto length = 0;
+	for (; length < kEmojiReplaceMaxLength && ch + length != e; ++length) {
+		auto childrenBegin = emojiReplaceTrie + node->childrenStart, childrenEnd = childrenBegin + node->childrenCount;
+		auto unicode = (ch + length)->unicode();
+		auto child = std::lower_bound(childrenBegin, childrenEnd, unicode, [](const EmojiReplaceNode &node, ushort unicode) {
+			return node.ch < unicode;
+		});
+		if (child == childrenEnd || child->ch != unicode) break;
+
+		node = found[length] = child;
+	}
+
+	// prefer the longest replacement that ends on an edge
+	while (length > 0) {
+		auto match = found[--length];
+		if (!match->code) continue;
+
+		newEmojiEnd = ch + length + 1;
+		if (newEmojiEnd == e || emojiEdge(newEmojiEnd) || newEmojiEnd->unicode() == ' ') {
+			emojiCode = match->code;
+			return;
 		}
-	break;
 	}
 }
 
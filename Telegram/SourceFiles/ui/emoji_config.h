@@ -20,7 +20,7 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 */
 #pragma once
 
-#include "ui/text/text.h"
+#include "ui/text/text_entity.h"
 
 void emojiInit();
 EmojiPtr emojiGet(uint32 code);
@@ -23,6 +23,7 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 
 #include "mainwidget.h"
 #include "localstorage.h"
+#include "core/task_queue.h"
 
 #include "pspecific.h"
 
@@ -367,6 +368,33 @@ StorageImages storageImages;
 
 int64 globalAcquiredSize = 0;
 
+// Forgotten images being decoded on a background thread with request ids,
+// so that a result of a cancelled or outdated request is skipped.
+QMap<const Image*, uint64> restoringImages;
+uint64 restoringImagesLastId = 0;
+
+struct RestoreStatistics {
+	int64 count = 0;
+	TimeMs latencyTotal = 0;
+	TimeMs latencyMax = 0;
+	TimeMs decodeTotal = 0;
+};
+RestoreStatistics restoreStatistics;
+
+void countRestore(TimeMs latency, TimeMs decodeTime) {
+	constexpr auto kLogRestoresCount = 100;
+
+	auto &statistics = restoreStatistics;
+	++statistics.count;
+	statistics.latencyTotal += latency;
+	statistics.decodeTotal += decodeTime;
+	accumulate_max(statistics.latencyMax, latency);
+	if (statistics.count % kLogRestoresCount) {
+		return;
+	}
+	DEBUG_LOG(("Images Info: %1 async decodes, average latency %2ms, max latency %3ms, average decode %4ms").arg(statistics.count).arg(float64(statistics.latencyTotal) / statistics.count).arg(statistics.latencyMax).arg(float64(statistics.decodeTotal) / statistics.count));
+}
+
 uint64 PixKey(int width, int height, Images::Options options) {
 	return static_cast<uint64>(width) | (static_cast<uint64>(height) << 24) | (static_cast<uint64>(options) << 48);
 }
@@ -674,7 +702,7 @@ const QPixmap &Image::pixBlurredSingle(int w, int h, int32 outerw, int32 outerh,
 
 QPixmap Image::pixNoCache(int w, int h, Images::Options options, int outerw, int outerh) const {
 	if (!loading()) const_cast<Image*>(this)->load();
-	restore();
+	restoreAsync();
 
 	if (_data.isNull()) {
 		if (h <= 0 && height() > 0) {
@@ -724,7 +752,7 @@ QPixmap Image::pixNoCache(int w, int h, Images::Options options, int outerw, int
 
 QPixmap Image::pixColoredNoCache(style::color add, int32 w, int32 h, bool smooth) const {
 	const_cast<Image*>(this)->load();
-	restore();
+	restoreAsync();
 	if (_data.isNull()) return blank()->pix();
 
 	QImage img = _data.toImage();
@@ -737,7 +765,7 @@ QPixmap Image::pixColoredNoCache(style::color add, int32 w, int32 h, bool smooth
 
 QPixmap Image::pixBlurredColoredNoCache(style::color add, int32 w, int32 h) const {
 	const_cast<Image*>(this)->load();
-	restore();
+	restoreAsync();
 	if (_data.isNull()) return blank()->pix();
 
 	QImage img = Images::prepareBlur(_data.toImage());
@@ -753,27 +781,23 @@ QPixmap Image::pixBlurredColoredNoCache(style::color add, int32 w, int32 h) cons
 void Image::forget() const {
 	if (_forgot) return;
 
-	if (_data.isNull()) return;
+	// Encoding a pixmap without the source data costs more than keeping it.
+	if (_data.isNull() || _saved.isEmpty()) return;
 
 	invalidateSizeCache();
-	if (_saved.isEmpty()) {
-		QBuffer buffer(&_saved);
-		if (!_data.save(&buffer, _format)) {
-			if (_data.save(&buffer, "PNG")) {
-				_format = "PNG";
-			} else {
-				return;
-			}
-		}
-	}
 	globalAcquiredSize -= int64(_data.width()) * _data.height() * 4;
+	_forgotSize = _data.size();
 	_data = QPixmap();
 	_forgot = true;
+	restoringImages.remove(this);
 }
 
 void Image::restore() const {
 	if (!_forgot) return;
 
+	restoringImages.remove(this);
+	invalidateSizeCache();
+
 	QBuffer buffer(&_saved);
 	QImageReader reader(&buffer, _format);
 #ifndef OS_MAC_OLD
@@ -787,6 +811,55 @@ void Image::restore() const {
 	_forgot = false;
 }
 
+void Image::restoreAsync() const {
+	if (!_forgot || restoringImages.contains(this)) return;
+
+	auto requestId = ++restoringImagesLastId;
+	restoringImages.insert(this, requestId);
+
+	auto image = this;
+	auto requested = getms();
+	base::TaskQueue::Normal().Put([image, requestId, requested, saved = _saved, format = _format] {
+		auto decodeStart = getms();
+		auto bytes = saved;
+		QBuffer buffer(&bytes);
+		QImageReader reader(&buffer, format);
+#ifndef OS_MAC_OLD
+		reader.setAutoTransform(true);
+#endif // OS_MAC_OLD
+		struct mutable_data {
+			mutable_data(QImage &&value) : value(std_::move(value)) {
+			}
+			mutable QImage value;
+		};
+		auto data = mutable_data(reader.read());
+		auto decodeTime = getms() - decodeStart;
+		base::TaskQueue::Main().Put([image, requestId, requested, decodeTime, data = std_::move(data)] {
+			auto i = restoringImages.find(image);
+			if (i == restoringImages.end() || i.value() != requestId) {
+				return;
+			}
+			restoringImages.erase(i);
+			countRestore(getms() - requested, decodeTime);
+			image->finishRestore(std_::move(data.value));
+		});
+	});
+}
+
+void Image::finishRestore(QImage &&data) const {
+	if (!_forgot) return;
+
+	_data = App::pixmapFromImageInPlace(std_::move(data));
+	if (!_data.isNull()) {
+		globalAcquiredSize += int64(_data.width()) * _data.height() * 4;
+	}
+	_forgot = false;
+
+	// Drop the blank placeholders cached while the image was decoding.
+	invalidateSizeCache();
+	FileDownload::ImageLoaded().notify();
+}
+
 void Image::invalidateSizeCache() const {
 	for (auto &pix : _sizesCache) {
 		if (!pix.isNull()) {
@@ -797,6 +870,7 @@ void Image::invalidateSizeCache() const {
 }
 
 Image::~Image() {
+	restoringImages.remove(this);
 	invalidateSizeCache();
 	if (!_data.isNull()) {
 		globalAcquiredSize -= int64(_data.width()) * _data.height() * 4;
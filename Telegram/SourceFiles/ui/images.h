@@ -219,7 +219,15 @@ public:
 
 	bool isNull() const;
 
+	// forget() drops the decoded pixmap of an image that has compressed data,
+	// paint calls decode it back on a background thread, showing a blank
+	// placeholder until it is ready. restore() decodes it synchronously,
+	// call it before preparing a pixmap that is kept after the paint.
 	void forget() const;
+	void restore() const;
+	bool forgotten() const {
+		return _forgot;
+	}
 
 	QByteArray savedFormat() const {
 		return _format;
@@ -241,19 +249,17 @@ protected:
 	Image(QByteArray format = "PNG") : _format(format), _forgot(false) {
 	}
 
-	void restore() const;
+	void restoreAsync() const;
 	virtual void checkload() const {
 	}
 	void invalidateSizeCache() const;
 
 	virtual int32 countWidth() const {
-		restore();
-		return _data.width();
+		return _forgot ? _forgotSize.width() : _data.width();
 	}
 
 	virtual int32 countHeight() const {
-		restore();
-		return _data.height();
+		return _forgot ? _forgotSize.height() : _data.height();
 	}
 
 	mutable QByteArray _saved, _format;
@@ -261,6 +267,10 @@ protected:
 	mutable QPixmap _data;
 
 private:
+	void finishRestore(QImage &&data) const;
+
+	mutable QSize _forgotSize;
+
 	using Sizes = QMap<uint64, QPixmap>;
 	mutable Sizes _sizesCache;
 
@@ -64,8 +64,10 @@ void startManager() {
 		cSetRealScale(dbisOne);
 	}
 
+	auto ms = getms(true);
 	internal::registerFontFamily(qsl("Open Sans"));
 	internal::startModules();
+	DEBUG_LOG(("Style Info: modules started in %1ms, fonts created: %2").arg(getms(true) - ms).arg(internal::fontsCreated()));
 }
 
 void stopManager() {
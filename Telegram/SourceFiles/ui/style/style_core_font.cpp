@@ -33,9 +33,25 @@ FontFamilies fontFamilies;
 
 typedef QMap<uint32, FontData*> FontDatas;
 FontDatas fontsMap;
+int fontsCreatedCount = 0;
+
+constexpr auto kFontFlagsBits = 3;
+constexpr auto kFontSizeBits = 10;
 
 uint32 fontKey(int size, uint32 flags, int family) {
-	return (((uint32(family) << 10) | uint32(size)) << 3) | flags;
+	return (((uint32(family) << kFontSizeBits) | uint32(size)) << kFontFlagsBits) | flags;
+}
+
+int fontKeySize(uint32 key) {
+	return int((key >> kFontFlagsBits) & ((1U << kFontSizeBits) - 1));
+}
+
+uint32 fontKeyFlags(uint32 key) {
+	return key & ((1U << kFontFlagsBits) - 1);
+}
+
+int fontKeyFamily(uint32 key) {
+	return int(key >> (kFontFlagsBits + kFontSizeBits));
 }
 
 } // namespace
@@ -47,6 +63,10 @@ void destroyFonts() {
 	fontsMap.clear();
 }
 
+int fontsCreated() {
+	return fontsCreatedCount;
+}
+
 int registerFontFamily(const QString &family) {
 	auto result = fontFamilyMap.value(family, -1);
 	if (result < 0) {
@@ -58,10 +78,12 @@ int registerFontFamily(const QString &family) {
 }
 
 FontData::FontData(int size, uint32 flags, int family, Font *other) : f(fontFamilies[family]), m(f), _size(size), _flags(flags), _family(family) {
+	// The array is default-constructed empty, Font keeps a key for the
+	// lazy creation, so it can't be filled by memset / memcpy any more.
 	if (other) {
-		memcpy(modified, other, sizeof(modified));
-	} else {
-		memset(modified, 0, sizeof(modified));
+		for (auto i = 0; i != FontDifferentFlags; ++i) {
+			modified[i] = other[i];
+		}
 	}
 	modified[_flags] = Font(this);
 
@@ -105,7 +127,7 @@ int FontData::family() const {
 
 Font FontData::otherFlagsFont(uint32 flag, bool set) const {
 	int32 newFlags = set ? (_flags | flag) : (_flags & ~flag);
-	if (!modified[newFlags].v()) {
+	if (!modified[newFlags].ptr) {
 		modified[newFlags] = Font(_size, newFlags, _family, modified);
 	}
 	return modified[newFlags];
@@ -123,22 +145,34 @@ Font::Font(int size, uint32 flags, const QString &family) {
 		fontFamilies.push_back(family);
 		i = fontFamilyMap.insert(family, fontFamilies.size() - 1);
 	}
-	init(size, flags, i.value(), 0);
+	ptr = nullptr;
+	key = fontKey(size, flags, i.value());
 }
 
-Font::Font(int size, uint32 flags, int family) {
-	init(size, flags, family, 0);
+Font::Font(int size, uint32 flags, int family)
+: ptr(nullptr)
+, key(fontKey(size, flags, family)) {
 }
 
-Font::Font(int size, uint32 flags, int family, Font *modified) {
+Font::Font(int size, uint32 flags, int family, Font *modified) : key(kNoKey) {
 	init(size, flags, family, modified);
 }
 
 void Font::init(int size, uint32 flags, int family, Font *modified) {
-	uint32 key = fontKey(size, flags, family);
+	auto dataKey = fontKey(size, flags, family);
+	auto i = fontsMap.constFind(dataKey);
+	if (i == fontsMap.cend()) {
+		i = fontsMap.insert(dataKey, new FontData(size, flags, family, modified));
+		++fontsCreatedCount;
+	}
+	ptr = i.value();
+}
+
+void Font::materialize() const {
 	auto i = fontsMap.constFind(key);
 	if (i == fontsMap.cend()) {
-		i = fontsMap.insert(key, new FontData(size, flags, family, modified));
+		i = fontsMap.insert(key, new FontData(fontKeySize(key), fontKeyFlags(key), fontKeyFamily(key), nullptr));
+		++fontsCreatedCount;
 	}
 	ptr = i.value();
 }
@@ -26,39 +26,53 @@ namespace internal {
 void destroyFonts();
 int registerFontFamily(const QString &family);
 
+// Returns the count of font datas created since the start.
+int fontsCreated();
+
 class FontData;
+
+// FontData with its QFontMetrics is created on the first access,
+// so that the fonts of the never shown styles are not created at all.
 class Font {
 public:
-	Font(Qt::Initialization = Qt::Uninitialized) : ptr(0) {
+	Font(Qt::Initialization = Qt::Uninitialized) : ptr(0), key(kNoKey) {
 	}
 	Font(int size, uint32 flags, const QString &family);
 	Font(int size, uint32 flags, int family);
 
 	Font &operator=(const Font &other) {
 		ptr = other.ptr;
+		key = other.key;
 		return (*this);
 	}
 
 	FontData *operator->() const {
-		return ptr;
+		return v();
 	}
 	FontData *v() const {
+		if (!ptr && key != kNoKey) {
+			materialize();
+		}
 		return ptr;
 	}
 
 	operator bool() const {
-		return !!ptr;
+		return ptr || (key != kNoKey);
 	}
 
 	operator const QFont &() const;
 
 private:
-	FontData *ptr;
+	static constexpr auto kNoKey = uint32(0xFFFFFFFFU);
+
+	mutable FontData *ptr;
+	uint32 key;
 
 	void init(int size, uint32 flags, int family, Font *modified);
+	void materialize() const;
 	friend void startManager();
 
-	Font(FontData *p) : ptr(p) {
+	Font(FontData *p) : ptr(p), key(kNoKey) {
 	}
 	Font(int size, uint32 flags, int family, Font *modified);
 	friend class FontData;
@@ -122,7 +136,7 @@ inline bool operator!=(const Font &a, const Font &b) {
 }
 
 inline Font::operator const QFont &() const {
-	return ptr->f;
+	return v()->f;
 }
 
 } // namespace internal
@@ -117,6 +117,10 @@ MonoIcon::MonoIcon(const IconMask *mask, Color color, QPoint offset)
 }
 
 void MonoIcon::reset() const {
+	// Pixmaps colorized with the color that was not changed are kept.
+	if (!_pixmap.isNull() && _pixmapColorKey == colorKey(_color->c)) {
+		return;
+	}
 	_pixmap = QPixmap();
 	_size = QSize();
 }
@@ -275,6 +279,7 @@ void MonoIcon::createCachedPixmap() const {
 		j = iconPixmaps->insert(key, App::pixmapFromImageInPlace(std_::move(image)));
 	}
 	_pixmap = j.value();
+	_pixmapColorKey = key.second;
 	_size = _pixmap.size() / cIntRetinaFactor();
 }
 
@@ -333,12 +338,23 @@ int IconData::height() const {
 }
 
 void resetIcons() {
-	iconPixmaps.clear();
 	if (iconData) {
 		for (auto data : *iconData) {
 			data->reset();
 		}
 	}
+
+	// The pixmaps are found by the color value, so only the ones
+	// that are not used by any icon after the reset are dropped.
+	if (iconPixmaps) {
+		for (auto i = iconPixmaps->begin(); i != iconPixmaps->end();) {
+			if (i->isDetached()) {
+				i = iconPixmaps->erase(i);
+			} else {
+				++i;
+			}
+		}
+	}
 }
 
 void destroyIcons() {
@@ -86,6 +86,7 @@ private:
 	QPoint _offset = { 0, 0 };
 	mutable QImage _maskImage, _colorizedImage;
 	mutable QPixmap _pixmap; // for pixmaps
+	mutable uint32 _pixmapColorKey = 0; // _pixmap is colorized with this color
 	mutable QSize _size; // for rects
 
 };
@@ -38,98 +38,6 @@ inline int32 countBlockHeight(const ITextBlock *b, const style::TextStyle *st) {
 
 } // namespace
 
-QString textcmdSkipBlock(ushort w, ushort h) {
-	static QString cmd(5, TextCommand);
-	cmd[1] = QChar(TextCommandSkipBlock);
-	cmd[2] = QChar(w);
-	cmd[3] = QChar(h);
-	return cmd;
-}
-
-QString textcmdStartLink(ushort lnkIndex) {
-	static QString cmd(4, TextCommand);
-	cmd[1] = QChar(TextCommandLinkIndex);
-	cmd[2] = QChar(lnkIndex);
-	return cmd;
-}
-
-QString textcmdStartLink(const QString &url) {
-	if (url.size() >= 4096) return QString();
-
-	QString result;
-	result.reserve(url.size() + 4);
-	return result.append(TextCommand).append(QChar(TextCommandLinkText)).append(QChar(url.size())).append(url).append(TextCommand);
-}
-
-QString textcmdStopLink() {
-	return textcmdStartLink(0);
-}
-
-QString textcmdLink(ushort lnkIndex, const QString &text) {
-	QString result;
-	result.reserve(4 + text.size() + 4);
-	return result.append(textcmdStartLink(lnkIndex)).append(text).append(textcmdStopLink());
-}
-
-QString textcmdLink(const QString &url, const QString &text) {
-	QString result;
-	result.reserve(4 + url.size() + text.size() + 4);
-	return result.append(textcmdStartLink(url)).append(text).append(textcmdStopLink());
-}
-
-QString textcmdStartSemibold() {
-	QString result;
-	result.reserve(3);
-	return result.append(TextCommand).append(QChar(TextCommandSemibold)).append(TextCommand);
-}
-
-QString textcmdStopSemibold() {
-	QString result;
-	result.reserve(3);
-	return result.append(TextCommand).append(QChar(TextCommandNoSemibold)).append(TextCommand);
-}
-
-const QChar *textSkipCommand(const QChar *from, const QChar *end, bool canLink) {
-	const QChar *result = from + 1;
-	if (*from != TextCommand || result >= end) return from;
-
-	ushort cmd = result->unicode();
-	++result;
-	if (result >= end) return from;
-
-	switch (cmd) {
-	case TextCommandBold:
-	case TextCommandNoBold:
-	case TextCommandSemibold:
-	case TextCommandNoSemibold:
-	case TextCommandItalic:
-	case TextCommandNoItalic:
-	case TextCommandUnderline:
-	case TextCommandNoUnderline:
-		break;
-
-	case TextCommandLinkIndex:
-		if (result->unicode() > 0x7FFF) return from;
-		++result;
-		break;
-
-	case TextCommandLinkText: {
-		ushort len = result->unicode();
-		if (len >= 4096 || !canLink) return from;
-		result += len + 1;
-	} break;
-
-	case TextCommandSkipBlock:
-		result += 2;
-		break;
-
-	case TextCommandLangTag:
-		result += 1;
-		break;
-	}
-	return (result < end && *result == TextCommand) ? (result + 1) : from;
-}
-
 class TextParser {
 public:
 
@@ -602,17 +510,17 @@ public:
 					const TextLinkData &link(links[lnkIndex - maxLnkIndex - 1]);
 					ClickHandlerPtr handler;
 					switch (link.type) {
-					case EntityInTextCustomUrl: handler.reset(new HiddenUrlClickHandler(link.data)); break;
+					case EntityInTextCustomUrl: handler.reset(new HiddenUrlClickHandler(textIntern(link.data))); break;
 					case EntityInTextEmail:
-					case EntityInTextUrl: handler.reset(new UrlClickHandler(link.data, link.displayStatus == LinkDisplayedFull)); break;
-					case EntityInTextBotCommand: handler.reset(new BotCommandClickHandler(link.data)); break;
+					case EntityInTextUrl: handler.reset(new UrlClickHandler(textIntern(link.data), link.displayStatus == LinkDisplayedFull)); break;
+					case EntityInTextBotCommand: handler.reset(new BotCommandClickHandler(textIntern(link.data))); break;
 					case EntityInTextHashtag:
 						if (options.flags & TextTwitterMentions) {
 							handler.reset(new UrlClickHandler(qsl("https://twitter.com/hashtag/") + link.data.mid(1) + qsl("?src=hash"), true));
 						} else if (options.flags & TextInstagramMentions) {
 							handler.reset(new UrlClickHandler(qsl("https://instagram.com/explore/tags/") + link.data.mid(1) + '/', true));
 						} else {
-							handler.reset(new HashtagClickHandler(link.data));
+							handler.reset(new HashtagClickHandler(textIntern(link.data)));
 						}
 					break;
 					case EntityInTextMention:
@@ -621,7 +529,7 @@ public:
 						} else if (options.flags & TextInstagramMentions) {
 							handler.reset(new UrlClickHandler(qsl("https://instagram.com/") + link.data.mid(1) + '/', true));
 						} else {
-							handler.reset(new MentionClickHandler(link.data));
+							handler.reset(new MentionClickHandler(textIntern(link.data)));
 						}
 					break;
 					case EntityInTextMentionName: {
@@ -2965,6 +2873,22 @@ QString Text::originalText(TextSelection selection, ExpandLinksMode mode) const
 	return result;
 }
 
+int Text::countMemoryUsage() const {
+	auto result = int(sizeof(Text));
+	result += _text.capacity() * sizeof(QChar);
+	result += _blocks.capacity() * sizeof(ITextBlock*);
+	for_const (auto block, _blocks) {
+		switch (block->type()) {
+		case TextBlockTNewline: result += sizeof(NewlineBlock); break;
+		case TextBlockTText: result += sizeof(TextBlock) + static_cast<const TextBlock*>(block)->_words.capacity() * sizeof(TextWord); break;
+		case TextBlockTEmoji: result += sizeof(EmojiBlock); break;
+		case TextBlockTSkip: result += sizeof(SkipBlock); break;
+		}
+	}
+	result += _links.capacity() * sizeof(ClickHandlerPtr);
+	return result;
+}
+
 void Text::clear() {
 	for (TextBlocks::iterator i = _blocks.begin(), e = _blocks.end(); i != e; ++i) {
 		delete *i;
@@ -2981,5 +2905,5 @@ void Text::clearFields() {
 }
 
 void emojiDraw(QPainter &p, EmojiPtr e, int x, int y) {
-	p.drawPixmap(QPoint(x, y), App::emoji(), QRect(e->x * ESize, e->y * ESize, ESize, ESize));
+	p.drawPixmap(QPoint(x, y), App::emoji(e), QRect(e->x * ESize, 0, ESize, ESize));
 }
@@ -26,23 +26,6 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include "ui/text/text_entity.h"
 #include "ui/emoji_config.h"
 
-static const QChar TextCommand(0x0010);
-enum TextCommands {
-	TextCommandBold        = 0x01,
-	TextCommandNoBold      = 0x02,
-	TextCommandItalic      = 0x03,
-	TextCommandNoItalic    = 0x04,
-	TextCommandUnderline   = 0x05,
-	TextCommandNoUnderline = 0x06,
-	TextCommandSemibold    = 0x07,
-	TextCommandNoSemibold  = 0x08,
-	TextCommandLinkIndex   = 0x09, // 0 - NoLink
-	TextCommandLinkText    = 0x0A,
-	TextCommandSkipBlock   = 0x0D,
-
-	TextCommandLangTag     = 0x20,
-};
-
 struct TextParseOptions {
 	int32 flags;
 	int32 maxw;
@@ -199,6 +182,9 @@ public:
 		return true;
 	}
 
+	// Approximate heap and inline size of the parsed text layout in bytes.
+	int countMemoryUsage() const;
+
 	void clear();
 	~Text() {
 		clear();
@@ -253,141 +239,4 @@ inline TextSelection unshiftSelection(TextSelection selection, const Text &byTex
 	return snapSelection(int(selection.from) - len, int(selection.to) - len);
 }
 
-void initLinkSets();
-const QSet<int32> &validProtocols();
-const QSet<int32> &validTopDomains();
-const QRegularExpression &reDomain();
-const QRegularExpression &reMailName();
-const QRegularExpression &reMailStart();
-const QRegularExpression &reHashtag();
-const QRegularExpression &reBotCommand();
-
-// textcmd
-QString textcmdSkipBlock(ushort w, ushort h);
-QString textcmdStartLink(ushort lnkIndex);
-QString textcmdStartLink(const QString &url);
-QString textcmdStopLink();
-QString textcmdLink(ushort lnkIndex, const QString &text);
-QString textcmdLink(const QString &url, const QString &text);
-QString textcmdStartSemibold();
-QString textcmdStopSemibold();
-const QChar *textSkipCommand(const QChar *from, const QChar *end, bool canLink = true);
-
-inline bool chIsSpace(QChar ch, bool rich = false) {
-	return ch.isSpace() || (ch < 32 && !(rich && ch == TextCommand)) || (ch == QChar::ParagraphSeparator) || (ch == QChar::LineSeparator) || (ch == QChar::ObjectReplacementCharacter) || (ch == QChar::CarriageReturn) || (ch == QChar::Tabulation);
-}
-inline bool chIsDiac(QChar ch) { // diac and variation selectors
-	return (ch.category() == QChar::Mark_NonSpacing) || (ch == 1652) || (ch >= 64606 && ch <= 64611);
-}
-inline bool chIsBad(QChar ch) {
-	return (ch == 0) || (ch >= 8232 && ch < 8237) || (ch >= 65024 && ch < 65040 && ch != 65039) || (ch >= 127 && ch < 160 && ch != 156) || (cPlatform() == dbipMac && ch >= 0x0B00 && ch <= 0x0B7F && chIsDiac(ch) && cIsElCapitan()); // tmp hack see https://bugreports.qt.io/browse/QTBUG-48910
-}
-inline bool chIsTrimmed(QChar ch, bool rich = false) {
-	return (!rich || ch != TextCommand) && (chIsSpace(ch) || chIsBad(ch));
-}
-inline bool chReplacedBySpace(QChar ch) {
-	// \xe2\x80[\xa8 - \xac\xad] // 8232 - 8237
-	// QString from1 = QString::fromUtf8("\xe2\x80\xa8"), to1 = QString::fromUtf8("\xe2\x80\xad");
-	// \xcc[\xb3\xbf\x8a] // 819, 831, 778
-	// QString bad1 = QString::fromUtf8("\xcc\xb3"), bad2 = QString::fromUtf8("\xcc\xbf"), bad3 = QString::fromUtf8("\xcc\x8a");
-	// [\x00\x01\x02\x07\x08\x0b-\x1f] // '\t' = 0x09
-	return (/*code >= 0x00 && */ch <= 0x02) || (ch >= 0x07 && ch <= 0x09) || (ch >= 0x0b && ch <= 0x1f) ||
-		(ch == 819) || (ch == 831) || (ch == 778) || (ch >= 8232 && ch <= 8237);
-}
-inline int32 chMaxDiacAfterSymbol() {
-	return 2;
-}
-inline bool chIsNewline(QChar ch) {
-	return (ch == QChar::LineFeed || ch == 156);
-}
-inline bool chIsLinkEnd(QChar ch) {
-	return ch == TextCommand || chIsBad(ch) || chIsSpace(ch) || chIsNewline(ch) || ch.isLowSurrogate() || ch.isHighSurrogate();
-}
-inline bool chIsAlmostLinkEnd(QChar ch) {
-	switch (ch.unicode()) {
-	case '?':
-	case ',':
-	case '.':
-	case '"':
-	case ':':
-	case '!':
-	case '\'':
-		return true;
-	default:
-		break;
-	}
-	return false;
-}
-inline bool chIsWordSeparator(QChar ch) {
-	switch (ch.unicode()) {
-	case QChar::Space:
-	case QChar::LineFeed:
-	case '.':
-	case ',':
-	case '?':
-	case '!':
-	case '@':
-	case '#':
-	case '$':
-	case ':':
-	case ';':
-	case '-':
-	case '<':
-	case '>':
-	case '[':
-	case ']':
-	case '(':
-	case ')':
-	case '{':
-	case '}':
-	case '=':
-	case '/':
-	case '+':
-	case '%':
-	case '&':
-	case '^':
-	case '*':
-	case '\'':
-	case '"':
-	case '`':
-	case '~':
-	case '|':
-		return true;
-	default:
-		break;
-	}
-	return false;
-}
-inline bool chIsSentenceEnd(QChar ch) {
-	switch (ch.unicode()) {
-	case '.':
-	case '?':
-	case '!':
-		return true;
-	default:
-		break;
-	}
-	return false;
-}
-inline bool chIsSentencePartEnd(QChar ch) {
-	switch (ch.unicode()) {
-	case ',':
-	case ':':
-	case ';':
-		return true;
-	default:
-		break;
-	}
-	return false;
-}
-inline bool chIsParagraphSeparator(QChar ch) {
-	switch (ch.unicode()) {
-	case QChar::LineFeed:
-		return true;
-	default:
-		break;
-	}
-	return false;
-}
-
 void emojiDraw(QPainter &p, EmojiPtr e, int x, int y);
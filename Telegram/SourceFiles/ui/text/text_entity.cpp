@@ -21,6 +21,8 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include "stdafx.h"
 #include "ui/text/text_entity.h"
 
+#include "ui/emoji_config.h"
+
 namespace {
 
 const QRegularExpression _reDomain(QString::fromUtf8("(?<![\\w\\$\\-\\_%=\\.])(?:([a-zA-Z]+)://)?((?:[A-Za-z" "\xd0\x90-\xd0\xaf" "\xd0\xb0-\xd1\x8f" "\xd1\x91\xd0\x81" "0-9\\-\\_]+\\.){1,10}([A-Za-z" "\xd1\x80\xd1\x84" "\\-\\d]{2,22})(\\:\\d+)?)"), QRegularExpression::UseUnicodePropertiesOption);
@@ -34,6 +36,11 @@ const QRegularExpression _rePre(qsl("(^|[\\s\\.,:;<>|'\"\\[\\]\\{\\}`\\~\\!\\?\\
 const QRegularExpression _reCode(qsl("(^|[\\s\\.,:;<>|'\"\\[\\]\\{\\}`\\~\\!\\?\\%\\^\\*\\(\\)\\-\\+=\\x10])(`)[^\\n]+?(`)([\\s\\.,:;<>|'\"\\[\\]\\{\\}`\\~\\!\\?\\%\\^\\*\\(\\)\\-\\+=\\x10]|$)"), QRegularExpression::UseUnicodePropertiesOption);
 QSet<int32> _validProtocols, _validTopDomains;
 
+constexpr auto kInternedMinSweepCount = 1024;
+
+QSet<QString> InternedStrings;
+int InternedSweepCount = kInternedMinSweepCount;
+
 } // namespace
 
 const QRegularExpression &reDomain() {
@@ -1311,6 +1318,125 @@ goodCanBreakEntity = canBreakEntity;\
 	return true;
 }
 
+QString textcmdSkipBlock(ushort w, ushort h) {
+	static QString cmd(5, TextCommand);
+	cmd[1] = QChar(TextCommandSkipBlock);
+	cmd[2] = QChar(w);
+	cmd[3] = QChar(h);
+	return cmd;
+}
+
+QString textcmdStartLink(ushort lnkIndex) {
+	static QString cmd(4, TextCommand);
+	cmd[1] = QChar(TextCommandLinkIndex);
+	cmd[2] = QChar(lnkIndex);
+	return cmd;
+}
+
+QString textcmdStartLink(const QString &url) {
+	if (url.size() >= 4096) return QString();
+
+	QString result;
+	result.reserve(url.size() + 4);
+	return result.append(TextCommand).append(QChar(TextCommandLinkText)).append(QChar(url.size())).append(url).append(TextCommand);
+}
+
+QString textcmdStopLink() {
+	return textcmdStartLink(0);
+}
+
+QString textcmdLink(ushort lnkIndex, const QString &text) {
+	QString result;
+	result.reserve(4 + text.size() + 4);
+	return result.append(textcmdStartLink(lnkIndex)).append(text).append(textcmdStopLink());
+}
+
+QString textcmdLink(const QString &url, const QString &text) {
+	QString result;
+	result.reserve(4 + url.size() + text.size() + 4);
+	return result.append(textcmdStartLink(url)).append(text).append(textcmdStopLink());
+}
+
+QString textcmdStartSemibold() {
+	QString result;
+	result.reserve(3);
+	return result.append(TextCommand).append(QChar(TextCommandSemibold)).append(TextCommand);
+}
+
+QString textcmdStopSemibold() {
+	QString result;
+	result.reserve(3);
+	return result.append(TextCommand).append(QChar(TextCommandNoSemibold)).append(TextCommand);
+}
+
+const QChar *textSkipCommand(const QChar *from, const QChar *end, bool canLink) {
+	const QChar *result = from + 1;
+	if (*from != TextCommand || result >= end) return from;
+
+	ushort cmd = result->unicode();
+	++result;
+	if (result >= end) return from;
+
+	switch (cmd) {
+	case TextCommandBold:
+	case TextCommandNoBold:
+	case TextCommandSemibold:
+	case TextCommandNoSemibold:
+	case TextCommandItalic:
+	case TextCommandNoItalic:
+	case TextCommandUnderline:
+	case TextCommandNoUnderline:
+		break;
+
+	case TextCommandLinkIndex:
+		if (result->unicode() > 0x7FFF) return from;
+		++result;
+		break;
+
+	case TextCommandLinkText: {
+		ushort len = result->unicode();
+		if (len >= 4096 || !canLink) return from;
+		result += len + 1;
+	} break;
+
+	case TextCommandSkipBlock:
+		result += 2;
+		break;
+
+	case TextCommandLangTag:
+		result += 1;
+		break;
+	}
+	return (result < end && *result == TextCommand) ? (result + 1) : from;
+}
+
+QString textIntern(const QString &str) {
+	if (str.isEmpty()) {
+		return str;
+	}
+	auto i = InternedStrings.constFind(str);
+	if (i != InternedStrings.cend()) {
+		return *i;
+	}
+	if (InternedStrings.size() >= InternedSweepCount) {
+		// Drop the strings that are not used by anybody except us.
+		for (auto j = InternedStrings.begin(); j != InternedStrings.end();) {
+			if (j->isDetached()) {
+				j = InternedStrings.erase(j);
+			} else {
+				++j;
+			}
+		}
+		InternedSweepCount = qMax(2 * InternedStrings.size(), kInternedMinSweepCount);
+	}
+	InternedStrings.insert(str);
+	return str;
+}
+
+int textInternedCount() {
+	return InternedStrings.size();
+}
+
 bool textcmdStartsLink(const QChar *start, int32 len, int32 commandOffset) {
 	if (commandOffset + 2 < len) {
 		if (*(start + commandOffset + 1) == TextCommandLinkIndex) {
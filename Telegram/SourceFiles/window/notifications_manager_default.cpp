@@ -40,6 +40,10 @@ namespace {
 
 NeverFreedPointer<Manager> ManagerInstance;
 
+constexpr auto kPooledNotifications = 3;
+constexpr auto kGroupQueuedAfter = 5;
+constexpr auto kStatisticsPeriod = 60 * 1000LL;
+
 int notificationMaxHeight() {
 	return st::notifyMinHeight + st::notifyReplyArea.heightMax + st::notifyBorderWidth;
 }
@@ -82,6 +86,7 @@ Manager::Manager() {
 		settingsChanged(change);
 	});
 	_inputCheckTimer.setTimeoutHandler([this] { checkLastInput(); });
+	_showQueueTimer.setTimeoutHandler([this] { showNextFromQueue(); });
 }
 
 bool Manager::hasReplyingNotification() const {
@@ -175,13 +180,41 @@ void Manager::stopAllHiding() {
 	}
 }
 
+void Manager::groupQueuedBurst(int freeSlots) {
+	// When the waiting queue gets long the notifications would be shown
+	// for minutes, so everything that doesn't fit is replaced by a summary.
+	auto keep = qMax(freeSlots - 1, 0);
+	if (_queuedNotifications.size() - keep < kGroupQueuedAfter) {
+		return;
+	}
+	auto messages = 0;
+	auto summarizedChats = 0;
+	auto chats = OrderedSet<History*>();
+	for_const (auto &queued, _queuedNotifications.mid(keep)) {
+		chats.insert(queued.history);
+		if (queued.burstMessages > 0) {
+			// Only the last chat of a previous summary is known.
+			messages += queued.burstMessages;
+			summarizedChats += queued.burstChats - 1;
+		} else {
+			messages += qMax(queued.forwardedCount, 1);
+		}
+	}
+	auto summary = QueuedNotification(_queuedNotifications.back().history, messages, chats.size() + summarizedChats);
+	_queuedNotifications.erase(_queuedNotifications.begin() + keep, _queuedNotifications.end());
+	_queuedNotifications.push_back(summary);
+	++_burstsGrouped;
+}
+
 void Manager::showNextFromQueue() {
+	_showQueueTimer.stop();
 	if (!_queuedNotifications.isEmpty()) {
 		int count = Global::NotificationsCount();
 		for_const (auto notification, _notifications) {
 			if (notification->isUnlinked()) continue;
 			--count;
 		}
+		groupQueuedBurst(count);
 		if (count > 0) {
 			auto startPosition = notificationStartPosition();
 			auto startShift = 0;
@@ -190,15 +223,16 @@ void Manager::showNextFromQueue() {
 				auto queued = _queuedNotifications.front();
 				_queuedNotifications.pop_front();
 
-				auto notification = std_::make_unique<Notification>(
-					queued.history,
-					queued.peer,
-					queued.author,
-					queued.item,
-					queued.forwardedCount,
-					startPosition, startShift, shiftDirection);
-				Platform::Notifications::defaultNotificationShown(notification.get());
-				_notifications.push_back(notification.release());
+				auto reused = !_pool.isEmpty();
+				auto notification = reused ? _pool.takeLast() : nullptr;
+				if (notification) {
+					notification->reuse(queued, startPosition, startShift, shiftDirection);
+				} else {
+					notification = new Notification(queued, startPosition, startShift, shiftDirection);
+				}
+				Platform::Notifications::defaultNotificationShown(notification);
+				_notifications.push_back(notification);
+				countShownWidget(reused);
 				--count;
 			} while (count > 0 && !_queuedNotifications.isEmpty());
 
@@ -278,6 +312,33 @@ void Manager::removeFromShown(Notification *remove) {
 	showNextFromQueue();
 }
 
+bool Manager::returnToPool(Notification *hidden) {
+	if (_pool.size() >= kPooledNotifications) {
+		return false;
+	}
+	auto index = _notifications.indexOf(hidden);
+	if (index < 0) {
+		return false;
+	}
+	_notifications.removeAt(index);
+	_pool.push_back(hidden);
+	_positionsOutdated = true;
+	showNextFromQueue();
+	return true;
+}
+
+void Manager::countShownWidget(bool reused) {
+	auto ms = getms(true);
+	if (ms - _statisticsStart >= kStatisticsPeriod) {
+		if (_widgetsCreated || _widgetsReused) {
+			DEBUG_LOG(("Notifications Info: %1 widgets created, %2 reused, %3 bursts grouped in %4 s").arg(_widgetsCreated).arg(_widgetsReused).arg(_burstsGrouped).arg((ms - _statisticsStart) / 1000));
+		}
+		_statisticsStart = ms;
+		_widgetsCreated = _widgetsReused = _burstsGrouped = 0;
+	}
+	++(reused ? _widgetsReused : _widgetsCreated);
+}
+
 void Manager::removeHideAll(HideAllButton *remove) {
 	if (remove == _hideAll) {
 		_hideAll = nullptr;
@@ -285,7 +346,9 @@ void Manager::removeHideAll(HideAllButton *remove) {
 }
 void Manager::doShowNotification(HistoryItem *item, int forwardedCount) {
 	_queuedNotifications.push_back(QueuedNotification(item, forwardedCount));
-	showNextFromQueue();
+	if (!_showQueueTimer.isActive()) {
+		_showQueueTimer.start(0);
+	}
 }
 
 void Manager::doClearAll() {
@@ -298,7 +361,9 @@ void Manager::doClearAll() {
 
 void Manager::doClearAllFast() {
 	_queuedNotifications.clear();
+	_showQueueTimer.stop();
 	auto notifications = base::take(_notifications);
+	notifications.append(base::take(_pool));
 	for_const (auto notification, notifications) {
 		delete notification;
 	}
@@ -307,7 +372,7 @@ void Manager::doClearAllFast() {
 
 void Manager::doClearFromHistory(History *history) {
 	for (auto i = _queuedNotifications.begin(); i != _queuedNotifications.cend();) {
-		if (i->history == history) {
+		if (i->history == history && !i->burstMessages) {
 			i = _queuedNotifications.erase(i);
 		} else {
 			++i;
@@ -360,6 +425,22 @@ Widget::Widget(QPoint startPosition, int shift, Direction shiftDirection) : TWid
 	_a_opacity.start([this] { opacityAnimationCallback(); }, 0., 1., st::notifyFastAnim);
 }
 
+void Widget::reuse(QPoint startPosition, int shift, Direction shiftDirection) {
+	_hiding = false;
+	_deleted = false;
+	_startPosition = startPosition;
+	_direction = shiftDirection;
+	a_shift = anim::value(shift);
+	_a_shift.stop();
+	setWindowOpacity(0.);
+
+	_a_opacity.start([this] { opacityAnimationCallback(); }, 0., 1., st::notifyFastAnim);
+}
+
+void Widget::hideFinished() {
+	destroyDelayed();
+}
+
 void Widget::destroyDelayed() {
 	hide();
 	if (_deleted) return;
@@ -377,7 +458,7 @@ void Widget::opacityAnimationCallback() {
 	updateOpacity();
 	update();
 	if (!_a_opacity.animating() && _hiding) {
-		destroyDelayed();
+		hideFinished();
 	}
 }
 
@@ -470,22 +551,21 @@ void Background::paintEvent(QPaintEvent *e) {
 	p.fillRect(st::notifyBorderWidth, height() - st::notifyBorderWidth, width() - 2 * st::notifyBorderWidth, st::notifyBorderWidth, st::notifyBorder);
 }
 
-Notification::Notification(History *history, PeerData *peer, PeerData *author, HistoryItem *msg, int forwardedCount, QPoint startPosition, int shift, Direction shiftDirection) : Widget(startPosition, shift, shiftDirection)
-, _history(history)
-, _peer(peer)
-, _author(author)
-, _item(msg)
-, _forwardedCount(forwardedCount)
+Notification::Notification(const Content &content, QPoint startPosition, int shift, Direction shiftDirection) : Widget(startPosition, shift, shiftDirection)
 #if defined Q_OS_WIN && !defined Q_OS_WINRT
 , _started(GetTickCount())
 #endif // Q_OS_WIN && !Q_OS_WINRT
+, _history(nullptr)
+, _peer(nullptr)
+, _author(nullptr)
+, _item(nullptr)
+, _forwardedCount(0)
 , _close(this, st::notifyClose)
 , _reply(this, lang(lng_notification_reply), st::defaultBoxButton) {
 	auto position = computePosition(st::notifyMinHeight);
 	updateGeometry(position.x(), position.y(), st::notifyWidth, st::notifyMinHeight);
 
-	_userpicLoaded = _peer ? _peer->userpicLoaded() : true;
-	updateNotifyDisplay();
+	setContent(content);
 
 	_hideTimer.setSingleShot(true);
 	connect(&_hideTimer, SIGNAL(timeout()), this, SLOT(onHideByTimer()));
@@ -522,6 +602,65 @@ Notification::Notification(History *history, PeerData *peer, PeerData *author, H
 	show();
 }
 
+void Notification::setContent(const Content &content) {
+	_history = content.history;
+	_peer = content.peer;
+	_author = content.author;
+	_item = content.item;
+	_forwardedCount = content.forwardedCount;
+	_burstMessages = content.burstMessages;
+	_burstChats = content.burstChats;
+
+	_userpicLoaded = _peer ? _peer->userpicLoaded() : true;
+	updateNotifyDisplay();
+}
+
+void Notification::reuse(const Content &content, QPoint startPosition, int shift, Direction shiftDirection) {
+	Widget::reuse(startPosition, shift, shiftDirection);
+
+#if defined Q_OS_WIN && !defined Q_OS_WINRT
+	_started = GetTickCount();
+#endif // Q_OS_WIN && !Q_OS_WINRT
+	_hideTimer.stop();
+	_waitingForInput = true;
+	resetReplyField();
+	_actionsVisible = false;
+	_hideReplyButton = false;
+	a_actionsOpacity.finish();
+	_reply->clearState();
+	_reply->hide();
+
+	auto position = computePosition(st::notifyMinHeight);
+	updateGeometry(position.x(), position.y(), st::notifyWidth, st::notifyMinHeight);
+
+	setContent(content);
+	show();
+}
+
+void Notification::resetReplyField() {
+	if (_replyArea) {
+		Sandbox::removeEventFilter(this);
+	}
+	_replySend.destroy();
+	_replyArea.destroy();
+	_background.destroy();
+}
+
+void Notification::hideFinished() {
+	if (auto manager = ManagerInstance.data()) {
+		if (!_replyArea) {
+			// Pooled widgets are not notified about removed items.
+			_history = nullptr;
+			_item = nullptr;
+			hide();
+			if (manager->returnToPool(this)) {
+				return;
+			}
+		}
+	}
+	Widget::hideFinished();
+}
+
 void Notification::prepareActionsCache() {
 	auto replyCache = myGrab(_reply);
 	auto fadeWidth = st::notifyFadeRight.width();
@@ -607,10 +746,13 @@ void Notification::actionsOpacityCallback() {
 }
 
 void Notification::updateNotifyDisplay() {
-	if (!_history || !_peer || (!_item && _forwardedCount < 2)) return;
+	if (!_history || !_peer || (!_item && _forwardedCount < 2 && !_burstMessages)) return;
 
 	auto options = Manager::getNotificationOptions(_item);
 	_hideReplyButton = options.hideReplyButton;
+	if (_burstMessages > 0) {
+		options.hideNameAndPhoto = true;
+	}
 
 	int32 w = width(), h = height();
 	QImage img(w * cIntRetinaFactor(), h * cIntRetinaFactor(), QImage::Format_ARGB32_Premultiplied);
@@ -647,7 +789,12 @@ void Notification::updateNotifyDisplay() {
 			const HistoryItem *textCachedFor = 0;
 			Text itemTextCache(itemWidth);
 			QRect r(st::notifyPhotoPos.x() + st::notifyPhotoSize + st::notifyTextLeft, st::notifyItemTop + st::msgNameFont->height, itemWidth, 2 * st::dialogsTextFont->height);
-			if (_item) {
+			if (_burstMessages > 0) {
+				p.setFont(st::dialogsTextFont);
+				p.setPen(st::dialogsTextFg);
+				auto text = lng_notification_burst(lt_count, _burstMessages, lt_count_chats, _burstChats);
+				p.drawText(r.left(), r.top() + st::dialogsTextFont->ascent, st::dialogsTextFont->elided(text, r.width()));
+			} else if (_item) {
 				auto active = false, selected = false;
 				_item->drawInDialog(p, r, active, selected, textCachedFor, itemTextCache);
 			} else if (_forwardedCount > 1) {
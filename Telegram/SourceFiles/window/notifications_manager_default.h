@@ -72,8 +72,11 @@ private:
 	void doClearFromItem(HistoryItem *item) override;
 
 	void showNextFromQueue();
+	void groupQueuedBurst(int freeSlots);
 	void unlinkFromShown(Notification *remove);
 	void removeFromShown(Notification *remove);
+	bool returnToPool(Notification *hidden);
+	void countShownWidget(bool reused);
 	void removeHideAll(HideAllButton *remove);
 	void startAllHiding();
 	void stopAllHiding();
@@ -91,6 +94,9 @@ private:
 	using Notifications = QList<Notification*>;
 	Notifications _notifications;
 
+	// Hidden widgets kept for the next notifications.
+	Notifications _pool;
+
 	HideAllButton *_hideAll = nullptr;
 
 	bool _positionsOutdated = false;
@@ -105,15 +111,33 @@ private:
 		, forwardedCount(forwardedCount) {
 		}
 
+		// Summary of a burst, it opens the chat of the last message.
+		QueuedNotification(History *history, int burstMessages, int burstChats)
+		: history(history)
+		, peer(history->peer)
+		, burstMessages(burstMessages)
+		, burstChats(burstChats) {
+		}
+
 		History *history;
 		PeerData *peer;
-		PeerData *author;
-		HistoryItem *item;
-		int forwardedCount;
+		PeerData *author = nullptr;
+		HistoryItem *item = nullptr;
+		int forwardedCount = 0;
+		int burstMessages = 0;
+		int burstChats = 0;
 	};
 	using QueuedNotifications = QList<QueuedNotification>;
 	QueuedNotifications _queuedNotifications;
 
+	// Notifications added in one event loop iteration are shown together.
+	SingleTimer _showQueueTimer;
+
+	TimeMs _statisticsStart = 0;
+	int _widgetsCreated = 0;
+	int _widgetsReused = 0;
+	int _burstsGrouped = 0;
+
 	Animation _demoMasterOpacity;
 
 };
@@ -147,11 +171,17 @@ protected:
 	void hideStop();
 	QPoint computePosition(int height) const;
 
+	// Prepares a hidden widget to be shown again.
+	void reuse(QPoint startPosition, int shift, Direction shiftDirection);
+	void destroyDelayed();
+
 	virtual void updateGeometry(int x, int y, int width, int height);
 
+	// Called when the hiding animation is finished, destroys the widget.
+	virtual void hideFinished();
+
 private:
 	void opacityAnimationCallback();
-	void destroyDelayed();
 	void moveByShift();
 	void hideAnimated(float64 duration, const anim::transition &func);
 	void step_shift(float64 ms, bool timer);
@@ -180,7 +210,11 @@ class Notification : public Widget {
 	Q_OBJECT
 
 public:
-	Notification(History *history, PeerData *peer, PeerData *author, HistoryItem *item, int forwardedCount, QPoint startPosition, int shift, Direction shiftDirection);
+	using Content = Manager::QueuedNotification;
+	Notification(const Content &content, QPoint startPosition, int shift, Direction shiftDirection);
+
+	// Shows a pooled widget with the new content.
+	void reuse(const Content &content, QPoint startPosition, int shift, Direction shiftDirection);
 
 	void startHiding();
 	void stopHiding();
@@ -225,7 +259,10 @@ private:
 	void sendReply();
 	void changeHeight(int newHeight);
 	void updateGeometry(int x, int y, int width, int height) override;
+	void hideFinished() override;
 	void actionsOpacityCallback();
+	void setContent(const Content &content);
+	void resetReplyField();
 
 	QPixmap _cache;
 
@@ -243,6 +280,8 @@ private:
 	PeerData *_author;
 	HistoryItem *_item;
 	int _forwardedCount;
+	int _burstMessages = 0;
+	int _burstChats = 0;
 	object_ptr<Ui::IconButton> _close;
 	object_ptr<Ui::RoundButton> _reply;
 	object_ptr<Background> _background = { nullptr };
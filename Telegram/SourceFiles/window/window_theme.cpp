@@ -521,6 +521,7 @@ void ChatBackground::saveForRevert() {
 }
 
 void ChatBackground::setTestingTheme(Instance &&theme) {
+	paletteChangeStarted();
 	style::main_palette::apply(theme.palette);
 	if (!theme.background.isNull() || _id == kThemeBackground) {
 		saveForRevert();
@@ -530,10 +531,12 @@ void ChatBackground::setTestingTheme(Instance &&theme) {
 		// Apply current background image so that service bg colors are recounted.
 		setImage(_id, std_::move(_pixmap).toImage());
 	}
+	paletteChangeFinished();
 	notify(BackgroundUpdate(BackgroundUpdate::Type::TestingTheme, _tile), true);
 }
 
 void ChatBackground::setTestingDefaultTheme() {
+	paletteChangeStarted();
 	style::main_palette::reset();
 	if (_id == kThemeBackground) {
 		saveForRevert();
@@ -543,6 +546,7 @@ void ChatBackground::setTestingDefaultTheme() {
 		// Apply current background image so that service bg colors are recounted.
 		setImage(_id, std_::move(_pixmap).toImage());
 	}
+	paletteChangeFinished();
 	notify(BackgroundUpdate(BackgroundUpdate::Type::TestingTheme, _tile), true);
 }
 
@@ -568,7 +572,11 @@ void ChatBackground::writeNewBackgroundSettings() {
 	Local::writeBackground(_id, QImage());
 }
 
-void ChatBackground::revert() {
+void ChatBackground::revert(const QByteArray &paletteForRevert) {
+	paletteChangeStarted();
+	if (!paletteForRevert.isEmpty()) {
+		style::main_palette::load(paletteForRevert);
+	}
 	if (_id == internal::kTestingThemeBackground || _id == internal::kTestingDefaultBackground) {
 		setTile(_tileForRevert);
 		setImage(_idForRevert, std_::move(_imageForRevert));
@@ -576,9 +584,43 @@ void ChatBackground::revert() {
 		// Apply current background image so that service bg colors are recounted.
 		setImage(_id, std_::move(_pixmap).toImage());
 	}
+	paletteChangeFinished();
 	notify(BackgroundUpdate(BackgroundUpdate::Type::RevertingTheme, _tile), true);
 }
 
+void ChatBackground::paletteChangeStarted() {
+	_paletteBeforeChange = style::main_palette::save();
+}
+
+void ChatBackground::paletteChangeFinished() {
+	auto was = base::take(_paletteBeforeChange);
+	auto now = style::main_palette::save();
+	if (was.size() != now.size()) {
+		_paletteChanges = QBitArray();
+		return;
+	}
+
+	// Each color is saved as four bytes in the order of the palette indices.
+	auto count = now.size() / 4;
+	auto changed = 0;
+	_paletteChanges = QBitArray(count);
+	for (auto i = 0; i != count; ++i) {
+		if (memcmp(was.constData() + i * 4, now.constData() + i * 4, 4)) {
+			_paletteChanges.setBit(i);
+			++changed;
+		}
+	}
+	DEBUG_LOG(("Theme Info: palette switch changed %1 of %2 colors").arg(changed).arg(count));
+}
+
+bool ChatBackground::paletteColorChanged(const style::color &color) const {
+	auto index = style::main_palette::indexOfColor(color);
+	if (index < 0 || index >= _paletteChanges.size()) {
+		return true;
+	}
+	return _paletteChanges.testBit(index);
+}
+
 
 ChatBackground *Background() {
 	instance.createIfNull();
@@ -652,11 +694,9 @@ void KeepApplied() {
 }
 
 void Revert() {
-	if (!instance->applying.paletteForRevert.isEmpty()) {
-		style::main_palette::load(instance->applying.paletteForRevert);
-	}
+	auto paletteForRevert = base::take(instance->applying.paletteForRevert);
 	instance->applying = Data::Applying();
-	Background()->revert();
+	Background()->revert(paletteForRevert);
 }
 
 bool LoadFromFile(const QString &path, Instance *out, QByteArray *outContent) {
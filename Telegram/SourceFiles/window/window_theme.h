@@ -100,7 +100,7 @@ public:
 	void setTestingTheme(Instance &&theme);
 	void setTestingDefaultTheme();
 	void keepApplied();
-	void revert();
+	void revert(const QByteArray &paletteForRevert);
 
 	int32 id() const;
 	const QPixmap &pixmap() const {
@@ -112,11 +112,17 @@ public:
 	bool tile() const;
 	bool tileForSave() const;
 
+	// Returns true if the color was changed by the last palette switch,
+	// the caches depending only on the unchanged colors can be kept.
+	bool paletteColorChanged(const style::color &color) const;
+
 private:
 	void ensureStarted();
 	void saveForRevert();
 	void setPreparedImage(QImage &&image);
 	void writeNewBackgroundSettings();
+	void paletteChangeStarted();
+	void paletteChangeFinished();
 
 	int32 _id = internal::kUninitializedBackground;
 	QPixmap _pixmap;
@@ -130,6 +136,9 @@ private:
 	QImage _imageForRevert;
 	bool _tileForRevert = false;
 
+	QByteArray _paletteBeforeChange;
+	QBitArray _paletteChanges; // Empty if the changed colors are unknown.
+
 };
 
 ChatBackground *Background();
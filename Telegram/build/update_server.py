@@ -0,0 +1,127 @@
+'''
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014 John Preston, https://desktop.telegram.org
+'''
+# Local stand-in for the updates server, serves the packages made by Packer.
+#
+# Usage: update_server.py {packages dir} {version} [-port {port}] [-break {bytes}]
+#
+# Launch Telegram with -updateurl http://localhost:{port}/tupdates/current
+# The "current" reply has the full package url of {version} and the delta
+# package url, if the dir has a delta made from the version in the request.
+# With -break each package response is cut after {bytes} to check the resume.
+from __future__ import print_function
+import sys
+import os
+import re
+
+try:
+  from http.server import BaseHTTPRequestHandler, HTTPServer
+  from urllib.parse import urlparse, parse_qs
+except ImportError:
+  from BaseHTTPServer import BaseHTTPRequestHandler, HTTPServer
+  from urlparse import urlparse, parse_qs
+
+def eprint(*args, **kwargs):
+  print(*args, file=sys.stderr, **kwargs)
+  sys.exit(1)
+
+if len(sys.argv) < 3:
+  eprint('Usage: update_server.py {packages dir} {version} [-port {port}] [-break {bytes}]')
+
+packages_dir = os.path.abspath(sys.argv[1])
+version = sys.argv[2]
+port = 8090
+break_after = 0
+i = 3
+while i + 1 < len(sys.argv):
+  if sys.argv[i] == '-port':
+    port = int(sys.argv[i + 1])
+  elif sys.argv[i] == '-break':
+    break_after = int(sys.argv[i + 1])
+  i += 2
+
+full_re = re.compile(r'^(tupdate|tmacupd|tmac32upd|tlinuxupd|tlinux32upd)' + version + '$')
+full_name = ''
+for name in os.listdir(packages_dir):
+  if full_re.match(name):
+    full_name = name
+if not full_name:
+  eprint('Full package for version ' + version + ' not found in ' + packages_dir)
+
+class Handler(BaseHTTPRequestHandler):
+  def do_GET(self):
+    url = urlparse(self.path)
+    if url.path.endswith('/current'):
+      self.reply_current(parse_qs(url.query))
+    else:
+      self.reply_package(os.path.basename(url.path))
+
+  def base_url(self):
+    return 'http://localhost:' + str(port) + '/tupdates/'
+
+  def reply_current(self, query):
+    result = version + ':' + self.base_url() + full_name
+    if 'delta' in query and 'version' in query:
+      installed = query['beta'][0] if 'beta' in query else query['version'][0]
+      delta_name = full_name + 'd' + installed
+      if os.path.isfile(os.path.join(packages_dir, delta_name)):
+        result += ' ' + self.base_url() + delta_name
+    data = result.encode('utf-8')
+    self.send_response(200)
+    self.send_header('Content-Length', str(len(data)))
+    self.end_headers()
+    self.wfile.write(data)
+
+  def reply_package(self, name):
+    path = os.path.join(packages_dir, name)
+    if not os.path.isfile(path):
+      self.send_error(404)
+      return
+    size = os.path.getsize(path)
+    offset = 0
+    ranges = re.match(r'^bytes=(\d+)-$', self.headers.get('Range', ''))
+    if ranges:
+      offset = int(ranges.group(1))
+      if offset >= size:
+        self.send_response(416)
+        self.send_header('Content-Range', 'bytes */' + str(size))
+        self.end_headers()
+        return
+      self.send_response(206)
+      self.send_header('Content-Range', 'bytes ' + str(offset) + '-' + str(size - 1) + '/' + str(size))
+    else:
+      self.send_response(200)
+    self.send_header('Content-Length', str(size - offset))
+    self.end_headers()
+
+    with open(path, 'rb') as f:
+      f.seek(offset)
+      left = (size - offset) if not break_after else min(size - offset, break_after)
+      while left > 0:
+        data = f.read(min(left, 64 * 1024))
+        if not data:
+          break
+        self.wfile.write(data)
+        left -= len(data)
+    if break_after:
+      self.close_connection = True
+
+print('Serving ' + full_name + ' from ' + packages_dir + ' on port ' + str(port))
+HTTPServer(('localhost', port), Handler).serve_forever()
@@ -123,6 +123,8 @@
       '<(src_loc)/historywidget.h',
       '<(src_loc)/lang.cpp',
       '<(src_loc)/lang.h',
+      '<(src_loc)/langloaderpack.cpp',
+      '<(src_loc)/langloaderpack.h',
       '<(src_loc)/langloaderplain.cpp',
       '<(src_loc)/langloaderplain.h',
       '<(src_loc)/layerwidget.cpp',
@@ -207,6 +209,8 @@
       '<(src_loc)/core/click_handler.h',
       '<(src_loc)/core/click_handler_types.cpp',
       '<(src_loc)/core/click_handler_types.h',
+      '<(src_loc)/core/hashing.cpp',
+      '<(src_loc)/core/hashing.h',
       '<(src_loc)/core/lambda.h',
       '<(src_loc)/core/observer.cpp',
       '<(src_loc)/core/observer.h',
@@ -234,6 +238,10 @@
       '<(src_loc)/data/data_abstract_structure.h',
       '<(src_loc)/data/data_drafts.cpp',
       '<(src_loc)/data/data_drafts.h',
+      '<(src_loc)/data/data_mention_index.cpp',
+      '<(src_loc)/data/data_mention_index.h',
+      '<(src_loc)/data/data_userpic_cache.cpp',
+      '<(src_loc)/data/data_userpic_cache.h',
       '<(src_loc)/dialogs/dialogs_common.h',
       '<(src_loc)/dialogs/dialogs_indexed_list.cpp',
       '<(src_loc)/dialogs/dialogs_indexed_list.h',
@@ -257,6 +265,8 @@
       '<(src_loc)/history/history_media_types.h',
       '<(src_loc)/history/history_message.cpp',
       '<(src_loc)/history/history_message.h',
+      '<(src_loc)/history/history_render_cache.cpp',
+      '<(src_loc)/history/history_render_cache.h',
       '<(src_loc)/history/history_service_layout.cpp',
       '<(src_loc)/history/history_service_layout.h',
       '<(src_loc)/inline_bots/inline_bot_layout_internal.cpp',
@@ -299,6 +309,8 @@
       '<(src_loc)/media/view/media_clip_playback.h',
       '<(src_loc)/media/view/media_clip_volume_controller.cpp',
       '<(src_loc)/media/view/media_clip_volume_controller.h',
+      '<(src_loc)/media/view/media_view_prefetcher.cpp',
+      '<(src_loc)/media/view/media_view_prefetcher.h',
       '<(src_loc)/media/media_audio.cpp',
       '<(src_loc)/media/media_audio.h',
       '<(src_loc)/media/media_audio_capture.cpp',
@@ -331,6 +343,8 @@
       '<(src_loc)/mtproto/connection_auto.h',
       '<(src_loc)/mtproto/connection_http.cpp',
       '<(src_loc)/mtproto/connection_http.h',
+      '<(src_loc)/mtproto/connection_pool.cpp',
+      '<(src_loc)/mtproto/connection_pool.h',
       '<(src_loc)/mtproto/connection_tcp.cpp',
       '<(src_loc)/mtproto/connection_tcp.h',
       '<(src_loc)/mtproto/core_types.cpp',
@@ -339,6 +353,8 @@
       '<(src_loc)/mtproto/dcenter.h',
       '<(src_loc)/mtproto/file_download.cpp',
       '<(src_loc)/mtproto/file_download.h',
+      '<(src_loc)/mtproto/inflater.cpp',
+      '<(src_loc)/mtproto/inflater.h',
       '<(src_loc)/mtproto/rsa_public_key.cpp',
       '<(src_loc)/mtproto/rsa_public_key.h',
       '<(src_loc)/mtproto/rpc_sender.cpp',
@@ -347,6 +363,8 @@
       '<(src_loc)/mtproto/scheme_auto.h',
       '<(src_loc)/mtproto/session.cpp',
       '<(src_loc)/mtproto/session.h',
+      '<(src_loc)/mtproto/traffic_recorder.cpp',
+      '<(src_loc)/mtproto/traffic_recorder.h',
       '<(src_loc)/overview/overview_layout.cpp',
       '<(src_loc)/overview/overview_layout.h',
       '<(src_loc)/pspecific.h',
@@ -469,6 +487,8 @@
       '<(src_loc)/stickers/emoji_pan.h',
       '<(src_loc)/stickers/stickers.cpp',
       '<(src_loc)/stickers/stickers.h',
+      '<(src_loc)/stickers/stickers_panel_cache.cpp',
+      '<(src_loc)/stickers/stickers_panel_cache.h',
       '<(src_loc)/ui/buttons/history_down_button.cpp',
       '<(src_loc)/ui/buttons/history_down_button.h',
       '<(src_loc)/ui/buttons/peer_avatar_button.cpp',
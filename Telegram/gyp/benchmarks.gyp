@@ -0,0 +1,244 @@
+# This file is part of Telegram Desktop,
+# the official desktop version of Telegram messaging app, see https://telegram.org
+#
+# Telegram Desktop is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# It is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+# GNU General Public License for more details.
+#
+# In addition, as a special exception, the copyright holders give permission
+# to link the code of portions of this program with the OpenSSL library.
+#
+# Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+# Copyright (c) 2014 John Preston, https://desktop.telegram.org
+
+# Headless microbenchmarks of the non-GUI code, run "Benchmarks -json {path}"
+# after the build to get the results of this commit in JSON.
+#
+# ReplayServer replays the traffic recorded by the app started with
+# -mtprecord {path} to the app started with -mtpreplay, see replay_main.cpp.
+{
+  'includes': [
+    'common.gypi',
+  ],
+  'targets': [{
+    'target_name': 'Benchmarks',
+    'variables': {
+      'libs_loc': '../../../Libraries',
+      'src_loc': '../SourceFiles',
+    },
+    'includes': [
+      'common_executable.gypi',
+      'qt.gypi',
+    ],
+    'conditions': [
+      [ 'build_win', {
+        'libraries': [
+          'libeay32',
+          'ssleay32',
+          'Crypt32',
+          'zlibstat',
+        ],
+      }],
+      [ 'build_linux', {
+        'libraries': [
+          'z',
+        ],
+      }],
+      [ 'build_mac', {
+        'include_dirs': [
+          '<(libs_loc)/openssl-xcode/include'
+        ],
+        'library_dirs': [
+          '<(libs_loc)/openssl-xcode',
+        ],
+        'xcode_settings': {
+          'OTHER_LDFLAGS': [
+            '-lcrypto',
+          ],
+        },
+      }],
+    ],
+    'include_dirs': [
+      # The linked sources of the app get the headless stdafx.h from here.
+      '<(src_loc)/benchmarks',
+      '<(src_loc)',
+      '<(libs_loc)/zlib-1.2.8',
+    ],
+    'sources': [
+      '<(src_loc)/benchmarks/benchmark_core.cpp',
+      '<(src_loc)/benchmarks/benchmark_emoji.cpp',
+      '<(src_loc)/benchmarks/benchmark_hashing.cpp',
+      '<(src_loc)/benchmarks/benchmark_history.cpp',
+      '<(src_loc)/benchmarks/benchmark_mtproto.cpp',
+      '<(src_loc)/benchmarks/benchmark_text.cpp',
+      '<(src_loc)/benchmarks/benchmarks.h',
+      '<(src_loc)/benchmarks/benchmarks_app.cpp',
+      '<(src_loc)/benchmarks/benchmarks_app.h',
+      '<(src_loc)/benchmarks/benchmarks_logs.cpp',
+      '<(src_loc)/benchmarks/benchmarks_main.cpp',
+      '<(src_loc)/benchmarks/stdafx.h',
+      '<(src_loc)/core/hashing.cpp',
+      '<(src_loc)/core/hashing.h',
+      '<(src_loc)/mtproto/auth_key.cpp',
+      '<(src_loc)/mtproto/auth_key.h',
+      '<(src_loc)/mtproto/inflater.cpp',
+      '<(src_loc)/mtproto/inflater.h',
+      '<(src_loc)/ui/emoji_config.cpp',
+      '<(src_loc)/ui/emoji_config.h',
+      '<(src_loc)/ui/text/text_entity.cpp',
+      '<(src_loc)/ui/text/text_entity.h',
+    ],
+    'configurations': {
+      'Debug': {
+        'conditions': [
+          [ 'build_win', {
+            'include_dirs': [
+              '<(libs_loc)/openssl_debug/Debug/include',
+            ],
+            'library_dirs': [
+              '<(libs_loc)/openssl_debug/Debug/lib',
+              '<(libs_loc)/zlib-1.2.8/contrib/vstudio/vc11/x86/ZlibStatDebug',
+            ],
+          }, {
+            'include_dirs': [
+              '/usr/local/include',
+              '<(libs_loc)/openssl-xcode/include'
+            ],
+            'library_dirs': [
+              '/usr/local/lib',
+            ],
+          }]
+        ],
+      },
+      'Release': {
+        'conditions': [
+          [ 'build_win', {
+            'include_dirs': [
+              '<(libs_loc)/openssl/Release/include',
+            ],
+            'library_dirs': [
+              '<(libs_loc)/openssl/Release/lib',
+              '<(libs_loc)/zlib-1.2.8/contrib/vstudio/vc11/x86/ZlibStatRelease',
+            ],
+          }, {
+            'include_dirs': [
+              '/usr/local/include',
+              '<(libs_loc)/openssl-xcode/include'
+            ],
+            'library_dirs': [
+              '/usr/local/lib',
+            ],
+          }]
+        ],
+      },
+    },
+  }, {
+    'target_name': 'ReplayServer',
+    'variables': {
+      'libs_loc': '../../../Libraries',
+      'src_loc': '../SourceFiles',
+    },
+    'includes': [
+      'common_executable.gypi',
+      'qt.gypi',
+    ],
+    'conditions': [
+      [ 'build_win', {
+        'libraries': [
+          'libeay32',
+          'ssleay32',
+          'Crypt32',
+          'zlibstat',
+        ],
+      }],
+      [ 'build_linux', {
+        'libraries': [
+          'z',
+        ],
+      }],
+      [ 'build_mac', {
+        'include_dirs': [
+          '<(libs_loc)/openssl-xcode/include'
+        ],
+        'library_dirs': [
+          '<(libs_loc)/openssl-xcode',
+        ],
+        'xcode_settings': {
+          'OTHER_LDFLAGS': [
+            '-lcrypto',
+          ],
+        },
+      }],
+    ],
+    'include_dirs': [
+      # The linked sources of the app get the headless stdafx.h from here.
+      '<(src_loc)/benchmarks',
+      '<(src_loc)',
+      '<(libs_loc)/zlib-1.2.8',
+    ],
+    'sources': [
+      '<(src_loc)/benchmarks/benchmarks_logs.cpp',
+      '<(src_loc)/benchmarks/replay_main.cpp',
+      '<(src_loc)/benchmarks/replay_recording.cpp',
+      '<(src_loc)/benchmarks/replay_recording.h',
+      '<(src_loc)/benchmarks/replay_server.cpp',
+      '<(src_loc)/benchmarks/replay_server.h',
+      '<(src_loc)/benchmarks/stdafx.h',
+      '<(src_loc)/core/hashing.cpp',
+      '<(src_loc)/core/hashing.h',
+      '<(src_loc)/mtproto/auth_key.cpp',
+      '<(src_loc)/mtproto/auth_key.h',
+      '<(src_loc)/mtproto/traffic_recorder.h',
+    ],
+    'configurations': {
+      'Debug': {
+        'conditions': [
+          [ 'build_win', {
+            'include_dirs': [
+              '<(libs_loc)/openssl_debug/Debug/include',
+            ],
+            'library_dirs': [
+              '<(libs_loc)/openssl_debug/Debug/lib',
+              '<(libs_loc)/zlib-1.2.8/contrib/vstudio/vc11/x86/ZlibStatDebug',
+            ],
+          }, {
+            'include_dirs': [
+              '/usr/local/include',
+              '<(libs_loc)/openssl-xcode/include'
+            ],
+            'library_dirs': [
+              '/usr/local/lib',
+            ],
+          }]
+        ],
+      },
+      'Release': {
+        'conditions': [
+          [ 'build_win', {
+            'include_dirs': [
+              '<(libs_loc)/openssl/Release/include',
+            ],
+            'library_dirs': [
+              '<(libs_loc)/openssl/Release/lib',
+              '<(libs_loc)/zlib-1.2.8/contrib/vstudio/vc11/x86/ZlibStatRelease',
+            ],
+          }, {
+            'include_dirs': [
+              '/usr/local/include',
+              '<(libs_loc)/openssl-xcode/include'
+            ],
+            'library_dirs': [
+              '/usr/local/lib',
+            ],
+          }]
+        ],
+      },
+    },
+  }],
+}
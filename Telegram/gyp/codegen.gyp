@@ -77,6 +77,8 @@
       '<(src_loc)/codegen/style/main.cpp',
       '<(src_loc)/codegen/style/module.cpp',
       '<(src_loc)/codegen/style/module.h',
+      '<(src_loc)/codegen/style/module_cache.cpp',
+      '<(src_loc)/codegen/style/module_cache.h',
       '<(src_loc)/codegen/style/options.cpp',
       '<(src_loc)/codegen/style/options.h',
       '<(src_loc)/codegen/style/parsed_file.cpp',
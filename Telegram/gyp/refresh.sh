@@ -9,7 +9,7 @@ MySystem=`uname -s`
 cd $FullScriptPath
 
 if [ "$MySystem" == "Linux" ]; then
-  ../../../Libraries/gyp/gyp --depth=. --generator-output=../.. -Goutput_dir=out Telegram.gyp --format=cmake
+  ../../../Libraries/gyp/gyp --depth=. --generator-output=../.. -Goutput_dir=out Telegram.gyp benchmarks.gyp --format=cmake
   cd ../../out/Debug
   ../../../Libraries/cmake-3.6.2/bin/cmake .
   cd ../Release